@@ -1,29 +1,381 @@
+#include <errno.h>
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "i8080.h"
 
+#if defined(__unix__) || defined(__APPLE__)
+#define I8080_HAVE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #define CONCAT(HI, LO) ((((HI) << 8) | ((LO) & 0XFF)) & 0XFFFF)
 
-int parity_table[] = {
-  1, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1,
-  0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0,
-  0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0,
-  1, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1,
-  0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0,
-  1, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1,
-  1, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1,
-  0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0,
-  0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0,
-  1, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1,
-  1, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1,
-  0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0,
-  1, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1,
-  0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0,
-  0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0,
-  1, 0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1
+#ifdef __GNUC__
+#define ALWAYS_INLINE inline __attribute__((always_inline))
+#define NOINLINE __attribute__((noinline))
+#else
+#define ALWAYS_INLINE inline
+#define NOINLINE
+#endif
+
+// Cached code
+// The block cache and the JIT keep decoded or translated runs of instructions
+// (blocks) by start address. Stores through write_byte and write_word drop
+// every block covering the written address, so self-modifying code works.
+struct block_index {
+  void *blocks[0x10000];
+  // Length in bytes of the block starting at each address
+  uint8_t len[0x10000];
+  // Number of blocks covering each byte (saturating at 255)
+  uint8_t covered[0x10000];
+  // Longest possible block in bytes
+  uint max_len;
+
+  // Memory the blocks were decoded from
+  char *memory;
+  size_t memsize;
+
+  // Block being run and whether a store has dropped it
+  void *current;
+  int current_invalidated;
+};
+
+// Start of every block, whatever it holds (see run_blocks)
+struct block_info {
+  // Cycles taken by all but the last instruction
+  uint prefix_cycles;
+  // Whether it ends in a control transfer, after which traps are checked
+  int transfers;
+};
+
+static void index_reset(struct block_index *index) {
+  memset(index->blocks, 0, sizeof(index->blocks));
+  memset(index->covered, 0, sizeof(index->covered));
+
+  // A running block stays intact until it returns, but must stop early
+  if (index->current != NULL) {
+    index->current_invalidated = 1;
+  }
+}
+
+static void index_add(struct block_index *index, uint start, uint len,
+                      void *block) {
+  index->blocks[start] = block;
+  index->len[start] = len;
+
+  for (uint i=start;i<start+len;i++) {
+    if (index->covered[i] != 255) {
+      index->covered[i]++;
+    }
+  }
+}
+
+static void index_invalidate(struct block_index *index, uint addr) {
+  uint first = addr >= index->max_len ? addr - index->max_len + 1 : 0;
+
+  for (uint start=first;start<=addr;start++) {
+    void *block = index->blocks[start];
+    uint len = index->len[start];
+
+    if (block == NULL || start + len <= addr) {
+      continue;
+    }
+
+    index->blocks[start] = NULL;
+    for (uint i=start;i<start+len;i++) {
+      // Saturated counts stay that way until the next reset
+      if (index->covered[i] != 255) {
+        index->covered[i]--;
+      }
+    }
+
+    if (block == index->current) {
+      index->current_invalidated = 1;
+    }
+  }
+}
+
+// Pre-decoded instructions (see cache_decode and run_blocks)
+#define CACHE_MAX_INSNS 32
+#define CACHE_MAX_BLOCKS 32768
+#define CACHE_MAX_UOPS (CACHE_MAX_BLOCKS * 8)
+
+struct uop;
+typedef int (*uop_handler)(struct i8080 *, const struct uop *);
+
+struct uop {
+  uop_handler handler;
+  // Address of the following instruction
+  uint next;
+  uint16_t imm;
+  // Register (or register pair) operands as indexes into cpu->regs, or a
+  // condition code in src
+  uint8_t dst;
+  uint8_t src;
+  // Cycles not already added by the handler
+  uint8_t cycles;
+};
+
+struct cache_block {
+  struct block_info info;
+  struct uop *uops;
+};
+
+struct i8080_block_cache {
+  struct block_index index;
+
+  struct cache_block blocks[CACHE_MAX_BLOCKS];
+  uint num_blocks;
+  struct uop uops[CACHE_MAX_UOPS];
+  size_t num_uops;
+  uint max_insns;
+};
+
+#ifdef I8080_JIT
+#if !defined(__x86_64__) || !defined(__GNUC__) || !defined(I8080_HAVE_MMAP)
+#error "I8080_JIT requires GNU C on x86-64 with mmap"
+#endif
+
+#define JIT_CODE_SIZE (4 * 1024 * 1024)
+#define JIT_MAX_BLOCKS 32768
+#define JIT_MAX_INSNS 32
+
+// A straight line run of 8080 code translated to x86-64 (see jit_compile and
+// run_blocks)
+struct jit_block {
+  struct block_info info;
+  void (*code)(struct i8080 *);
+};
+
+struct i8080_jit {
+  struct block_index index;
+
+  struct jit_block pool[JIT_MAX_BLOCKS];
+  uint num_blocks;
+
+  uint8_t *code;
+  size_t code_used;
+  uint max_insns;
+};
+#endif
+
+// Snapshots (see i8080_snapshot)
+// Memory is kept in reference counted pages, shared by every snapshot in which
+// the page is unchanged
+struct i8080_snapshot_page {
+  uint refs;
+  char data[I8080_PAGE_SIZE];
+};
+
+struct i8080_dirty_pages {
+  // Memory being tracked
+  char *memory;
+  size_t memsize;
+  size_t num_pages;
+
+  // Pages of the snapshot last taken or restored, or NULL. Memory matches
+  // them apart from the pages marked dirty since.
+  struct i8080_snapshot_page **base;
+  uint8_t dirty[];
+};
+
+// Recorded IO (see i8080_record_start)
+enum event_kind {EVENT_IN = 1, EVENT_OUT, EVENT_INTERRUPT};
+
+struct event {
+  enum event_kind kind;
+  unsigned long long cyc;
+  // Port and value for IN and OUT, opcode in port for interrupts
+  uint port;
+  uint value;
+};
+
+struct i8080_recording {
+  FILE *file;
+  int replaying;
+  // Cycle count of the last event written or read
+  unsigned long long cyc;
+
+  // Next event to replay, if replay hasn't ended
+  struct event next;
+  int have_next;
+
+  // errno value for i8080_recording_stop, if anything went wrong
+  int error;
+};
+
+// Reverse execution (see i8080_journal_enable)
+// Every instruction run gets an entry holding the registers from before it.
+// It owns the old contents of every byte stored to until the next entry.
+#define JOURNAL_CHECKPOINTS 16
+
+struct journal_entry {
+  unsigned long long cyc;
+  uint16_t SP;
+  uint16_t PC;
+  // A, B, C, D, E, H, L and flags
+  uint8_t regs[8];
+  // INTE, halted and pending_interrupt
+  uint8_t state;
+  uint8_t interrupt_opcode;
+  uint32_t num_writes;
+};
+
+struct journal_write {
+  uint32_t addr;
+  uint8_t old;
+};
+
+// Snapshot taken just before an instruction, to jump back to without undoing
+// everything after it
+struct journal_checkpoint {
+  struct i8080_snapshot snapshot;
+  unsigned long long insn;
+};
+
+struct i8080_journal {
+  // Ring buffers of entries and writes, oldest first
+  struct journal_entry *entries;
+  size_t max_entries;
+  size_t first_entry;
+  size_t num_entries;
+
+  struct journal_write *writes;
+  size_t max_writes;
+  size_t first_write;
+  size_t num_writes;
+
+  // Number of the next instruction, counting from when journaling started
+  unsigned long long insns;
+
+  unsigned long checkpoint_interval;
+  struct journal_checkpoint checkpoints[JOURNAL_CHECKPOINTS];
+  uint num_checkpoints;
+};
+
+// Timed events (see i8080_schedule_event)
+struct scheduled_event {
+  unsigned long long cyc;
+  // Breaks ties between events due at the same cycle, first come first served
+  unsigned long long seq;
+  i8080_event_handler handler;
+  void *data;
+};
+
+struct i8080_scheduler {
+  // Binary min-heap ordered by cyc, then seq
+  struct scheduled_event *events;
+  size_t num_events;
+  size_t max_events;
+  unsigned long long next_seq;
+};
+
+ALWAYS_INLINE static void code_written(struct i8080 *cpu, uint addr) {
+  if (addr >= 0x10000) {
+    return;
+  }
+
+  if (cpu->block_cache != NULL && cpu->block_cache->index.covered[addr]) {
+    index_invalidate(&cpu->block_cache->index, addr);
+  }
+#ifdef I8080_JIT
+  if (cpu->jit != NULL && cpu->jit->index.covered[addr]) {
+    index_invalidate(&cpu->jit->index, addr);
+  }
+#endif
+}
+
+ALWAYS_INLINE static void memory_written(struct i8080 *cpu, uint addr) {
+  struct i8080_dirty_pages *tracker = cpu->dirty_pages;
+
+  if (tracker != NULL && addr / I8080_PAGE_SIZE < tracker->num_pages) {
+    tracker->dirty[addr / I8080_PAGE_SIZE] = 1;
+  }
+
+  code_written(cpu, addr);
+}
+
+// S, Z and P flag bits for a result byte (indices 0x000 - 0x0FF), followed by
+// the same bits passed through verbatim for flags loaded from outside (indices
+// 0x100 - 0x1FF, see unpack_flags)
+static const uint8_t szp_table[512] = {
+  0x44, 0x00, 0x00, 0x04, 0x00, 0x04, 0x04, 0x00,
+  0x00, 0x04, 0x04, 0x00, 0x04, 0x00, 0x00, 0x04,
+  0x00, 0x04, 0x04, 0x00, 0x04, 0x00, 0x00, 0x04,
+  0x04, 0x00, 0x00, 0x04, 0x00, 0x04, 0x04, 0x00,
+  0x00, 0x04, 0x04, 0x00, 0x04, 0x00, 0x00, 0x04,
+  0x04, 0x00, 0x00, 0x04, 0x00, 0x04, 0x04, 0x00,
+  0x04, 0x00, 0x00, 0x04, 0x00, 0x04, 0x04, 0x00,
+  0x00, 0x04, 0x04, 0x00, 0x04, 0x00, 0x00, 0x04,
+  0x00, 0x04, 0x04, 0x00, 0x04, 0x00, 0x00, 0x04,
+  0x04, 0x00, 0x00, 0x04, 0x00, 0x04, 0x04, 0x00,
+  0x04, 0x00, 0x00, 0x04, 0x00, 0x04, 0x04, 0x00,
+  0x00, 0x04, 0x04, 0x00, 0x04, 0x00, 0x00, 0x04,
+  0x04, 0x00, 0x00, 0x04, 0x00, 0x04, 0x04, 0x00,
+  0x00, 0x04, 0x04, 0x00, 0x04, 0x00, 0x00, 0x04,
+  0x00, 0x04, 0x04, 0x00, 0x04, 0x00, 0x00, 0x04,
+  0x04, 0x00, 0x00, 0x04, 0x00, 0x04, 0x04, 0x00,
+  0x80, 0x84, 0x84, 0x80, 0x84, 0x80, 0x80, 0x84,
+  0x84, 0x80, 0x80, 0x84, 0x80, 0x84, 0x84, 0x80,
+  0x84, 0x80, 0x80, 0x84, 0x80, 0x84, 0x84, 0x80,
+  0x80, 0x84, 0x84, 0x80, 0x84, 0x80, 0x80, 0x84,
+  0x84, 0x80, 0x80, 0x84, 0x80, 0x84, 0x84, 0x80,
+  0x80, 0x84, 0x84, 0x80, 0x84, 0x80, 0x80, 0x84,
+  0x80, 0x84, 0x84, 0x80, 0x84, 0x80, 0x80, 0x84,
+  0x84, 0x80, 0x80, 0x84, 0x80, 0x84, 0x84, 0x80,
+  0x84, 0x80, 0x80, 0x84, 0x80, 0x84, 0x84, 0x80,
+  0x80, 0x84, 0x84, 0x80, 0x84, 0x80, 0x80, 0x84,
+  0x80, 0x84, 0x84, 0x80, 0x84, 0x80, 0x80, 0x84,
+  0x84, 0x80, 0x80, 0x84, 0x80, 0x84, 0x84, 0x80,
+  0x80, 0x84, 0x84, 0x80, 0x84, 0x80, 0x80, 0x84,
+  0x84, 0x80, 0x80, 0x84, 0x80, 0x84, 0x84, 0x80,
+  0x84, 0x80, 0x80, 0x84, 0x80, 0x84, 0x84, 0x80,
+  0x80, 0x84, 0x84, 0x80, 0x84, 0x80, 0x80, 0x84,
+  0x00, 0x00, 0x00, 0x00, 0x04, 0x04, 0x04, 0x04,
+  0x00, 0x00, 0x00, 0x00, 0x04, 0x04, 0x04, 0x04,
+  0x00, 0x00, 0x00, 0x00, 0x04, 0x04, 0x04, 0x04,
+  0x00, 0x00, 0x00, 0x00, 0x04, 0x04, 0x04, 0x04,
+  0x00, 0x00, 0x00, 0x00, 0x04, 0x04, 0x04, 0x04,
+  0x00, 0x00, 0x00, 0x00, 0x04, 0x04, 0x04, 0x04,
+  0x00, 0x00, 0x00, 0x00, 0x04, 0x04, 0x04, 0x04,
+  0x00, 0x00, 0x00, 0x00, 0x04, 0x04, 0x04, 0x04,
+  0x40, 0x40, 0x40, 0x40, 0x44, 0x44, 0x44, 0x44,
+  0x40, 0x40, 0x40, 0x40, 0x44, 0x44, 0x44, 0x44,
+  0x40, 0x40, 0x40, 0x40, 0x44, 0x44, 0x44, 0x44,
+  0x40, 0x40, 0x40, 0x40, 0x44, 0x44, 0x44, 0x44,
+  0x40, 0x40, 0x40, 0x40, 0x44, 0x44, 0x44, 0x44,
+  0x40, 0x40, 0x40, 0x40, 0x44, 0x44, 0x44, 0x44,
+  0x40, 0x40, 0x40, 0x40, 0x44, 0x44, 0x44, 0x44,
+  0x40, 0x40, 0x40, 0x40, 0x44, 0x44, 0x44, 0x44,
+  0x80, 0x80, 0x80, 0x80, 0x84, 0x84, 0x84, 0x84,
+  0x80, 0x80, 0x80, 0x80, 0x84, 0x84, 0x84, 0x84,
+  0x80, 0x80, 0x80, 0x80, 0x84, 0x84, 0x84, 0x84,
+  0x80, 0x80, 0x80, 0x80, 0x84, 0x84, 0x84, 0x84,
+  0x80, 0x80, 0x80, 0x80, 0x84, 0x84, 0x84, 0x84,
+  0x80, 0x80, 0x80, 0x80, 0x84, 0x84, 0x84, 0x84,
+  0x80, 0x80, 0x80, 0x80, 0x84, 0x84, 0x84, 0x84,
+  0x80, 0x80, 0x80, 0x80, 0x84, 0x84, 0x84, 0x84,
+  0xC0, 0xC0, 0xC0, 0xC0, 0xC4, 0xC4, 0xC4, 0xC4,
+  0xC0, 0xC0, 0xC0, 0xC0, 0xC4, 0xC4, 0xC4, 0xC4,
+  0xC0, 0xC0, 0xC0, 0xC0, 0xC4, 0xC4, 0xC4, 0xC4,
+  0xC0, 0xC0, 0xC0, 0xC0, 0xC4, 0xC4, 0xC4, 0xC4,
+  0xC0, 0xC0, 0xC0, 0xC0, 0xC4, 0xC4, 0xC4, 0xC4,
+  0xC0, 0xC0, 0xC0, 0xC0, 0xC4, 0xC4, 0xC4, 0xC4,
+  0xC0, 0xC0, 0xC0, 0xC0, 0xC4, 0xC4, 0xC4, 0xC4,
+  0xC0, 0xC0, 0xC0, 0xC0, 0xC4, 0xC4, 0xC4, 0xC4
 };
 
 // External API
+// Doesn't look at the old contents of the struct, which may be uninitialized,
+// so anything allocated for it must have been released by the matching disable
+// calls beforehand
 void i8080_reset(struct i8080 *cpu) {
   cpu->A = 0;
   cpu->B = 0;
@@ -35,20 +387,40 @@ void i8080_reset(struct i8080 *cpu) {
   cpu->PC = 0;
   cpu->SP = 0;
   cpu->flags = 2;
+  cpu->flags_lazy = 0;
 
   cpu->INTE = 0;
   cpu->halted = 0;
 
   cpu->cyc = 0;
+  cpu->clock_hz = I8080_CLOCK_HZ;
 
   cpu->input_handler = NULL;
   cpu->output_handler = NULL;
+  cpu->ports = NULL;
+
+  cpu->traps = NULL;
+  cpu->trap_handler = NULL;
+  cpu->trap_ctx = NULL;
+
+  cpu->memory_64k = 0;
+  cpu->pages = NULL;
+  cpu->block_cache = NULL;
+  cpu->jit = NULL;
+  cpu->dirty_pages = NULL;
+  cpu->recording = NULL;
+  cpu->journal = NULL;
+  cpu->scheduler = NULL;
 
   cpu->pending_interrupt = 0;
   cpu->interrupt_opcode = 0;
+  cpu->mailbox = 0;
+
+  cpu->in_pending = 0;
+  cpu->in_port = 0;
 }
 
-void i8080_request_interrupt(struct i8080 *cpu, uint opcode) {
+static void request_interrupt(struct i8080 *cpu, uint opcode) {
   cpu->halted = 0;
   if (cpu->INTE) {
     cpu->INTE = 0;
@@ -57,1195 +429,4485 @@ void i8080_request_interrupt(struct i8080 *cpu, uint opcode) {
   }
 }
 
-void i8080_load_memory(struct i8080 *cpu, char *path, size_t offset) {
-  FILE *file = fopen(path, "r");
-  if (file == NULL) {
-    perror("fopen");
-    exit(1);
-  }
-
-  for (int i=0;i<cpu->memsize;i++) {
-    size_t res = fread(cpu->memory+(offset+i), sizeof(char), 1, file);
+static void record_event(struct i8080 *cpu, enum event_kind kind, uint port,
+                         uint value);
+static void journal_clear(struct i8080 *cpu);
 
-    if (res == 0) break;
-  };
+void i8080_request_interrupt(struct i8080 *cpu, uint opcode) {
+  if (cpu->recording != NULL) {
+    // While replaying, interrupts come from the log instead
+    if (cpu->recording->have_next) {
+      return;
+    }
+    record_event(cpu, EVENT_INTERRUPT, opcode & 0xFF, 0);
+  }
 
-  fclose(file);
+  request_interrupt(cpu, opcode);
 }
 
-uint i8080_read_byte(struct i8080 *cpu, uint addr) {
-  if (addr >= cpu->memsize) {
-    return '\0';
-  }
+// Interrupt mailbox
+// Other threads post interrupts into mailbox as MAILBOX_FULL | opcode, and
+// the CPU thread takes them out at instruction boundaries. Posting is a
+// release and taking an acquire, so whatever the posting thread wrote before
+// is visible to the CPU thread once the interrupt is taken. The CPU thread
+// only peeks with a relaxed load until there is something to take.
+#define MAILBOX_FULL 0x100
+
+#ifdef __GNUC__
+static ALWAYS_INLINE uint mailbox_peek(struct i8080 *cpu) {
+  return __atomic_load_n(&cpu->mailbox, __ATOMIC_RELAXED);
+}
 
-  return cpu->memory[addr] & 0xFF;
+static inline uint mailbox_take(struct i8080 *cpu) {
+  return __atomic_exchange_n(&cpu->mailbox, 0, __ATOMIC_ACQUIRE);
 }
 
-uint i8080_read_word(struct i8080 *cpu, uint addr) {
-  int hi = cpu->memory[addr+1] & 0xFF;
-  int lo = cpu->memory[addr] & 0xFF;
+static inline int mailbox_put(struct i8080 *cpu, uint val) {
+  uint empty = 0;
+  return __atomic_compare_exchange_n(&cpu->mailbox, &empty, val, 0,
+                                     __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+}
+#else
+// Without atomics, posting is only safe from the CPU's own thread
+static inline uint mailbox_peek(struct i8080 *cpu) {
+  return cpu->mailbox;
+}
 
-  return (hi << 8) | lo;
+static inline uint mailbox_take(struct i8080 *cpu) {
+  uint val = cpu->mailbox;
+  cpu->mailbox = 0;
+  return val;
 }
 
-void i8080_write_byte(struct i8080 *cpu, uint addr, uint data) {
-  if (addr < cpu->memsize) {
-    cpu->memory[addr] = (char) data;
+static inline int mailbox_put(struct i8080 *cpu, uint val) {
+  if (cpu->mailbox != 0) {
+    return 0;
   }
+  cpu->mailbox = val;
+  return 1;
 }
+#endif
 
-void i8080_write_word(struct i8080 *cpu, uint addr, uint data) {
-  char hi = (data >> 8) & 0xFF;
-  char lo = data & 0xFF;
-
-  cpu->memory[addr] = lo;
-  cpu->memory[addr+1] = hi;
+// Requests the posted interrupt, if any, as if by i8080_request_interrupt
+static NOINLINE void take_posted_interrupt(struct i8080 *cpu) {
+  uint val = mailbox_take(cpu);
+  if (val & MAILBOX_FULL) {
+    i8080_request_interrupt(cpu, val & 0xFF);
+  }
 }
 
-uint get_flag_mask(enum i8080_flag flag);
-void i8080_set_flag(struct i8080 *cpu, enum i8080_flag flag, int val) {
-  uint mask = get_flag_mask(flag);
-
-  if (val) {
-    cpu->flags = (cpu->flags | mask) & 0xFF;
-  } else {
-    cpu->flags = (cpu->flags & ~mask) & 0xFF;
+int i8080_post_interrupt(struct i8080 *cpu, uint opcode) {
+  // Like the INT line, held by the first device until the CPU takes it
+  if (!mailbox_put(cpu, MAILBOX_FULL | (opcode & 0xFF))) {
+    errno = EBUSY;
+    return -1;
   }
-}
 
-int i8080_get_flag(struct i8080 *cpu, enum i8080_flag flag) {
-  uint mask = get_flag_mask(flag);
-  return (cpu->flags & mask) != 0;
+  return 0;
 }
 
-void i8080_push_stackb(struct i8080 *cpu, uint val) {
-  cpu->SP = (cpu->SP-1) & 0XFFFF;
-  i8080_write_byte(cpu, cpu->SP, val & 0xFF);
+int i8080_interrupt_posted(struct i8080 *cpu) {
+  return mailbox_peek(cpu) != 0;
 }
 
-void i8080_push_stackw(struct i8080 *cpu, uint val) {
-  i8080_push_stackb(cpu, (val & 0xFF00) >> 8);
-  i8080_push_stackb(cpu, val & 0xFF);
-}
+long i8080_load_memory(struct i8080 *cpu, char *path, size_t offset) {
+  if (offset > cpu->memsize) {
+    errno = EINVAL;
+    return -1;
+  }
 
-uint i8080_pop_stackb(struct i8080 *cpu) {
-  uint byte = i8080_read_byte(cpu, cpu->SP);
-  cpu->SP = (cpu->SP + 1) & 0xFFFF;
-  return byte;
-}
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) {
+    return -1;
+  }
 
-uint i8080_pop_stackw(struct i8080 *cpu) {
-  uint lo = i8080_pop_stackb(cpu);
-  uint hi = i8080_pop_stackb(cpu);
+  // Read as much of the file as fits in one go
+  size_t loaded = fread(cpu->memory + offset, 1, cpu->memsize - offset, file);
+  int failed = ferror(file);
 
-  return CONCAT(hi, lo);
-}
+  fclose(file);
 
-// Internal logic
-uint get_flag_mask(enum i8080_flag flag) {
-  switch (flag) {
-    case FLAG_S: return 0x80;
-    case FLAG_Z: return 0x40;
-    case FLAG_A: return 0x10;
-    case FLAG_P: return 0x04;
-    case FLAG_C: return 0x01;
-    default:
-      fprintf(stderr, "Invalid flag %d", flag);
-      exit(1);
+  // Snapshots can't share the pages loaded into with earlier ones
+  struct i8080_dirty_pages *tracker = cpu->dirty_pages;
+  if (tracker != NULL && loaded > 0) {
+    size_t last = (offset + loaded - 1) / I8080_PAGE_SIZE;
+    for (size_t page=offset / I8080_PAGE_SIZE;
+         page <= last && page < tracker->num_pages;page++) {
+      tracker->dirty[page] = 1;
+    }
   }
-}
 
-int check_condition(struct i8080 *cpu, uint condition) {
-  switch (condition) {
-    case 0: return !i8080_get_flag(cpu, FLAG_Z); // No zero
-    case 1: return i8080_get_flag(cpu, FLAG_Z); // Zero
-    case 2: return !i8080_get_flag(cpu, FLAG_C); // No carry
-    case 3: return i8080_get_flag(cpu, FLAG_C); // Carry
-    case 4: return !i8080_get_flag(cpu, FLAG_P); // Parity odd
-    case 5: return i8080_get_flag(cpu, FLAG_P); // Parity even
-    case 6: return !i8080_get_flag(cpu, FLAG_S); // Positive
-    case 7: return i8080_get_flag(cpu, FLAG_S); // Negative
-    default:
-      fprintf(stderr, "Invalid condition code %d", condition);
-      exit(1);
+  // Whatever was decoded from the old contents is stale now, and can't be
+  // undone
+  i8080_block_cache_flush(cpu);
+  i8080_jit_flush(cpu);
+  journal_clear(cpu);
+
+  if (failed) {
+    errno = EIO;
+    return -1;
   }
+
+  return (long) loaded;
 }
 
-void set_reg(struct i8080 *cpu, uint reg, uint val) {
-  val &= 0xFF;
+#ifdef I8080_HAVE_MMAP
+int i8080_open_image(struct i8080_image *image, const char *path) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return -1;
+  }
 
-  switch (reg) {
-    case 7: cpu->A = val;
-      break;
-    case 0: cpu->B = val;
-      break;
-    case 1: cpu->C = val;
-      break;
-    case 2: cpu->D = val;
-      break;
-    case 3: cpu->E = val;
-      break;
-    case 4: cpu->H = val;
-      break;
-    case 5: cpu->L = val;
-      break;
-    case 6: i8080_write_byte(cpu, CONCAT(cpu->H, cpu->L), val);
-      break;
-    default:
-      fprintf(stderr, "Invalid register %d\n", reg);
-      exit(1);
+  struct stat st;
+  if (fstat(fd, &st) < 0) {
+    close(fd);
+    return -1;
   }
-}
 
-uint get_reg(struct i8080 *cpu, uint reg) {
-  switch (reg) {
-    case 7: return cpu->A;
-    case 0: return cpu->B;
-    case 1: return cpu->C;
-    case 2: return cpu->D;
-    case 3: return cpu->E;
-    case 4: return cpu->H;
-    case 5: return cpu->L;
-    case 6: return i8080_read_byte(cpu, CONCAT(cpu->H, cpu->L));
-    default:
-      fprintf(stderr, "Invalid register %d\n", reg);
-      exit(1);
+  image->data = NULL;
+  image->size = (size_t) st.st_size;
+  image->mapped = 0;
+
+  if (image->size > 0) {
+    // Private, read only mappings of the same file share page cache pages, so
+    // opening an image is cheap no matter how many CPUs end up using it
+    void *data = mmap(NULL, image->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      close(fd);
+      return -1;
+    }
+
+    image->data = data;
+    image->mapped = 1;
   }
+
+  close(fd);
+  return 0;
 }
 
-uint get_reg_pair(struct i8080 *cpu, uint reg_pair) {
-  switch (reg_pair) {
-    case 0: return CONCAT(cpu->B, cpu->C);
-    case 1: return CONCAT(cpu->D, cpu->E);
-    case 2: return CONCAT(cpu->H, cpu->L);
-    case 3: return cpu->SP;
-    default:
-      fprintf(stderr, "Invalid register pair %d\n", reg_pair);
-      exit(1);
+void i8080_close_image(struct i8080_image *image) {
+  if (image->mapped) {
+    munmap(image->data, image->size);
+  } else {
+    free(image->data);
   }
-}
 
-void set_reg_pair(struct i8080 *cpu, uint reg_pair, uint val) {
-  uint hi = (val >> 8) & 0xFF;
-  uint lo = val & 0xFF;
+  image->data = NULL;
+  image->size = 0;
+  image->mapped = 0;
+}
+#else
+int i8080_open_image(struct i8080_image *image, const char *path) {
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) {
+    return -1;
+  }
 
-  switch (reg_pair) {
-    case 0:
-      cpu->B = hi;
-      cpu->C = lo;
-      break;
-    case 1:
-      cpu->D = hi;
-      cpu->E = lo;
-      break;
-    case 2:
-      cpu->H = hi;
-      cpu->L = lo;
-      break;
-    case 3:
-      cpu->SP = CONCAT(hi, lo);
-      break;
-    default:
-      fprintf(stderr, "Invalid register pair %d\n", reg_pair);
-      exit(1);
+  if (fseek(file, 0, SEEK_END) != 0) {
+    fclose(file);
+    return -1;
   }
-}
 
-void setSZP(struct i8080 *cpu, uint val) {
-  val &= 0xFF;
+  long size = ftell(file);
+  if (size < 0) {
+    fclose(file);
+    return -1;
+  }
+  rewind(file);
+
+  // Round up to a whole page so that i8080_map_image never maps past the end
+  // of the buffer
+  size_t alloc = ((size_t) size + I8080_PAGE_SIZE - 1)
+                 & ~(size_t) (I8080_PAGE_SIZE - 1);
+
+  image->data = calloc(alloc > 0 ? alloc : 1, 1);
+  image->size = (size_t) size;
+  image->mapped = 0;
+
+  if (image->data == NULL || fread(image->data, 1, image->size, file) != image->size) {
+    free(image->data);
+    image->data = NULL;
+    fclose(file);
+    return -1;
+  }
 
-  i8080_set_flag(cpu, FLAG_S, val & 0x80);
-  i8080_set_flag(cpu, FLAG_Z, val == 0);
-  i8080_set_flag(cpu, FLAG_P, parity_table[val]);
+  fclose(file);
+  return 0;
 }
 
-uint next_byte(struct i8080 *cpu) {
-  return i8080_read_byte(cpu, cpu->PC++);
-}
+void i8080_close_image(struct i8080_image *image) {
+  free(image->data);
 
-uint next_word(struct i8080 *cpu) {
-  uint word  = i8080_read_word(cpu, cpu->PC);
-  cpu->PC += 2;
-  return word;
+  image->data = NULL;
+  image->size = 0;
 }
+#endif
 
-uint next_instruction_opcode(struct i8080 *cpu) {
-  if (cpu->pending_interrupt) {
-    return cpu->interrupt_opcode;
-  } else {
-    return next_byte(cpu);
+int i8080_map_image(struct i8080 *cpu, uint addr, struct i8080_image *image) {
+  if (cpu->pages == NULL || (addr % I8080_PAGE_SIZE) != 0) {
+    errno = EINVAL;
+    return -1;
   }
-}
 
-uint perform_sub(struct i8080 *cpu, uint minu, uint subt, int borrow) {
-  uint subt_ones = (~subt) & 0xFF;
+  // The last page may be partially backed by the file. The rest of it reads
+  // as zero, since both mmap and the fallback loader zero fill up to the next
+  // page boundary.
+  size_t size = (image->size + I8080_PAGE_SIZE - 1) & ~(size_t) (I8080_PAGE_SIZE - 1);
+  i8080_map_rom(cpu, addr, size, image->data);
 
-  // Minuend plus ones complement of subtrahend with a carry input
-  // Note that if there is a borrow, we negate the carry in (for forming the
-  // 2's complement) as the borrow will cancel it out
-  uint res16 = minu + subt_ones + (borrow ? 0 : 1);
-  uint res8 = res16 & 0xFF;
+  return 0;
+}
 
-  i8080_set_flag(cpu, FLAG_C, !(res16 & 0x100));
-  i8080_set_flag(cpu, FLAG_A, ((minu & 0xF) + (subt_ones & 0xF) + (borrow ? 0 : 1)) & 0x10);
-  setSZP(cpu, res8);
+void i8080_bus_init(struct i8080 *cpu, struct i8080_page *pages) {
+  for (int i=0;i<I8080_NUM_PAGES;i++) {
+    pages[i].read = NULL;
+    pages[i].write = NULL;
+    pages[i].read_handler = NULL;
+    pages[i].write_handler = NULL;
+    pages[i].ctx = NULL;
+  }
 
-  return res8;
+  cpu->pages = pages;
 }
 
-uint perform_add(struct i8080 *cpu, uint a, uint b, int carry) {
-  uint carry_val = carry ? 1 : 0;
-
-  uint res16 = a + b + carry_val;
-  uint res8 = res16 & 0xFF;
+static void map_pages(struct i8080 *cpu, uint addr, size_t size,
+                      char *read, char *write,
+                      i8080_read_handler read_handler,
+                      i8080_write_handler write_handler, void *ctx) {
+  uint first = (addr >> 8) & 0xFF;
+  size_t count = size / I8080_PAGE_SIZE;
+
+  for (size_t i=0;i<count && first+i<I8080_NUM_PAGES;i++) {
+    struct i8080_page *page = &cpu->pages[first+i];
+    size_t offset = i * I8080_PAGE_SIZE;
+
+    page->read = read != NULL ? read + offset : NULL;
+    page->write = write != NULL ? write + offset : NULL;
+    page->read_handler = read_handler;
+    page->write_handler = write_handler;
+    page->ctx = ctx;
+  }
+}
 
-  i8080_set_flag(cpu, FLAG_C, res16 & 0x100);
-  i8080_set_flag(cpu, FLAG_A, (((a & 0xF) + (b & 0xF) + carry_val) & 0x10));
-  setSZP(cpu, res8);
+void i8080_map_ram(struct i8080 *cpu, uint addr, size_t size, char *mem) {
+  map_pages(cpu, addr, size, mem, mem, NULL, NULL, NULL);
+}
 
-  return res8;
+void i8080_map_rom(struct i8080 *cpu, uint addr, size_t size, char *mem) {
+  map_pages(cpu, addr, size, mem, NULL, NULL, NULL, NULL);
 }
 
-// Instructions follow
-// HLT - Halt
-void hlt(struct i8080 *cpu) {
-  cpu->cyc += 7;
-  cpu->halted = 1;
+void i8080_map_io(struct i8080 *cpu, uint addr, size_t size,
+                  i8080_read_handler read_handler,
+                  i8080_write_handler write_handler, void *ctx) {
+  map_pages(cpu, addr, size, NULL, NULL, read_handler, write_handler, ctx);
 }
 
-// NOP - No Operation
-void nop(struct i8080 *cpu) {
-  cpu->cyc += 4;
+void i8080_ports_init(struct i8080 *cpu, struct i8080_port *ports) {
+  for (int i=0;i<I8080_NUM_PORTS;i++) {
+    ports[i].in = NULL;
+    ports[i].out = NULL;
+    ports[i].ctx = NULL;
+    ports[i].latch = 0;
+    ports[i].mapped = 0;
+  }
+
+  cpu->ports = ports;
 }
 
-// MOV - Move
-void mov(struct i8080 *cpu, uint opcode) {
-  uint dst = (opcode & 0x38) >> 3;
-  uint src = opcode & 0x07;
-  cpu->cyc += (dst == 6 || src == 6) ? 7 : 5;
+void i8080_map_port(struct i8080 *cpu, uint port, i8080_read_handler in,
+                    i8080_write_handler out, void *ctx) {
+  struct i8080_port *entry = &cpu->ports[port & 0xFF];
 
-  set_reg(cpu, dst, get_reg(cpu, src));
+  entry->in = in;
+  entry->out = out;
+  entry->ctx = ctx;
+  entry->mapped = 1;
 }
 
-// MVI - Move Immediate
-void mvi(struct i8080 *cpu, uint opcode) {
-  uint reg = (opcode & 0x38) >> 3;
-  cpu->cyc += (reg == 6) ? 10 : 7;
-  set_reg(cpu, reg, next_byte(cpu));
+void i8080_latch_port(struct i8080 *cpu, uint port, uint val) {
+  i8080_map_port(cpu, port, NULL, NULL, NULL);
+  cpu->ports[port & 0xFF].latch = val & 0xFF;
 }
 
-// STA - Store Accumulator Direct
-void sta(struct i8080 *cpu) {
-  cpu->cyc += 13;
-  i8080_write_byte(cpu, next_word(cpu), cpu->A);
+// PC traps
+// A bitmap with a bit per address, checked whenever control is transferred
+// rather than on every instruction, so hooks on entry points like BDOS cost
+// nothing in straight line code.
+void i8080_traps_init(struct i8080 *cpu, uint8_t *traps,
+                      i8080_trap_handler handler, void *ctx) {
+  memset(traps, 0, I8080_TRAP_BYTES);
+
+  cpu->traps = traps;
+  cpu->trap_handler = handler;
+  cpu->trap_ctx = ctx;
 }
 
-// LDA - Load Accumulator Direct
-void lda(struct i8080 *cpu) {
-  cpu->cyc += 13;
-  cpu->A = i8080_read_byte(cpu, next_word(cpu));
+void i8080_set_trap(struct i8080 *cpu, uint addr) {
+  addr &= 0xFFFF;
+  cpu->traps[addr >> 3] |= (uint8_t) (1 << (addr & 7));
 }
 
-// LXI - Load Register Pair Immediate
-void lxi(struct i8080 *cpu, uint opcode) {
-  cpu->cyc += 10;
-  uint reg_pair = (opcode & 0x30) >> 4;
-  set_reg_pair(cpu, reg_pair, next_word(cpu));
+void i8080_clear_trap(struct i8080 *cpu, uint addr) {
+  addr &= 0xFFFF;
+  cpu->traps[addr >> 3] &= (uint8_t) ~(1 << (addr & 7));
 }
 
-// STAX - Store Accumulator
-void stax(struct i8080 *cpu, uint opcode) {
-  cpu->cyc += 7;
-  uint reg_pair = (opcode & 0x30) >> 4;
-  i8080_write_byte(cpu, get_reg_pair(cpu, reg_pair), cpu->A);
+static void begin_lazy_flags(struct i8080 *cpu);
+static void end_lazy_flags(struct i8080 *cpu);
+
+NOINLINE static int take_trap(struct i8080 *cpu) {
+  // Handlers see (and may change) an up to date flags register
+  end_lazy_flags(cpu);
+  cpu->trap_handler(cpu, cpu->trap_ctx, cpu->PC);
+  begin_lazy_flags(cpu);
+  return cpu->halted;
 }
 
-// LDAX - Load Accumulator
-void ldax(struct i8080 *cpu, uint opcode) {
-  cpu->cyc += 7;
-  uint reg_pair = (opcode & 0x30) >> 4;
-  cpu->A = i8080_read_byte(cpu, get_reg_pair(cpu, reg_pair));
+// Runs the handler if PC has just landed on a trap, before the instruction
+// there. Returns nonzero if the handler halted the CPU to end the run.
+ALWAYS_INLINE static int check_trap(struct i8080 *cpu) {
+  if (cpu->traps == NULL ||
+      !(cpu->traps[cpu->PC >> 3] & (1 << (cpu->PC & 7)))) {
+    return 0;
+  }
+
+  return take_trap(cpu);
 }
 
-// INR - Increment Register or Memory
-void inr(struct i8080 *cpu, uint opcode) {
-  uint reg = (opcode & 0x38) >> 3;
-  cpu->cyc += (reg == 6) ? 10 : 5;
+// 64K memory
+// A buffer covering the whole address space lets every access be masked to
+// 16 bits instead of checked against memsize, and makes words at 0xFFFF wrap
+// around to 0x0000 like on the real chip.
+int i8080_memory_64k_enable(struct i8080 *cpu) {
+  if (cpu->memory_64k) {
+    return 0;
+  }
+
+  char *memory = calloc(1, 0x10000);
+  if (memory == NULL) {
+    return -1;
+  }
 
-  i8080_set_flag(cpu, FLAG_A, (get_reg(cpu, reg) & 0x0F) == 0x0F);
-  set_reg(cpu, reg, get_reg(cpu, reg)+1);
-  setSZP(cpu, get_reg(cpu, reg));
+  cpu->memory = memory;
+  cpu->memsize = 0x10000;
+  cpu->memory_64k = 1;
+
+  return 0;
 }
 
-// DCR - Decrement Register or Memory
-void dcr(struct i8080 *cpu, uint opcode) {
-  uint reg = (opcode & 0x38) >> 3;
-  cpu->cyc += (reg == 6) ? 10 : 5;
+void i8080_memory_64k_disable(struct i8080 *cpu) {
+  if (!cpu->memory_64k) {
+    return;
+  }
 
-  i8080_set_flag(cpu, FLAG_A, !(get_reg(cpu, reg) & 0x0F) == 0);
-  set_reg(cpu, reg, get_reg(cpu, reg)-1);
-  setSZP(cpu, get_reg(cpu, reg));
+  free(cpu->memory);
+  cpu->memory = NULL;
+  cpu->memsize = 0;
+  cpu->memory_64k = 0;
 }
 
-// INX - Increment Register Pair
-void inx(struct i8080 *cpu, uint opcode) {
-  cpu->cyc += 5;
-  uint reg = (opcode & 0x30) >> 4;
-  set_reg_pair(cpu, reg, get_reg_pair(cpu, reg)+1);
+// Memory accesses
+// The interpreter cores go through these rather than the public
+// i8080_read_byte etc. so that flat memory accesses are always inlined into
+// them, while page table lookups stay out of line.
+NOINLINE static uint read_paged(struct i8080 *cpu, uint addr) {
+  struct i8080_page *page = &cpu->pages[(addr >> 8) & 0xFF];
+
+  if (page->read != NULL) {
+    return page->read[addr & 0xFF] & 0xFF;
+  } else if (page->read_handler != NULL) {
+    return page->read_handler(cpu, page->ctx, addr & 0xFFFF) & 0xFF;
+  }
+
+  return 0;
 }
 
-// DCX - Decrement Register Pair
-void dcx(struct i8080 *cpu, uint opcode) {
-  cpu->cyc += 5;
-  uint reg = (opcode & 0x30) >> 4;
-  set_reg_pair(cpu, reg, get_reg_pair(cpu, reg)-1);
+NOINLINE static void write_paged(struct i8080 *cpu, uint addr, uint data) {
+  struct i8080_page *page = &cpu->pages[(addr >> 8) & 0xFF];
+
+  if (page->write != NULL) {
+    page->write[addr & 0xFF] = (char) data;
+  } else if (page->write_handler != NULL) {
+    page->write_handler(cpu, page->ctx, addr & 0xFFFF, data & 0xFF);
+  }
+
+  // Writes to ROM or unmapped pages are dropped
 }
 
-// DAA - Decimal Adjust Accumulator
-void daa(struct i8080 *cpu) {
-  cpu->cyc += 4;
-  uint add = 0;
+// mem64k is a constant everywhere in the interpreter, which has an instance
+// per memory mode (see execute), so each access there compiles down to either
+// a masked load or store or the checks below, never a test of the mode.
+// Everything else passes cpu->memory_64k.
+ALWAYS_INLINE static uint read_byte(struct i8080 *cpu, uint addr, int mem64k) {
+  if (mem64k) {
+    return (uint8_t) cpu->memory[addr & 0xFFFF];
+  }
 
-  if (((cpu->A & 0xF) > 9) || i8080_get_flag(cpu, FLAG_A)) {
-    add |= 0x06;
+  if (cpu->pages != NULL) {
+    return read_paged(cpu, addr);
   }
 
-  int carry = i8080_get_flag(cpu, FLAG_C);
-  /*
-   * If the upper nibble is greater than 9
-   * or the upper nibble will be greater than 9 when adding 6 to the lower nibble
-   * or the carry flag is set
-   */
-  if (((cpu->A & 0xF0) > 0x90) ||
-      (((cpu->A & 0xF0) >= 0x90) && ((cpu->A & 0xF) > 9)) ||
-      i8080_get_flag(cpu, FLAG_C)) {
-    add |= 0x60;
-    carry = 1;
+  if (addr >= cpu->memsize) {
+    return '\0';
   }
 
-  cpu->A = perform_add(cpu, cpu->A, add, 0);
-
-  // The carry bit is unaffected if there is no carry out of the upper nibble
-  i8080_set_flag(cpu, FLAG_C, carry);
+  return cpu->memory[addr] & 0xFF;
 }
 
-// ADD - Add Register or Memory to Accumulator
-void add(struct i8080 *cpu, uint opcode) {
-  uint reg = opcode & 0x7;
-  cpu->cyc += (reg == 6) ? 7 : 4;
-  cpu->A = perform_add(cpu, cpu->A, get_reg(cpu, reg), 0);
+ALWAYS_INLINE static uint read_word(struct i8080 *cpu, uint addr, int mem64k) {
+  return (read_byte(cpu, addr + 1, mem64k) << 8) | read_byte(cpu, addr, mem64k);
 }
 
-// ADC - Add Register or Memory to Accumulator With Carry
-void adc(struct i8080 *cpu, uint opcode) {
-  uint reg = opcode & 0x7;
-  cpu->cyc += (reg == 6) ? 7 : 4;
-  cpu->A = perform_add(cpu, cpu->A, get_reg(cpu, reg), i8080_get_flag(cpu, FLAG_C));
+NOINLINE static void journal_store(struct i8080 *cpu, uint addr);
+
+ALWAYS_INLINE static void write_byte(struct i8080 *cpu, uint addr, uint data,
+                                     int mem64k) {
+  if (mem64k) {
+    addr &= 0xFFFF;
+  } else if (cpu->pages != NULL) {
+    write_paged(cpu, addr, data);
+    return;
+  } else if (addr >= cpu->memsize) {
+    return;
+  }
+
+  if (cpu->journal != NULL) {
+    journal_store(cpu, addr);
+  }
+  cpu->memory[addr] = (char) data;
+  memory_written(cpu, addr);
 }
 
-// SBB - Subtract Register or Memory from Accumulator with Borrow
-void sbb(struct i8080 *cpu, uint opcode) {
-  uint reg = opcode & 0x7;
-  cpu->cyc += (reg == 6) ? 7 : 4;
-  cpu->A = perform_sub(cpu, cpu->A, get_reg(cpu, reg), i8080_get_flag(cpu, FLAG_C));
+ALWAYS_INLINE static void write_word(struct i8080 *cpu, uint addr, uint data,
+                                     int mem64k) {
+  write_byte(cpu, addr, data & 0xFF, mem64k);
+  write_byte(cpu, addr + 1, (data >> 8) & 0xFF, mem64k);
 }
 
-// SUB - Subtract Register or Memory from Accumulator
-void sub(struct i8080 *cpu, uint opcode) {
-  uint reg = opcode & 0x7;
-  cpu->cyc += (reg == 6) ? 7 : 4;
-  cpu->A = perform_sub(cpu, cpu->A, get_reg(cpu, reg), 0);
+ALWAYS_INLINE static void push_word(struct i8080 *cpu, uint val, int mem64k) {
+  cpu->SP = (cpu->SP - 1) & 0xFFFF;
+  write_byte(cpu, cpu->SP, (val >> 8) & 0xFF, mem64k);
+  cpu->SP = (cpu->SP - 1) & 0xFFFF;
+  write_byte(cpu, cpu->SP, val & 0xFF, mem64k);
 }
 
-// ANA - Logical and Memory or Register with Accumulator
-void ana(struct i8080 *cpu, uint opcode) {
-  uint reg = opcode & 0x07;
-  cpu->cyc += (reg == 6) ? 7 : 4;
-  i8080_set_flag(cpu, FLAG_A, (get_reg(cpu, reg) | cpu->A) & 0x08);
+ALWAYS_INLINE static uint pop_word(struct i8080 *cpu, int mem64k) {
+  uint lo = read_byte(cpu, cpu->SP, mem64k);
+  uint hi = read_byte(cpu, (cpu->SP + 1) & 0xFFFF, mem64k);
+  cpu->SP = (cpu->SP + 2) & 0xFFFF;
 
-  cpu->A &= get_reg(cpu, reg);
+  return CONCAT(hi, lo);
+}
 
-  i8080_set_flag(cpu, FLAG_C, 0);
-  setSZP(cpu, cpu->A);
+uint i8080_read_byte(struct i8080 *cpu, uint addr) {
+  return read_byte(cpu, addr, cpu->memory_64k);
 }
 
-// XRA - Logical Exclusive-Or Register or Memory With Accumulator
-void xra(struct i8080 *cpu, uint opcode) {
-  uint reg = opcode & 0x07;
-  cpu->cyc += (reg == 6) ? 7 : 4;
-  cpu->A ^= get_reg(cpu, reg);
+uint i8080_read_word(struct i8080 *cpu, uint addr) {
+  return read_word(cpu, addr, cpu->memory_64k);
+}
 
-  i8080_set_flag(cpu, FLAG_C, 0);
-  i8080_set_flag(cpu, FLAG_A, 0);
-  setSZP(cpu, cpu->A);
+void i8080_write_byte(struct i8080 *cpu, uint addr, uint data) {
+  write_byte(cpu, addr, data, cpu->memory_64k);
 }
 
-// ADI - Add Immediate to Accumulator
-void adi(struct i8080 *cpu) {
-  cpu->cyc += 7;
-  cpu->A = perform_add(cpu, cpu->A, next_byte(cpu), 0);
+void i8080_write_word(struct i8080 *cpu, uint addr, uint data) {
+  write_word(cpu, addr, data, cpu->memory_64k);
 }
 
-// SUI - Subtract Immediate From Accumulator
-void sui(struct i8080 *cpu) {
-  cpu->cyc += 7;
-  cpu->A = perform_sub(cpu, cpu->A, next_byte(cpu), 0);
+// Snapshots
+static size_t snapshot_num_pages(struct i8080 *cpu) {
+  return (cpu->memsize + I8080_PAGE_SIZE - 1) / I8080_PAGE_SIZE;
 }
 
-// ANI - Logical and Immediate With Accumulator
-void ani(struct i8080 *cpu) {
-  cpu->cyc += 7;
-  uint val = next_byte(cpu);
-  i8080_set_flag(cpu, FLAG_A, (val | cpu->A) & 0x08);
+static size_t page_bytes(struct i8080 *cpu, size_t page) {
+  size_t offset = page * I8080_PAGE_SIZE;
+  size_t left = cpu->memsize - offset;
 
-  cpu->A &= val;
+  return left < I8080_PAGE_SIZE ? left : I8080_PAGE_SIZE;
+}
+
+static void release_pages(struct i8080_snapshot_page **pages, size_t count) {
+  if (pages == NULL) {
+    return;
+  }
 
-  i8080_set_flag(cpu, FLAG_C, 0);
-  setSZP(cpu, cpu->A);
+  for (size_t i=0;i<count;i++) {
+    if (pages[i] != NULL && --pages[i]->refs == 0) {
+      free(pages[i]);
+    }
+  }
+  free(pages);
 }
 
-// ORI - Logical or Immediate With Accumulator
-void ori(struct i8080 *cpu) {
-  cpu->cyc += 7;
-  uint val = next_byte(cpu);
+// Base pages memory is known to match apart from dirty ones, or NULL if every
+// page has to be treated as dirty
+static struct i8080_snapshot_page **tracked_base(struct i8080 *cpu) {
+  struct i8080_dirty_pages *tracker = cpu->dirty_pages;
 
-  cpu->A |= val;
+  if (tracker == NULL || tracker->memory != cpu->memory ||
+      tracker->memsize != cpu->memsize) {
+    return NULL;
+  }
 
-  i8080_set_flag(cpu, FLAG_A, 0);
-  i8080_set_flag(cpu, FLAG_C, 0);
-  setSZP(cpu, cpu->A);
+  return tracker->base;
 }
 
-// ACI - Add Immediate to Accumulator With Carry
-void aci(struct i8080 *cpu) {
-  cpu->cyc += 7;
-  cpu->A = perform_add(cpu, cpu->A, next_byte(cpu), i8080_get_flag(cpu, FLAG_C));
-}
+// Makes pages the new base and starts tracking dirty pages afresh. The base
+// holds its own reference to each page.
+static int track_base(struct i8080 *cpu, struct i8080_snapshot_page **pages,
+                      size_t count) {
+  struct i8080_dirty_pages *tracker = cpu->dirty_pages;
 
-// SBI - Subtract Immediate from Accumulator With Borrow
-void sbi(struct i8080 *cpu) {
-  cpu->cyc += 7;
-  cpu->A = perform_sub(cpu, cpu->A, next_byte(cpu), i8080_get_flag(cpu, FLAG_C));
-}
+  if (tracker == NULL || tracker->memory != cpu->memory ||
+      tracker->memsize != cpu->memsize) {
+    return 0;
+  }
 
-// XRI - Logical Exclusive-Or Immediate With Accumulator
-void xri(struct i8080 *cpu) {
-  cpu->cyc += 7;
-  uint val = next_byte(cpu);
-  cpu->A ^= val;
+  if (tracker->base == NULL) {
+    tracker->base = calloc(count, sizeof(*tracker->base));
+    if (tracker->base == NULL) {
+      return -1;
+    }
+  }
 
-  i8080_set_flag(cpu, FLAG_C, 0);
-  i8080_set_flag(cpu, FLAG_A, 0);
-  setSZP(cpu, cpu->A);
-}
+  for (size_t i=0;i<count;i++) {
+    struct i8080_snapshot_page *old = tracker->base[i];
 
-// CPI - Compare Immediate With Accumulator
-void cpi(struct i8080 *cpu) {
-  cpu->cyc += 7;
-  perform_sub(cpu, cpu->A, next_byte(cpu), 0);
-}
+    if (old != pages[i]) {
+      pages[i]->refs++;
+      tracker->base[i] = pages[i];
+      if (old != NULL && --old->refs == 0) {
+        free(old);
+      }
+    }
+  }
+  memset(tracker->dirty, 0, tracker->num_pages);
 
-// CMP - Compare Memory or Register With Accumulator
-void cmp(struct i8080 *cpu, uint opcode) {
-  uint reg = opcode & 0x7;
-  cpu->cyc += (reg == 6) ? 7 : 4;
-  perform_sub(cpu, cpu->A, get_reg(cpu, reg), 0);
+  return 0;
 }
 
-// ORA - Logical or Memory or Register with Accumulator
-void ora(struct i8080 *cpu, uint opcode) {
-  uint reg = opcode & 0x07;
-  cpu->cyc += (reg == 6) ? 7 : 4;
-  cpu->A |= get_reg(cpu, reg);
+int i8080_snapshot_enable(struct i8080 *cpu) {
+  size_t num_pages = snapshot_num_pages(cpu);
+  struct i8080_dirty_pages *tracker =
+      calloc(1, sizeof(struct i8080_dirty_pages) + num_pages);
 
-  i8080_set_flag(cpu, FLAG_A, 0);
-  i8080_set_flag(cpu, FLAG_C, 0);
-  setSZP(cpu, cpu->A);
-}
+  if (tracker == NULL) {
+    return -1;
+  }
 
-// RLC - Rotate Accumulator Left
-void rlc(struct i8080 *cpu) {
-  cpu->cyc += 4;
-  uint hi_bit = (cpu->A & 0x80) ? 1 : 0;
+  tracker->memory = cpu->memory;
+  tracker->memsize = cpu->memsize;
+  tracker->num_pages = num_pages;
 
-  cpu->A <<= 1;
-  cpu->A |= hi_bit;
+  i8080_snapshot_disable(cpu);
+  cpu->dirty_pages = tracker;
 
-  cpu->A &= 0xFF;
+  // Translated stores have to start marking pages dirty
+  i8080_jit_flush(cpu);
 
-  i8080_set_flag(cpu, FLAG_C, hi_bit);
+  return 0;
 }
 
-// RRC - Rotate Accumulator Right
-void rrc(struct i8080 *cpu) {
-  cpu->cyc += 4;
-  uint lo_bit = cpu->A & 0x01;
+void i8080_snapshot_disable(struct i8080 *cpu) {
+  struct i8080_dirty_pages *tracker = cpu->dirty_pages;
 
-  cpu->A >>= 1;
-  cpu->A |= (lo_bit << 7);
-  cpu->A &= 0xFF;
+  if (tracker == NULL) {
+    return;
+  }
 
-  i8080_set_flag(cpu, FLAG_C, lo_bit);
+  release_pages(tracker->base, tracker->num_pages);
+  free(tracker);
+  cpu->dirty_pages = NULL;
+
+  i8080_jit_flush(cpu);
 }
 
-// RAL - Rotate Accumulator Left Through Carry
-void ral(struct i8080 *cpu) {
-  cpu->cyc += 4;
-  uint old_carry = i8080_get_flag(cpu, FLAG_C) ? 1 : 0;
+int i8080_snapshot(struct i8080 *cpu, struct i8080_snapshot *snapshot) {
+  if (cpu->pages != NULL) {
+    errno = EINVAL;
+    return -1;
+  }
 
-  i8080_set_flag(cpu, FLAG_C, cpu->A & 0x80);
-  cpu->A <<= 1;
-  cpu->A &= 0xFF;
+  size_t num_pages = snapshot_num_pages(cpu);
+  struct i8080_snapshot_page **base = tracked_base(cpu);
+  struct i8080_snapshot_page **pages = malloc(num_pages * sizeof(*pages));
 
-  cpu->A |= old_carry & 0x01;
-}
+  if (pages == NULL) {
+    return -1;
+  }
 
-// RAR - Rotate Accumulator Right Through Carry
-void rar(struct i8080 *cpu) {
-  cpu->cyc += 4;
-  uint old_carry = i8080_get_flag(cpu, FLAG_C) ? 1 : 0;
+  for (size_t i=0;i<num_pages;i++) {
+    if (base != NULL && !cpu->dirty_pages->dirty[i]) {
+      // Unchanged since the base was taken, so share its copy
+      pages[i] = base[i];
+      pages[i]->refs++;
+      continue;
+    }
+
+    pages[i] = malloc(sizeof(struct i8080_snapshot_page));
+    if (pages[i] == NULL) {
+      release_pages(pages, i);
+      return -1;
+    }
+
+    pages[i]->refs = 1;
+    memcpy(pages[i]->data, cpu->memory + i * I8080_PAGE_SIZE,
+           page_bytes(cpu, i));
+  }
 
-  i8080_set_flag(cpu, FLAG_C, cpu->A & 0x01);
-  cpu->A >>= 1;
-  cpu->A &= 0xFF;
+  if (track_base(cpu, pages, num_pages) < 0) {
+    release_pages(pages, num_pages);
+    return -1;
+  }
 
-  cpu->A |= ((old_carry << 7) & 0x80);
-}
+  i8080_free_snapshot(snapshot);
+  snapshot->state = *cpu;
+  snapshot->pages = pages;
+  snapshot->num_pages = num_pages;
 
-// CMC - Complement Carry Bit
-void cmc(struct i8080 *cpu) {
-  cpu->cyc += 4;
-  i8080_set_flag(cpu, FLAG_C, !i8080_get_flag(cpu, FLAG_C));
+  return 0;
 }
 
-// CMA - Complement Accumulator
-void cma(struct i8080 *cpu) {
-  cpu->cyc += 4;
-  cpu->A = (~cpu->A) & 0xFF;
-}
+static int restore(struct i8080 *cpu, const struct i8080_snapshot *snapshot) {
+  size_t num_pages = snapshot_num_pages(cpu);
 
-// STC - Set Carry Bit
-void stc(struct i8080 *cpu) {
-  cpu->cyc += 4;
-  i8080_set_flag(cpu, FLAG_C, 1);
-}
+  if (cpu->pages != NULL || snapshot->pages == NULL ||
+      snapshot->num_pages != num_pages) {
+    errno = EINVAL;
+    return -1;
+  }
 
-// DAD - Double Add
-void dad(struct i8080 *cpu, uint opcode) {
-  cpu->cyc += 10;
-  uint reg_pair = (opcode & 0x30) >> 4;
+  struct i8080_snapshot_page **base = tracked_base(cpu);
 
-  uint new_val = (CONCAT(cpu->H, cpu->L) + get_reg_pair(cpu, reg_pair));
-  i8080_set_flag(cpu, FLAG_C, new_val & 0x10000);
+  for (size_t i=0;i<num_pages;i++) {
+    if (base != NULL && !cpu->dirty_pages->dirty[i] &&
+        base[i] == snapshot->pages[i]) {
+      continue;
+    }
 
-  cpu->H = (new_val >> 8) & 0xFF;
-  cpu->L = new_val & 0xFF;
-}
+    size_t offset = i * I8080_PAGE_SIZE;
+    size_t bytes = page_bytes(cpu, i);
 
-// XCHG - Exchange Registers
-void xchg(struct i8080 *cpu) {
-  cpu->cyc += 5;
-  uint h_temp = cpu->H;
-  uint l_temp = cpu->L;
+    memcpy(cpu->memory + offset, snapshot->pages[i]->data, bytes);
+    if (cpu->block_cache != NULL || cpu->jit != NULL) {
+      for (size_t addr=offset;addr<offset+bytes;addr++) {
+        code_written(cpu, addr);
+      }
+    }
+  }
 
-  cpu->H = cpu->D;
-  cpu->L = cpu->E;
-  cpu->D = h_temp;
-  cpu->E = l_temp;
+  // Without a base every page just counts as dirty, which is slower but still
+  // correct
+  track_base(cpu, snapshot->pages, num_pages);
+
+  const struct i8080 *state = &snapshot->state;
+  cpu->A = state->A;
+  cpu->B = state->B;
+  cpu->C = state->C;
+  cpu->D = state->D;
+  cpu->E = state->E;
+  cpu->H = state->H;
+  cpu->L = state->L;
+  cpu->flags = state->flags;
+  cpu->SP = state->SP;
+  cpu->PC = state->PC;
+  cpu->INTE = state->INTE;
+  cpu->halted = state->halted;
+  cpu->pending_interrupt = state->pending_interrupt;
+  cpu->interrupt_opcode = state->interrupt_opcode;
+  cpu->in_pending = state->in_pending;
+  cpu->in_port = state->in_port;
+  cpu->cyc = state->cyc;
+  cpu->flags_lazy = state->flags_lazy;
+  cpu->flag_res = state->flag_res;
+  cpu->flag_ac = state->flag_ac;
+  cpu->flag_cy = state->flag_cy;
+
+  return 0;
 }
 
-// SPHL - Load SP from H and L
-void sphl(struct i8080 *cpu) {
-  cpu->cyc += 5;
-  cpu->SP = CONCAT(cpu->H, cpu->L);
-}
+int i8080_restore(struct i8080 *cpu, const struct i8080_snapshot *snapshot) {
+  if (restore(cpu, snapshot) < 0) {
+    return -1;
+  }
 
-// SHLD - Store H and L direct
-void shld(struct i8080 *cpu) {
-  cpu->cyc += 16;
-  uint addr = next_word(cpu);
-  i8080_write_byte(cpu, addr, cpu->L);
-  i8080_write_byte(cpu, addr + 1, cpu->H);
+  // Memory was replaced behind the journal's back
+  journal_clear(cpu);
+  return 0;
 }
 
-// LHLD - Load H and L direct
-void ldhd(struct i8080 *cpu) {
-  cpu->cyc += 16;
-  uint addr = next_word(cpu);
-  cpu->L = i8080_read_byte(cpu, addr);
-  cpu->H = i8080_read_byte(cpu, addr + 1);
+void i8080_free_snapshot(struct i8080_snapshot *snapshot) {
+  release_pages(snapshot->pages, snapshot->num_pages);
+  snapshot->pages = NULL;
+  snapshot->num_pages = 0;
 }
 
-// PUSH - Push Data Onto Stack
-void push(struct i8080 *cpu, uint opcode) {
-  cpu->cyc += 11;
-  uint reg_pair = (opcode & 0x30) >> 4;
-
-  // Register pair 3 refers to the concatenation of A and flags with push/pop
-  uint data = reg_pair == 3 ? CONCAT(cpu->A, cpu->flags) : get_reg_pair(cpu, reg_pair);
-  i8080_push_stackw(cpu, data);
+// Recording and replaying IO
+// A log starts with a header holding the cycle count recording started at,
+// followed by one record per event: its kind, the cycles since the previous
+// event as a little endian base 128 number, then the port and value for IN
+// and OUT or the opcode for interrupts.
+static const char log_magic[4] = {'8', '0', '8', '0'};
+#define LOG_VERSION 1
+
+static void write_number(FILE *file, unsigned long long val) {
+  while (val >= 0x80) {
+    putc((int) (val & 0x7F) | 0x80, file);
+    val >>= 7;
+  }
+  putc((int) val, file);
 }
 
-// POP - Pop Data From Stack
-void pop(struct i8080 *cpu, uint opcode) {
-  cpu->cyc += 10;
-  uint reg_pair = (opcode & 0x30) >> 4;
-
-  if (reg_pair == 3) { // PSW special case for push/pop
-    cpu->flags = i8080_pop_stackb(cpu);
+static int read_number(FILE *file, unsigned long long *val) {
+  *val = 0;
 
-    cpu->flags |= 2; // Bit 1 of flags always set
-    cpu->flags &= 0xD7; // Bits 3 and 5 of flags always reset
+  for (uint shift=0;shift<64;shift+=7) {
+    int byte = getc(file);
+    if (byte == EOF) {
+      return -1;
+    }
 
-    cpu->A = i8080_pop_stackb(cpu);
-  } else {
-    set_reg_pair(cpu, reg_pair, i8080_pop_stackw(cpu));
+    *val |= (unsigned long long) (byte & 0x7F) << shift;
+    if (!(byte & 0x80)) {
+      return 0;
+    }
   }
+
+  return -1;
 }
 
-// XTHL - Exchange Stack
-void xthl(struct i8080 *cpu) {
-  cpu->cyc += 18;
-  uint temp_h = cpu->H;
-  uint temp_l = cpu->L;
+static void record_event(struct i8080 *cpu, enum event_kind kind, uint port,
+                         uint value) {
+  struct i8080_recording *recording = cpu->recording;
 
-  cpu->L = i8080_read_byte(cpu, cpu->SP);
-  cpu->H = i8080_read_byte(cpu, cpu->SP + 1);
+  // Only reached when recording, or after replay has ended
+  if (recording->replaying) {
+    return;
+  }
 
-  i8080_write_byte(cpu, cpu->SP, temp_l);
-  i8080_write_byte(cpu, cpu->SP + 1, temp_h);
-}
+  putc(kind, recording->file);
+  write_number(recording->file, cpu->cyc - recording->cyc);
+  putc((int) port, recording->file);
+  if (kind != EVENT_INTERRUPT) {
+    putc((int) (value & 0xFF), recording->file);
+  }
 
-// CALL - Call
-// CZ   - Call if Zero
-// CNC  - Call if no Carry
-// CC   - Call if Carry
-// CPO  - Call if Parity Odd
-// CPE  - Call if Parity Even
-// CP   - Call if Plus
-// CM   - Call if Minus
-void general_call(struct i8080 *cpu, uint opcode) {
-  cpu->cyc += 11;
+  recording->cyc = cpu->cyc;
+}
 
-  // Unconditional call has LSB set, conditional calls do not
-  if ((opcode & 1) || check_condition(cpu, (opcode >> 3) & 0x07)) {
-    cpu->cyc += 6;
-    i8080_push_stackw(cpu, cpu->PC + 2);
-    cpu->PC = next_word(cpu);
-  } else {
-    cpu->PC += 2;
+// Ends replay, handing IO back to the handlers
+static void end_replay(struct i8080_recording *recording, int error) {
+  recording->have_next = 0;
+  if (recording->error == 0) {
+    recording->error = error;
   }
 }
 
-// RET - Return
-// RNZ - Return if not Zero
-// RZ  - Return if Zero
-// RNC - Return if no Carry
-// RC  - Return if Carry
-// RPO - Return if Parity Odd
-// RPE - Return if Parity Even
-// RP  - Return if Parity Odd
-// RP  - Return if Plus
-// RM  - Return if Minus
-void general_return(struct i8080 *cpu, uint opcode) {
-  cpu->cyc += 5;
+// Reads the next event into recording->next, ending replay at the end of the
+// log
+static void read_event(struct i8080_recording *recording) {
+  FILE *file = recording->file;
+  struct event *next = &recording->next;
+  int kind = getc(file);
+  unsigned long long delta;
 
-  // Unconditional return has LSB set, conditional returns do not
-  if ((opcode & 1) || check_condition(cpu, (opcode >> 3) & 0x07)) {
-    cpu->cyc += 6;
-    cpu->PC = i8080_pop_stackw(cpu);
+  if (kind == EOF) {
+    end_replay(recording, ferror(file) ? EIO : 0);
+    return;
   }
-}
 
-// JMP - Jump
-// JNZ - Jump if not Zero
-// JZ  - Jump if Zero
-// JNC - Jump if no Carry
-// JC  - Jump if Carry
-// JPO - Jump if Parity Odd
-// JPE - Jump if Parity Even
-// JP  - Jump if Parity Odd
-// JP  - Jump if Plus
-// JM  - Jump if Minus
-void general_jump(struct i8080 *cpu, uint opcode) {
-  cpu->cyc += 10;
-  if ((opcode & 1) || check_condition(cpu, (opcode >> 3) & 0x07)) {
-    cpu->PC = next_word(cpu);
-  } else {
-    cpu->PC += 2;
+  next->kind = (enum event_kind) kind;
+  if (kind < EVENT_IN || kind > EVENT_INTERRUPT || read_number(file, &delta) < 0) {
+    end_replay(recording, EILSEQ);
+    return;
   }
-}
 
-// PCHL - Load Program Counter
-void pchl(struct i8080 *cpu) {
-  cpu->cyc += 5;
-  cpu->PC = CONCAT(cpu->H, cpu->L);
-}
+  int port = getc(file);
+  int value = kind != EVENT_INTERRUPT ? getc(file) : 0;
+  if (port == EOF || value == EOF) {
+    end_replay(recording, EILSEQ);
+    return;
+  }
 
-// EI - Enable Interrupts
-void ei(struct i8080 *cpu) {
-  cpu->cyc += 4;
-  cpu->INTE = 1;
+  recording->cyc += delta;
+  next->cyc = recording->cyc;
+  next->port = (uint) port;
+  next->value = (uint) value;
 }
 
-// DI - Disable Interrupts
-void di(struct i8080 *cpu) {
-  cpu->cyc += 4;
-  cpu->INTE = 0;
-}
+// Requests any logged interrupts that are due
+static void replay_interrupts(struct i8080 *cpu) {
+  struct i8080_recording *recording = cpu->recording;
 
-// RST - Restart
-void rst(struct i8080 *cpu, uint opcode) {
-  cpu->cyc += 11;
-  i8080_push_stackw(cpu, cpu->PC);
-  cpu->PC = opcode & 0x38;
+  while (recording->have_next && recording->next.kind == EVENT_INTERRUPT &&
+         recording->next.cyc <= cpu->cyc) {
+    request_interrupt(cpu, recording->next.port);
+    read_event(recording);
+  }
 }
 
-// IN - Input
-void in(struct i8080 *cpu) {
-  cpu->cyc += 10;
-  uint dev = next_byte(cpu);
-  if (cpu->input_handler != NULL) {
-    cpu->A = cpu->input_handler(cpu, dev);
+// Replays an IN or OUT, returning whether it came from the log. Interrupts
+// requested by the handlers while recording are requested again right away.
+static int replay_io(struct i8080 *cpu, enum event_kind kind, uint port,
+                     uint *value) {
+  struct i8080_recording *recording = cpu->recording;
+
+  replay_interrupts(cpu);
+  if (!recording->have_next) {
+    return 0;
   }
-}
 
-void out(struct i8080 *cpu) {
-  cpu->cyc += 10;
-  uint dev = next_byte(cpu);
-  if (cpu->output_handler != NULL) {
-    cpu->output_handler(cpu, dev, cpu->A);
+  struct event *next = &recording->next;
+  if (next->kind != kind || next->port != port ||
+      (kind == EVENT_OUT && next->value != *value)) {
+    // The program has gone somewhere else than it did while recording
+    end_replay(recording, EILSEQ);
+    return 0;
   }
+
+  *value = next->value;
+  read_event(recording);
+  replay_interrupts(cpu);
+
+  return 1;
 }
 
-void i8080_step(struct i8080 *cpu) {
-  if (cpu->halted) {
-    return;
+int i8080_record_start(struct i8080 *cpu, FILE *file) {
+  struct i8080_recording *recording = calloc(1, sizeof(struct i8080_recording));
+  if (recording == NULL) {
+    return -1;
   }
 
-  uint opcode = next_instruction_opcode(cpu);
+  fwrite(log_magic, 1, sizeof(log_magic), file);
+  putc(LOG_VERSION, file);
+  write_number(file, cpu->cyc);
 
-  switch (opcode) {
-    case 0x00: // NOP
-    case 0x08: // NOP (alternate)
-    case 0x10: // NOP (alternate)
-    case 0x18: // NOP (alternate)
-    case 0x20: // NOP (alternate)
-    case 0x28: // NOP (alternate)
-    case 0x30: // NOP (alternate)
-    case 0x38: // NOP (alternate)
-      nop(cpu);
-      break;
+  recording->file = file;
+  recording->cyc = cpu->cyc;
 
-    case 0x22: // SHLD a16
-      shld(cpu);
-      break;
+  i8080_recording_stop(cpu);
+  cpu->recording = recording;
 
-    case 0x2A: // LDHD a16
-      ldhd(cpu);
-      break;
+  return 0;
+}
 
-    case 0x2F: // CMA
-      cma(cpu);
-      break;
+int i8080_replay_start(struct i8080 *cpu, FILE *file) {
+  char magic[sizeof(log_magic)];
+  unsigned long long cyc;
 
-    case 0x3F: // CMC
-      cmc(cpu);
-      break;
+  if (fread(magic, 1, sizeof(magic), file) != sizeof(magic) ||
+      memcmp(magic, log_magic, sizeof(magic)) != 0 ||
+      getc(file) != LOG_VERSION || read_number(file, &cyc) < 0) {
+    errno = EILSEQ;
+    return -1;
+  }
 
-    case 0x01: // LXI B, d16
-    case 0x11: // LXI D, d16
-    case 0x21: // LXI H, d16
-    case 0x31: // LXI SP, d16
-      lxi(cpu, opcode);
-      break;
+  // Logged cycle counts only make sense from where recording started
+  if (cyc != cpu->cyc) {
+    errno = EINVAL;
+    return -1;
+  }
 
-    case 0x09: // DAD B
-    case 0x19: // DAD D
-    case 0x29: // DAD H
-    case 0x39: // DAD SP
-      dad(cpu, opcode);
-      break;
+  struct i8080_recording *recording = calloc(1, sizeof(struct i8080_recording));
+  if (recording == NULL) {
+    return -1;
+  }
+
+  recording->file = file;
+  recording->replaying = 1;
+  recording->cyc = cyc;
+  recording->have_next = 1;
+  read_event(recording);
+
+  i8080_recording_stop(cpu);
+  cpu->recording = recording;
+
+  return 0;
+}
+
+int i8080_replay_active(struct i8080 *cpu) {
+  return cpu->recording != NULL && cpu->recording->have_next;
+}
+
+int i8080_recording_stop(struct i8080 *cpu) {
+  struct i8080_recording *recording = cpu->recording;
+
+  if (recording == NULL) {
+    return 0;
+  }
+
+  int error = recording->error;
+  if (!recording->replaying && (fflush(recording->file) != 0 ||
+                                ferror(recording->file))) {
+    error = EIO;
+  }
+
+  free(recording);
+  cpu->recording = NULL;
+
+  if (error != 0) {
+    errno = error;
+    return -1;
+  }
+
+  return 0;
+}
+
+// Reverse execution
+static struct journal_entry *newest_entry(struct i8080_journal *journal) {
+  size_t i = journal->first_entry + journal->num_entries - 1;
+  return &journal->entries[i % journal->max_entries];
+}
+
+static struct journal_write *newest_write(struct i8080_journal *journal) {
+  size_t i = journal->first_write + journal->num_writes - 1;
+  return &journal->writes[i % journal->max_writes];
+}
+
+static void evict_oldest_entry(struct i8080_journal *journal) {
+  struct journal_entry *entry = &journal->entries[journal->first_entry];
+
+  journal->first_write = (journal->first_write + entry->num_writes)
+                         % journal->max_writes;
+  journal->num_writes -= entry->num_writes;
+  journal->first_entry = (journal->first_entry + 1) % journal->max_entries;
+  journal->num_entries--;
+}
+
+// Drops the newest entry without undoing it
+static void drop_newest_entry(struct i8080_journal *journal) {
+  journal->num_writes -= newest_entry(journal)->num_writes;
+  journal->num_entries--;
+  journal->insns--;
+}
+
+NOINLINE static void journal_store(struct i8080 *cpu, uint addr) {
+  struct i8080_journal *journal = cpu->journal;
+
+  if (addr >= cpu->memsize) {
+    return;
+  }
+
+  // Making room may drop every entry, including the one this write belongs to
+  while (journal->num_writes == journal->max_writes && journal->num_entries > 0) {
+    evict_oldest_entry(journal);
+  }
+  if (journal->num_entries == 0) {
+    return;
+  }
+
+  journal->num_writes++;
+  struct journal_write *write = newest_write(journal);
+  write->addr = addr;
+  write->old = (uint8_t) cpu->memory[addr];
+  newest_entry(journal)->num_writes++;
+}
+
+static void drop_checkpoint(struct i8080_journal *journal, uint i) {
+  i8080_free_snapshot(&journal->checkpoints[i].snapshot);
+  for (;i+1<journal->num_checkpoints;i++) {
+    journal->checkpoints[i] = journal->checkpoints[i+1];
+  }
+  journal->num_checkpoints--;
+}
+
+static void journal_clear(struct i8080 *cpu) {
+  struct i8080_journal *journal = cpu->journal;
+
+  if (journal == NULL) {
+    return;
+  }
+
+  while (journal->num_checkpoints > 0) {
+    drop_checkpoint(journal, journal->num_checkpoints - 1);
+  }
+  journal->first_entry = 0;
+  journal->num_entries = 0;
+  journal->first_write = 0;
+  journal->num_writes = 0;
+}
+
+// Undoes the newest entry's instruction
+static void undo_entry(struct i8080 *cpu) {
+  struct i8080_journal *journal = cpu->journal;
+  struct journal_entry *entry = newest_entry(journal);
+
+  // Newest first, in case the same byte was written twice
+  for (uint32_t i=0;i<entry->num_writes;i++) {
+    struct journal_write *write = newest_write(journal);
+    cpu->memory[write->addr] = (char) write->old;
+    memory_written(cpu, write->addr);
+    journal->num_writes--;
+  }
+
+  cpu->A = entry->regs[0];
+  cpu->B = entry->regs[1];
+  cpu->C = entry->regs[2];
+  cpu->D = entry->regs[3];
+  cpu->E = entry->regs[4];
+  cpu->H = entry->regs[5];
+  cpu->L = entry->regs[6];
+  cpu->flags = entry->regs[7];
+  cpu->flags_lazy = 0;
+  cpu->SP = entry->SP;
+  cpu->PC = entry->PC;
+  cpu->INTE = entry->state & 1;
+  cpu->halted = (entry->state >> 1) & 1;
+  cpu->pending_interrupt = (entry->state >> 2) & 1;
+  cpu->interrupt_opcode = entry->interrupt_opcode;
+  // Instructions never start while an IN is pending
+  cpu->in_pending = 0;
+  cpu->cyc = entry->cyc;
+
+  journal->num_entries--;
+  journal->insns--;
+}
+
+int i8080_journal_enable(struct i8080 *cpu, size_t size,
+                         unsigned long checkpoint_interval) {
+  // One write for every instruction leaves plenty of room on average
+  size_t count = size / (sizeof(struct journal_entry) +
+                         sizeof(struct journal_write));
+
+  if (cpu->pages != NULL || count == 0) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  struct i8080_journal *journal = calloc(1, sizeof(struct i8080_journal));
+  if (journal == NULL) {
+    return -1;
+  }
+
+  journal->entries = malloc(count * sizeof(struct journal_entry));
+  journal->writes = malloc(count * sizeof(struct journal_write));
+  if (journal->entries == NULL || journal->writes == NULL) {
+    free(journal->entries);
+    free(journal->writes);
+    free(journal);
+    return -1;
+  }
+
+  journal->max_entries = count;
+  journal->max_writes = count;
+  journal->checkpoint_interval = checkpoint_interval;
+
+  i8080_journal_disable(cpu);
+  cpu->journal = journal;
+
+  return 0;
+}
+
+void i8080_journal_disable(struct i8080 *cpu) {
+  struct i8080_journal *journal = cpu->journal;
+
+  if (journal == NULL) {
+    return;
+  }
+
+  journal_clear(cpu);
+  free(journal->entries);
+  free(journal->writes);
+  free(journal);
+  cpu->journal = NULL;
+}
+
+unsigned long i8080_journal_depth(struct i8080 *cpu) {
+  return cpu->journal != NULL ? (unsigned long) cpu->journal->num_entries : 0;
+}
+
+unsigned long i8080_rewind(struct i8080 *cpu, unsigned long count) {
+  struct i8080_journal *journal = cpu->journal;
+
+  if (journal == NULL) {
+    return 0;
+  }
+  if (count > journal->num_entries) {
+    count = (unsigned long) journal->num_entries;
+  }
+
+  unsigned long long target = journal->insns - count;
+
+  // Checkpoints after the target are of no further use, but the earliest one
+  // saves undoing everything after it
+  struct journal_checkpoint *closest = NULL;
+  for (uint i=0;i<journal->num_checkpoints;i++) {
+    struct journal_checkpoint *checkpoint = &journal->checkpoints[i];
+
+    if (checkpoint->insn >= target && checkpoint->insn < journal->insns &&
+        (closest == NULL || checkpoint->insn < closest->insn)) {
+      closest = checkpoint;
+    }
+  }
+
+  if (closest != NULL && restore(cpu, &closest->snapshot) == 0) {
+    while (journal->insns > closest->insn) {
+      drop_newest_entry(journal);
+    }
+  }
+
+  while (journal->insns > target) {
+    undo_entry(cpu);
+  }
+
+  for (uint i=journal->num_checkpoints;i>0;i--) {
+    if (journal->checkpoints[i-1].insn > target) {
+      drop_checkpoint(journal, i - 1);
+    }
+  }
+
+  return count;
+}
+
+// Timed events
+static int event_before(const struct scheduled_event *a,
+                        const struct scheduled_event *b) {
+  if (a->cyc != b->cyc) {
+    return a->cyc < b->cyc;
+  }
+  return a->seq < b->seq;
+}
+
+static void sift_up(struct scheduled_event *events, size_t i) {
+  struct scheduled_event event = events[i];
+
+  while (i > 0 && event_before(&event, &events[(i - 1) / 2])) {
+    events[i] = events[(i - 1) / 2];
+    i = (i - 1) / 2;
+  }
+  events[i] = event;
+}
+
+static void sift_down(struct scheduled_event *events, size_t num_events,
+                      size_t i) {
+  struct scheduled_event event = events[i];
+
+  for (;;) {
+    size_t child = 2 * i + 1;
+    if (child >= num_events) {
+      break;
+    }
+    if (child + 1 < num_events && event_before(&events[child + 1],
+                                               &events[child])) {
+      child++;
+    }
+    if (!event_before(&events[child], &event)) {
+      break;
+    }
+    events[i] = events[child];
+    i = child;
+  }
+  events[i] = event;
+}
+
+int i8080_schedule_event(struct i8080 *cpu, unsigned long long cyc,
+                         i8080_event_handler handler, void *data) {
+  struct i8080_scheduler *scheduler = cpu->scheduler;
+
+  if (scheduler == NULL) {
+    scheduler = calloc(1, sizeof(struct i8080_scheduler));
+    if (scheduler == NULL) {
+      return -1;
+    }
+    cpu->scheduler = scheduler;
+  }
+
+  if (scheduler->num_events == scheduler->max_events) {
+    size_t max_events = scheduler->max_events ? scheduler->max_events * 2 : 8;
+    struct scheduled_event *events =
+      realloc(scheduler->events, max_events * sizeof(struct scheduled_event));
+    if (events == NULL) {
+      return -1;
+    }
+    scheduler->events = events;
+    scheduler->max_events = max_events;
+  }
+
+  struct scheduled_event *event = &scheduler->events[scheduler->num_events];
+  event->cyc = cyc;
+  event->seq = scheduler->next_seq++;
+  event->handler = handler;
+  event->data = data;
+  sift_up(scheduler->events, scheduler->num_events++);
+
+  return 0;
+}
+
+uint i8080_cancel_event(struct i8080 *cpu, i8080_event_handler handler,
+                        void *data) {
+  struct i8080_scheduler *scheduler = cpu->scheduler;
+  uint cancelled = 0;
+
+  if (scheduler == NULL) {
+    return 0;
+  }
+
+  size_t kept = 0;
+  for (size_t i=0;i<scheduler->num_events;i++) {
+    struct scheduled_event *event = &scheduler->events[i];
+
+    if (event->handler == handler && event->data == data) {
+      cancelled++;
+    } else {
+      scheduler->events[kept++] = *event;
+    }
+  }
+  scheduler->num_events = kept;
+
+  // Removing events from the middle breaks the heap, so build it again
+  for (size_t i=kept/2;i>0;i--) {
+    sift_down(scheduler->events, kept, i - 1);
+  }
+
+  return cancelled;
+}
+
+void i8080_cancel_all_events(struct i8080 *cpu) {
+  if (cpu->scheduler == NULL) {
+    return;
+  }
+
+  free(cpu->scheduler->events);
+  free(cpu->scheduler);
+  cpu->scheduler = NULL;
+}
+
+static uint get_flag_mask(enum i8080_flag flag);
+static void unpack_flags(struct i8080 *cpu, uint flags);
+static uint pack_flags(struct i8080 *cpu);
+
+void i8080_sync_flags(struct i8080 *cpu) {
+  if (cpu->flags_lazy) {
+    cpu->flags = pack_flags(cpu);
+  }
+}
+
+void i8080_set_flag(struct i8080 *cpu, enum i8080_flag flag, int val) {
+  uint mask = get_flag_mask(flag);
+  i8080_sync_flags(cpu);
+
+  if (val) {
+    cpu->flags = (cpu->flags | mask) & 0xFF;
+  } else {
+    cpu->flags = (cpu->flags & ~mask) & 0xFF;
+  }
+
+  if (cpu->flags_lazy) {
+    unpack_flags(cpu, cpu->flags);
+  }
+}
+
+int i8080_get_flag(struct i8080 *cpu, enum i8080_flag flag) {
+  uint mask = get_flag_mask(flag);
+  i8080_sync_flags(cpu);
+  return (cpu->flags & mask) != 0;
+}
+
+void i8080_push_stackb(struct i8080 *cpu, uint val) {
+  cpu->SP = (cpu->SP-1) & 0XFFFF;
+  write_byte(cpu, cpu->SP, val & 0xFF, cpu->memory_64k);
+}
+
+void i8080_push_stackw(struct i8080 *cpu, uint val) {
+  push_word(cpu, val, cpu->memory_64k);
+}
+
+uint i8080_pop_stackb(struct i8080 *cpu) {
+  uint byte = read_byte(cpu, cpu->SP, cpu->memory_64k);
+  cpu->SP = (cpu->SP + 1) & 0xFFFF;
+  return byte;
+}
+
+uint i8080_pop_stackw(struct i8080 *cpu) {
+  return pop_word(cpu, cpu->memory_64k);
+}
+
+// Internal logic
+static uint get_flag_mask(enum i8080_flag flag) {
+  switch (flag) {
+    case FLAG_S: return 0x80;
+    case FLAG_Z: return 0x40;
+    case FLAG_A: return 0x10;
+    case FLAG_P: return 0x04;
+    case FLAG_C: return 0x01;
+    default:
+      fprintf(stderr, "Invalid flag %d", flag);
+      exit(1);
+  }
+}
+
+// Lazy flags
+// While instructions are executing, the flags register is kept unpacked:
+// flag_res holds the last result, from which S, Z and P are only worked out
+// when something actually looks at them, flag_ac holds AC in bit 4 and flag_cy
+// holds the carry in bit 0. When S, Z and P are loaded verbatim (e.g. by POP
+// PSW) flag_res has bit 8 set, which szp_table maps straight back to them.
+// cpu->flags is only brought up to date by pack_flags (see i8080_sync_flags).
+static void unpack_flags(struct i8080 *cpu, uint flags) {
+  cpu->flag_res = 0x100 | (flags & 0xC4);
+  cpu->flag_ac = flags & 0x10;
+  cpu->flag_cy = flags & 0x01;
+}
+
+static int flag_s(struct i8080 *cpu) {
+  return (szp_table[cpu->flag_res] & 0x80) != 0;
+}
+
+static int flag_z(struct i8080 *cpu) {
+  return (szp_table[cpu->flag_res] & 0x40) != 0;
+}
+
+static int flag_p(struct i8080 *cpu) {
+  return (szp_table[cpu->flag_res] & 0x04) != 0;
+}
+
+static uint pack_flags(struct i8080 *cpu) {
+  return szp_table[cpu->flag_res] | cpu->flag_ac | 0x02 | cpu->flag_cy;
+}
+
+static void begin_lazy_flags(struct i8080 *cpu) {
+  unpack_flags(cpu, cpu->flags);
+  cpu->flags_lazy = 1;
+}
+
+static void end_lazy_flags(struct i8080 *cpu) {
+  cpu->flags = pack_flags(cpu);
+  cpu->flags_lazy = 0;
+}
+
+static int check_condition(struct i8080 *cpu, uint condition) {
+  switch (condition) {
+    case 0: return !flag_z(cpu); // No zero
+    case 1: return flag_z(cpu); // Zero
+    case 2: return !cpu->flag_cy; // No carry
+    case 3: return cpu->flag_cy; // Carry
+    case 4: return !flag_p(cpu); // Parity odd
+    case 5: return flag_p(cpu); // Parity even
+    case 6: return !flag_s(cpu); // Positive
+    case 7: return flag_s(cpu); // Negative
+    default:
+      fprintf(stderr, "Invalid condition code %d", condition);
+      exit(1);
+  }
+}
+
+// Pairs are adjacent in the register file, high byte first
+static uint get_reg_pair(struct i8080 *cpu, uint reg_pair) {
+  if (reg_pair == 3) {
+    return cpu->SP;
+  }
+  return CONCAT(cpu->regs[reg_pair * 2], cpu->regs[reg_pair * 2 + 1]);
+}
+
+static void set_reg_pair(struct i8080 *cpu, uint reg_pair, uint val) {
+  if (reg_pair == 3) {
+    cpu->SP = (uint16_t) val;
+  } else {
+    cpu->regs[reg_pair * 2] = (uint8_t) (val >> 8);
+    cpu->regs[reg_pair * 2 + 1] = (uint8_t) val;
+  }
+}
+
+ALWAYS_INLINE static uint next_byte(struct i8080 *cpu, int mem64k) {
+  return read_byte(cpu, cpu->PC++, mem64k);
+}
+
+ALWAYS_INLINE static uint next_word(struct i8080 *cpu, int mem64k) {
+  uint word  = read_word(cpu, cpu->PC, mem64k);
+  cpu->PC += 2;
+  return word;
+}
+
+ALWAYS_INLINE static uint next_instruction_opcode(struct i8080 *cpu,
+                                                  int mem64k) {
+  if (mailbox_peek(cpu)) {
+    take_posted_interrupt(cpu);
+  }
+
+  if (cpu->pending_interrupt) {
+    // The interrupting device's opcode is executed exactly once
+    cpu->pending_interrupt = 0;
+    return cpu->interrupt_opcode;
+  } else {
+    return next_byte(cpu, mem64k);
+  }
+}
+
+static uint perform_sub(struct i8080 *cpu, uint minu, uint subt, int borrow) {
+  uint subt_ones = (~subt) & 0xFF;
+
+  // Minuend plus ones complement of subtrahend with a carry input
+  // Note that if there is a borrow, we negate the carry in (for forming the
+  // 2's complement) as the borrow will cancel it out
+  uint res16 = minu + subt_ones + (borrow ? 0 : 1);
+  uint res8 = res16 & 0xFF;
+
+  cpu->flag_cy = ((res16 >> 8) & 1) ^ 1;
+  cpu->flag_ac = (minu ^ subt_ones ^ res16) & 0x10;
+  cpu->flag_res = res8;
+
+  return res8;
+}
+
+static uint perform_add(struct i8080 *cpu, uint a, uint b, int carry) {
+  uint carry_val = carry ? 1 : 0;
+
+  uint res16 = a + b + carry_val;
+  uint res8 = res16 & 0xFF;
+
+  cpu->flag_cy = (res16 >> 8) & 1;
+  cpu->flag_ac = (a ^ b ^ res16) & 0x10;
+  cpu->flag_res = res8;
+
+  return res8;
+}
+
+static uint perform_inr(struct i8080 *cpu, uint val) {
+  uint res = (val + 1) & 0xFF;
+
+  // Carry out of the low nibble happens exactly when bit 4 flips
+  cpu->flag_ac = (val ^ res) & 0x10;
+  cpu->flag_res = res;
+
+  return res;
+}
+
+static uint perform_dcr(struct i8080 *cpu, uint val) {
+  uint res = (val - 1) & 0xFF;
+
+  // Adding 0xFF carries out of the low nibble unless bit 4 flips
+  cpu->flag_ac = ~(val ^ res) & 0x10;
+  cpu->flag_res = res;
+
+  return res;
+}
+
+static void perform_ana(struct i8080 *cpu, uint val) {
+  cpu->flag_ac = ((val | cpu->A) & 0x08) << 1;
+
+  cpu->A &= val;
+
+  cpu->flag_cy = 0;
+  cpu->flag_res = cpu->A;
+}
+
+static void perform_xra(struct i8080 *cpu, uint val) {
+  cpu->A ^= val;
+
+  cpu->flag_cy = 0;
+  cpu->flag_ac = 0;
+  cpu->flag_res = cpu->A;
+}
+
+static void perform_ora(struct i8080 *cpu, uint val) {
+  cpu->A |= val;
+
+  cpu->flag_ac = 0;
+  cpu->flag_cy = 0;
+  cpu->flag_res = cpu->A;
+}
+
+ALWAYS_INLINE static void perform_jump(struct i8080 *cpu, int cond,
+                                       int mem64k) {
+  if (cond) {
+    cpu->PC = next_word(cpu, mem64k);
+  } else {
+    cpu->PC += 2;
+  }
+}
+
+ALWAYS_INLINE static void perform_call(struct i8080 *cpu, int cond,
+                                       int mem64k) {
+  if (cond) {
+    cpu->cyc += 6;
+    push_word(cpu, cpu->PC + 2, mem64k);
+    cpu->PC = next_word(cpu, mem64k);
+  } else {
+    cpu->PC += 2;
+  }
+}
+
+ALWAYS_INLINE static void perform_return(struct i8080 *cpu, int cond,
+                                         int mem64k) {
+  if (cond) {
+    cpu->cyc += 6;
+    cpu->PC = pop_word(cpu, mem64k);
+  }
+}
+
+static void perform_dad(struct i8080 *cpu, uint val) {
+  uint new_val = CONCAT(cpu->H, cpu->L) + val;
+  cpu->flag_cy = (new_val >> 16) & 1;
+
+  cpu->H = (new_val >> 8) & 0xFF;
+  cpu->L = new_val & 0xFF;
+}
+
+// Instructions follow
+// HLT - Halt
+static void hlt(struct i8080 *cpu) {
+  cpu->cyc += 7;
+  cpu->halted = 1;
+}
+
+// NOP - No Operation
+static void nop(struct i8080 *cpu) {
+  cpu->cyc += 4;
+}
+
+// STA - Store Accumulator Direct
+ALWAYS_INLINE static void sta(struct i8080 *cpu, int mem64k) {
+  cpu->cyc += 13;
+  write_byte(cpu, next_word(cpu, mem64k), cpu->A, mem64k);
+}
+
+// LDA - Load Accumulator Direct
+ALWAYS_INLINE static void lda(struct i8080 *cpu, int mem64k) {
+  cpu->cyc += 13;
+  cpu->A = read_byte(cpu, next_word(cpu, mem64k), mem64k);
+}
+
+// DAA - Decimal Adjust Accumulator
+static void daa(struct i8080 *cpu) {
+  cpu->cyc += 4;
+  uint add = 0;
+
+  if (((cpu->A & 0xF) > 9) || cpu->flag_ac) {
+    add |= 0x06;
+  }
+
+  uint carry = cpu->flag_cy;
+  /*
+   * If the upper nibble is greater than 9
+   * or the upper nibble will be greater than 9 when adding 6 to the lower nibble
+   * or the carry flag is set
+   */
+  if (((cpu->A & 0xF0) > 0x90) ||
+      (((cpu->A & 0xF0) >= 0x90) && ((cpu->A & 0xF) > 9)) ||
+      cpu->flag_cy) {
+    add |= 0x60;
+    carry = 1;
+  }
+
+  cpu->A = perform_add(cpu, cpu->A, add, 0);
+
+  // The carry bit is unaffected if there is no carry out of the upper nibble
+  cpu->flag_cy = carry;
+}
+
+// RLC - Rotate Accumulator Left
+static void rlc(struct i8080 *cpu) {
+  cpu->cyc += 4;
+  uint hi_bit = (cpu->A & 0x80) ? 1 : 0;
+
+  cpu->A <<= 1;
+  cpu->A |= hi_bit;
+
+  cpu->A &= 0xFF;
+
+  cpu->flag_cy = hi_bit;
+}
+
+// RRC - Rotate Accumulator Right
+static void rrc(struct i8080 *cpu) {
+  cpu->cyc += 4;
+  uint lo_bit = cpu->A & 0x01;
+
+  cpu->A >>= 1;
+  cpu->A |= (lo_bit << 7);
+  cpu->A &= 0xFF;
+
+  cpu->flag_cy = lo_bit;
+}
+
+// RAL - Rotate Accumulator Left Through Carry
+static void ral(struct i8080 *cpu) {
+  cpu->cyc += 4;
+  uint old_carry = cpu->flag_cy;
+
+  cpu->flag_cy = (cpu->A >> 7) & 1;
+  cpu->A <<= 1;
+  cpu->A &= 0xFF;
+
+  cpu->A |= old_carry & 0x01;
+}
+
+// RAR - Rotate Accumulator Right Through Carry
+static void rar(struct i8080 *cpu) {
+  cpu->cyc += 4;
+  uint old_carry = cpu->flag_cy;
+
+  cpu->flag_cy = cpu->A & 0x01;
+  cpu->A >>= 1;
+  cpu->A &= 0xFF;
+
+  cpu->A |= ((old_carry << 7) & 0x80);
+}
+
+// CMC - Complement Carry Bit
+static void cmc(struct i8080 *cpu) {
+  cpu->cyc += 4;
+  cpu->flag_cy ^= 1;
+}
+
+// CMA - Complement Accumulator
+static void cma(struct i8080 *cpu) {
+  cpu->cyc += 4;
+  cpu->A = (~cpu->A) & 0xFF;
+}
+
+// STC - Set Carry Bit
+static void stc(struct i8080 *cpu) {
+  cpu->cyc += 4;
+  cpu->flag_cy = 1;
+}
+
+// XCHG - Exchange Registers
+static void xchg(struct i8080 *cpu) {
+  cpu->cyc += 5;
+  uint h_temp = cpu->H;
+  uint l_temp = cpu->L;
+
+  cpu->H = cpu->D;
+  cpu->L = cpu->E;
+  cpu->D = h_temp;
+  cpu->E = l_temp;
+}
+
+// SPHL - Load SP from H and L
+static void sphl(struct i8080 *cpu) {
+  cpu->cyc += 5;
+  cpu->SP = CONCAT(cpu->H, cpu->L);
+}
+
+// SHLD - Store H and L direct
+ALWAYS_INLINE static void shld(struct i8080 *cpu, int mem64k) {
+  cpu->cyc += 16;
+  uint addr = next_word(cpu, mem64k);
+  write_byte(cpu, addr, cpu->L, mem64k);
+  write_byte(cpu, addr + 1, cpu->H, mem64k);
+}
+
+// LHLD - Load H and L direct
+ALWAYS_INLINE static void ldhd(struct i8080 *cpu, int mem64k) {
+  cpu->cyc += 16;
+  uint addr = next_word(cpu, mem64k);
+  cpu->L = read_byte(cpu, addr, mem64k);
+  cpu->H = read_byte(cpu, addr + 1, mem64k);
+}
+
+// PUSH - Push Data Onto Stack
+ALWAYS_INLINE static void push(struct i8080 *cpu, uint opcode, int mem64k) {
+  cpu->cyc += 11;
+  uint reg_pair = (opcode & 0x30) >> 4;
+
+  // Register pair 3 refers to the concatenation of A and flags with push/pop
+  uint data = reg_pair == 3 ? CONCAT(cpu->A, pack_flags(cpu)) : get_reg_pair(cpu, reg_pair);
+  push_word(cpu, data, mem64k);
+}
+
+// POP - Pop Data From Stack
+ALWAYS_INLINE static void pop(struct i8080 *cpu, uint opcode, int mem64k) {
+  cpu->cyc += 10;
+  uint reg_pair = (opcode & 0x30) >> 4;
+
+  if (reg_pair == 3) { // PSW special case for push/pop
+    // Bit 1 of flags is always set and bits 3 and 5 always reset, which
+    // pack_flags takes care of
+    uint psw = pop_word(cpu, mem64k);
+    unpack_flags(cpu, psw & 0xFF);
+    cpu->A = psw >> 8;
+  } else {
+    set_reg_pair(cpu, reg_pair, pop_word(cpu, mem64k));
+  }
+}
+
+// XTHL - Exchange Stack
+ALWAYS_INLINE static void xthl(struct i8080 *cpu, int mem64k) {
+  cpu->cyc += 18;
+  uint temp_h = cpu->H;
+  uint temp_l = cpu->L;
+
+  cpu->L = read_byte(cpu, cpu->SP, mem64k);
+  cpu->H = read_byte(cpu, cpu->SP + 1, mem64k);
+
+  write_byte(cpu, cpu->SP, temp_l, mem64k);
+  write_byte(cpu, cpu->SP + 1, temp_h, mem64k);
+}
+
+// PCHL - Load Program Counter
+static void pchl(struct i8080 *cpu) {
+  cpu->cyc += 5;
+  cpu->PC = CONCAT(cpu->H, cpu->L);
+}
+
+// EI - Enable Interrupts
+static void ei(struct i8080 *cpu) {
+  cpu->cyc += 4;
+  cpu->INTE = 1;
+}
+
+// DI - Disable Interrupts
+static void di(struct i8080 *cpu) {
+  cpu->cyc += 4;
+  cpu->INTE = 0;
+}
+
+// RST - Restart
+ALWAYS_INLINE static void rst(struct i8080 *cpu, uint opcode, int mem64k) {
+  cpu->cyc += 11;
+  push_word(cpu, cpu->PC, mem64k);
+  cpu->PC = opcode & 0x38;
+}
+
+// IN - Input
+// Returns 0 if the handler left the value pending, in which case the CPU
+// parks until i8080_complete_in provides it
+ALWAYS_INLINE static int in(struct i8080 *cpu, int mem64k) {
+  cpu->cyc += 10;
+  uint dev = next_byte(cpu, mem64k);
+  if (cpu->recording != NULL && cpu->recording->have_next) {
+    uint val = 0;
+    if (replay_io(cpu, EVENT_IN, dev, &val)) {
+      cpu->A = val;
+      return 1;
+    }
+  }
+
+  struct i8080_port *port = cpu->ports != NULL && cpu->ports[dev].mapped ?
+                            &cpu->ports[dev] : NULL;
+
+  if (port != NULL && port->in == NULL) {
+    // Ports that are just registers need no call, and so no flags either
+    cpu->A = port->latch;
+  } else if (port != NULL || cpu->input_handler != NULL) {
+    // Handlers see (and may change) an up to date flags register
+    end_lazy_flags(cpu);
+    uint val = port != NULL ? port->in(cpu, port->ctx, dev) :
+                              cpu->input_handler(cpu, dev);
+    begin_lazy_flags(cpu);
+
+    if (val == I8080_IN_PENDING) {
+      cpu->in_pending = 1;
+      cpu->in_port = dev;
+      return 0;
+    }
+    cpu->A = val;
+  }
+
+  if (cpu->recording != NULL) {
+    record_event(cpu, EVENT_IN, dev, cpu->A);
+  }
+
+  return 1;
+}
+
+int i8080_complete_in(struct i8080 *cpu, uint val) {
+  if (!cpu->in_pending) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  cpu->A = val;
+  cpu->in_pending = 0;
+
+  // Logged as if the value had been there all along
+  if (cpu->recording != NULL) {
+    record_event(cpu, EVENT_IN, cpu->in_port, cpu->A);
+  }
+
+  return 0;
+}
+
+ALWAYS_INLINE static void out(struct i8080 *cpu, int mem64k) {
+  cpu->cyc += 10;
+  uint dev = next_byte(cpu, mem64k);
+  if (cpu->recording != NULL) {
+    uint val = cpu->A;
+    if (cpu->recording->have_next && replay_io(cpu, EVENT_OUT, dev, &val)) {
+      return;
+    }
+
+    // Logged before calling the handler, which may request interrupts
+    record_event(cpu, EVENT_OUT, dev, cpu->A);
+  }
+
+  struct i8080_port *port = cpu->ports != NULL && cpu->ports[dev].mapped ?
+                            &cpu->ports[dev] : NULL;
+
+  if (port != NULL && port->out == NULL) {
+    port->latch = cpu->A;
+  } else if (port != NULL) {
+    end_lazy_flags(cpu);
+    port->out(cpu, port->ctx, dev, cpu->A);
+    begin_lazy_flags(cpu);
+  } else if (cpu->output_handler != NULL) {
+    end_lazy_flags(cpu);
+    cpu->output_handler(cpu, dev, cpu->A);
+    begin_lazy_flags(cpu);
+  }
+}
+
+void i8080_step(struct i8080 *cpu) {
+  // Every instruction takes at least 4 cycles, so a 1 cycle budget executes
+  // exactly one
+  i8080_run(cpu, 1);
+}
+
+#ifdef I8080_THREADED_DISPATCH
+#ifndef __GNUC__
+#error "I8080_THREADED_DISPATCH requires GNU C computed gotos"
+#endif
+
+// Direct threaded interpreter core
+// Every opcode gets its own label with its register operands spelled out, and
+// each handler jumps straight to the next opcode's label through
+// dispatch_table rather than going back around a switch.
+#define GET_M() read_byte(cpu, CONCAT(cpu->H, cpu->L), mem64k)
+#define SET_M(val) write_byte(cpu, CONCAT(cpu->H, cpu->L), (val), mem64k)
+#define CARRY() (cpu->flag_cy)
+#define PAIR(hi, lo) CONCAT(cpu->hi, cpu->lo)
+#define SET_PAIR(hi, lo, val) do { \
+    uint pair_val = (val); \
+    cpu->hi = (pair_val >> 8) & 0xFF; \
+    cpu->lo = pair_val & 0xFF; \
+  } while (0)
+
+#define DISPATCH() do { \
+    if (cpu->cyc - start >= cycles) goto done; \
+    goto *dispatch_table[next_instruction_opcode(cpu, mem64k)]; \
+  } while (0)
+
+// After a control transfer, leaving if a trap handler halted the CPU
+#define TRAP() do { \
+    if (check_trap(cpu)) goto done; \
+  } while (0)
+
+#define OP(opcode, body) op_##opcode: body; DISPATCH()
+#define OP_CYC(opcode, cyc_count, body) \
+  op_##opcode: cpu->cyc += (cyc_count); body; DISPATCH()
+
+// GCC won't copy a function that keeps label addresses in a static table, so
+// rather than being inlined into an instance per memory mode like the switch
+// core, this one is included once for each
+#define EXECUTE execute_checked
+#define MEM64K 0
+#include "i8080_threaded_core.h"
+#undef EXECUTE
+#undef MEM64K
+
+#define EXECUTE execute_64k
+#define MEM64K 1
+#include "i8080_threaded_core.h"
+#undef EXECUTE
+#undef MEM64K
+
+#undef GET_M
+#undef SET_M
+#undef CARRY
+#undef PAIR
+#undef SET_PAIR
+#undef DISPATCH
+#undef TRAP
+#undef OP
+#undef OP_CYC
+#else
+// Instructions only the switch core goes through, the threaded core having
+// its own handler for each opcode
+
+// Registers are stored in opcode order, with M (6) standing in for memory
+ALWAYS_INLINE static void set_reg(struct i8080 *cpu, uint reg, uint val,
+                                  int mem64k) {
+  if (reg == 6) {
+    write_byte(cpu, CONCAT(cpu->H, cpu->L), val & 0xFF, mem64k);
+  } else {
+    cpu->regs[reg & 0x07] = (uint8_t) val;
+  }
+}
+
+ALWAYS_INLINE static uint get_reg(struct i8080 *cpu, uint reg, int mem64k) {
+  if (reg == 6) {
+    return read_byte(cpu, CONCAT(cpu->H, cpu->L), mem64k);
+  }
+  return cpu->regs[reg & 0x07];
+}
+
+// MOV - Move
+ALWAYS_INLINE static void mov(struct i8080 *cpu, uint opcode, int mem64k) {
+  uint dst = (opcode & 0x38) >> 3;
+  uint src = opcode & 0x07;
+  cpu->cyc += (dst == 6 || src == 6) ? 7 : 5;
+
+  set_reg(cpu, dst, get_reg(cpu, src, mem64k), mem64k);
+}
+
+// MVI - Move Immediate
+ALWAYS_INLINE static void mvi(struct i8080 *cpu, uint opcode, int mem64k) {
+  uint reg = (opcode & 0x38) >> 3;
+  cpu->cyc += (reg == 6) ? 10 : 7;
+  set_reg(cpu, reg, next_byte(cpu, mem64k), mem64k);
+}
+
+// LXI - Load Register Pair Immediate
+ALWAYS_INLINE static void lxi(struct i8080 *cpu, uint opcode, int mem64k) {
+  cpu->cyc += 10;
+  uint reg_pair = (opcode & 0x30) >> 4;
+  set_reg_pair(cpu, reg_pair, next_word(cpu, mem64k));
+}
+
+// STAX - Store Accumulator
+ALWAYS_INLINE static void stax(struct i8080 *cpu, uint opcode, int mem64k) {
+  cpu->cyc += 7;
+  uint reg_pair = (opcode & 0x30) >> 4;
+  write_byte(cpu, get_reg_pair(cpu, reg_pair), cpu->A, mem64k);
+}
+
+// LDAX - Load Accumulator
+ALWAYS_INLINE static void ldax(struct i8080 *cpu, uint opcode, int mem64k) {
+  cpu->cyc += 7;
+  uint reg_pair = (opcode & 0x30) >> 4;
+  cpu->A = read_byte(cpu, get_reg_pair(cpu, reg_pair), mem64k);
+}
+
+// INR - Increment Register or Memory
+ALWAYS_INLINE static void inr(struct i8080 *cpu, uint opcode, int mem64k) {
+  uint reg = (opcode & 0x38) >> 3;
+  cpu->cyc += (reg == 6) ? 10 : 5;
+
+  set_reg(cpu, reg, perform_inr(cpu, get_reg(cpu, reg, mem64k)), mem64k);
+}
+
+// DCR - Decrement Register or Memory
+ALWAYS_INLINE static void dcr(struct i8080 *cpu, uint opcode, int mem64k) {
+  uint reg = (opcode & 0x38) >> 3;
+  cpu->cyc += (reg == 6) ? 10 : 5;
+
+  set_reg(cpu, reg, perform_dcr(cpu, get_reg(cpu, reg, mem64k)), mem64k);
+}
+
+// INX - Increment Register Pair
+static void inx(struct i8080 *cpu, uint opcode) {
+  cpu->cyc += 5;
+  uint reg = (opcode & 0x30) >> 4;
+  set_reg_pair(cpu, reg, get_reg_pair(cpu, reg)+1);
+}
+
+// DCX - Decrement Register Pair
+static void dcx(struct i8080 *cpu, uint opcode) {
+  cpu->cyc += 5;
+  uint reg = (opcode & 0x30) >> 4;
+  set_reg_pair(cpu, reg, get_reg_pair(cpu, reg)-1);
+}
+
+// ADD - Add Register or Memory to Accumulator
+ALWAYS_INLINE static void add(struct i8080 *cpu, uint opcode, int mem64k) {
+  uint reg = opcode & 0x7;
+  cpu->cyc += (reg == 6) ? 7 : 4;
+  cpu->A = perform_add(cpu, cpu->A, get_reg(cpu, reg, mem64k), 0);
+}
+
+// ADC - Add Register or Memory to Accumulator With Carry
+ALWAYS_INLINE static void adc(struct i8080 *cpu, uint opcode, int mem64k) {
+  uint reg = opcode & 0x7;
+  cpu->cyc += (reg == 6) ? 7 : 4;
+  cpu->A = perform_add(cpu, cpu->A, get_reg(cpu, reg, mem64k), cpu->flag_cy);
+}
+
+// SBB - Subtract Register or Memory from Accumulator with Borrow
+ALWAYS_INLINE static void sbb(struct i8080 *cpu, uint opcode, int mem64k) {
+  uint reg = opcode & 0x7;
+  cpu->cyc += (reg == 6) ? 7 : 4;
+  cpu->A = perform_sub(cpu, cpu->A, get_reg(cpu, reg, mem64k), cpu->flag_cy);
+}
+
+// SUB - Subtract Register or Memory from Accumulator
+ALWAYS_INLINE static void sub(struct i8080 *cpu, uint opcode, int mem64k) {
+  uint reg = opcode & 0x7;
+  cpu->cyc += (reg == 6) ? 7 : 4;
+  cpu->A = perform_sub(cpu, cpu->A, get_reg(cpu, reg, mem64k), 0);
+}
+
+// ANA - Logical and Memory or Register with Accumulator
+ALWAYS_INLINE static void ana(struct i8080 *cpu, uint opcode, int mem64k) {
+  uint reg = opcode & 0x07;
+  cpu->cyc += (reg == 6) ? 7 : 4;
+  perform_ana(cpu, get_reg(cpu, reg, mem64k));
+}
+
+// XRA - Logical Exclusive-Or Register or Memory With Accumulator
+ALWAYS_INLINE static void xra(struct i8080 *cpu, uint opcode, int mem64k) {
+  uint reg = opcode & 0x07;
+  cpu->cyc += (reg == 6) ? 7 : 4;
+  perform_xra(cpu, get_reg(cpu, reg, mem64k));
+}
+
+// ADI - Add Immediate to Accumulator
+ALWAYS_INLINE static void adi(struct i8080 *cpu, int mem64k) {
+  cpu->cyc += 7;
+  cpu->A = perform_add(cpu, cpu->A, next_byte(cpu, mem64k), 0);
+}
+
+// SUI - Subtract Immediate From Accumulator
+ALWAYS_INLINE static void sui(struct i8080 *cpu, int mem64k) {
+  cpu->cyc += 7;
+  cpu->A = perform_sub(cpu, cpu->A, next_byte(cpu, mem64k), 0);
+}
+
+// ANI - Logical and Immediate With Accumulator
+ALWAYS_INLINE static void ani(struct i8080 *cpu, int mem64k) {
+  cpu->cyc += 7;
+  perform_ana(cpu, next_byte(cpu, mem64k));
+}
+
+// ORI - Logical or Immediate With Accumulator
+ALWAYS_INLINE static void ori(struct i8080 *cpu, int mem64k) {
+  cpu->cyc += 7;
+  perform_ora(cpu, next_byte(cpu, mem64k));
+}
+
+// ACI - Add Immediate to Accumulator With Carry
+ALWAYS_INLINE static void aci(struct i8080 *cpu, int mem64k) {
+  cpu->cyc += 7;
+  cpu->A = perform_add(cpu, cpu->A, next_byte(cpu, mem64k), cpu->flag_cy);
+}
+
+// SBI - Subtract Immediate from Accumulator With Borrow
+ALWAYS_INLINE static void sbi(struct i8080 *cpu, int mem64k) {
+  cpu->cyc += 7;
+  cpu->A = perform_sub(cpu, cpu->A, next_byte(cpu, mem64k), cpu->flag_cy);
+}
+
+// XRI - Logical Exclusive-Or Immediate With Accumulator
+ALWAYS_INLINE static void xri(struct i8080 *cpu, int mem64k) {
+  cpu->cyc += 7;
+  perform_xra(cpu, next_byte(cpu, mem64k));
+}
+
+// CPI - Compare Immediate With Accumulator
+ALWAYS_INLINE static void cpi(struct i8080 *cpu, int mem64k) {
+  cpu->cyc += 7;
+  perform_sub(cpu, cpu->A, next_byte(cpu, mem64k), 0);
+}
+
+// CMP - Compare Memory or Register With Accumulator
+ALWAYS_INLINE static void cmp(struct i8080 *cpu, uint opcode, int mem64k) {
+  uint reg = opcode & 0x7;
+  cpu->cyc += (reg == 6) ? 7 : 4;
+  perform_sub(cpu, cpu->A, get_reg(cpu, reg, mem64k), 0);
+}
+
+// ORA - Logical or Memory or Register with Accumulator
+ALWAYS_INLINE static void ora(struct i8080 *cpu, uint opcode, int mem64k) {
+  uint reg = opcode & 0x07;
+  cpu->cyc += (reg == 6) ? 7 : 4;
+  perform_ora(cpu, get_reg(cpu, reg, mem64k));
+}
+
+// DAD - Double Add
+static void dad(struct i8080 *cpu, uint opcode) {
+  cpu->cyc += 10;
+  uint reg_pair = (opcode & 0x30) >> 4;
+  perform_dad(cpu, get_reg_pair(cpu, reg_pair));
+}
+
+// CALL - Call
+// CZ   - Call if Zero
+// CNC  - Call if no Carry
+// CC   - Call if Carry
+// CPO  - Call if Parity Odd
+// CPE  - Call if Parity Even
+// CP   - Call if Plus
+// CM   - Call if Minus
+ALWAYS_INLINE static void general_call(struct i8080 *cpu, uint opcode,
+                                       int mem64k) {
+  cpu->cyc += 11;
+
+  // Unconditional call has LSB set, conditional calls do not
+  perform_call(cpu, (opcode & 1) || check_condition(cpu, (opcode >> 3) & 0x07),
+               mem64k);
+}
+
+// RET - Return
+// RNZ - Return if not Zero
+// RZ  - Return if Zero
+// RNC - Return if no Carry
+// RC  - Return if Carry
+// RPO - Return if Parity Odd
+// RPE - Return if Parity Even
+// RP  - Return if Parity Odd
+// RP  - Return if Plus
+// RM  - Return if Minus
+ALWAYS_INLINE static void general_return(struct i8080 *cpu, uint opcode,
+                                         int mem64k) {
+  cpu->cyc += 5;
+
+  // Unconditional return has LSB set, conditional returns do not
+  perform_return(cpu, (opcode & 1) || check_condition(cpu, (opcode >> 3) & 0x07),
+                 mem64k);
+}
+
+// JMP - Jump
+// JNZ - Jump if not Zero
+// JZ  - Jump if Zero
+// JNC - Jump if no Carry
+// JC  - Jump if Carry
+// JPO - Jump if Parity Odd
+// JPE - Jump if Parity Even
+// JP  - Jump if Parity Odd
+// JP  - Jump if Plus
+// JM  - Jump if Minus
+ALWAYS_INLINE static void general_jump(struct i8080 *cpu, uint opcode,
+                                       int mem64k) {
+  cpu->cyc += 10;
+  perform_jump(cpu, (opcode & 1) || check_condition(cpu, (opcode >> 3) & 0x07),
+               mem64k);
+}
+
+ALWAYS_INLINE static unsigned long execute_in(struct i8080 *cpu,
+                                             unsigned long cycles, int mem64k) {
+  unsigned long long start = cpu->cyc;
+
+  while (!cpu->halted && cpu->cyc - start < cycles) {
+    uint opcode = next_instruction_opcode(cpu, mem64k);
+
+    switch (opcode) {
+      case 0x00: // NOP
+      case 0x08: // NOP (alternate)
+      case 0x10: // NOP (alternate)
+      case 0x18: // NOP (alternate)
+      case 0x20: // NOP (alternate)
+      case 0x28: // NOP (alternate)
+      case 0x30: // NOP (alternate)
+      case 0x38: // NOP (alternate)
+        nop(cpu);
+        break;
+
+      case 0x22: // SHLD a16
+        shld(cpu, mem64k);
+        break;
+
+      case 0x2A: // LDHD a16
+        ldhd(cpu, mem64k);
+        break;
+
+      case 0x2F: // CMA
+        cma(cpu);
+        break;
+
+      case 0x3F: // CMC
+        cmc(cpu);
+        break;
+
+      case 0x01: // LXI B, d16
+      case 0x11: // LXI D, d16
+      case 0x21: // LXI H, d16
+      case 0x31: // LXI SP, d16
+        lxi(cpu, opcode, mem64k);
+        break;
+
+      case 0x09: // DAD B
+      case 0x19: // DAD D
+      case 0x29: // DAD H
+      case 0x39: // DAD SP
+        dad(cpu, opcode);
+        break;
+
+      case 0x37: // STC
+        stc(cpu);
+        break;
+
+      case 0x02: // STAX B
+      case 0x12: // STAX D
+        stax(cpu, opcode, mem64k);
+        break;
+
+      case 0x0A: // LDAX B
+      case 0x1A: // LDAX D
+        ldax(cpu, opcode, mem64k);
+        break;
+
+      case 0x07: // RLC
+        rlc(cpu);
+        break;
+
+      case 0x0F: // RRC
+        rrc(cpu);
+        break;
+
+      case 0x17: // RAL
+        ral(cpu);
+        break;
+
+      case 0x1F: // RAR
+        rar(cpu);
+        break;
+
+      case 0x03: // INX B
+      case 0x13: // INX D
+      case 0x23: // INX H
+      case 0x33: // INX SP
+        inx(cpu, opcode);
+        break;
+
+      case 0x0B: // DCX B
+      case 0x1B: // DCX D
+      case 0x2B: // DCX H
+      case 0x3B: // DCX SP
+        dcx(cpu, opcode);
+        break;
+
+      case 0x04: // INR B
+      case 0x0C: // INR C
+      case 0x14: // INR D
+      case 0x1C: // INR E
+      case 0x24: // INR H
+      case 0x2C: // INR L
+      case 0x34: // INR M
+      case 0x3C: // INR A
+        inr(cpu, opcode, mem64k);
+        break;
+
+      case 0x05: // DCR B
+      case 0x0D: // DCR C
+      case 0x15: // DCR D
+      case 0x1D: // DCR E
+      case 0x25: // DCR H
+      case 0x2D: // DCR L
+      case 0x35: // DCR M
+      case 0x3D: // DCR A
+        dcr(cpu, opcode, mem64k);
+        break;
+
+      case 0x27: // DAA
+        daa(cpu);
+        break;
+
+      case 0x06: // MVI B, d8
+      case 0x0E: // MVI C, d8
+      case 0x16: // MVI D, d8
+      case 0x1E: // MVI E, d8
+      case 0x2E: // MVI L, d8
+      case 0x3E: // MVI A, d8
+      case 0x26: // MVI H, d8
+      case 0x36: // MVI M, d8
+        mvi(cpu, opcode, mem64k);
+        break;
+
+      case 0x32: // STA a16
+        sta(cpu, mem64k);
+        break;
+
+      case 0x3A: // LDA a16
+        lda(cpu, mem64k);
+        break;
+
+      case 0x40: // MOV B, B
+      case 0x41: // MOV B, C
+      case 0x42: // MOV B, D
+      case 0x43: // MOV B, E
+      case 0x44: // MOV B, E
+      case 0x45: // MOV B, H
+      case 0x46: // MOV B, L
+      case 0x47: // MOV B, M
+      case 0x48: // MOV B, A
+      case 0x49: // MOV C, B
+      case 0x4A: // MOV C, C
+      case 0x4B: // MOV C, D
+      case 0x4C: // MOV C, E
+      case 0x4D: // MOV C, L
+      case 0x4E: // MOV C, M
+      case 0x4F: // MOV C, A
+      case 0x50: // MOV D, B
+      case 0x51: // MOV D, C
+      case 0x52: // MOV D, D
+      case 0x53: // MOV D, E
+      case 0x54: // MOV D, H
+      case 0x55: // MOV D, L
+      case 0x56: // MOV D, M
+      case 0x57: // MOV D, A
+      case 0x58: // MOV E, B
+      case 0x59: // MOV E, C
+      case 0x5A: // MOV E, D
+      case 0x5B: // MOV E, E
+      case 0x5C: // MOV E, H
+      case 0x5D: // MOV E, L
+      case 0x5E: // MOV E, M
+      case 0x5F: // MOV E, A
+      case 0x60: // MOV H, B
+      case 0x61: // MOV H, C
+      case 0x62: // MOV H, D
+      case 0x63: // MOV H, E
+      case 0x64: // MOV H, H
+      case 0x65: // MOV H, L
+      case 0x66: // MOV H, M
+      case 0x67: // MOV H, A
+      case 0x68: // MOV L, B
+      case 0x69: // MOV L, C
+      case 0x6A: // MOV L, D
+      case 0x6B: // MOV L, E
+      case 0x6C: // MOV L, H
+      case 0x6D: // MOV L, L
+      case 0x6E: // MOV L, M
+      case 0x6F: // MOV L, A
+      case 0x70: // MOV M, B
+      case 0x71: // MOV M, C
+      case 0x72: // MOV M, D
+      case 0x73: // MOV M, E
+      case 0x74: // MOV M, H
+      case 0x75: // MOV M, L
+      case 0x77: // MOV M, A
+      case 0x78: // MOV A, B
+      case 0x79: // MOV A, C
+      case 0x7A: // MOV A, D
+      case 0x7B: // MOV A, E
+      case 0x7C: // MOV A, H
+      case 0x7D: // MOV A, L
+      case 0x7E: // MOV A, M
+      case 0x7F: // MOV A, A
+        mov(cpu, opcode, mem64k);
+        break;
+
+      case 0x76: // HLT
+        hlt(cpu);
+        break;
+
+      case 0x80: // ADD B
+      case 0x81: // ADD C
+      case 0x82: // ADD D
+      case 0x83: // ADD E
+      case 0x84: // ADD H
+      case 0x85: // ADD L
+      case 0x86: // ADD M
+      case 0x87: // ADD A
+        add(cpu, opcode, mem64k);
+        break;
+
+      case 0x88: // ADC B
+      case 0x89: // ADC C
+      case 0x8A: // ADC D
+      case 0x8B: // ADC E
+      case 0x8C: // ADC H
+      case 0x8D: // ADC L
+      case 0x8E: // ADC M
+      case 0x8F: // ADC A
+        adc(cpu, opcode, mem64k);
+        break;
+
+      case 0x90: // SUB B
+      case 0x91: // SUB C
+      case 0x92: // SUB D
+      case 0x93: // SUB E
+      case 0x94: // SUB H
+      case 0x95: // SUB L
+      case 0x96: // SUB M
+      case 0x97: // SUB A
+        sub(cpu, opcode, mem64k);
+        break;
+
+      case 0x98: // SBB B
+      case 0x99: // SBB C
+      case 0x9A: // SBB D
+      case 0x9B: // SBB E
+      case 0x9C: // SBB H
+      case 0x9D: // SBB L
+      case 0x9E: // SBB M
+      case 0x9F: // SBB A
+        sbb(cpu, opcode, mem64k);
+        break;
+
+      case 0xA0: // ANA B
+      case 0xA1: // ANA C
+      case 0xA2: // ANA D
+      case 0xA3: // ANA E
+      case 0xA4: // ANA H
+      case 0xA5: // ANA L
+      case 0xA6: // ANA M
+      case 0xA7: // ANA A
+        ana(cpu, opcode, mem64k);
+        break;
+
+      case 0xDB: // IN d8
+        if (!in(cpu, mem64k)) {
+          goto parked;
+        }
+        break;
+
+      case 0xD3: // OUT d8
+        out(cpu, mem64k);
+        break;
+
+      case 0xC6: // ADI d8
+        adi(cpu, mem64k);
+        break;
+
+      case 0xD6: // SUI d8
+        sui(cpu, mem64k);
+        break;
+
+      case 0xE6: // ANI d8
+        ani(cpu, mem64k);
+        break;
+
+      case 0xF6: // ORI d8
+        ori(cpu, mem64k);
+        break;
+
+      case 0xCE: // ACI d8
+        aci(cpu, mem64k);
+        break;
+
+      case 0xDE: // SBI d8
+        sbi(cpu, mem64k);
+        break;
+
+      case 0xEE: // XRI d8
+        xri(cpu, mem64k);
+        break;
+
+      case 0xFE: // CPI d8
+        cpi(cpu, mem64k);
+        break;
+
+      case 0xA8: // XRA B
+      case 0xA9: // XRA C
+      case 0xAA: // XRA D
+      case 0xAB: // XRA E
+      case 0xAC: // XRA H
+      case 0xAD: // XRA L
+      case 0xAE: // XRA M
+      case 0xAF: // XRA A
+        xra(cpu, opcode, mem64k);
+        break;
+
+      case 0xB0: // ORA B
+      case 0xB1: // ORA C
+      case 0xB2: // ORA D
+      case 0xB3: // ORA E
+      case 0xB4: // ORA H
+      case 0xB5: // ORA L
+      case 0xB6: // ORA M
+      case 0xB7: // ORA A
+        ora(cpu, opcode, mem64k);
+        break;
+
+      case 0xB8: // CMP B
+      case 0xB9: // CMP C
+      case 0xBA: // CMP D
+      case 0xBB: // CMP E
+      case 0xBC: // CMP H
+      case 0xBD: // CMP L
+      case 0xBE: // CMP M
+      case 0xBF: // CMP A
+        cmp(cpu, opcode, mem64k);
+        break;
+
+      case 0xC1: // POP B
+      case 0xD1: // POP D
+      case 0xE1: // POP H
+      case 0xF1: // POP PSW
+        pop(cpu, opcode, mem64k);
+        break;
+
+      case 0xC5: // PUSH B
+      case 0xD5: // PUSH D
+      case 0xE5: // PUSH H
+      case 0xF5: // PUSH PSW
+        push(cpu, opcode, mem64k);
+        break;
+
+      case 0xC3: // JMP a16
+      case 0xCB: // JMP a16 (alternate)
+      case 0xC2: // JNZ a16
+      case 0xCA: // JZ a16
+      case 0xD2: // JNC a16
+      case 0xDA: // JC a16
+      case 0xE2: // JPO a16
+      case 0xEA: // JPE a16
+      case 0xF2: // JP a16
+      case 0xFA: // JM a16
+        general_jump(cpu, opcode, mem64k);
+        check_trap(cpu);
+        break;
+
+      case 0xE9: // PCHL
+        pchl(cpu);
+        check_trap(cpu);
+        break;
+
+      case 0xC9: // RET
+      case 0xD9: // RET (alternate)
+      case 0xC0: // RNZ
+      case 0xC8: // RZ
+      case 0xD0: // RNC
+      case 0xD8: // RC
+      case 0xE0: // RPO
+      case 0xE8: // RPE
+      case 0xF0: // RP
+      case 0xF8: // RM
+        general_return(cpu, opcode, mem64k);
+        check_trap(cpu);
+        break;
+
+      case 0xC7: // RST 0
+      case 0xCF: // RST 1
+      case 0xD7: // RST 2
+      case 0xDF: // RST 3
+      case 0xE7: // RST 4
+      case 0xEF: // RST 5
+      case 0xF7: // RST 6
+      case 0xFF: // RST 7
+        rst(cpu, opcode, mem64k);
+        check_trap(cpu);
+        break;
+
+      case 0xF3: // DI
+        di(cpu);
+        break;
+
+      case 0xFB: // EI
+        ei(cpu);
+        break;
+
+      case 0xCD: // CALL a16
+      case 0xDD: // CALL a16 (alternate)
+      case 0xED: // CALL a16 (alternate)
+      case 0xFD: // CALL a16 (alternate)
+      case 0xC4: // CNZ a16
+      case 0xCC: // CZ a16
+      case 0xD4: // CNC a16
+      case 0xDC: // CC a16
+      case 0xE4: // CPO a16
+      case 0xEC: // CPE a16
+      case 0xF4: // CP a16
+      case 0xFC: // CM a16
+        general_call(cpu, opcode, mem64k);
+        check_trap(cpu);
+        break;
+
+      case 0xE3: // XTHL
+        xthl(cpu, mem64k);
+        break;
+
+      case 0xEB: // XCHG
+        xchg(cpu);
+        break;
+
+      case 0xF9: // SPHL
+        sphl(cpu);
+        break;
+
+      default:
+        fprintf(stderr, "Opcode not implemented 0x%x\n", opcode);
+        exit(1);
+    }
+  }
+
+parked:
+  return cpu->cyc - start;
+}
+
+static unsigned long execute_checked(struct i8080 *cpu, unsigned long cycles) {
+  return execute_in(cpu, cycles, 0);
+}
+
+static unsigned long execute_64k(struct i8080 *cpu, unsigned long cycles) {
+  return execute_in(cpu, cycles, 1);
+}
+#endif
+
+// The interpreter for the memory mode, for the executors that fall back on it
+// (run picks the instance itself)
+static unsigned long execute(struct i8080 *cpu, unsigned long cycles) {
+  if (cpu->memory_64k) {
+    return execute_64k(cpu, cycles);
+  }
+
+  return execute_checked(cpu, cycles);
+}
+
+// Whether an opcode is a jump, call, return, RST or PCHL
+static int insn_transfers(uint opcode) {
+  switch (opcode & 0xC7) {
+    case 0xC0: case 0xC2: case 0xC4: case 0xC7: // Conditionals and RST
+      return 1;
+  }
+
+  return opcode == 0xC3 || opcode == 0xCB || (opcode & 0xCF) == 0xCD ||
+         opcode == 0xC9 || opcode == 0xD9 || opcode == 0xE9;
+}
+
+// Instruction lengths and base cycle counts, for decoding blocks
+static uint insn_size(uint opcode) {
+  switch (opcode) {
+    case 0x01: case 0x11: case 0x21: case 0x31: // LXI
+    case 0x22: case 0x2A: case 0x32: case 0x3A: // SHLD, LHLD, STA, LDA
+    case 0xC2: case 0xC3: case 0xCA: case 0xCB: // Jumps
+    case 0xD2: case 0xDA: case 0xE2: case 0xEA: case 0xF2: case 0xFA:
+    case 0xC4: case 0xCC: case 0xCD: case 0xD4: // Calls
+    case 0xDC: case 0xDD: case 0xE4: case 0xEC: case 0xED: case 0xF4:
+    case 0xFC: case 0xFD:
+      return 3;
+    case 0x06: case 0x0E: case 0x16: case 0x1E: // MVI
+    case 0x26: case 0x2E: case 0x36: case 0x3E:
+    case 0xC6: case 0xCE: case 0xD6: case 0xDE: // Immediate arithmetic
+    case 0xE6: case 0xEE: case 0xF6: case 0xFE:
+    case 0xD3: case 0xDB: // OUT, IN
+      return 2;
+    default:
+      return 1;
+  }
+}
+
+// Conditional calls and returns take 6 more cycles when taken
+static const uint8_t insn_cycles[256] = {
+   4, 10,  7,  5,  5,  5,  7,  4,  4, 10,  7,  5,  5,  5,  7,  4, // 0x00
+   4, 10,  7,  5,  5,  5,  7,  4,  4, 10,  7,  5,  5,  5,  7,  4, // 0x10
+   4, 10, 16,  5,  5,  5,  7,  4,  4, 10, 16,  5,  5,  5,  7,  4, // 0x20
+   4, 10, 13,  5, 10, 10, 10,  4,  4, 10, 13,  5,  5,  5,  7,  4, // 0x30
+   5,  5,  5,  5,  5,  5,  7,  5,  5,  5,  5,  5,  5,  5,  7,  5, // 0x40
+   5,  5,  5,  5,  5,  5,  7,  5,  5,  5,  5,  5,  5,  5,  7,  5, // 0x50
+   5,  5,  5,  5,  5,  5,  7,  5,  5,  5,  5,  5,  5,  5,  7,  5, // 0x60
+   7,  7,  7,  7,  7,  7,  7,  7,  5,  5,  5,  5,  5,  5,  7,  5, // 0x70
+   4,  4,  4,  4,  4,  4,  7,  4,  4,  4,  4,  4,  4,  4,  7,  4, // 0x80
+   4,  4,  4,  4,  4,  4,  7,  4,  4,  4,  4,  4,  4,  4,  7,  4, // 0x90
+   4,  4,  4,  4,  4,  4,  7,  4,  4,  4,  4,  4,  4,  4,  7,  4, // 0xA0
+   4,  4,  4,  4,  4,  4,  7,  4,  4,  4,  4,  4,  4,  4,  7,  4, // 0xB0
+   5, 10, 10, 10, 11, 11,  7, 11,  5, 11, 10, 10, 11, 17,  7, 11, // 0xC0
+   5, 10, 10, 10, 11, 11,  7, 11,  5, 11, 10, 10, 11, 17,  7, 11, // 0xD0
+   5, 10, 10, 18, 11, 11,  7, 11,  5,  5, 10,  5, 11, 17,  7, 11, // 0xE0
+   5, 10, 10,  4, 11, 11,  7, 11,  5,  5, 10,  4, 11, 17,  7, 11, // 0xF0
+};
+
+// Block cache
+// Runs of instructions are decoded once into arrays of micro-ops, each a
+// handler with its operands already extracted, and run from there on later
+// visits. A handler returns nonzero (having set PC) to leave the block, which
+// every block ends with.
+#define UOP(name) static int uop_##name(struct i8080 *cpu, const struct uop *op)
+#define REG(n) (cpu->regs[n])
+#define HL() CONCAT(cpu->H, cpu->L)
+#define MODE() (cpu->memory_64k)
+
+// Leaves the block after a store that dropped it
+static int uop_stored(struct i8080 *cpu, const struct uop *op) {
+  if (cpu->block_cache->index.current_invalidated) {
+    cpu->PC = op->next;
+    return 1;
+  }
+  return 0;
+}
+
+UOP(exit) { cpu->PC = op->next; return 1; }
+UOP(nop) { return 0; }
+UOP(hlt) { cpu->halted = 1; cpu->PC = op->next; return 1; }
+
+UOP(mov) { REG(op->dst) = REG(op->src); return 0; }
+UOP(mov_from_m) { REG(op->dst) = read_byte(cpu, HL(), MODE()); return 0; }
+UOP(mov_to_m) {
+  write_byte(cpu, HL(), REG(op->src), MODE());
+  return uop_stored(cpu, op);
+}
+UOP(mvi) { REG(op->dst) = op->imm; return 0; }
+UOP(mvi_m) {
+  write_byte(cpu, HL(), op->imm, MODE());
+  return uop_stored(cpu, op);
+}
+
+UOP(lxi) { REG(op->dst) = op->imm >> 8; REG(op->src) = op->imm & 0xFF; return 0; }
+UOP(lxi_sp) { cpu->SP = op->imm; return 0; }
+UOP(stax) {
+  write_byte(cpu, CONCAT(REG(op->dst), REG(op->src)), cpu->A, MODE());
+  return uop_stored(cpu, op);
+}
+UOP(ldax) {
+  cpu->A = read_byte(cpu, CONCAT(REG(op->dst), REG(op->src)), MODE());
+  return 0;
+}
+UOP(sta) {
+  write_byte(cpu, op->imm, cpu->A, MODE());
+  return uop_stored(cpu, op);
+}
+UOP(lda) { cpu->A = read_byte(cpu, op->imm, MODE()); return 0; }
+UOP(shld) {
+  write_byte(cpu, op->imm, cpu->L, MODE());
+  write_byte(cpu, op->imm + 1, cpu->H, MODE());
+  return uop_stored(cpu, op);
+}
+UOP(lhld) {
+  cpu->L = read_byte(cpu, op->imm, MODE());
+  cpu->H = read_byte(cpu, op->imm + 1, MODE());
+  return 0;
+}
+
+UOP(inx) {
+  uint val = CONCAT(REG(op->dst), REG(op->src)) + 1;
+  REG(op->dst) = (val >> 8) & 0xFF;
+  REG(op->src) = val & 0xFF;
+  return 0;
+}
+UOP(dcx) {
+  uint val = CONCAT(REG(op->dst), REG(op->src)) - 1;
+  REG(op->dst) = (val >> 8) & 0xFF;
+  REG(op->src) = val & 0xFF;
+  return 0;
+}
+UOP(inx_sp) { cpu->SP = (cpu->SP + 1) & 0xFFFF; return 0; }
+UOP(dcx_sp) { cpu->SP = (cpu->SP - 1) & 0xFFFF; return 0; }
+UOP(dad) { perform_dad(cpu, CONCAT(REG(op->dst), REG(op->src))); return 0; }
+UOP(dad_sp) { perform_dad(cpu, cpu->SP); return 0; }
+
+UOP(inr) { REG(op->dst) = perform_inr(cpu, REG(op->dst)); return 0; }
+UOP(dcr) { REG(op->dst) = perform_dcr(cpu, REG(op->dst)); return 0; }
+UOP(inr_m) {
+  write_byte(cpu, HL(), perform_inr(cpu, read_byte(cpu, HL(), MODE())), MODE());
+  return uop_stored(cpu, op);
+}
+UOP(dcr_m) {
+  write_byte(cpu, HL(), perform_dcr(cpu, read_byte(cpu, HL(), MODE())), MODE());
+  return uop_stored(cpu, op);
+}
+
+// Register, M and immediate forms of each accumulator operation
+#define UOP_ALU(name, body) \
+  UOP(name) { uint val = REG(op->src); body; return 0; } \
+  UOP(name##_m) { uint val = read_byte(cpu, HL(), MODE()); body; return 0; } \
+  UOP(name##_imm) { uint val = op->imm; body; return 0; }
+
+UOP_ALU(add, cpu->A = perform_add(cpu, cpu->A, val, 0))
+UOP_ALU(adc, cpu->A = perform_add(cpu, cpu->A, val, cpu->flag_cy))
+UOP_ALU(sub, cpu->A = perform_sub(cpu, cpu->A, val, 0))
+UOP_ALU(sbb, cpu->A = perform_sub(cpu, cpu->A, val, cpu->flag_cy))
+UOP_ALU(ana, perform_ana(cpu, val))
+UOP_ALU(xra, perform_xra(cpu, val))
+UOP_ALU(ora, perform_ora(cpu, val))
+UOP_ALU(cmp, perform_sub(cpu, cpu->A, val, 0))
+
+static const uop_handler alu_uops[8][3] = {
+  {uop_add, uop_add_m, uop_add_imm}, {uop_adc, uop_adc_m, uop_adc_imm},
+  {uop_sub, uop_sub_m, uop_sub_imm}, {uop_sbb, uop_sbb_m, uop_sbb_imm},
+  {uop_ana, uop_ana_m, uop_ana_imm}, {uop_xra, uop_xra_m, uop_xra_imm},
+  {uop_ora, uop_ora_m, uop_ora_imm}, {uop_cmp, uop_cmp_m, uop_cmp_imm},
+};
+
+// Instructions run by the interpreter's own functions, which add the cycles
+UOP(rlc) { rlc(cpu); return 0; }
+UOP(rrc) { rrc(cpu); return 0; }
+UOP(ral) { ral(cpu); return 0; }
+UOP(rar) { rar(cpu); return 0; }
+UOP(daa) { daa(cpu); return 0; }
+UOP(cma) { cma(cpu); return 0; }
+UOP(stc) { stc(cpu); return 0; }
+UOP(cmc) { cmc(cpu); return 0; }
+UOP(xchg) { xchg(cpu); return 0; }
+UOP(sphl) { sphl(cpu); return 0; }
+UOP(ei) { ei(cpu); return 0; }
+UOP(di) { di(cpu); return 0; }
+UOP(xthl) { xthl(cpu, MODE()); return uop_stored(cpu, op); }
+UOP(push_psw) { push(cpu, 0xF5, MODE()); return uop_stored(cpu, op); }
+UOP(pop_psw) { pop(cpu, 0xF1, MODE()); return 0; }
+
+UOP(push) {
+  push_word(cpu, CONCAT(REG(op->dst), REG(op->src)), MODE());
+  return uop_stored(cpu, op);
+}
+UOP(pop) {
+  uint val = pop_word(cpu, MODE());
+  REG(op->dst) = val >> 8;
+  REG(op->src) = val & 0xFF;
+  return 0;
+}
+
+// Instructions that end blocks
+UOP(jmp) { cpu->PC = op->imm; return 1; }
+UOP(jcc) {
+  cpu->PC = check_condition(cpu, op->src) ? op->imm : op->next;
+  return 1;
+}
+UOP(call) { push_word(cpu, op->next, MODE()); cpu->PC = op->imm; return 1; }
+UOP(ccc) {
+  if (check_condition(cpu, op->src)) {
+    cpu->cyc += 6;
+    push_word(cpu, op->next, MODE());
+    cpu->PC = op->imm;
+  } else {
+    cpu->PC = op->next;
+  }
+  return 1;
+}
+UOP(ret) { cpu->PC = pop_word(cpu, MODE()); return 1; }
+UOP(rcc) {
+  if (check_condition(cpu, op->src)) {
+    cpu->cyc += 6;
+    cpu->PC = pop_word(cpu, MODE());
+  } else {
+    cpu->PC = op->next;
+  }
+  return 1;
+}
+UOP(rst) { push_word(cpu, op->next, MODE()); cpu->PC = op->imm; return 1; }
+UOP(pchl) { cpu->PC = HL(); return 1; }
+UOP(in) { cpu->PC = op->next - 1; in(cpu, MODE()); return 1; }
+UOP(out) { cpu->PC = op->next - 1; out(cpu, MODE()); return 1; }
+
+// Decodes the instruction at pc into op, returning whether it ends the block
+static int decode_uop(struct i8080 *cpu, uint pc, struct uop *op) {
+  const char *mem = cpu->memory;
+  uint opcode = mem[pc] & 0xFF;
+  uint size = insn_size(opcode);
+  uint dst = (opcode >> 3) & 0x07;
+  uint src = opcode & 0x07;
+  uint pair = (opcode >> 4) & 0x03;
+
+  op->next = pc + size;
+  op->imm = 0;
+  if (size > 1) {
+    op->imm = mem[pc+1] & 0xFF;
+  }
+  if (size > 2) {
+    op->imm |= (mem[pc+2] & 0xFF) << 8;
+  }
+  op->dst = dst;
+  op->src = src;
+  op->cycles = insn_cycles[opcode];
+
+  if (opcode == 0x76) { // HLT
+    op->handler = uop_hlt;
+    return 1;
+  }
+
+  if (opcode >= 0x40 && opcode < 0x80) { // MOV
+    op->handler = src == 6 ? uop_mov_from_m : dst == 6 ? uop_mov_to_m : uop_mov;
+    return 0;
+  }
+
+  if (opcode >= 0x80 && opcode < 0xC0) { // Register or M arithmetic
+    op->handler = alu_uops[dst][src == 6 ? 1 : 0];
+    return 0;
+  }
+
+  if ((opcode & 0xC7) == 0xC6) { // Immediate arithmetic
+    op->handler = alu_uops[dst][2];
+    return 0;
+  }
+
+  // Register pair operands
+  op->dst = pair * 2;
+  op->src = pair * 2 + 1;
+
+  switch (opcode) {
+    case 0x00: case 0x08: case 0x10: case 0x18: // NOP
+    case 0x20: case 0x28: case 0x30: case 0x38:
+      op->handler = uop_nop;
+      return 0;
+
+    case 0x01: case 0x11: case 0x21: op->handler = uop_lxi; return 0;
+    case 0x31: op->handler = uop_lxi_sp; return 0;
+    case 0x02: case 0x12: op->handler = uop_stax; return 0;
+    case 0x0A: case 0x1A: op->handler = uop_ldax; return 0;
+    case 0x03: case 0x13: case 0x23: op->handler = uop_inx; return 0;
+    case 0x0B: case 0x1B: case 0x2B: op->handler = uop_dcx; return 0;
+    case 0x33: op->handler = uop_inx_sp; return 0;
+    case 0x3B: op->handler = uop_dcx_sp; return 0;
+    case 0x09: case 0x19: case 0x29: op->handler = uop_dad; return 0;
+    case 0x39: op->handler = uop_dad_sp; return 0;
+    case 0x22: op->handler = uop_shld; return 0;
+    case 0x2A: op->handler = uop_lhld; return 0;
+    case 0x32: op->handler = uop_sta; return 0;
+    case 0x3A: op->handler = uop_lda; return 0;
+    case 0xC1: case 0xD1: case 0xE1: op->handler = uop_pop; return 0;
+    case 0xC5: case 0xD5: case 0xE5: op->handler = uop_push; return 0;
+
+    case 0x04: case 0x0C: case 0x14: case 0x1C: // INR
+    case 0x24: case 0x2C: case 0x3C:
+      op->dst = dst;
+      op->handler = uop_inr;
+      return 0;
+    case 0x05: case 0x0D: case 0x15: case 0x1D: // DCR
+    case 0x25: case 0x2D: case 0x3D:
+      op->dst = dst;
+      op->handler = uop_dcr;
+      return 0;
+    case 0x06: case 0x0E: case 0x16: case 0x1E: // MVI
+    case 0x26: case 0x2E: case 0x3E:
+      op->dst = dst;
+      op->handler = uop_mvi;
+      return 0;
+    case 0x34: op->handler = uop_inr_m; return 0;
+    case 0x35: op->handler = uop_dcr_m; return 0;
+    case 0x36: op->handler = uop_mvi_m; return 0;
+  }
+
+  // The interpreter's functions add these cycles themselves
+  op->cycles = 0;
+
+  switch (opcode) {
+    case 0x07: op->handler = uop_rlc; return 0;
+    case 0x0F: op->handler = uop_rrc; return 0;
+    case 0x17: op->handler = uop_ral; return 0;
+    case 0x1F: op->handler = uop_rar; return 0;
+    case 0x27: op->handler = uop_daa; return 0;
+    case 0x2F: op->handler = uop_cma; return 0;
+    case 0x37: op->handler = uop_stc; return 0;
+    case 0x3F: op->handler = uop_cmc; return 0;
+    case 0xE3: op->handler = uop_xthl; return 0;
+    case 0xEB: op->handler = uop_xchg; return 0;
+    case 0xF1: op->handler = uop_pop_psw; return 0;
+    case 0xF5: op->handler = uop_push_psw; return 0;
+    case 0xF9: op->handler = uop_sphl; return 0;
+    case 0xF3: op->handler = uop_di; return 0;
+    case 0xFB: op->handler = uop_ei; return 0;
+    case 0xD3: op->handler = uop_out; return 1;
+    case 0xDB: op->handler = uop_in; return 1;
+  }
+
+  // Everything else is a jump, call, return, RST or PCHL
+  op->cycles = insn_cycles[opcode];
+  op->src = dst;
+
+  switch (opcode) {
+    case 0xC3: case 0xCB: op->handler = uop_jmp; break;
+    case 0xCD: case 0xDD: case 0xED: case 0xFD: op->handler = uop_call; break;
+    case 0xC9: case 0xD9: op->handler = uop_ret; break;
+    case 0xE9: op->handler = uop_pchl; break;
+    default:
+      switch (opcode & 0x07) {
+        case 0x00: op->handler = uop_rcc; break;
+        case 0x02: op->handler = uop_jcc; break;
+        case 0x04: op->handler = uop_ccc; break;
+        case 0x07:
+          op->handler = uop_rst;
+          op->imm = opcode & 0x38;
+          break;
+      }
+  }
+
+  return 1;
+}
+
+#undef UOP
+#undef REG
+#undef HL
+#undef MODE
+#undef UOP_ALU
+
+static void cache_reset(struct i8080_block_cache *cache) {
+  index_reset(&cache->index);
+  cache->num_blocks = 0;
+  cache->num_uops = 0;
+}
+
+static struct block_info *cache_decode(struct i8080 *cpu, uint pc) {
+  struct i8080_block_cache *cache = cpu->block_cache;
+  uint limit = cpu->memsize < 0x10000 ? (uint) cpu->memsize : 0x10000;
+
+  if (cache->num_blocks == CACHE_MAX_BLOCKS ||
+      cache->num_uops + CACHE_MAX_INSNS + 1 > CACHE_MAX_UOPS) {
+    cache_reset(cache);
+  }
+
+  struct uop *first = &cache->uops[cache->num_uops];
+  struct uop *op = first;
+  uint addr = pc;
+  uint insns = 0;
+  uint total_cycles = 0;
+  uint last_cycles = 0;
+  uint last_opcode = 0;
+  int ends = 0;
+
+  // Instructions running past the end of memory are left to the interpreter
+  while (!ends && insns < cache->max_insns && addr < limit &&
+         addr + insn_size(cpu->memory[addr] & 0xFF) <= limit) {
+    last_opcode = cpu->memory[addr] & 0xFF;
+    last_cycles = insn_cycles[last_opcode];
+    total_cycles += last_cycles;
+    ends = decode_uop(cpu, addr, op);
+    addr = op->next;
+    insns++;
+    op++;
+  }
+
+  if (insns == 0) {
+    return NULL;
+  }
+
+  if (!ends) {
+    op->handler = uop_exit;
+    op->next = addr;
+    op->cycles = 0;
+    op++;
+  }
+
+  struct cache_block *block = &cache->blocks[cache->num_blocks++];
+  block->uops = first;
+  block->info.prefix_cycles = total_cycles - last_cycles;
+  block->info.transfers = ends && insn_transfers(last_opcode);
+
+  cache->num_uops += op - first;
+  index_add(&cache->index, pc, addr - pc, &block->info);
+
+  return &block->info;
+}
+
+// Runs whole blocks while the budget allows, so cycle counts come out exactly
+// as they would from the interpreter. Interrupts are taken between blocks.
+// Shared by the block cache and the JIT, which pass in how to build a block
+// at an address and how to run one; both are inlined.
+ALWAYS_INLINE static unsigned long run_blocks(
+    struct i8080 *cpu, unsigned long cycles, struct block_index *index,
+    struct block_info *(*build)(struct i8080 *, uint),
+    void (*run)(struct i8080 *, struct block_info *)) {
+  unsigned long long start = cpu->cyc;
+
+  while (!cpu->halted && !cpu->in_pending && cpu->cyc - start < cycles) {
+    struct block_info *block = NULL;
+
+    // Blocks don't fetch through next_instruction_opcode, so posted
+    // interrupts are taken between them
+    if (mailbox_peek(cpu)) {
+      take_posted_interrupt(cpu);
+    }
+
+    if (!cpu->pending_interrupt) {
+      block = index->blocks[cpu->PC];
+      if (block == NULL) {
+        block = build(cpu, cpu->PC);
+      }
+    }
+
+    // The last instruction of a block runs if the budget isn't used up
+    // before it, like in the interpreter
+    if (block == NULL ||
+        (unsigned long) (cpu->cyc - start) + block->prefix_cycles >= cycles) {
+      execute(cpu, 1);
+      continue;
+    }
+
+    index->current = block;
+    index->current_invalidated = 0;
+    run(cpu, block);
+    index->current = NULL;
+
+    if (block->transfers) {
+      check_trap(cpu);
+    }
+  }
+
+  return cpu->cyc - start;
+}
+
+static void cache_run(struct i8080 *cpu, struct block_info *info) {
+  const struct cache_block *block = (const struct cache_block *) info;
+
+  for (const struct uop *op = block->uops;;op++) {
+    cpu->cyc += op->cycles;
+    if (op->handler(cpu, op)) {
+      break;
+    }
+  }
+}
+
+static unsigned long cache_execute(struct i8080 *cpu, unsigned long cycles) {
+  struct i8080_block_cache *cache = cpu->block_cache;
+
+  if (cpu->pages != NULL) {
+    // Memory behind a page table could change without going through us
+    return execute(cpu, cycles);
+  }
+
+  if (cache->index.memory != cpu->memory ||
+      cache->index.memsize != cpu->memsize) {
+    cache_reset(cache);
+    cache->index.memory = cpu->memory;
+    cache->index.memsize = cpu->memsize;
+  }
+
+  return run_blocks(cpu, cycles, &cache->index, cache_decode, cache_run);
+}
+
+int i8080_block_cache_enable(struct i8080 *cpu, uint max_block_insns) {
+  struct i8080_block_cache *cache = cpu->block_cache;
+
+  if (cache == NULL) {
+    cache = calloc(1, sizeof(struct i8080_block_cache));
+    if (cache == NULL) {
+      return -1;
+    }
+    cpu->block_cache = cache;
+  }
+
+  if (max_block_insns == 0 || max_block_insns > CACHE_MAX_INSNS) {
+    max_block_insns = CACHE_MAX_INSNS;
+  }
+  cache->max_insns = max_block_insns;
+  cache->index.max_len = max_block_insns * 3;
+  cache_reset(cache);
+
+  return 0;
+}
+
+void i8080_block_cache_disable(struct i8080 *cpu) {
+  free(cpu->block_cache);
+  cpu->block_cache = NULL;
+}
+
+void i8080_block_cache_flush(struct i8080 *cpu) {
+  if (cpu->block_cache != NULL) {
+    cache_reset(cpu->block_cache);
+  }
+}
+
+#ifdef I8080_JIT
+// Basic block JIT
+// Straight line runs of code are translated to x86-64 the first time they
+// are reached and cached by start address. A block ends at the first jump,
+// call, return, RST, PCHL, HLT, IN or OUT, or after max_insns instructions.
+// The 8080 state stays in struct i8080 (rbx points at it while a block runs),
+// r12 points at jit->index.covered, r13 at cpu->memory and r14 is set once a
+// store has invalidated the running block. Cycles are added up while translating
+// and only written to cpu->cyc at block exits and before calling back into C.
+
+#define JIT_RAX 0
+#define JIT_RCX 1
+#define JIT_RDX 2
+#define JIT_RSI 6
+
+// x86 ALU opcodes (register/memory destination) and their /digit forms
+#define JIT_ADD 0x01
+#define JIT_OR 0x09
+#define JIT_AND 0x21
+#define JIT_SUB 0x29
+#define JIT_XOR 0x31
+#define JIT_CMP 0x39
+#define JIT_MOV 0x89
+
+// Operands in struct i8080 are given as offset and width, the widths of the
+// fields deciding the width of the instructions that access them
+#define JIT_OFF(field) \
+  offsetof(struct i8080, field), sizeof(((struct i8080 *) 0)->field)
+#define JIT_REG(n) offsetof(struct i8080, regs) + (n), 1
+
+struct jit_emitter {
+  struct i8080 *cpu;
+  uint8_t *p;
+  // Cycles taken since cpu->cyc was last brought up to date
+  uint pending;
+};
+
+static void emit8(struct jit_emitter *e, uint val) {
+  *e->p++ = (uint8_t) val;
+}
+
+static void emit32(struct jit_emitter *e, uint val) {
+  memcpy(e->p, &val, 4);
+  e->p += 4;
+}
+
+static void emit64(struct jit_emitter *e, const void *ptr) {
+  uint64_t val = (uint64_t) (uintptr_t) ptr;
+  memcpy(e->p, &val, 8);
+  e->p += 8;
+}
+
+// ModRM for [rbx+off]
+static void emit_cpu_operand(struct jit_emitter *e, uint reg, size_t off) {
+  if (off < 0x80) {
+    emit8(e, 0x43 | (reg << 3));
+    emit8(e, off);
+  } else {
+    emit8(e, 0x83 | (reg << 3));
+    emit32(e, off);
+  }
+}
+
+// Operand size prefix for 16 bit fields, or REX.W for 64 bit ones
+static void emit_size_prefix(struct jit_emitter *e, size_t size) {
+  if (size == 2) {
+    emit8(e, 0x66);
+  } else if (size == 8) {
+    emit8(e, 0x48);
+  }
+}
+
+// movzx (or mov) reg, [rbx+off]
+static void emit_load(struct jit_emitter *e, uint reg, size_t off,
+                      size_t size) {
+  if (size < 4) {
+    emit8(e, 0x0F);
+    emit8(e, size == 1 ? 0xB6 : 0xB7);
+  } else {
+    emit8(e, 0x8B);
+  }
+  emit_cpu_operand(e, reg, off);
+}
+
+// mov [rbx+off], reg, truncated to the width of the field. Byte stores need
+// one of eax, ecx, edx or ebx, as there's no REX prefix.
+static void emit_store(struct jit_emitter *e, size_t off, size_t size,
+                       uint reg) {
+  emit_size_prefix(e, size);
+  emit8(e, size == 1 ? 0x88 : 0x89);
+  emit_cpu_operand(e, reg, off);
+}
+
+// mov [rbx+off], imm
+static void emit_store_imm(struct jit_emitter *e, size_t off, size_t size,
+                           uint imm) {
+  emit_size_prefix(e, size);
+  emit8(e, size == 1 ? 0xC6 : 0xC7);
+  emit_cpu_operand(e, 0, off);
+  if (size == 1) {
+    emit8(e, imm);
+  } else if (size == 2) {
+    emit8(e, imm);
+    emit8(e, imm >> 8);
+  } else {
+    emit32(e, imm);
+  }
+}
+
+// <op> [rbx+off], imm
+static void emit_op_mem_imm(struct jit_emitter *e, uint op, size_t off,
+                            size_t size, uint imm) {
+  int small = imm < 0x80;
+
+  emit_size_prefix(e, size);
+  if (size == 1) {
+    emit8(e, 0x80);
+  } else {
+    emit8(e, small ? 0x83 : 0x81);
+  }
+  emit_cpu_operand(e, op >> 3, off);
+  if (size == 1 || small) {
+    emit8(e, imm);
+  } else if (size == 2) {
+    emit8(e, imm);
+    emit8(e, imm >> 8);
+  } else {
+    emit32(e, imm);
+  }
+}
+
+// <op> dst, src
+static void emit_op_reg_reg(struct jit_emitter *e, uint op, uint dst,
+                            uint src) {
+  emit8(e, op);
+  emit8(e, 0xC0 | (src << 3) | dst);
+}
+
+// <op> reg, [rbx+off], zero extending narrow fields through esi first
+static void emit_op_reg_mem(struct jit_emitter *e, uint op, uint reg,
+                            size_t off, size_t size) {
+  if (size < 4) {
+    emit_load(e, JIT_RSI, off, size);
+    emit_op_reg_reg(e, op, reg, JIT_RSI);
+  } else {
+    emit8(e, op + 2);
+    emit_cpu_operand(e, reg, off);
+  }
+}
+
+// <op> reg, imm
+static void emit_op_reg_imm(struct jit_emitter *e, uint op, uint reg,
+                            uint imm) {
+  int small = imm < 0x80;
+  emit8(e, small ? 0x83 : 0x81);
+  emit8(e, 0xC0 | (op & 0x38) | reg);
+  if (small) {
+    emit8(e, imm);
+  } else {
+    emit32(e, imm);
+  }
+}
+
+// mov reg, imm
+static void emit_mov_imm(struct jit_emitter *e, uint reg, uint imm) {
+  emit8(e, 0xB8 + reg);
+  emit32(e, imm);
+}
+
+// shl (dir 4) or shr (dir 5) reg, count
+static void emit_shift(struct jit_emitter *e, uint dir, uint reg, uint count) {
+  emit8(e, 0xC1);
+  emit8(e, 0xC0 | (dir << 3) | reg);
+  emit8(e, count);
+}
+
+// rol reg16, 8, swapping the bytes of a register pair
+static void emit_swap16(struct jit_emitter *e, uint reg) {
+  emit8(e, 0x66); emit8(e, 0xC1); emit8(e, 0xC0 | reg); emit8(e, 0x08);
+}
+
+static void emit_movzx_al(struct jit_emitter *e) {
+  emit8(e, 0x0F); emit8(e, 0xB6); emit8(e, 0xC0);
+}
+
+// Calls fn(cpu) (or fn(cpu, esi))
+static void emit_call(struct jit_emitter *e, const void *fn) {
+  emit8(e, 0x48); emit8(e, 0x89); emit8(e, 0xDF); // mov rdi, rbx
+  emit8(e, 0x48); emit8(e, 0xB8); emit64(e, fn);  // mov rax, fn
+  emit8(e, 0xFF); emit8(e, 0xD0);                 // call rax
+}
+
+// Short forward jump, patched by emit_patch8
+static uint8_t *emit_jump8(struct jit_emitter *e, uint opcode) {
+  emit8(e, opcode);
+  emit8(e, 0);
+  return e->p;
+}
+
+static void emit_patch8(struct jit_emitter *e, uint8_t *from) {
+  from[-1] = (uint8_t) (e->p - from);
+}
+
+static uint8_t *emit_jump32(struct jit_emitter *e, uint opcode) {
+  emit8(e, 0x0F);
+  emit8(e, opcode);
+  emit32(e, 0);
+  return e->p;
+}
+
+static void emit_patch32(struct jit_emitter *e, uint8_t *from) {
+  int32_t rel = (int32_t) (e->p - from);
+  memcpy(from - 4, &rel, 4);
+}
+
+static void emit_prologue(struct jit_emitter *e) {
+  struct i8080_jit *jit = e->cpu->jit;
+
+  emit8(e, 0x53);                                 // push rbx
+  emit8(e, 0x41); emit8(e, 0x54);                 // push r12
+  emit8(e, 0x41); emit8(e, 0x55);                 // push r13
+  emit8(e, 0x41); emit8(e, 0x56);                 // push r14
+  emit8(e, 0x48); emit8(e, 0x83); emit8(e, 0xEC); emit8(e, 0x08); // sub rsp, 8
+  emit8(e, 0x48); emit8(e, 0x89); emit8(e, 0xFB); // mov rbx, rdi
+  emit8(e, 0x49); emit8(e, 0xBC); emit64(e, jit->index.covered); // mov r12, covered
+  emit8(e, 0x49); emit8(e, 0xBD); emit64(e, jit->index.memory); // mov r13, memory
+  emit8(e, 0x45); emit8(e, 0x31); emit8(e, 0xF6); // xor r14d, r14d
+}
+
+static void emit_commit_cycles(struct jit_emitter *e) {
+  if (e->pending > 0) {
+    emit_op_mem_imm(e, JIT_ADD, JIT_OFF(cyc), e->pending);
+  }
+}
+
+// Leaves the block with PC already set
+static void emit_return(struct jit_emitter *e) {
+  emit_commit_cycles(e);
+  emit8(e, 0x48); emit8(e, 0x83); emit8(e, 0xC4); emit8(e, 0x08); // add rsp, 8
+  emit8(e, 0x41); emit8(e, 0x5E);                 // pop r14
+  emit8(e, 0x41); emit8(e, 0x5D);                 // pop r13
+  emit8(e, 0x41); emit8(e, 0x5C);                 // pop r12
+  emit8(e, 0x5B);                                 // pop rbx
+  emit8(e, 0xC3);                                 // ret
+}
+
+static void emit_exit(struct jit_emitter *e, uint pc) {
+  emit_store_imm(e, JIT_OFF(PC), pc);
+  emit_return(e);
+}
 
-    case 0x37: // STC
-      stc(cpu);
-      break;
+// Leaves the block at pc if a store has invalidated it
+static void emit_check_invalidated(struct jit_emitter *e, uint pc) {
+  emit8(e, 0x45); emit8(e, 0x85); emit8(e, 0xF6); // test r14d, r14d
+  uint8_t *valid = emit_jump8(e, 0x74);           // jz
+  emit_exit(e, pc);
+  emit_patch8(e, valid);
+}
 
-    case 0x02: // STAX B
-    case 0x12: // STAX D
-      stax(cpu, opcode);
-      break;
+// Whether an access to addr (below 0x10000, or anywhere if wide) needs a
+// bounds check against memsize
+static int jit_needs_bounds(struct jit_emitter *e, int wide) {
+  return wide || e->cpu->memsize < 0x10000;
+}
 
-    case 0x0A: // LDAX B
-    case 0x1A: // LDAX D
-      ldax(cpu, opcode);
-      break;
+static uint jit_bounds(struct jit_emitter *e) {
+  return e->cpu->memsize < 0x7FFFFFFF ? (uint) e->cpu->memsize : 0x7FFFFFFF;
+}
 
-    case 0x07: // RLC
-      rlc(cpu);
-      break;
+// Address of the high byte of a word at a constant address, which wraps
+// around to 0x0000 in 64K mode like it does for read_word
+static uint jit_next_addr(struct jit_emitter *e, uint addr) {
+  return e->cpu->memory_64k ? (addr + 1) & 0xFFFF : addr + 1;
+}
 
-    case 0x0F: // RRC
-      rrc(cpu);
-      break;
+// eax = read_byte(edx)
+static void emit_read(struct jit_emitter *e, int wide) {
+  if (jit_needs_bounds(e, wide)) {
+    emit8(e, 0x31); emit8(e, 0xC0);               // xor eax, eax
+    emit8(e, 0x81); emit8(e, 0xFA); emit32(e, jit_bounds(e)); // cmp edx, size
+    emit8(e, 0x73); emit8(e, 0x06);               // jae over the load
+  }
+  // movzx eax, byte [r13+rdx]
+  emit8(e, 0x41); emit8(e, 0x0F); emit8(e, 0xB6); emit8(e, 0x44);
+  emit8(e, 0x15); emit8(e, 0x00);
+}
 
-    case 0x17: // RAL
-      ral(cpu);
-      break;
+static int jit_store(struct i8080 *cpu, uint addr) {
+  index_invalidate(&cpu->jit->index, addr);
+  return cpu->jit->index.current_invalidated;
+}
 
-    case 0x1F: // RAR
-      rar(cpu);
-      break;
+// write_byte(edx, cl), invalidating translated code at edx. Clobbers eax and
+// rsi, and all scratch registers when it invalidates code.
+static void emit_write(struct jit_emitter *e, int wide) {
+  uint8_t *out_of_range = NULL;
+  uint8_t *above_64k = NULL;
 
-    case 0x03: // INX B
-    case 0x13: // INX D
-    case 0x23: // INX H
-    case 0x33: // INX SP
-      inx(cpu, opcode);
-      break;
+  if (jit_needs_bounds(e, wide)) {
+    emit8(e, 0x81); emit8(e, 0xFA); emit32(e, jit_bounds(e)); // cmp edx, size
+    out_of_range = emit_jump8(e, 0x73);           // jae
+  }
 
-    case 0x0B: // DCX B
-    case 0x1B: // DCX D
-    case 0x2B: // DCX H
-    case 0x3B: // DCX SP
-      dcx(cpu, opcode);
-      break;
+  // mov [r13+rdx], cl
+  emit8(e, 0x41); emit8(e, 0x88); emit8(e, 0x4C); emit8(e, 0x15); emit8(e, 0x00);
+
+  // Mark the page dirty for snapshots
+  struct i8080_dirty_pages *tracker = e->cpu->dirty_pages;
+  if (tracker != NULL && tracker->memory == e->cpu->memory &&
+      tracker->memsize == e->cpu->memsize) {
+    emit8(e, 0x89); emit8(e, 0xD0);               // mov eax, edx
+    emit8(e, 0xC1); emit8(e, 0xE8); emit8(e, 0x08); // shr eax, 8
+    emit8(e, 0x48); emit8(e, 0xBE); emit64(e, tracker->dirty); // mov rsi, dirty
+    // mov byte [rsi+rax], 1
+    emit8(e, 0xC6); emit8(e, 0x04); emit8(e, 0x06); emit8(e, 0x01);
+  }
 
-    case 0x04: // INR B
-    case 0x0C: // INR C
-    case 0x14: // INR D
-    case 0x1C: // INR E
-    case 0x24: // INR H
-    case 0x2C: // INR L
-    case 0x34: // INR M
-    case 0x3C: // INR A
-      inr(cpu, opcode);
-      break;
+  if (wide) {
+    emit8(e, 0x81); emit8(e, 0xFA); emit32(e, 0xFFFF); // cmp edx, 0xFFFF
+    above_64k = emit_jump8(e, 0x77);              // ja
+  }
 
-    case 0x05: // DCR B
-    case 0x0D: // DCR C
-    case 0x15: // DCR D
-    case 0x1D: // DCR E
-    case 0x25: // DCR H
-    case 0x2D: // DCR L
-    case 0x35: // DCR M
-    case 0x3D: // DCR A
-      dcr(cpu, opcode);
-      break;
+  // cmp byte [r12+rdx], 0
+  emit8(e, 0x41); emit8(e, 0x80); emit8(e, 0x3C); emit8(e, 0x14); emit8(e, 0x00);
+  uint8_t *no_code = emit_jump8(e, 0x74);         // je
 
-    case 0x27: // DAA
-      daa(cpu);
-      break;
+  emit_op_reg_reg(e, JIT_MOV, JIT_RSI, JIT_RDX);
+  emit_call(e, (const void *) jit_store);
+  emit8(e, 0x41); emit8(e, 0x09); emit8(e, 0xC6); // or r14d, eax
 
-    case 0x06: // MVI B, d8
-    case 0x0E: // MVI C, d8
-    case 0x16: // MVI D, d8
-    case 0x1E: // MVI E, d8
-    case 0x2E: // MVI L, d8
-    case 0x3E: // MVI A, d8
-    case 0x26: // MVI H, d8
-    case 0x36: // MVI M, d8
-      mvi(cpu, opcode);
-      break;
+  emit_patch8(e, no_code);
+  if (above_64k != NULL) {
+    emit_patch8(e, above_64k);
+  }
+  if (out_of_range != NULL) {
+    emit_patch8(e, out_of_range);
+  }
+}
 
-    case 0x32: // STA a16
-      sta(cpu);
-      break;
+// Register pairs are stored high byte first, so each is a 16 bit load and a
+// byte swap
 
-    case 0x3A: // LDA a16
-      lda(cpu);
-      break;
+// edx = HL
+static void emit_hl(struct jit_emitter *e) {
+  emit_load(e, JIT_RDX, offsetof(struct i8080, H), 2);
+  emit_swap16(e, JIT_RDX);
+}
 
-    case 0x40: // MOV B, B
-    case 0x41: // MOV B, C
-    case 0x42: // MOV B, D
-    case 0x43: // MOV B, E
-    case 0x44: // MOV B, E
-    case 0x45: // MOV B, H
-    case 0x46: // MOV B, L
-    case 0x47: // MOV B, M
-    case 0x48: // MOV B, A
-    case 0x49: // MOV C, B
-    case 0x4A: // MOV C, C
-    case 0x4B: // MOV C, D
-    case 0x4C: // MOV C, E
-    case 0x4D: // MOV C, L
-    case 0x4E: // MOV C, M
-    case 0x4F: // MOV C, A
-    case 0x50: // MOV D, B
-    case 0x51: // MOV D, C
-    case 0x52: // MOV D, D
-    case 0x53: // MOV D, E
-    case 0x54: // MOV D, H
-    case 0x55: // MOV D, L
-    case 0x56: // MOV D, M
-    case 0x57: // MOV D, A
-    case 0x58: // MOV E, B
-    case 0x59: // MOV E, C
-    case 0x5A: // MOV E, D
-    case 0x5B: // MOV E, E
-    case 0x5C: // MOV E, H
-    case 0x5D: // MOV E, L
-    case 0x5E: // MOV E, M
-    case 0x5F: // MOV E, A
-    case 0x60: // MOV H, B
-    case 0x61: // MOV H, C
-    case 0x62: // MOV H, D
-    case 0x63: // MOV H, E
-    case 0x64: // MOV H, H
-    case 0x65: // MOV H, L
-    case 0x66: // MOV H, M
-    case 0x67: // MOV H, A
-    case 0x68: // MOV L, B
-    case 0x69: // MOV L, C
-    case 0x6A: // MOV L, D
-    case 0x6B: // MOV L, E
-    case 0x6C: // MOV L, H
-    case 0x6D: // MOV L, L
-    case 0x6E: // MOV L, M
-    case 0x6F: // MOV L, A
-    case 0x70: // MOV M, B
-    case 0x71: // MOV M, C
-    case 0x72: // MOV M, D
-    case 0x73: // MOV M, E
-    case 0x74: // MOV M, H
-    case 0x75: // MOV M, L
-    case 0x77: // MOV M, A
-    case 0x78: // MOV A, B
-    case 0x79: // MOV A, C
-    case 0x7A: // MOV A, D
-    case 0x7B: // MOV A, E
-    case 0x7C: // MOV A, H
-    case 0x7D: // MOV A, L
-    case 0x7E: // MOV A, M
-    case 0x7F: // MOV A, A
-      mov(cpu, opcode);
-      break;
+// reg = register pair (0 BC, 1 DE, 2 HL, 3 SP)
+static void emit_get_pair(struct jit_emitter *e, uint pair, uint reg) {
+  if (pair == 3) {
+    emit_load(e, reg, JIT_OFF(SP));
+  } else {
+    emit_load(e, reg, offsetof(struct i8080, regs) + pair * 2, 2);
+    emit_swap16(e, reg);
+  }
+}
 
-    case 0x76: // HLT
-      hlt(cpu);
-      break;
+// register pair = ax, clobbers ecx
+static void emit_set_pair(struct jit_emitter *e, uint pair) {
+  if (pair == 3) {
+    emit_store(e, JIT_OFF(SP), JIT_RAX);
+  } else {
+    emit_op_reg_reg(e, JIT_MOV, JIT_RCX, JIT_RAX);
+    emit_swap16(e, JIT_RCX);
+    emit_store(e, offsetof(struct i8080, regs) + pair * 2, 2, JIT_RCX);
+  }
+}
 
-    case 0x80: // ADD B
-    case 0x81: // ADD C
-    case 0x82: // ADD D
-    case 0x83: // ADD E
-    case 0x84: // ADD H
-    case 0x85: // ADD L
-    case 0x86: // ADD M
-    case 0x87: // ADD A
-      add(cpu, opcode);
-      break;
+// ecx = register or M
+static void emit_get_operand(struct jit_emitter *e, uint reg) {
+  if (reg == 6) {
+    emit_hl(e);
+    emit_read(e, 0);
+    emit_op_reg_reg(e, JIT_MOV, JIT_RCX, JIT_RAX);
+  } else {
+    emit_load(e, JIT_RCX, JIT_REG(reg));
+  }
+}
 
-    case 0x88: // ADC B
-    case 0x89: // ADC C
-    case 0x8A: // ADC D
-    case 0x8B: // ADC E
-    case 0x8C: // ADC H
-    case 0x8D: // ADC L
-    case 0x8E: // ADC M
-    case 0x8F: // ADC A
-      adc(cpu, opcode);
-      break;
+// ecx = packed flags
+static void emit_pack_flags(struct jit_emitter *e) {
+  emit_load(e, JIT_RAX, JIT_OFF(flag_res));
+  emit8(e, 0x48); emit8(e, 0xBE); emit64(e, szp_table); // mov rsi, szp_table
+  emit8(e, 0x0F); emit8(e, 0xB6); emit8(e, 0x0C); emit8(e, 0x06); // movzx ecx, [rsi+rax]
+  emit_op_reg_mem(e, JIT_OR, JIT_RCX, JIT_OFF(flag_ac));
+  emit_op_reg_mem(e, JIT_OR, JIT_RCX, JIT_OFF(flag_cy));
+  emit_op_reg_imm(e, JIT_OR, JIT_RCX, 0x02);
+}
 
-    case 0x90: // SUB B
-    case 0x91: // SUB C
-    case 0x92: // SUB D
-    case 0x93: // SUB E
-    case 0x94: // SUB H
-    case 0x95: // SUB L
-    case 0x96: // SUB M
-    case 0x97: // SUB A
-      sub(cpu, opcode);
-      break;
+// SP = SP - 1, leaving it in edx
+static void emit_push_byte(struct jit_emitter *e) {
+  emit_load(e, JIT_RDX, JIT_OFF(SP));
+  emit_op_reg_imm(e, JIT_SUB, JIT_RDX, 1);
+  emit_op_reg_imm(e, JIT_AND, JIT_RDX, 0xFFFF);
+  emit_store(e, JIT_OFF(SP), JIT_RDX);
+}
 
-    case 0x98: // SBB B
-    case 0x99: // SBB C
-    case 0x9A: // SBB D
-    case 0x9B: // SBB E
-    case 0x9C: // SBB H
-    case 0x9D: // SBB L
-    case 0x9E: // SBB M
-    case 0x9F: // SBB A
-      sbb(cpu, opcode);
-      break;
+static void emit_push_imm(struct jit_emitter *e, uint val) {
+  emit_push_byte(e);
+  emit_mov_imm(e, JIT_RCX, (val >> 8) & 0xFF);
+  emit_write(e, 0);
+  emit_push_byte(e);
+  emit_mov_imm(e, JIT_RCX, val & 0xFF);
+  emit_write(e, 0);
+}
 
-    case 0xA0: // ANA B
-    case 0xA1: // ANA C
-    case 0xA2: // ANA D
-    case 0xA3: // ANA E
-    case 0xA4: // ANA H
-    case 0xA5: // ANA L
-    case 0xA6: // ANA M
-    case 0xA7: // ANA A
-      ana(cpu, opcode);
-      break;
+// eax = popped byte
+static void emit_pop_byte(struct jit_emitter *e) {
+  emit_load(e, JIT_RDX, JIT_OFF(SP));
+  emit_read(e, 0);
+  emit_load(e, JIT_RDX, JIT_OFF(SP));
+  emit_op_reg_imm(e, JIT_ADD, JIT_RDX, 1);
+  emit_op_reg_imm(e, JIT_AND, JIT_RDX, 0xFFFF);
+  emit_store(e, JIT_OFF(SP), JIT_RDX);
+}
 
-    case 0xDB: // IN d8
-      in(cpu);
-      break;
+// PC = popped word
+static void emit_pop_pc(struct jit_emitter *e) {
+  emit_pop_byte(e);
+  emit_store(e, JIT_OFF(PC), JIT_RAX);
+  emit_pop_byte(e);
+  emit_shift(e, 4, JIT_RAX, 8);
+  emit_op_reg_mem(e, JIT_OR, JIT_RAX, JIT_OFF(PC));
+  emit_store(e, JIT_OFF(PC), JIT_RAX);
+}
 
-    case 0xD3: // OUT d8
-      out(cpu);
-      break;
+// Sets the x86 zero flag if the flag tested by condition code cond is clear
+static void emit_test_condition(struct jit_emitter *e, uint cond) {
+  static const uint8_t masks[4] = {0x40, 0x01, 0x04, 0x80};
 
-    case 0xC6: // ADI d8
-      adi(cpu);
-      break;
+  if ((cond >> 1) == 1) {
+    emit_op_mem_imm(e, JIT_CMP, JIT_OFF(flag_cy), 0);
+  } else {
+    emit_load(e, JIT_RAX, JIT_OFF(flag_res));
+    emit8(e, 0x48); emit8(e, 0xBE); emit64(e, szp_table); // mov rsi, szp_table
+    // test byte [rsi+rax], mask
+    emit8(e, 0xF6); emit8(e, 0x04); emit8(e, 0x06); emit8(e, masks[cond >> 1]);
+  }
+}
 
-    case 0xD6: // SUI d8
-      sui(cpu);
-      break;
+// Jumps (rel32, to be patched) when condition cond doesn't hold
+static uint8_t *emit_jump_unless(struct jit_emitter *e, uint cond) {
+  emit_test_condition(e, cond);
+  return emit_jump32(e, (cond & 1) ? 0x84 : 0x85);
+}
 
-    case 0xE6: // ANI d8
-      ani(cpu);
-      break;
+// ADD, ADC, SUB, SBB, CMP on A and ecx (alu is bits 3-5 of the opcode)
+static void emit_add(struct jit_emitter *e, uint alu) {
+  int sub = alu >= 2;
 
-    case 0xF6: // ORI d8
-      ori(cpu);
-      break;
+  if (sub) {
+    emit_op_reg_imm(e, JIT_XOR, JIT_RCX, 0xFF);
+  }
+  emit_load(e, JIT_RAX, JIT_OFF(A));
+  emit_op_reg_reg(e, JIT_MOV, JIT_RDX, JIT_RAX);
+  emit_op_reg_reg(e, JIT_XOR, JIT_RDX, JIT_RCX);
+  emit_op_reg_reg(e, JIT_ADD, JIT_RAX, JIT_RCX);
+  if (sub) {
+    emit_op_reg_imm(e, JIT_ADD, JIT_RAX, 1);
+  }
+  if (alu == 1) {
+    emit_op_reg_mem(e, JIT_ADD, JIT_RAX, JIT_OFF(flag_cy));
+  } else if (alu == 3) {
+    emit_op_reg_mem(e, JIT_SUB, JIT_RAX, JIT_OFF(flag_cy));
+  }
+  emit_op_reg_reg(e, JIT_XOR, JIT_RDX, JIT_RAX);
+  emit_op_reg_imm(e, JIT_AND, JIT_RDX, 0x10);
+  emit_store(e, JIT_OFF(flag_ac), JIT_RDX);
+  emit_op_reg_reg(e, JIT_MOV, JIT_RDX, JIT_RAX);
+  emit_shift(e, 5, JIT_RDX, 8);
+  if (sub) {
+    emit_op_reg_imm(e, JIT_XOR, JIT_RDX, 1);
+  }
+  emit_store(e, JIT_OFF(flag_cy), JIT_RDX);
+  emit_movzx_al(e);
+  emit_store(e, JIT_OFF(flag_res), JIT_RAX);
+  if (alu != 7) {
+    emit_store(e, JIT_OFF(A), JIT_RAX);
+  }
+}
 
-    case 0xCE: // ACI d8
-      aci(cpu);
+// The eight accumulator operations on A and ecx
+static void emit_alu(struct jit_emitter *e, uint alu) {
+  switch (alu) {
+    case 4: // ANA
+      emit_load(e, JIT_RAX, JIT_OFF(A));
+      emit_op_reg_reg(e, JIT_MOV, JIT_RDX, JIT_RAX);
+      emit_op_reg_reg(e, JIT_OR, JIT_RDX, JIT_RCX);
+      emit_op_reg_imm(e, JIT_AND, JIT_RDX, 0x08);
+      emit_shift(e, 4, JIT_RDX, 1);
+      emit_store(e, JIT_OFF(flag_ac), JIT_RDX);
+      emit_op_reg_reg(e, JIT_AND, JIT_RAX, JIT_RCX);
+      emit_store(e, JIT_OFF(A), JIT_RAX);
+      emit_store(e, JIT_OFF(flag_res), JIT_RAX);
+      emit_store_imm(e, JIT_OFF(flag_cy), 0);
       break;
-
-    case 0xDE: // SBI d8
-      sbi(cpu);
+    case 5: // XRA
+    case 6: // ORA
+      emit_load(e, JIT_RAX, JIT_OFF(A));
+      emit_op_reg_reg(e, alu == 5 ? JIT_XOR : JIT_OR, JIT_RAX, JIT_RCX);
+      emit_store(e, JIT_OFF(A), JIT_RAX);
+      emit_store(e, JIT_OFF(flag_res), JIT_RAX);
+      emit_store_imm(e, JIT_OFF(flag_ac), 0);
+      emit_store_imm(e, JIT_OFF(flag_cy), 0);
       break;
+    default:
+      emit_add(e, alu);
+  }
+}
 
-    case 0xEE: // XRI d8
-      xri(cpu);
-      break;
+// INR (dec 0) or DCR (dec 1) of eax, leaving the result in eax
+static void emit_inr_dcr(struct jit_emitter *e, int dec) {
+  emit_op_reg_reg(e, JIT_MOV, JIT_RCX, JIT_RAX);
+  emit_op_reg_imm(e, dec ? JIT_SUB : JIT_ADD, JIT_RAX, 1);
+  emit_movzx_al(e);
+  emit_op_reg_reg(e, JIT_XOR, JIT_RCX, JIT_RAX);
+  if (dec) {
+    emit8(e, 0xF7); emit8(e, 0xD1);               // not ecx
+  }
+  emit_op_reg_imm(e, JIT_AND, JIT_RCX, 0x10);
+  emit_store(e, JIT_OFF(flag_ac), JIT_RCX);
+  emit_store(e, JIT_OFF(flag_res), JIT_RAX);
+}
 
-    case 0xFE: // CPI d8
-      cpi(cpu);
-      break;
+static void jit_daa(struct i8080 *cpu) {
+  daa(cpu);
+}
 
-    case 0xA8: // XRA B
-    case 0xA9: // XRA C
-    case 0xAA: // XRA D
-    case 0xAB: // XRA E
-    case 0xAC: // XRA H
-    case 0xAD: // XRA L
-    case 0xAE: // XRA M
-    case 0xAF: // XRA A
-      xra(cpu, opcode);
-      break;
+static int jit_xthl(struct i8080 *cpu) {
+  xthl(cpu, cpu->memory_64k);
+  return cpu->jit->index.current_invalidated;
+}
 
-    case 0xB0: // ORA B
-    case 0xB1: // ORA C
-    case 0xB2: // ORA D
-    case 0xB3: // ORA E
-    case 0xB4: // ORA H
-    case 0xB5: // ORA L
-    case 0xB6: // ORA M
-    case 0xB7: // ORA A
-      ora(cpu, opcode);
-      break;
+static void jit_in(struct i8080 *cpu) {
+  in(cpu, cpu->memory_64k);
+}
 
-    case 0xB8: // CMP B
-    case 0xB9: // CMP C
-    case 0xBA: // CMP D
-    case 0xBB: // CMP E
-    case 0xBC: // CMP H
-    case 0xBD: // CMP L
-    case 0xBE: // CMP M
-    case 0xBF: // CMP A
-      cmp(cpu, opcode);
-      break;
+static void jit_out(struct i8080 *cpu) {
+  out(cpu, cpu->memory_64k);
+}
+
+// Translates the instruction at pc, returning its cycle count (the base count
+// for conditional calls and returns). Sets *ends if it ends the block.
+static uint jit_translate(struct jit_emitter *e, uint pc, int *ends) {
+  const char *mem = e->cpu->memory;
+  uint opcode = mem[pc] & 0xFF;
+  uint next = pc + insn_size(opcode);
+  uint imm8 = mem[pc+1] & 0xFF;
+  uint imm16 = imm8 | ((mem[pc+2] & 0xFF) << 8);
+  uint dst = (opcode >> 3) & 0x07;
+  uint src = opcode & 0x07;
+  uint pair = (opcode >> 4) & 0x03;
+
+  *ends = 0;
+
+  if (opcode == 0x76) { // HLT
+    emit_store_imm(e, JIT_OFF(halted), 1);
+    e->pending += 7;
+    emit_exit(e, next);
+    *ends = 1;
+    return 7;
+  }
+
+  if (opcode >= 0x40 && opcode < 0x80) { // MOV
+    if (src == 6) {
+      emit_hl(e);
+      emit_read(e, 0);
+      emit_store(e, JIT_REG(dst), JIT_RAX);
+    } else if (dst == 6) {
+      emit_hl(e);
+      emit_load(e, JIT_RCX, JIT_REG(src));
+      emit_write(e, 0);
+    } else if (src != dst) {
+      emit_load(e, JIT_RAX, JIT_REG(src));
+      emit_store(e, JIT_REG(dst), JIT_RAX);
+    }
+    return (src == 6 || dst == 6) ? 7 : 5;
+  }
+
+  if (opcode >= 0x80 && opcode < 0xC0) { // Register or M arithmetic
+    emit_get_operand(e, src);
+    emit_alu(e, dst);
+    return src == 6 ? 7 : 4;
+  }
 
-    case 0xC1: // POP B
-    case 0xD1: // POP D
-    case 0xE1: // POP H
+  if ((opcode & 0xC7) == 0xC6) { // Immediate arithmetic
+    emit_mov_imm(e, JIT_RCX, imm8);
+    emit_alu(e, dst);
+    return 7;
+  }
+
+  switch (opcode) {
+    case 0x00: case 0x08: case 0x10: case 0x18: // NOP
+    case 0x20: case 0x28: case 0x30: case 0x38:
+      return 4;
+
+    case 0x01: case 0x11: case 0x21: // LXI
+      emit_store_imm(e, JIT_REG(pair * 2), imm16 >> 8);
+      emit_store_imm(e, JIT_REG(pair * 2 + 1), imm16 & 0xFF);
+      return 10;
+    case 0x31: // LXI SP
+      emit_store_imm(e, JIT_OFF(SP), imm16);
+      return 10;
+
+    case 0x02: case 0x12: // STAX
+      emit_get_pair(e, pair, JIT_RDX);
+      emit_load(e, JIT_RCX, JIT_OFF(A));
+      emit_write(e, 0);
+      return 7;
+    case 0x0A: case 0x1A: // LDAX
+      emit_get_pair(e, pair, JIT_RDX);
+      emit_read(e, 0);
+      emit_store(e, JIT_OFF(A), JIT_RAX);
+      return 7;
+
+    case 0x03: case 0x13: case 0x23: case 0x33: // INX
+    case 0x0B: case 0x1B: case 0x2B: case 0x3B: // DCX
+      emit_get_pair(e, pair, JIT_RAX);
+      emit_op_reg_imm(e, (opcode & 0x08) ? JIT_SUB : JIT_ADD, JIT_RAX, 1);
+      emit_set_pair(e, pair);
+      return 5;
+
+    case 0x09: case 0x19: case 0x29: case 0x39: // DAD
+      emit_get_pair(e, pair, JIT_RCX);
+      emit_hl(e);
+      emit_op_reg_reg(e, JIT_MOV, JIT_RAX, JIT_RDX);
+      emit_op_reg_reg(e, JIT_ADD, JIT_RAX, JIT_RCX);
+      emit_op_reg_reg(e, JIT_MOV, JIT_RDX, JIT_RAX);
+      emit_shift(e, 5, JIT_RDX, 16);
+      emit_op_reg_imm(e, JIT_AND, JIT_RDX, 1);
+      emit_store(e, JIT_OFF(flag_cy), JIT_RDX);
+      emit_set_pair(e, 2);
+      return 10;
+
+    case 0x04: case 0x0C: case 0x14: case 0x1C: // INR
+    case 0x24: case 0x2C: case 0x3C:
+    case 0x05: case 0x0D: case 0x15: case 0x1D: // DCR
+    case 0x25: case 0x2D: case 0x3D:
+      emit_load(e, JIT_RAX, JIT_REG(dst));
+      emit_inr_dcr(e, opcode & 1);
+      emit_store(e, JIT_REG(dst), JIT_RAX);
+      return 5;
+    case 0x34: case 0x35: // INR M, DCR M
+      emit_hl(e);
+      emit_read(e, 0);
+      emit_inr_dcr(e, opcode & 1);
+      emit_op_reg_reg(e, JIT_MOV, JIT_RCX, JIT_RAX);
+      emit_write(e, 0);
+      return 10;
+
+    case 0x06: case 0x0E: case 0x16: case 0x1E: // MVI
+    case 0x26: case 0x2E: case 0x3E:
+      emit_store_imm(e, JIT_REG(dst), imm8);
+      return 7;
+    case 0x36: // MVI M
+      emit_hl(e);
+      emit_mov_imm(e, JIT_RCX, imm8);
+      emit_write(e, 0);
+      return 10;
+
+    case 0x07: // RLC
+      emit_load(e, JIT_RAX, JIT_OFF(A));
+      emit_op_reg_reg(e, JIT_MOV, JIT_RCX, JIT_RAX);
+      emit_shift(e, 5, JIT_RCX, 7);
+      emit_store(e, JIT_OFF(flag_cy), JIT_RCX);
+      emit_shift(e, 4, JIT_RAX, 1);
+      emit_op_reg_reg(e, JIT_OR, JIT_RAX, JIT_RCX);
+      emit_op_reg_imm(e, JIT_AND, JIT_RAX, 0xFF);
+      emit_store(e, JIT_OFF(A), JIT_RAX);
+      return 4;
+    case 0x0F: // RRC
+      emit_load(e, JIT_RAX, JIT_OFF(A));
+      emit_op_reg_reg(e, JIT_MOV, JIT_RCX, JIT_RAX);
+      emit_op_reg_imm(e, JIT_AND, JIT_RCX, 1);
+      emit_store(e, JIT_OFF(flag_cy), JIT_RCX);
+      emit_shift(e, 5, JIT_RAX, 1);
+      emit_shift(e, 4, JIT_RCX, 7);
+      emit_op_reg_reg(e, JIT_OR, JIT_RAX, JIT_RCX);
+      emit_store(e, JIT_OFF(A), JIT_RAX);
+      return 4;
+    case 0x17: // RAL
+      emit_load(e, JIT_RAX, JIT_OFF(A));
+      emit_load(e, JIT_RCX, JIT_OFF(flag_cy));
+      emit_op_reg_reg(e, JIT_MOV, JIT_RDX, JIT_RAX);
+      emit_shift(e, 5, JIT_RDX, 7);
+      emit_store(e, JIT_OFF(flag_cy), JIT_RDX);
+      emit_shift(e, 4, JIT_RAX, 1);
+      emit_op_reg_imm(e, JIT_AND, JIT_RAX, 0xFF);
+      emit_op_reg_imm(e, JIT_AND, JIT_RCX, 1);
+      emit_op_reg_reg(e, JIT_OR, JIT_RAX, JIT_RCX);
+      emit_store(e, JIT_OFF(A), JIT_RAX);
+      return 4;
+    case 0x1F: // RAR
+      emit_load(e, JIT_RAX, JIT_OFF(A));
+      emit_load(e, JIT_RCX, JIT_OFF(flag_cy));
+      emit_op_reg_reg(e, JIT_MOV, JIT_RDX, JIT_RAX);
+      emit_op_reg_imm(e, JIT_AND, JIT_RDX, 1);
+      emit_store(e, JIT_OFF(flag_cy), JIT_RDX);
+      emit_shift(e, 5, JIT_RAX, 1);
+      emit_shift(e, 4, JIT_RCX, 7);
+      emit_op_reg_imm(e, JIT_AND, JIT_RCX, 0x80);
+      emit_op_reg_reg(e, JIT_OR, JIT_RAX, JIT_RCX);
+      emit_store(e, JIT_OFF(A), JIT_RAX);
+      return 4;
+
+    case 0x22: // SHLD
+      emit_mov_imm(e, JIT_RDX, imm16);
+      emit_load(e, JIT_RCX, JIT_OFF(L));
+      emit_write(e, 0);
+      emit_mov_imm(e, JIT_RDX, jit_next_addr(e, imm16));
+      emit_load(e, JIT_RCX, JIT_OFF(H));
+      emit_write(e, jit_next_addr(e, imm16) > 0xFFFF);
+      return 16;
+    case 0x2A: // LHLD
+      emit_mov_imm(e, JIT_RDX, imm16);
+      emit_read(e, 0);
+      emit_store(e, JIT_OFF(L), JIT_RAX);
+      emit_mov_imm(e, JIT_RDX, jit_next_addr(e, imm16));
+      emit_read(e, jit_next_addr(e, imm16) > 0xFFFF);
+      emit_store(e, JIT_OFF(H), JIT_RAX);
+      return 16;
+
+    case 0x27: // DAA
+      // Adds its own cycles
+      emit_call(e, (const void *) jit_daa);
+      return 4;
+    case 0x2F: // CMA
+      emit_op_mem_imm(e, JIT_XOR, JIT_OFF(A), 0xFF);
+      return 4;
+    case 0x32: // STA
+      emit_mov_imm(e, JIT_RDX, imm16);
+      emit_load(e, JIT_RCX, JIT_OFF(A));
+      emit_write(e, 0);
+      return 13;
+    case 0x3A: // LDA
+      emit_mov_imm(e, JIT_RDX, imm16);
+      emit_read(e, 0);
+      emit_store(e, JIT_OFF(A), JIT_RAX);
+      return 13;
+    case 0x37: // STC
+      emit_store_imm(e, JIT_OFF(flag_cy), 1);
+      return 4;
+    case 0x3F: // CMC
+      emit_op_mem_imm(e, JIT_XOR, JIT_OFF(flag_cy), 1);
+      return 4;
+
+    case 0xC1: case 0xD1: case 0xE1: // POP
+      emit_pop_byte(e);
+      emit_store(e, JIT_REG(pair * 2 + 1), JIT_RAX);
+      emit_pop_byte(e);
+      emit_store(e, JIT_REG(pair * 2), JIT_RAX);
+      return 10;
     case 0xF1: // POP PSW
-      pop(cpu, opcode);
-      break;
+      emit_pop_byte(e);
+      emit_op_reg_reg(e, JIT_MOV, JIT_RCX, JIT_RAX);
+      emit_op_reg_imm(e, JIT_AND, JIT_RCX, 0xC4);
+      emit_op_reg_imm(e, JIT_OR, JIT_RCX, 0x100);
+      emit_store(e, JIT_OFF(flag_res), JIT_RCX);
+      emit_op_reg_reg(e, JIT_MOV, JIT_RCX, JIT_RAX);
+      emit_op_reg_imm(e, JIT_AND, JIT_RCX, 0x10);
+      emit_store(e, JIT_OFF(flag_ac), JIT_RCX);
+      emit_op_reg_imm(e, JIT_AND, JIT_RAX, 0x01);
+      emit_store(e, JIT_OFF(flag_cy), JIT_RAX);
+      emit_pop_byte(e);
+      emit_store(e, JIT_OFF(A), JIT_RAX);
+      return 10;
+
+    case 0xC5: case 0xD5: case 0xE5: case 0xF5: // PUSH
+      emit_push_byte(e);
+      emit_load(e, JIT_RCX, JIT_REG(pair == 3 ? 7 : pair * 2));
+      emit_write(e, 0);
+      emit_push_byte(e);
+      if (pair == 3) {
+        emit_pack_flags(e);
+      } else {
+        emit_load(e, JIT_RCX, JIT_REG(pair * 2 + 1));
+      }
+      emit_write(e, 0);
+      return 11;
 
-    case 0xC5: // PUSH B
-    case 0xD5: // PUSH D
-    case 0xE5: // PUSH H
-    case 0xF5: // PUSH PSW
-      push(cpu, opcode);
-      break;
+    case 0xE3: // XTHL
+      emit_call(e, (const void *) jit_xthl);
+      emit8(e, 0x41); emit8(e, 0x09); emit8(e, 0xC6); // or r14d, eax
+      return 18;
+    case 0xEB: // XCHG
+      emit_load(e, JIT_RAX, JIT_OFF(H));
+      emit_load(e, JIT_RCX, JIT_OFF(D));
+      emit_store(e, JIT_OFF(H), JIT_RCX);
+      emit_store(e, JIT_OFF(D), JIT_RAX);
+      emit_load(e, JIT_RAX, JIT_OFF(L));
+      emit_load(e, JIT_RCX, JIT_OFF(E));
+      emit_store(e, JIT_OFF(L), JIT_RCX);
+      emit_store(e, JIT_OFF(E), JIT_RAX);
+      return 5;
+    case 0xF9: // SPHL
+      emit_hl(e);
+      emit_store(e, JIT_OFF(SP), JIT_RDX);
+      return 5;
+    case 0xF3: // DI
+      emit_store_imm(e, JIT_OFF(INTE), 0);
+      return 4;
+    case 0xFB: // EI
+      emit_store_imm(e, JIT_OFF(INTE), 1);
+      return 4;
+  }
 
-    case 0xC3: // JMP a16
-    case 0xCB: // JMP a16 (alternate)
-    case 0xC2: // JNZ a16
-    case 0xCA: // JZ a16
-    case 0xD2: // JNC a16
-    case 0xDA: // JC a16
-    case 0xE2: // JPO a16
-    case 0xEA: // JPE a16
-    case 0xF2: // JP a16
-    case 0xFA: // JM a16
-      general_jump(cpu, opcode);
-      break;
+  // Everything else ends the block
+  *ends = 1;
+
+  switch (opcode) {
+    case 0xC3: case 0xCB: // JMP
+      e->pending += 10;
+      emit_exit(e, imm16);
+      return 10;
+
+    case 0xC2: case 0xCA: case 0xD2: case 0xDA: // Jcc
+    case 0xE2: case 0xEA: case 0xF2: case 0xFA:
+      emit_test_condition(e, dst);
+      emit_mov_imm(e, JIT_RAX, next);
+      emit_mov_imm(e, JIT_RCX, imm16);
+      // cmovnz/cmovz eax, ecx
+      emit8(e, 0x0F); emit8(e, (dst & 1) ? 0x45 : 0x44); emit8(e, 0xC1);
+      emit_store(e, JIT_OFF(PC), JIT_RAX);
+      e->pending += 10;
+      emit_return(e);
+      return 10;
+
+    case 0xCD: case 0xDD: case 0xED: case 0xFD: // CALL
+      emit_push_imm(e, next);
+      e->pending += 17;
+      emit_exit(e, imm16);
+      return 17;
+
+    case 0xC4: case 0xCC: case 0xD4: case 0xDC: // Ccc
+    case 0xE4: case 0xEC: case 0xF4: case 0xFC: {
+      uint8_t *not_taken = emit_jump_unless(e, dst);
+      uint pending = e->pending;
+      emit_push_imm(e, next);
+      e->pending = pending + 17;
+      emit_exit(e, imm16);
+      emit_patch32(e, not_taken);
+      e->pending = pending + 11;
+      emit_exit(e, next);
+      return 11;
+    }
+
+    case 0xC9: case 0xD9: // RET
+      emit_pop_pc(e);
+      e->pending += 11;
+      emit_return(e);
+      return 11;
+
+    case 0xC0: case 0xC8: case 0xD0: case 0xD8: // Rcc
+    case 0xE0: case 0xE8: case 0xF0: case 0xF8: {
+      uint8_t *not_taken = emit_jump_unless(e, dst);
+      uint pending = e->pending;
+      emit_pop_pc(e);
+      e->pending = pending + 11;
+      emit_return(e);
+      emit_patch32(e, not_taken);
+      e->pending = pending + 5;
+      emit_exit(e, next);
+      return 5;
+    }
+
+    case 0xC7: case 0xCF: case 0xD7: case 0xDF: // RST
+    case 0xE7: case 0xEF: case 0xF7: case 0xFF:
+      emit_push_imm(e, next);
+      e->pending += 11;
+      emit_exit(e, opcode & 0x38);
+      return 11;
 
     case 0xE9: // PCHL
-      pchl(cpu);
-      break;
+      emit_hl(e);
+      emit_store(e, JIT_OFF(PC), JIT_RDX);
+      e->pending += 5;
+      emit_return(e);
+      return 5;
+
+    case 0xD3: // OUT
+    case 0xDB: // IN
+      // The handlers may look at cyc and PC, and add their own cycles
+      emit_commit_cycles(e);
+      e->pending = 0;
+      emit_store_imm(e, JIT_OFF(PC), pc + 1);
+      emit_call(e, opcode == 0xDB ? (const void *) jit_in : (const void *) jit_out);
+      emit_return(e);
+      return 10;
+  }
 
-    case 0xC9: // RET
-    case 0xD9: // RET (alternate)
-    case 0xC0: // RNZ
-    case 0xC8: // RZ
-    case 0xD0: // RNC
-    case 0xD8: // RC
-    case 0xE0: // RPO
-    case 0xE8: // RPE
-    case 0xF0: // RP
-    case 0xF8: // RM
-      general_return(cpu, opcode);
-      break;
+  fprintf(stderr, "Opcode not translated 0x%x\n", opcode);
+  exit(1);
+}
 
-    case 0xC7: // RST 0
-    case 0xCF: // RST 1
-    case 0xD7: // RST 2
-    case 0xDF: // RST 3
-    case 0xE7: // RST 4
-    case 0xEF: // RST 5
-    case 0xF7: // RST 6
-    case 0xFF: // RST 7
-      rst(cpu, opcode);
-      break;
+// Whether the instruction may store to memory, and so invalidate the block
+// it is in
+static int jit_stores(uint opcode) {
+  switch (opcode) {
+    case 0x02: case 0x12: // STAX
+    case 0x22: case 0x32: // SHLD, STA
+    case 0x34: case 0x35: case 0x36: // INR M, DCR M, MVI M
+    case 0x70: case 0x71: case 0x72: case 0x73: // MOV M, r
+    case 0x74: case 0x75: case 0x77:
+    case 0xC5: case 0xD5: case 0xE5: case 0xF5: // PUSH
+    case 0xE3: // XTHL
+      return 1;
+    default:
+      return 0;
+  }
+}
 
-    case 0xF3: // DI
-      di(cpu);
-      break;
+// Large enough for any block
+#define JIT_BLOCK_RESERVE (JIT_MAX_INSNS * 512)
 
-    case 0xFB: // EI
-      ei(cpu);
+static void jit_reset_cache(struct i8080_jit *jit) {
+  index_reset(&jit->index);
+  jit->num_blocks = 0;
+  jit->code_used = 0;
+}
+
+static struct block_info *jit_compile(struct i8080 *cpu, uint pc) {
+  struct i8080_jit *jit = cpu->jit;
+  uint limit = cpu->memsize < 0x10000 ? (uint) cpu->memsize : 0x10000;
+
+  if (jit->num_blocks == JIT_MAX_BLOCKS ||
+      jit->code_used + JIT_BLOCK_RESERVE > JIT_CODE_SIZE) {
+    jit_reset_cache(jit);
+  }
+
+  struct jit_emitter e;
+  e.cpu = cpu;
+  e.p = jit->code + jit->code_used;
+  e.pending = 0;
+
+  uint8_t *code = e.p;
+  uint addr = pc;
+  uint insns = 0;
+  uint total_cycles = 0;
+  uint last_cycles = 0;
+  uint last_opcode = 0;
+  int ends = 0;
+
+  emit_prologue(&e);
+
+  // Instructions running past the end of memory are left to the interpreter
+  while (!ends && insns < jit->max_insns && addr < limit &&
+         addr + insn_size(cpu->memory[addr] & 0xFF) <= limit) {
+    uint opcode = cpu->memory[addr] & 0xFF;
+
+    last_opcode = opcode;
+    last_cycles = jit_translate(&e, addr, &ends);
+    total_cycles += last_cycles;
+    insns++;
+    addr += insn_size(opcode);
+
+    if (ends) {
       break;
+    }
+
+    // DAA and XTHL run the interpreter's code, which adds their cycles
+    if (opcode != 0x27 && opcode != 0xE3) {
+      e.pending += last_cycles;
+    }
+
+    if (jit_stores(opcode)) {
+      emit_check_invalidated(&e, addr);
+    }
+  }
+
+  if (insns == 0) {
+    return NULL;
+  }
+
+  if (!ends) {
+    emit_exit(&e, addr);
+  }
+
+  struct jit_block *block = &jit->pool[jit->num_blocks++];
+  block->code = (void (*)(struct i8080 *)) code;
+  block->info.prefix_cycles = total_cycles - last_cycles;
+  block->info.transfers = ends && insn_transfers(last_opcode);
+
+  jit->code_used = e.p - jit->code;
+  index_add(&jit->index, pc, addr - pc, &block->info);
+
+  return &block->info;
+}
+
+static void jit_run(struct i8080 *cpu, struct block_info *info) {
+  ((const struct jit_block *) info)->code(cpu);
+}
+
+static unsigned long jit_execute(struct i8080 *cpu, unsigned long cycles) {
+  struct i8080_jit *jit = cpu->jit;
+
+  if (cpu->pages != NULL) {
+    // Memory behind a page table can't be translated
+    return execute(cpu, cycles);
+  }
+
+  if (jit->index.memory != cpu->memory || jit->index.memsize != cpu->memsize) {
+    jit_reset_cache(jit);
+    jit->index.memory = cpu->memory;
+    jit->index.memsize = cpu->memsize;
+  }
+
+  return run_blocks(cpu, cycles, &jit->index, jit_compile, jit_run);
+}
+
+int i8080_jit_enable(struct i8080 *cpu, uint max_block_insns) {
+  struct i8080_jit *jit = cpu->jit;
+
+  if (jit == NULL) {
+    jit = calloc(1, sizeof(struct i8080_jit));
+    if (jit == NULL) {
+      return -1;
+    }
+
+    void *code = mmap(NULL, JIT_CODE_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (code == MAP_FAILED) {
+      int err = errno;
+      free(jit);
+      errno = err;
+      return -1;
+    }
+
+    jit->code = code;
+    cpu->jit = jit;
+  }
+
+  if (max_block_insns == 0 || max_block_insns > JIT_MAX_INSNS) {
+    max_block_insns = JIT_MAX_INSNS;
+  }
+  jit->max_insns = max_block_insns;
+  jit->index.max_len = max_block_insns * 3;
+  jit_reset_cache(jit);
+
+  return 0;
+}
+
+void i8080_jit_disable(struct i8080 *cpu) {
+  if (cpu->jit != NULL) {
+    munmap(cpu->jit->code, JIT_CODE_SIZE);
+    free(cpu->jit);
+    cpu->jit = NULL;
+  }
+}
+
+void i8080_jit_flush(struct i8080 *cpu) {
+  if (cpu->jit != NULL) {
+    jit_reset_cache(cpu->jit);
+  }
+}
+#else
+int i8080_jit_enable(struct i8080 *cpu, uint max_block_insns) {
+  errno = ENOSYS;
+  return -1;
+}
+
+void i8080_jit_disable(struct i8080 *cpu) {
+}
+
+void i8080_jit_flush(struct i8080 *cpu) {
+}
+#endif
+
+static void take_checkpoint(struct i8080 *cpu) {
+  struct i8080_journal *journal = cpu->journal;
+  unsigned long long oldest = journal->insns - journal->num_entries;
+
+  // Make room by dropping checkpoints from before the oldest entry first
+  while (journal->num_checkpoints > 0 &&
+         (journal->checkpoints[0].insn < oldest ||
+          journal->num_checkpoints == JOURNAL_CHECKPOINTS)) {
+    drop_checkpoint(journal, 0);
+  }
+
+  struct journal_checkpoint *checkpoint =
+      &journal->checkpoints[journal->num_checkpoints];
+  memset(&checkpoint->snapshot, 0, sizeof(checkpoint->snapshot));
+  checkpoint->insn = journal->insns;
+
+  // Saved with packed flags, as if taken between calls to i8080_run
+  end_lazy_flags(cpu);
+  if (i8080_snapshot(cpu, &checkpoint->snapshot) == 0) {
+    journal->num_checkpoints++;
+  }
+  begin_lazy_flags(cpu);
+}
+
+// Adds an entry for the instruction about to run
+static void journal_record(struct i8080 *cpu) {
+  struct i8080_journal *journal = cpu->journal;
+
+  if (journal->checkpoint_interval > 0 &&
+      journal->insns % journal->checkpoint_interval == 0) {
+    take_checkpoint(cpu);
+  }
+
+  if (journal->num_entries == journal->max_entries) {
+    evict_oldest_entry(journal);
+  }
+  journal->num_entries++;
+  journal->insns++;
+
+  struct journal_entry *entry = newest_entry(journal);
+  entry->cyc = cpu->cyc;
+  entry->SP = (uint16_t) cpu->SP;
+  entry->PC = (uint16_t) cpu->PC;
+  entry->regs[0] = (uint8_t) cpu->A;
+  entry->regs[1] = (uint8_t) cpu->B;
+  entry->regs[2] = (uint8_t) cpu->C;
+  entry->regs[3] = (uint8_t) cpu->D;
+  entry->regs[4] = (uint8_t) cpu->E;
+  entry->regs[5] = (uint8_t) cpu->H;
+  entry->regs[6] = (uint8_t) cpu->L;
+  entry->regs[7] = (uint8_t) pack_flags(cpu);
+  entry->state = (cpu->INTE ? 1 : 0) | (cpu->halted ? 2 : 0) |
+                 (cpu->pending_interrupt ? 4 : 0);
+  entry->interrupt_opcode = (uint8_t) cpu->interrupt_opcode;
+  entry->num_writes = 0;
+}
+
+// Interprets one instruction at a time, so that every store is journaled
+static unsigned long journal_execute(struct i8080 *cpu, unsigned long cycles) {
+  unsigned long long start = cpu->cyc;
+
+  while (!cpu->halted && !cpu->in_pending && cpu->cyc - start < cycles) {
+    journal_record(cpu);
+    execute(cpu, 1);
+  }
+
+  return cpu->cyc - start;
+}
+
+static unsigned long run(struct i8080 *cpu, unsigned long cycles) {
+  // A posted interrupt wakes a halted CPU, and keeps blocks from being entered
+  if (mailbox_peek(cpu)) {
+    take_posted_interrupt(cpu);
+  }
+
+  // Parked on an IN until the host completes it
+  if (cpu->halted || cpu->in_pending) {
+    return 0;
+  }
+
+  begin_lazy_flags(cpu);
+  unsigned long cyc;
+  if (cpu->journal != NULL) {
+    cyc = journal_execute(cpu, cycles);
+  } else
+#ifdef I8080_JIT
+  if (cpu->jit != NULL) {
+    cyc = jit_execute(cpu, cycles);
+  } else
+#endif
+  if (cpu->block_cache != NULL) {
+    cyc = cache_execute(cpu, cycles);
+  } else if (cpu->memory_64k) {
+    cyc = execute_64k(cpu, cycles);
+  } else {
+    cyc = execute_checked(cpu, cycles);
+  }
+  end_lazy_flags(cpu);
 
-    case 0xCD: // CALL a16
-    case 0xDD: // CALL a16 (alternate)
-    case 0xED: // CALL a16 (alternate)
-    case 0xFD: // CALL a16 (alternate)
-    case 0xC4: // CNZ a16
-    case 0xCC: // CZ a16
-    case 0xD4: // CNC a16
-    case 0xDC: // CC a16
-    case 0xE4: // CPO a16
-    case 0xEC: // CPE a16
-    case 0xF4: // CP a16
-    case 0xFC: // CM a16
-      general_call(cpu, opcode);
+  return cyc;
+}
+
+// Runs in slices ending at the next logged event, so that interrupts are
+// requested at the same instruction boundary as while recording (IN and OUT
+// are logged with the cycle count at the end of the instruction)
+static unsigned long replay_run(struct i8080 *cpu, unsigned long cycles) {
+  struct i8080_recording *recording = cpu->recording;
+  unsigned long total = 0;
+
+  while (total < cycles) {
+    replay_interrupts(cpu);
+
+    unsigned long budget = cycles - total;
+    if (recording->have_next && recording->next.cyc > cpu->cyc &&
+        recording->next.cyc - cpu->cyc < budget) {
+      budget = recording->next.cyc - cpu->cyc;
+    }
+
+    unsigned long cyc = run(cpu, budget);
+    if (cyc == 0) {
       break;
+    }
+    total += cyc;
+  }
 
-    case 0xE3: // XTHL
-      xthl(cpu);
+  return total;
+}
+
+static unsigned long run_slice(struct i8080 *cpu, unsigned long cycles) {
+  if (cpu->recording != NULL && cpu->recording->have_next) {
+    return replay_run(cpu, cycles);
+  }
+
+  return run(cpu, cycles);
+}
+
+// Calls the handlers of every event that is due, including any they schedule
+// for a cycle count that has already been reached
+static void fire_events(struct i8080 *cpu) {
+  struct i8080_scheduler *scheduler;
+
+  while ((scheduler = cpu->scheduler) != NULL && scheduler->num_events > 0 &&
+         scheduler->events[0].cyc <= cpu->cyc) {
+    struct scheduled_event event = scheduler->events[0];
+
+    // Taken off the heap first, so the handler is free to schedule or cancel
+    // events
+    scheduler->events[0] = scheduler->events[--scheduler->num_events];
+    sift_down(scheduler->events, scheduler->num_events, 0);
+
+    event.handler(cpu, event.data);
+  }
+}
+
+// Runs in slices ending at the next event, so that the CPU runs undisturbed
+// in between and every handler is called at the first instruction boundary
+// at or after its cycle count
+static unsigned long scheduled_run(struct i8080 *cpu, unsigned long cycles) {
+  unsigned long total = 0;
+
+  for (;;) {
+    fire_events(cpu);
+    if (total >= cycles) {
       break;
+    }
 
-    case 0xEB: // XCHG
-      xchg(cpu);
+    unsigned long budget = cycles - total;
+    struct i8080_scheduler *scheduler = cpu->scheduler;
+    if (scheduler != NULL && scheduler->num_events > 0 &&
+        scheduler->events[0].cyc - cpu->cyc < budget) {
+      budget = scheduler->events[0].cyc - cpu->cyc;
+    }
+
+    unsigned long cyc = run_slice(cpu, budget);
+    if (cyc == 0) {
       break;
+    }
+    total += cyc;
+  }
 
-    case 0xF9: // SPHL
-      sphl(cpu);
+  return total;
+}
+
+unsigned long i8080_run(struct i8080 *cpu, unsigned long cycles) {
+  if (cpu->scheduler != NULL) {
+    return scheduled_run(cpu, cycles);
+  }
+
+  return run_slice(cpu, cycles);
+}
+
+int i8080_next_event(struct i8080 *cpu, unsigned long long *cyc) {
+  struct i8080_scheduler *scheduler = cpu->scheduler;
+  struct i8080_recording *recording = cpu->recording;
+  int found = 0;
+
+  if (scheduler != NULL && scheduler->num_events > 0) {
+    *cyc = scheduler->events[0].cyc;
+    found = 1;
+  }
+
+  // Logged interrupts are due at a given cycle count too
+  if (recording != NULL && recording->have_next &&
+      recording->next.kind == EVENT_INTERRUPT &&
+      (!found || recording->next.cyc < *cyc)) {
+    *cyc = recording->next.cyc;
+    found = 1;
+  }
+
+  return found;
+}
+
+unsigned long i8080_run_timed(struct i8080 *cpu, unsigned long cycles) {
+  unsigned long total = 0;
+
+  // With nothing left of the budget, i8080_run still fires events that are
+  // due, as it does at the end of any budget
+  for (;;) {
+    total += i8080_run(cpu, cycles - total);
+    if (total >= cycles || !cpu->halted) {
       break;
+    }
+
+    // Posted while i8080_run was returning, and wakes the CPU on the next
+    // time around
+    if (i8080_interrupt_posted(cpu)) {
+      continue;
+    }
+
+    // Nothing happens until the next event, so skip straight to it, or to the
+    // end of the budget. i8080_run fires it on the next time around, having
+    // already fired any that were due.
+    unsigned long long until = cpu->cyc + (cycles - total);
+    unsigned long long next;
+    if (i8080_next_event(cpu, &next) && next < until) {
+      if (next <= cpu->cyc) {
+        break;
+      }
+      until = next;
+    }
+
+    total += (unsigned long) (until - cpu->cyc);
+    cpu->cyc = until;
+  }
 
-    default:
-      fprintf(stderr, "Opcode not implemented 0x%x\n", opcode);
-      exit(1);
+  return total;
+}
+
+unsigned long long i8080_run_until(struct i8080 *cpu, unsigned long long cyc) {
+  unsigned long long start = cpu->cyc;
+
+  // Budgets are only as wide as unsigned long, which may be 32 bits
+  while (cpu->cyc < cyc) {
+    unsigned long long left = cyc - cpu->cyc;
+    if (i8080_run(cpu, left < ULONG_MAX ? (unsigned long) left : ULONG_MAX) == 0) {
+      break;
+    }
   }
-}
\ No newline at end of file
+
+  return cpu->cyc - start;
+}
+
+#define NS_PER_SECOND 1000000000ull
+
+static unsigned long long clock_hz(struct i8080 *cpu) {
+  return cpu->clock_hz > 0 ? cpu->clock_hz : I8080_CLOCK_HZ;
+}
+
+// Whole seconds and the remainder are converted separately, so that neither
+// multiplication overflows for any realistic clock rate
+unsigned long long i8080_cycles_to_ns(struct i8080 *cpu,
+                                      unsigned long long cycles) {
+  unsigned long long hz = clock_hz(cpu);
+  return cycles / hz * NS_PER_SECOND + cycles % hz * NS_PER_SECOND / hz;
+}
+
+unsigned long long i8080_ns_to_cycles(struct i8080 *cpu,
+                                      unsigned long long ns) {
+  unsigned long long hz = clock_hz(cpu);
+  return ns / NS_PER_SECOND * hz + ns % NS_PER_SECOND * hz / NS_PER_SECOND;
+}
+
+unsigned long long i8080_elapsed_ns(struct i8080 *cpu) {
+  return i8080_cycles_to_ns(cpu, cpu->cyc);
+}
@@ -2,12 +2,25 @@
 #define LIB8080_H_
 
 #include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
 
 typedef unsigned int uint;
 
 struct i8080;
+struct i8080_block_cache;
+struct i8080_jit;
+struct i8080_dirty_pages;
+struct i8080_snapshot_page;
+struct i8080_recording;
+struct i8080_journal;
+struct i8080_scheduler;
 typedef uint (*i8080_in_handler)(struct i8080 *, uint);
 typedef void (*i8080_out_handler)(struct i8080 *, uint, uint);
+typedef uint (*i8080_read_handler)(struct i8080 *, void *, uint);
+typedef void (*i8080_write_handler)(struct i8080 *, void *, uint, uint);
+typedef void (*i8080_event_handler)(struct i8080 *, void *);
+typedef void (*i8080_trap_handler)(struct i8080 *, void *, uint);
 
 #define I8080_RST_0 0xC7
 #define I8080_RST_1 0xCF
@@ -18,37 +31,166 @@ typedef void (*i8080_out_handler)(struct i8080 *, uint, uint);
 #define I8080_RST_6 0xF7
 #define I8080_RST_7 0xFF
 
+#define I8080_CLOCK_HZ 2000000
+
+#define I8080_IN_PENDING 0x10000
+
+#define I8080_PAGE_SIZE 256
+#define I8080_NUM_PAGES 256
+
+#define I8080_NUM_PORTS 256
+
+#define I8080_TRAP_BYTES (0x10000 / 8)
+
+struct i8080_page {
+  char *read;
+  char *write;
+  i8080_read_handler read_handler;
+  i8080_write_handler write_handler;
+  void *ctx;
+};
+
+struct i8080_port {
+  i8080_read_handler in;
+  i8080_write_handler out;
+  void *ctx;
+  uint latch;
+  int mapped;
+};
+
+struct i8080_image {
+  char *data;
+  size_t size;
+  int mapped;
+};
+
 struct i8080 {
-  uint A, B, C, D, E;
-  uint H, L;
-  uint flags;
-  uint SP;
-  uint PC;
-  int INTE;
-  int halted;
+  union {
+    uint8_t regs[8];
+    struct {
+      uint8_t B, C, D, E, H, L;
+      uint8_t flags;
+      uint8_t A;
+    };
+  };
+  uint16_t PC;
+  uint16_t SP;
+  uint8_t INTE;
+  uint8_t halted;
+  uint8_t pending_interrupt;
+  uint8_t interrupt_opcode;
+  unsigned long long cyc;
+  uint flag_res;
+  uint8_t flag_ac;
+  uint8_t flag_cy;
+  uint8_t flags_lazy;
+  uint8_t in_pending;
   char *memory;
   size_t memsize;
+  uint8_t memory_64k;
+
+  struct i8080_page *pages;
+  struct i8080_block_cache *block_cache;
+  struct i8080_jit *jit;
+  struct i8080_dirty_pages *dirty_pages;
+  struct i8080_recording *recording;
+  struct i8080_journal *journal;
+  struct i8080_scheduler *scheduler;
 
-  int pending_interrupt;
-  uint interrupt_opcode;
+  uint mailbox;
+  uint in_port;
 
   i8080_in_handler input_handler;
   i8080_out_handler output_handler;
+  struct i8080_port *ports;
 
-  uint cyc;
+  uint8_t *traps;
+  i8080_trap_handler trap_handler;
+  void *trap_ctx;
+
+  unsigned long clock_hz;
+};
+
+struct i8080_snapshot {
+  struct i8080 state;
+  struct i8080_snapshot_page **pages;
+  size_t num_pages;
 };
 
 enum i8080_flag {FLAG_S, FLAG_Z, FLAG_A, FLAG_P, FLAG_C};
 
 void i8080_reset(struct i8080 *);
-void i8080_load_memory(struct i8080 *, char *, size_t);
+long i8080_load_memory(struct i8080 *, char *, size_t);
+
+int i8080_open_image(struct i8080_image *, const char *);
+void i8080_close_image(struct i8080_image *);
+int i8080_map_image(struct i8080 *, uint, struct i8080_image *);
+
+int i8080_memory_64k_enable(struct i8080 *);
+void i8080_memory_64k_disable(struct i8080 *);
+
+void i8080_bus_init(struct i8080 *, struct i8080_page *);
+void i8080_map_ram(struct i8080 *, uint, size_t, char *);
+void i8080_map_rom(struct i8080 *, uint, size_t, char *);
+void i8080_map_io(struct i8080 *, uint, size_t, i8080_read_handler,
+                  i8080_write_handler, void *);
+
+void i8080_ports_init(struct i8080 *, struct i8080_port *);
+void i8080_map_port(struct i8080 *, uint, i8080_read_handler,
+                    i8080_write_handler, void *);
+void i8080_latch_port(struct i8080 *, uint, uint);
+
+void i8080_traps_init(struct i8080 *, uint8_t *, i8080_trap_handler, void *);
+void i8080_set_trap(struct i8080 *, uint);
+void i8080_clear_trap(struct i8080 *, uint);
+
+int i8080_block_cache_enable(struct i8080 *, uint);
+void i8080_block_cache_disable(struct i8080 *);
+void i8080_block_cache_flush(struct i8080 *);
+
+int i8080_jit_enable(struct i8080 *, uint);
+void i8080_jit_disable(struct i8080 *);
+void i8080_jit_flush(struct i8080 *);
+
+int i8080_snapshot_enable(struct i8080 *);
+void i8080_snapshot_disable(struct i8080 *);
+int i8080_snapshot(struct i8080 *, struct i8080_snapshot *);
+int i8080_restore(struct i8080 *, const struct i8080_snapshot *);
+void i8080_free_snapshot(struct i8080_snapshot *);
+
+int i8080_record_start(struct i8080 *, FILE *);
+int i8080_replay_start(struct i8080 *, FILE *);
+int i8080_replay_active(struct i8080 *);
+int i8080_recording_stop(struct i8080 *);
+
+int i8080_journal_enable(struct i8080 *, size_t, unsigned long);
+void i8080_journal_disable(struct i8080 *);
+unsigned long i8080_journal_depth(struct i8080 *);
+unsigned long i8080_rewind(struct i8080 *, unsigned long);
+
+int i8080_schedule_event(struct i8080 *, unsigned long long,
+                         i8080_event_handler, void *);
+uint i8080_cancel_event(struct i8080 *, i8080_event_handler, void *);
+void i8080_cancel_all_events(struct i8080 *);
 
 void i8080_step(struct i8080 *);
+unsigned long i8080_run(struct i8080 *, unsigned long);
+unsigned long i8080_run_timed(struct i8080 *, unsigned long);
+unsigned long long i8080_run_until(struct i8080 *, unsigned long long);
+int i8080_next_event(struct i8080 *, unsigned long long *);
+
+unsigned long long i8080_cycles_to_ns(struct i8080 *, unsigned long long);
+unsigned long long i8080_ns_to_cycles(struct i8080 *, unsigned long long);
+unsigned long long i8080_elapsed_ns(struct i8080 *);
 
+void i8080_sync_flags(struct i8080 *);
 void i8080_set_flag(struct i8080 *, enum i8080_flag, int);
 int i8080_get_flag(struct i8080 *, enum i8080_flag);
 
 void i8080_request_interrupt(struct i8080 *, uint);
+int i8080_post_interrupt(struct i8080 *, uint);
+int i8080_interrupt_posted(struct i8080 *);
+int i8080_complete_in(struct i8080 *, uint);
 
 void i8080_push_stackb(struct i8080 *, uint);
 void i8080_push_stackw(struct i8080 *, uint);
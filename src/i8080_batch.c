@@ -0,0 +1,185 @@
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "i8080_batch.h"
+
+// Queue of machines (by index) owned by a single worker. The owner takes
+// machines from the front and puts them back at the end after each slice,
+// idle workers steal from the end.
+struct batch_queue {
+  pthread_mutex_t lock;
+  size_t *items;
+  size_t head;
+  size_t count;
+  size_t capacity;
+};
+
+struct batch {
+  struct i8080 **cpus;
+  unsigned long slice;
+  i8080_batch_callback done;
+  void *ctx;
+
+  struct batch_queue *queues;
+  int num_queues;
+
+  // Number of machines that haven't halted yet
+  size_t remaining;
+};
+
+struct batch_worker {
+  struct batch *batch;
+  int id;
+};
+
+static void queue_push(struct batch_queue *queue, size_t item) {
+  pthread_mutex_lock(&queue->lock);
+  queue->items[(queue->head + queue->count) % queue->capacity] = item;
+  queue->count++;
+  pthread_mutex_unlock(&queue->lock);
+}
+
+static int queue_take(struct batch_queue *queue, size_t *item) {
+  int found = 0;
+
+  pthread_mutex_lock(&queue->lock);
+  if (queue->count > 0) {
+    *item = queue->items[queue->head];
+    queue->head = (queue->head + 1) % queue->capacity;
+    queue->count--;
+    found = 1;
+  }
+  pthread_mutex_unlock(&queue->lock);
+
+  return found;
+}
+
+static int queue_steal(struct batch_queue *queue, size_t *item) {
+  int found = 0;
+
+  pthread_mutex_lock(&queue->lock);
+  if (queue->count > 0) {
+    queue->count--;
+    *item = queue->items[(queue->head + queue->count) % queue->capacity];
+    found = 1;
+  }
+  pthread_mutex_unlock(&queue->lock);
+
+  return found;
+}
+
+static int next_machine(struct batch *batch, int id, size_t *item) {
+  if (queue_take(&batch->queues[id], item)) {
+    return 1;
+  }
+
+  for (int i=1;i<batch->num_queues;i++) {
+    if (queue_steal(&batch->queues[(id + i) % batch->num_queues], item)) {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+static void *run_worker(void *arg) {
+  struct batch_worker *worker = arg;
+  struct batch *batch = worker->batch;
+  struct batch_queue *own = &batch->queues[worker->id];
+
+  while (__atomic_load_n(&batch->remaining, __ATOMIC_ACQUIRE) > 0) {
+    size_t item;
+
+    if (!next_machine(batch, worker->id, &item)) {
+      // Everything left is being run by other workers right now
+      sched_yield();
+      continue;
+    }
+
+    struct i8080 *cpu = batch->cpus[item];
+    i8080_run(cpu, batch->slice);
+
+    if (cpu->halted) {
+      if (batch->done != NULL) {
+        batch->done(cpu, batch->ctx);
+      }
+      __atomic_sub_fetch(&batch->remaining, 1, __ATOMIC_RELEASE);
+    } else {
+      queue_push(own, item);
+    }
+  }
+
+  return NULL;
+}
+
+int i8080_batch_run(struct i8080 **cpus, size_t count, int threads,
+                    unsigned long slice, i8080_batch_callback done,
+                    void *ctx) {
+  if (threads <= 0) {
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = online > 0 ? (int) online : 1;
+  }
+  if ((size_t) threads > count) {
+    threads = count > 0 ? (int) count : 1;
+  }
+
+  struct batch batch;
+  batch.cpus = cpus;
+  batch.slice = slice;
+  batch.done = done;
+  batch.ctx = ctx;
+  batch.num_queues = threads;
+  batch.remaining = count;
+
+  batch.queues = calloc(threads, sizeof(struct batch_queue));
+  struct batch_worker *workers = calloc(threads, sizeof(struct batch_worker));
+  pthread_t *tids = calloc(threads, sizeof(pthread_t));
+  int ok = batch.queues != NULL && workers != NULL && tids != NULL;
+
+  for (int i=0;ok && i<threads;i++) {
+    struct batch_queue *queue = &batch.queues[i];
+
+    // Each queue can hold every machine, since any of them can end up there
+    queue->items = malloc((count > 0 ? count : 1) * sizeof(size_t));
+    queue->capacity = count > 0 ? count : 1;
+    pthread_mutex_init(&queue->lock, NULL);
+    ok = queue->items != NULL;
+
+    workers[i].batch = &batch;
+    workers[i].id = i;
+  }
+
+  if (ok) {
+    for (size_t i=0;i<count;i++) {
+      queue_push(&batch.queues[i % threads], i);
+    }
+
+    // The calling thread is worker 0. If a thread can't be started, its
+    // machines just get stolen by the others.
+    int started[threads];
+    for (int i=1;i<threads;i++) {
+      started[i] = pthread_create(&tids[i], NULL, run_worker, &workers[i]) == 0;
+    }
+
+    run_worker(&workers[0]);
+
+    for (int i=1;i<threads;i++) {
+      if (started[i]) {
+        pthread_join(tids[i], NULL);
+      }
+    }
+  }
+
+  for (int i=0;batch.queues != NULL && i<threads;i++) {
+    if (batch.queues[i].items != NULL) {
+      pthread_mutex_destroy(&batch.queues[i].lock);
+      free(batch.queues[i].items);
+    }
+  }
+  free(batch.queues);
+  free(workers);
+  free(tids);
+
+  return ok ? 0 : -1;
+}
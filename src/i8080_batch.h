@@ -0,0 +1,12 @@
+#ifndef LIB8080_BATCH_H_
+#define LIB8080_BATCH_H_
+
+#include <stddef.h>
+#include "i8080.h"
+
+typedef void (*i8080_batch_callback)(struct i8080 *, void *);
+
+int i8080_batch_run(struct i8080 **, size_t, int, unsigned long,
+                    i8080_batch_callback, void *);
+
+#endif
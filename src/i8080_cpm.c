@@ -0,0 +1,1199 @@
+#include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "i8080_cpm.h"
+
+#define RECORD_SIZE 128
+#define EOF_CHAR 0x1A
+
+// Default DMA address, which is also where the command tail goes
+#define DEFAULT_DMA 0x0080
+#define TPA 0x0100
+
+#define BIOS_ENTRIES 17
+
+// Cycles run between checks for the program having exited, and between
+// writes of console output
+#define RUN_SLICE 1000000
+
+// Guest memory
+static uint guest_read(struct i8080_cpm *cpm, uint addr) {
+  return i8080_read_byte(cpm->cpu, addr & 0xFFFF);
+}
+
+static void guest_write(struct i8080_cpm *cpm, uint addr, uint val) {
+  i8080_write_byte(cpm->cpu, addr & 0xFFFF, val);
+}
+
+// BDOS results go in A and L, with B and H holding the high byte of 16 bit
+// ones
+static void set_result(struct i8080 *cpu, uint hl) {
+  cpu->A = cpu->L = hl & 0xFF;
+  cpu->B = cpu->H = (hl >> 8) & 0xFF;
+}
+
+// Console
+// Output collects in a buffer that goes out in one write, when the program
+// waits for input, at the end of each run slice, or when the buffer fills up.
+static int flush_output(struct i8080_cpm *cpm) {
+  size_t done = 0;
+
+  while (done < cpm->out_len) {
+    ssize_t len = write(cpm->out, cpm->out_buf + done, cpm->out_len - done);
+    if (len < 0 && errno == EINTR) {
+      continue;
+    }
+    if (len <= 0) {
+      cpm->out_error = 1;
+      break;
+    }
+    done += (size_t) len;
+  }
+
+  cpm->out_len = 0;
+  return cpm->out_error ? -1 : 0;
+}
+
+static void buffer_output(struct i8080_cpm *cpm, const uint8_t *data,
+                          size_t len) {
+  if (I8080_CPM_OUTPUT_SIZE - cpm->out_len < len) {
+    flush_output(cpm);
+  }
+
+  memcpy(cpm->out_buf + cpm->out_len, data, len);
+  cpm->out_len += len;
+}
+
+static void console_out(struct i8080_cpm *cpm, uint c) {
+  // NULs are padding for slow terminals, so they're dropped
+  if (c == 0) {
+    return;
+  }
+
+  if (cpm->out_len == I8080_CPM_OUTPUT_SIZE) {
+    flush_output(cpm);
+  }
+  cpm->out_buf[cpm->out_len++] = (uint8_t) c;
+}
+
+// Returns the next character typed, with newlines as the CR a terminal
+// would send, or ^Z once input runs out
+static uint console_in(struct i8080_cpm *cpm) {
+  flush_output(cpm);
+
+  int c = getc(cpm->in);
+  if (c == EOF) {
+    return EOF_CHAR;
+  }
+  return c == '\n' ? '\r' : (uint) c;
+}
+
+// Buffers a span of memory, up to any '$' in it. Returns 0 if there wasn't
+// one.
+static int write_span(struct i8080_cpm *cpm, const uint8_t *str, size_t len) {
+  const uint8_t *end = memchr(str, '$', len);
+  if (end != NULL) {
+    len = (size_t) (end - str);
+  }
+
+  while (len > 0) {
+    const uint8_t *nul = memchr(str, 0, len);
+    size_t part = nul != NULL ? (size_t) (nul - str) : len;
+
+    buffer_output(cpm, str, part);
+    if (nul == NULL) {
+      break;
+    }
+    str += part + 1;
+    len -= part + 1;
+  }
+
+  return end != NULL;
+}
+
+// Scans memory directly rather than a byte at a time, wrapping around at the
+// top, unless it goes through a page table
+static void write_string(struct i8080_cpm *cpm, uint addr) {
+  struct i8080 *cpu = cpm->cpu;
+  const uint8_t *memory = (const uint8_t *) cpu->memory;
+
+  if (cpu->pages != NULL && !cpu->memory_64k) {
+    for (uint i=0;i<0x10000;i++) {
+      uint c = guest_read(cpm, addr + i);
+      if (c == '$') {
+        break;
+      }
+      console_out(cpm, c);
+    }
+    return;
+  }
+
+  if (!write_span(cpm, memory + addr, 0x10000 - addr)) {
+    write_span(cpm, memory, addr);
+  }
+}
+
+// Reads a line into a buffer holding its maximum length, followed by the
+// length read and the characters themselves
+static void read_line(struct i8080_cpm *cpm, uint addr) {
+  uint max = guest_read(cpm, addr);
+  uint len = 0;
+  int c;
+
+  flush_output(cpm);
+  while (len < max && (c = getc(cpm->in)) != EOF && c != '\n') {
+    if (c == '\r') {
+      continue;
+    }
+    guest_write(cpm, addr + 2 + len, (uint) c);
+    console_out(cpm, (uint) c);
+    len++;
+  }
+
+  guest_write(cpm, addr + 1, len);
+  console_out(cpm, '\r');
+}
+
+// File names
+// FCBs hold names as 8 + 3 characters padded with spaces, with attributes in
+// the top bits. Host files go by the same name with a dot before any
+// extension, matched case insensitively and created in upper case.
+static int valid_char(char c) {
+  return c > ' ' && c < 0x7F && strchr("<>.,;:=?*[]|/\\\"", c) == NULL;
+}
+
+// Names can't have characters that mean something to the host, like '/' or
+// '.', so they can only ever name a file in the directory. Each part is
+// padded with spaces after any characters, and '?' is only allowed in search
+// patterns.
+static int valid_name(const uint8_t *name, int wildcards) {
+  static const int parts[][2] = {{0, 8}, {8, 11}};
+
+  if (name[0] == ' ') {
+    return 0;
+  }
+  for (int p=0;p<2;p++) {
+    int padding = 0;
+    for (int i=parts[p][0];i<parts[p][1];i++) {
+      if (name[i] == ' ') {
+        padding = 1;
+      } else if (padding ||
+                 !(valid_char((char) name[i]) ||
+                   (wildcards && name[i] == '?'))) {
+        return 0;
+      }
+    }
+  }
+
+  return 1;
+}
+
+static void read_fcb_name(struct i8080_cpm *cpm, uint fcb, uint8_t *name) {
+  for (int i=0;i<11;i++) {
+    name[i] = (uint8_t) toupper(guest_read(cpm, fcb + 1 + i) & 0x7F);
+  }
+}
+
+// Returns 0 if the FCB doesn't hold a valid name
+static int fcb_name(struct i8080_cpm *cpm, uint fcb, uint8_t *name) {
+  read_fcb_name(cpm, fcb, name);
+  return valid_name(name, 0);
+}
+
+static void host_name(const uint8_t *name, char *host) {
+  for (int i=0;i<8 && name[i] != ' ';i++) {
+    *host++ = (char) name[i];
+  }
+  if (name[8] != ' ') {
+    *host++ = '.';
+    for (int i=8;i<11 && name[i] != ' ';i++) {
+      *host++ = (char) name[i];
+    }
+  }
+  *host = '\0';
+}
+
+// Converts a host file name to FCB form, returning 0 if it doesn't fit
+static int parse_host_name(const char *host, uint8_t *name) {
+  int i = 0;
+
+  memset(name, ' ', 11);
+  for (;*host != '\0' && *host != '.';host++) {
+    if (i == 8 || !valid_char(*host)) {
+      return 0;
+    }
+    name[i++] = (uint8_t) toupper(*host);
+  }
+  if (i == 0) {
+    return 0;
+  }
+
+  if (*host == '.') {
+    for (i=8,host++;*host != '\0';host++) {
+      if (i == 11 || !valid_char(*host)) {
+        return 0;
+      }
+      name[i++] = (uint8_t) toupper(*host);
+    }
+  }
+
+  return 1;
+}
+
+// '?' in a pattern matches any character
+static int name_matches(const uint8_t *pattern, const uint8_t *name) {
+  for (int i=0;i<11;i++) {
+    if (pattern[i] != '?' && pattern[i] != name[i]) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static DIR *open_dir(struct i8080_cpm *cpm) {
+  int fd = openat(cpm->dir, ".", O_RDONLY | O_DIRECTORY);
+  if (fd < 0) {
+    return NULL;
+  }
+
+  DIR *dir = fdopendir(fd);
+  if (dir == NULL) {
+    close(fd);
+  }
+  return dir;
+}
+
+// Finds the host file going by a name, returning 0 if there isn't one
+static int find_host(struct i8080_cpm *cpm, const uint8_t *name, char *host) {
+  struct stat st;
+  uint8_t other[11];
+  int found = 0;
+
+  host_name(name, host);
+  if (fstatat(cpm->dir, host, &st, 0) == 0) {
+    return 1;
+  }
+
+  DIR *dir = open_dir(cpm);
+  if (dir == NULL) {
+    return 0;
+  }
+
+  struct dirent *entry;
+  while (!found && (entry = readdir(dir)) != NULL) {
+    if (parse_host_name(entry->d_name, other) && memcmp(other, name, 11) == 0) {
+      strcpy(host, entry->d_name);
+      found = 1;
+    }
+  }
+
+  closedir(dir);
+  return found;
+}
+
+// Open files
+// Records are read and written through a large buffer per file, so that
+// most 128 byte record accesses are a copy rather than a system call.
+static int flush_file(struct i8080_cpm_file *file) {
+  if (file->dirty_end > file->dirty_start) {
+    size_t len = file->dirty_end - file->dirty_start;
+    if (pwrite(file->fd, file->buf + file->dirty_start, len,
+               file->buf_pos + (off_t) file->dirty_start) != (ssize_t) len) {
+      return -1;
+    }
+  }
+
+  file->dirty_start = 0;
+  file->dirty_end = 0;
+  return 0;
+}
+
+static int close_file(struct i8080_cpm_file *file) {
+  int err = flush_file(file);
+
+  if (close(file->fd) < 0) {
+    err = -1;
+  }
+  file->fd = -1;
+  memset(file->name, 0, sizeof(file->name));
+  file->buf_len = 0;
+
+  return err;
+}
+
+// Closes a file without writing out anything left in its buffer
+static void drop_file(struct i8080_cpm_file *file) {
+  file->dirty_start = 0;
+  file->dirty_end = 0;
+  close_file(file);
+}
+
+static struct i8080_cpm_file *find_file(struct i8080_cpm *cpm,
+                                        const uint8_t *name) {
+  for (int i=0;i<I8080_CPM_MAX_FILES;i++) {
+    struct i8080_cpm_file *file = &cpm->files[i];
+    if (file->fd >= 0 && memcmp(file->name, name, 11) == 0) {
+      file->used = ++cpm->clock;
+      return file;
+    }
+  }
+
+  return NULL;
+}
+
+// A free slot, or the least recently used one after closing its file
+static struct i8080_cpm_file *free_file(struct i8080_cpm *cpm) {
+  struct i8080_cpm_file *lru = &cpm->files[0];
+
+  for (int i=0;i<I8080_CPM_MAX_FILES;i++) {
+    struct i8080_cpm_file *file = &cpm->files[i];
+    if (file->fd < 0) {
+      return file;
+    }
+    if (file->used < lru->used) {
+      lru = file;
+    }
+  }
+
+  close_file(lru);
+  return lru;
+}
+
+// Opens (or with create, creates or truncates) a file, reusing it if it's
+// already open. Returns NULL if there's no such file.
+static struct i8080_cpm_file *open_file(struct i8080_cpm *cpm,
+                                        const uint8_t *name, int create) {
+  struct i8080_cpm_file *file = find_file(cpm, name);
+  char host[13];
+  struct stat st;
+  int fd;
+
+  if (file != NULL && create) {
+    drop_file(file);
+  } else if (file != NULL) {
+    return file;
+  }
+
+  if (create) {
+    if (!find_host(cpm, name, host)) {
+      host_name(name, host);
+    }
+    fd = openat(cpm->dir, host, O_RDWR | O_CREAT | O_TRUNC, 0666);
+  } else {
+    if (!find_host(cpm, name, host)) {
+      return NULL;
+    }
+    fd = openat(cpm->dir, host, O_RDWR);
+    if (fd < 0 && (errno == EACCES || errno == EROFS)) {
+      fd = openat(cpm->dir, host, O_RDONLY);
+    }
+  }
+  if (fd < 0) {
+    return NULL;
+  }
+
+  if (fstat(fd, &st) < 0) {
+    close(fd);
+    return NULL;
+  }
+
+  file = free_file(cpm);
+  if (file->buf == NULL) {
+    file->buf = malloc(I8080_CPM_BUFFER_SIZE);
+    if (file->buf == NULL) {
+      close(fd);
+      return NULL;
+    }
+  }
+
+  memcpy(file->name, name, 11);
+  file->fd = fd;
+  file->size = st.st_size;
+  file->used = ++cpm->clock;
+  file->buf_pos = 0;
+  file->buf_len = 0;
+  file->dirty_start = 0;
+  file->dirty_end = 0;
+
+  return file;
+}
+
+// Reads a record, with any part of it past the end of the file filled with
+// ^Z. Returns 1 at the end of the file, or -1 on errors.
+static int read_record(struct i8080_cpm_file *file, unsigned long record,
+                       uint8_t *data) {
+  off_t offset = (off_t) record * RECORD_SIZE;
+
+  if (offset >= file->size) {
+    return 1;
+  }
+
+  if (offset < file->buf_pos ||
+      offset + RECORD_SIZE > file->buf_pos + (off_t) file->buf_len) {
+    if (flush_file(file) < 0) {
+      return -1;
+    }
+
+    ssize_t len = pread(file->fd, file->buf, I8080_CPM_BUFFER_SIZE, offset);
+    if (len < 0) {
+      return -1;
+    }
+    file->buf_pos = offset;
+    file->buf_len = (size_t) len;
+  }
+
+  size_t start = (size_t) (offset - file->buf_pos);
+  size_t len = file->buf_len - start < RECORD_SIZE ?
+               file->buf_len - start : RECORD_SIZE;
+  if (len == 0) {
+    return 1;
+  }
+
+  memcpy(data, file->buf + start, len);
+  memset(data + len, EOF_CHAR, RECORD_SIZE - len);
+  return 0;
+}
+
+// Writes a record into the buffer, writing out the buffer first if the
+// record isn't next to what it already holds
+static int write_record(struct i8080_cpm_file *file, unsigned long record,
+                        const uint8_t *data) {
+  off_t offset = (off_t) record * RECORD_SIZE;
+
+  if (offset < file->buf_pos ||
+      offset > file->buf_pos + (off_t) file->buf_len ||
+      offset + RECORD_SIZE > file->buf_pos + I8080_CPM_BUFFER_SIZE) {
+    if (flush_file(file) < 0) {
+      return -1;
+    }
+    file->buf_pos = offset;
+    file->buf_len = 0;
+  }
+
+  size_t start = (size_t) (offset - file->buf_pos);
+  memcpy(file->buf + start, data, RECORD_SIZE);
+
+  if (file->dirty_end == file->dirty_start) {
+    file->dirty_start = start;
+    file->dirty_end = start + RECORD_SIZE;
+  } else {
+    if (start < file->dirty_start) {
+      file->dirty_start = start;
+    }
+    if (start + RECORD_SIZE > file->dirty_end) {
+      file->dirty_end = start + RECORD_SIZE;
+    }
+  }
+  if (start + RECORD_SIZE > file->buf_len) {
+    file->buf_len = start + RECORD_SIZE;
+  }
+  if (offset + RECORD_SIZE > file->size) {
+    file->size = offset + RECORD_SIZE;
+  }
+
+  return 0;
+}
+
+static unsigned long file_records(off_t size) {
+  return (unsigned long) ((size + RECORD_SIZE - 1) / RECORD_SIZE);
+}
+
+// FCB positions
+// Sequential accesses go by the current record (cr) within the extent (ex)
+// of 128 records, within the module (s2) of 32 extents. Random accesses go
+// by the record number in r0 - r2.
+static unsigned long seq_record(struct i8080_cpm *cpm, uint fcb) {
+  return ((unsigned long) (guest_read(cpm, fcb + 14) & 0x3F) << 12) +
+         ((unsigned long) (guest_read(cpm, fcb + 12) & 0x1F) << 7) +
+         guest_read(cpm, fcb + 32);
+}
+
+// Sets the record count (rc) of the extent holding a record
+static void set_record_count(struct i8080_cpm *cpm, uint fcb, off_t size,
+                             unsigned long record) {
+  unsigned long records = file_records(size);
+  unsigned long base = record & ~0x7FUL;
+  unsigned long count = records > base ? records - base : 0;
+
+  guest_write(cpm, fcb + 15, count > 0x80 ? 0x80 : (uint) count);
+}
+
+static void set_position(struct i8080_cpm *cpm, uint fcb,
+                         struct i8080_cpm_file *file, unsigned long record) {
+  guest_write(cpm, fcb + 12, (record >> 7) & 0x1F);
+  guest_write(cpm, fcb + 14, (record >> 12) & 0x3F);
+  guest_write(cpm, fcb + 32, record & 0x7F);
+  set_record_count(cpm, fcb, file->size, record);
+}
+
+static void set_random_record(struct i8080_cpm *cpm, uint fcb,
+                              unsigned long record) {
+  guest_write(cpm, fcb + 33, record & 0xFF);
+  guest_write(cpm, fcb + 34, (record >> 8) & 0xFF);
+  guest_write(cpm, fcb + 35, (record >> 16) & 0xFF);
+}
+
+// Searching
+// Matching names are collected up front, so search next just works through
+// them
+static int add_found(struct i8080_cpm *cpm, const uint8_t *name,
+                     unsigned long records) {
+  if ((cpm->num_found & (cpm->num_found - 1)) == 0) {
+    size_t capacity = cpm->num_found ? cpm->num_found * 2 : 16;
+    uint8_t (*found)[11] = realloc(cpm->found, capacity * sizeof(*found));
+    if (found == NULL) {
+      return -1;
+    }
+    cpm->found = found;
+
+    unsigned long *found_records = realloc(cpm->found_records,
+                                           capacity * sizeof(*found_records));
+    if (found_records == NULL) {
+      return -1;
+    }
+    cpm->found_records = found_records;
+  }
+
+  memcpy(cpm->found[cpm->num_found], name, 11);
+  cpm->found_records[cpm->num_found] = records;
+  cpm->num_found++;
+
+  return 0;
+}
+
+static void search_files(struct i8080_cpm *cpm, const uint8_t *pattern) {
+  uint8_t name[11];
+
+  cpm->num_found = 0;
+  cpm->next_found = 0;
+
+  DIR *dir = open_dir(cpm);
+  if (dir == NULL) {
+    return;
+  }
+
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != NULL) {
+    struct stat st;
+
+    if (!parse_host_name(entry->d_name, name) ||
+        !name_matches(pattern, name) ||
+        fstatat(cpm->dir, entry->d_name, &st, 0) < 0 ||
+        !S_ISREG(st.st_mode)) {
+      continue;
+    }
+
+    // Open files may have writes that are only buffered so far
+    struct i8080_cpm_file *file = find_file(cpm, name);
+    if (add_found(cpm, name, file_records(file ? file->size : st.st_size)) < 0) {
+      break;
+    }
+  }
+
+  closedir(dir);
+}
+
+// Puts the next match in the DMA buffer as a directory entry describing the
+// last extent of the file
+static uint next_found(struct i8080_cpm *cpm) {
+  if (cpm->next_found == cpm->num_found) {
+    return 0xFF;
+  }
+
+  const uint8_t *name = cpm->found[cpm->next_found];
+  unsigned long records = cpm->found_records[cpm->next_found];
+  unsigned long last = records ? records - 1 : 0;
+  cpm->next_found++;
+
+  guest_write(cpm, cpm->dma, cpm->user);
+  for (int i=0;i<11;i++) {
+    guest_write(cpm, cpm->dma + 1 + i, name[i]);
+  }
+  guest_write(cpm, cpm->dma + 12, (last >> 7) & 0x1F);
+  guest_write(cpm, cpm->dma + 13, 0);
+  guest_write(cpm, cpm->dma + 14, (last >> 12) & 0x3F);
+  guest_write(cpm, cpm->dma + 15, records ? (uint) (records - (last & ~0x7FUL)) : 0);
+  for (int i=16;i<32;i++) {
+    guest_write(cpm, cpm->dma + i, 0);
+  }
+
+  return 0;
+}
+
+// Returns 0 if the FCB doesn't hold a valid pattern
+static int search_pattern(struct i8080_cpm *cpm, uint fcb, uint8_t *pattern) {
+  if (guest_read(cpm, fcb) == '?') {
+    memset(pattern, '?', 11);
+    return 1;
+  }
+
+  read_fcb_name(cpm, fcb, pattern);
+  return valid_name(pattern, 1);
+}
+
+// BDOS file functions
+static uint open_fcb(struct i8080_cpm *cpm, uint fcb) {
+  uint8_t name[11];
+
+  if (!fcb_name(cpm, fcb, name)) {
+    return 0xFF;
+  }
+  struct i8080_cpm_file *file = open_file(cpm, name, 0);
+  if (file == NULL) {
+    return 0xFF;
+  }
+
+  set_record_count(cpm, fcb, file->size, seq_record(cpm, fcb) & ~0x7FUL);
+  return 0;
+}
+
+static uint close_fcb(struct i8080_cpm *cpm, uint fcb) {
+  uint8_t name[11];
+
+  // The file stays open, in case it's opened again
+  if (!fcb_name(cpm, fcb, name)) {
+    return 0xFF;
+  }
+  struct i8080_cpm_file *file = find_file(cpm, name);
+  if (file != NULL && flush_file(file) < 0) {
+    return 0xFF;
+  }
+
+  return 0;
+}
+
+static uint make_fcb(struct i8080_cpm *cpm, uint fcb) {
+  uint8_t name[11];
+
+  if (!fcb_name(cpm, fcb, name) || open_file(cpm, name, 1) == NULL) {
+    return 0xFF;
+  }
+
+  guest_write(cpm, fcb + 15, 0);
+  return 0;
+}
+
+static uint delete_fcb(struct i8080_cpm *cpm, uint fcb) {
+  uint8_t pattern[11];
+  char host[13];
+  uint result = 0xFF;
+
+  if (!search_pattern(cpm, fcb, pattern)) {
+    return 0xFF;
+  }
+  search_files(cpm, pattern);
+
+  for (size_t i=0;i<cpm->num_found;i++) {
+    struct i8080_cpm_file *file = find_file(cpm, cpm->found[i]);
+    if (file != NULL) {
+      drop_file(file);
+    }
+    if (find_host(cpm, cpm->found[i], host) &&
+        unlinkat(cpm->dir, host, 0) == 0) {
+      result = 0;
+    }
+  }
+
+  cpm->num_found = 0;
+  return result;
+}
+
+static uint rename_fcb(struct i8080_cpm *cpm, uint fcb) {
+  uint8_t from[11], to[11];
+  char from_host[13], to_host[13];
+
+  if (!fcb_name(cpm, fcb, from) || !fcb_name(cpm, fcb + 16, to) ||
+      !find_host(cpm, from, from_host)) {
+    return 0xFF;
+  }
+
+  // CP/M won't rename over an existing file
+  if (find_host(cpm, to, to_host)) {
+    return 0xFF;
+  }
+
+  struct i8080_cpm_file *file = find_file(cpm, from);
+  if (file != NULL && close_file(file) < 0) {
+    return 0xFF;
+  }
+
+  return renameat(cpm->dir, from_host, cpm->dir, to_host) == 0 ? 0 : 0xFF;
+}
+
+static uint read_fcb(struct i8080_cpm *cpm, uint fcb, unsigned long record,
+                     int advance) {
+  uint8_t name[11], data[RECORD_SIZE];
+
+  // Files are reopened if need be, as CP/M itself doesn't need an FCB to be
+  // open as long as it still describes the file
+  if (!fcb_name(cpm, fcb, name)) {
+    return 1;
+  }
+  struct i8080_cpm_file *file = open_file(cpm, name, 0);
+  if (file == NULL) {
+    return 1;
+  }
+
+  int err = read_record(file, record, data);
+  if (err != 0) {
+    return 1;
+  }
+
+  for (int i=0;i<RECORD_SIZE;i++) {
+    guest_write(cpm, cpm->dma + i, data[i]);
+  }
+  set_position(cpm, fcb, file, advance ? record + 1 : record);
+  return 0;
+}
+
+static uint write_fcb(struct i8080_cpm *cpm, uint fcb, unsigned long record,
+                      int advance) {
+  uint8_t name[11], data[RECORD_SIZE];
+
+  if (!fcb_name(cpm, fcb, name)) {
+    return 2;
+  }
+  struct i8080_cpm_file *file = open_file(cpm, name, 0);
+  if (file == NULL) {
+    return 2;
+  }
+
+  for (int i=0;i<RECORD_SIZE;i++) {
+    data[i] = (uint8_t) guest_read(cpm, cpm->dma + i);
+  }
+  if (write_record(file, record, data) < 0) {
+    return 2;
+  }
+
+  set_position(cpm, fcb, file, advance ? record + 1 : record);
+  return 0;
+}
+
+// Returns 0 if r2 is set, which CP/M 2.2 doesn't support
+static int random_record(struct i8080_cpm *cpm, uint fcb,
+                         unsigned long *record) {
+  *record = guest_read(cpm, fcb + 33) | (guest_read(cpm, fcb + 34) << 8);
+  return guest_read(cpm, fcb + 35) == 0;
+}
+
+static uint size_fcb(struct i8080_cpm *cpm, uint fcb) {
+  uint8_t name[11];
+  char host[13];
+  struct stat st;
+  off_t size;
+
+  int valid = fcb_name(cpm, fcb, name);
+  struct i8080_cpm_file *file = valid ? find_file(cpm, name) : NULL;
+  if (file != NULL) {
+    size = file->size;
+  } else if (valid && find_host(cpm, name, host) &&
+             fstatat(cpm->dir, host, &st, 0) == 0) {
+    size = st.st_size;
+  } else {
+    set_random_record(cpm, fcb, 0);
+    return 0xFF;
+  }
+
+  set_random_record(cpm, fcb, file_records(size));
+  return 0;
+}
+
+static void exit_program(struct i8080_cpm *cpm) {
+  cpm->exited = 1;
+  cpm->cpu->halted = 1;
+}
+
+static void bdos(struct i8080_cpm *cpm) {
+  struct i8080 *cpu = cpm->cpu;
+  uint de = (cpu->D << 8) | cpu->E;
+  unsigned long record;
+  uint result = 0;
+
+  switch (cpu->C) {
+    case 0: // P_TERMCPM
+      exit_program(cpm);
+      break;
+    case 1: // C_READ
+      result = console_in(cpm);
+      console_out(cpm, result);
+      break;
+    case 2: // C_WRITE
+      console_out(cpm, cpu->E);
+      break;
+    case 3: // A_READ
+      result = EOF_CHAR;
+      break;
+    case 6: // C_RAWIO
+      if (cpu->E == 0xFF) {
+        result = console_in(cpm);
+      } else if (cpu->E != 0xFE) {
+        console_out(cpm, cpu->E);
+      }
+      break;
+    case 9: // C_WRITESTR
+      write_string(cpm, de);
+      break;
+    case 10: // C_READSTR
+      read_line(cpm, de);
+      break;
+    case 12: // S_BDOSVER
+      result = 0x0022;
+      break;
+    case 13: // DRV_ALLRESET
+      cpm->dma = DEFAULT_DMA;
+      cpm->drive = 0;
+      break;
+    case 14: // DRV_SET
+      cpm->drive = cpu->E & 0x0F;
+      guest_write(cpm, 0x0004, (cpm->user << 4) | cpm->drive);
+      break;
+    case 15: // F_OPEN
+      result = open_fcb(cpm, de);
+      break;
+    case 16: // F_CLOSE
+      result = close_fcb(cpm, de);
+      break;
+    case 17: { // F_SFIRST
+      uint8_t pattern[11];
+      if (search_pattern(cpm, de, pattern)) {
+        search_files(cpm, pattern);
+        result = next_found(cpm);
+      } else {
+        cpm->num_found = 0;
+        cpm->next_found = 0;
+        result = 0xFF;
+      }
+      break;
+    }
+    case 18: // F_SNEXT
+      result = next_found(cpm);
+      break;
+    case 19: // F_DELETE
+      result = delete_fcb(cpm, de);
+      break;
+    case 20: // F_READ
+      result = read_fcb(cpm, de, seq_record(cpm, de), 1);
+      break;
+    case 21: // F_WRITE
+      result = write_fcb(cpm, de, seq_record(cpm, de), 1);
+      break;
+    case 22: // F_MAKE
+      result = make_fcb(cpm, de);
+      break;
+    case 23: // F_RENAME
+      result = rename_fcb(cpm, de);
+      break;
+    case 24: // DRV_LOGINVEC
+      result = 1 << cpm->drive;
+      break;
+    case 25: // DRV_GET
+      result = cpm->drive;
+      break;
+    case 26: // F_DMAOFF
+      cpm->dma = de;
+      break;
+    case 32: // F_USERNUM
+      if (cpu->E == 0xFF) {
+        result = cpm->user;
+      } else {
+        cpm->user = cpu->E & 0x0F;
+        guest_write(cpm, 0x0004, (cpm->user << 4) | cpm->drive);
+      }
+      break;
+    case 33: // F_READRAND
+      result = random_record(cpm, de, &record) ? read_fcb(cpm, de, record, 0) : 6;
+      break;
+    case 34: // F_WRITERAND
+    case 40: // F_WRITEZF (unwritten records read as zeros anyway)
+      result = random_record(cpm, de, &record) ? write_fcb(cpm, de, record, 0) : 6;
+      break;
+    case 35: // F_SIZE
+      result = size_fcb(cpm, de);
+      break;
+    case 36: // F_RANDREC
+      set_random_record(cpm, de, seq_record(cpm, de));
+      break;
+    default:
+      // Console status (11), the IO byte and disk parameters all read as 0
+      break;
+  }
+
+  set_result(cpu, result);
+}
+
+// The BIOS covers the console, with no disk access of its own
+static void bios(struct i8080_cpm *cpm, uint entry) {
+  struct i8080 *cpu = cpm->cpu;
+
+  switch (entry) {
+    case 0: // BOOT
+    case 1: // WBOOT
+      exit_program(cpm);
+      break;
+    case 2: // CONST
+      cpu->A = 0;
+      break;
+    case 3: // CONIN
+      cpu->A = console_in(cpm);
+      break;
+    case 4: // CONOUT
+      console_out(cpm, cpu->C);
+      break;
+    case 7: // READER
+      cpu->A = EOF_CHAR;
+      break;
+    case 9: // SELDSK
+      cpu->H = 0;
+      cpu->L = 0;
+      break;
+    case 13: // READ
+    case 14: // WRITE
+      cpu->A = 1;
+      break;
+    case 15: // LISTST
+      cpu->A = 0xFF;
+      break;
+    case 16: // SECTRAN
+      cpu->H = cpu->B;
+      cpu->L = cpu->C;
+      break;
+  }
+}
+
+static void handle_trap(struct i8080 *cpu, void *ctx, uint addr) {
+  struct i8080_cpm *cpm = ctx;
+
+  if (addr == I8080_CPM_BDOS) {
+    bdos(cpm);
+  } else if (addr == 0x0000) {
+    exit_program(cpm);
+  } else {
+    bios(cpm, (addr - I8080_CPM_BIOS) / 3);
+  }
+}
+
+// Sets up page zero and the BDOS and BIOS entry points, each a RET that runs
+// after the trap on it has done the work
+static void install(struct i8080_cpm *cpm) {
+  struct i8080 *cpu = cpm->cpu;
+
+  guest_write(cpm, 0x0000, 0xC3); // JMP WBOOT
+  i8080_write_word(cpu, 0x0001, I8080_CPM_BIOS + 3);
+  guest_write(cpm, 0x0003, 0);
+  guest_write(cpm, 0x0004, (cpm->user << 4) | cpm->drive);
+  guest_write(cpm, 0x0005, 0xC3); // JMP BDOS
+  i8080_write_word(cpu, 0x0006, I8080_CPM_BDOS);
+
+  guest_write(cpm, I8080_CPM_BDOS, 0xC9);
+  i8080_set_trap(cpu, I8080_CPM_BDOS);
+  i8080_set_trap(cpu, 0x0000);
+
+  for (uint i=0;i<BIOS_ENTRIES;i++) {
+    uint addr = I8080_CPM_BIOS + i * 3;
+    guest_write(cpm, addr, 0xC9);
+    guest_write(cpm, addr + 1, 0);
+    guest_write(cpm, addr + 2, 0);
+    i8080_set_trap(cpu, addr);
+  }
+}
+
+int i8080_cpm_init(struct i8080_cpm *cpm, struct i8080 *cpu, const char *dir) {
+  // Page zero and the entry points at the top need all of memory
+  if (cpu->memsize < 0x10000) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  cpm->out_buf = malloc(I8080_CPM_OUTPUT_SIZE);
+  if (cpm->out_buf == NULL) {
+    return -1;
+  }
+
+  cpm->dir = open(dir, O_RDONLY | O_DIRECTORY);
+  if (cpm->dir < 0) {
+    free(cpm->out_buf);
+    return -1;
+  }
+
+  cpm->cpu = cpu;
+  cpm->in = stdin;
+  cpm->out = STDOUT_FILENO;
+  cpm->out_len = 0;
+  cpm->out_error = 0;
+  cpm->dma = DEFAULT_DMA;
+  cpm->drive = 0;
+  cpm->user = 0;
+  cpm->exited = 0;
+
+  for (int i=0;i<I8080_CPM_MAX_FILES;i++) {
+    cpm->files[i].fd = -1;
+    cpm->files[i].buf = NULL;
+    memset(cpm->files[i].name, 0, sizeof(cpm->files[i].name));
+  }
+  cpm->clock = 0;
+
+  cpm->found = NULL;
+  cpm->found_records = NULL;
+  cpm->num_found = 0;
+  cpm->next_found = 0;
+
+  i8080_traps_init(cpu, cpm->traps, handle_trap, cpm);
+  install(cpm);
+
+  return 0;
+}
+
+void i8080_cpm_destroy(struct i8080_cpm *cpm) {
+  for (int i=0;i<I8080_CPM_MAX_FILES;i++) {
+    if (cpm->files[i].fd >= 0) {
+      close_file(&cpm->files[i]);
+    }
+    free(cpm->files[i].buf);
+  }
+
+  flush_output(cpm);
+  free(cpm->out_buf);
+
+  free(cpm->found);
+  free(cpm->found_records);
+  close(cpm->dir);
+
+  cpm->cpu->traps = NULL;
+}
+
+int i8080_cpm_flush(struct i8080_cpm *cpm) {
+  int err = 0;
+
+  for (int i=0;i<I8080_CPM_MAX_FILES;i++) {
+    if (cpm->files[i].fd >= 0 && flush_file(&cpm->files[i]) < 0) {
+      err = -1;
+    }
+  }
+  if (flush_output(cpm) < 0) {
+    err = -1;
+  }
+
+  return err;
+}
+
+// Fills in the name or extension part of an FCB, skipping anything too long
+static const char *parse_fcb_part(struct i8080_cpm *cpm, uint addr, int len,
+                                  const char *arg) {
+  for (int i=0;*arg != '\0' && *arg != ' ' && *arg != '.';arg++) {
+    if (*arg == '*') {
+      while (i < len) {
+        guest_write(cpm, addr + i++, '?');
+      }
+    } else if (i < len) {
+      guest_write(cpm, addr + i++, toupper(*arg));
+    }
+  }
+
+  return arg;
+}
+
+// Parses a file name from a command into an FCB, like the CCP does for the
+// first two arguments
+static const char *parse_fcb(struct i8080_cpm *cpm, uint fcb, const char *arg) {
+  while (*arg == ' ') {
+    arg++;
+  }
+  if (*arg == '\0') {
+    return arg;
+  }
+
+  if (arg[1] == ':') {
+    guest_write(cpm, fcb, toupper(arg[0]) - 'A' + 1);
+    arg += 2;
+  }
+
+  arg = parse_fcb_part(cpm, fcb + 1, 8, arg);
+  if (*arg == '.') {
+    arg = parse_fcb_part(cpm, fcb + 9, 3, arg + 1);
+  }
+
+  while (*arg != '\0' && *arg != ' ') {
+    arg++;
+  }
+  return arg;
+}
+
+// Loads a .COM file into the TPA, with a command tail (which may be NULL)
+// and the default FCBs set up from it
+int i8080_cpm_load(struct i8080_cpm *cpm, const char *path, const char *tail) {
+  struct i8080 *cpu = cpm->cpu;
+
+  // The size is checked up front, as loading a program that runs into the
+  // BDOS would already have overwritten the stubs
+  struct stat st;
+  if (stat(path, &st) < 0) {
+    return -1;
+  }
+  if (st.st_size > I8080_CPM_BDOS - TPA) {
+    errno = EFBIG;
+    return -1;
+  }
+
+  if (i8080_load_memory(cpu, (char *) path, TPA) < 0) {
+    return -1;
+  }
+
+  // The program may have changed page zero when it last ran
+  install(cpm);
+
+  if (tail == NULL) {
+    tail = "";
+  }
+
+  // Default FCBs at 0x005C and 0x006C, then the command tail, with a leading
+  // space, in the default DMA buffer
+  for (uint addr=0x005C;addr<DEFAULT_DMA;addr++) {
+    guest_write(cpm, addr, 0);
+  }
+  for (uint i=0;i<11;i++) {
+    guest_write(cpm, 0x005D + i, ' ');
+    guest_write(cpm, 0x006D + i, ' ');
+  }
+  parse_fcb(cpm, 0x006C, parse_fcb(cpm, 0x005C, tail));
+
+  uint len = 0;
+  if (*tail != '\0') {
+    guest_write(cpm, DEFAULT_DMA + 1, ' ');
+    len = 1;
+    for (;*tail != '\0' && len < 0x7F;tail++) {
+      guest_write(cpm, DEFAULT_DMA + 1 + len++, toupper(*tail));
+    }
+  }
+  guest_write(cpm, DEFAULT_DMA, len);
+  guest_write(cpm, DEFAULT_DMA + 1 + len, 0);
+
+  cpm->dma = DEFAULT_DMA;
+  cpm->exited = 0;
+
+  // Returning from the program warm boots
+  cpu->PC = TPA;
+  cpu->SP = I8080_CPM_BDOS;
+  cpu->halted = 0;
+  i8080_push_stackw(cpu, 0x0000);
+
+  return 0;
+}
+
+// Runs the loaded program until it exits, returning -1 if it halted the CPU
+// instead, or its files or console output couldn't be written out
+int i8080_cpm_run(struct i8080_cpm *cpm) {
+  struct i8080 *cpu = cpm->cpu;
+
+  while (!cpm->exited && !cpu->halted) {
+    i8080_run(cpu, RUN_SLICE);
+    flush_output(cpm);
+  }
+
+  int err = i8080_cpm_flush(cpm);
+  return cpm->exited ? err : -1;
+}
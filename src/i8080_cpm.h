@@ -0,0 +1,74 @@
+#ifndef LIB8080_CPM_H_
+#define LIB8080_CPM_H_
+
+#include <stdio.h>
+#include <sys/types.h>
+#include "i8080.h"
+
+// Memory layout: the BDOS entry point (also the top of the TPA, as found at
+// 0x0006) and the BIOS jump table
+#define I8080_CPM_BDOS 0xFE00
+#define I8080_CPM_BIOS 0xFF00
+
+#define I8080_CPM_MAX_FILES 16
+#define I8080_CPM_BUFFER_SIZE 65536
+// Enough for any string BDOS function 9 can print
+#define I8080_CPM_OUTPUT_SIZE 65536
+
+// An open host file, shared by every FCB naming it
+struct i8080_cpm_file {
+  // Name as in an FCB, or all zeros if the slot is free
+  uint8_t name[11];
+  int fd;
+  // Size including any buffered writes
+  off_t size;
+  // For evicting the least recently used file
+  unsigned long used;
+
+  // Read-ahead (and write-behind) window of the file, with the part that
+  // still needs writing out
+  uint8_t *buf;
+  off_t buf_pos;
+  size_t buf_len;
+  size_t dirty_start;
+  size_t dirty_end;
+};
+
+struct i8080_cpm {
+  struct i8080 *cpu;
+
+  // Host directory standing in for every drive
+  int dir;
+  // Console, with output buffered until the program waits for input or the
+  // run slice ends
+  FILE *in;
+  int out;
+  uint8_t *out_buf;
+  size_t out_len;
+  int out_error;
+
+  uint dma;
+  uint drive;
+  uint user;
+  // Set once the program warm boots or calls BDOS function 0
+  int exited;
+
+  struct i8080_cpm_file files[I8080_CPM_MAX_FILES];
+  unsigned long clock;
+
+  // Names (and sizes in records) matched by search first, for search next
+  uint8_t (*found)[11];
+  unsigned long *found_records;
+  size_t num_found;
+  size_t next_found;
+
+  uint8_t traps[I8080_TRAP_BYTES];
+};
+
+int i8080_cpm_init(struct i8080_cpm *, struct i8080 *, const char *);
+void i8080_cpm_destroy(struct i8080_cpm *);
+int i8080_cpm_load(struct i8080_cpm *, const char *, const char *);
+int i8080_cpm_run(struct i8080_cpm *);
+int i8080_cpm_flush(struct i8080_cpm *);
+
+#endif
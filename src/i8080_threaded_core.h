@@ -0,0 +1,303 @@
+// The direct threaded core (see i8080.c), which is included there once per
+// memory mode, with EXECUTE naming the function and MEM64K the mode
+static unsigned long EXECUTE(struct i8080 *cpu, unsigned long cycles) {
+  const int mem64k = MEM64K;
+  static const void *const dispatch_table[256] = {
+    &&op_0x00, &&op_0x01, &&op_0x02, &&op_0x03, &&op_0x04, &&op_0x05, &&op_0x06, &&op_0x07,
+    &&op_0x08, &&op_0x09, &&op_0x0A, &&op_0x0B, &&op_0x0C, &&op_0x0D, &&op_0x0E, &&op_0x0F,
+    &&op_0x10, &&op_0x11, &&op_0x12, &&op_0x13, &&op_0x14, &&op_0x15, &&op_0x16, &&op_0x17,
+    &&op_0x18, &&op_0x19, &&op_0x1A, &&op_0x1B, &&op_0x1C, &&op_0x1D, &&op_0x1E, &&op_0x1F,
+    &&op_0x20, &&op_0x21, &&op_0x22, &&op_0x23, &&op_0x24, &&op_0x25, &&op_0x26, &&op_0x27,
+    &&op_0x28, &&op_0x29, &&op_0x2A, &&op_0x2B, &&op_0x2C, &&op_0x2D, &&op_0x2E, &&op_0x2F,
+    &&op_0x30, &&op_0x31, &&op_0x32, &&op_0x33, &&op_0x34, &&op_0x35, &&op_0x36, &&op_0x37,
+    &&op_0x38, &&op_0x39, &&op_0x3A, &&op_0x3B, &&op_0x3C, &&op_0x3D, &&op_0x3E, &&op_0x3F,
+    &&op_0x40, &&op_0x41, &&op_0x42, &&op_0x43, &&op_0x44, &&op_0x45, &&op_0x46, &&op_0x47,
+    &&op_0x48, &&op_0x49, &&op_0x4A, &&op_0x4B, &&op_0x4C, &&op_0x4D, &&op_0x4E, &&op_0x4F,
+    &&op_0x50, &&op_0x51, &&op_0x52, &&op_0x53, &&op_0x54, &&op_0x55, &&op_0x56, &&op_0x57,
+    &&op_0x58, &&op_0x59, &&op_0x5A, &&op_0x5B, &&op_0x5C, &&op_0x5D, &&op_0x5E, &&op_0x5F,
+    &&op_0x60, &&op_0x61, &&op_0x62, &&op_0x63, &&op_0x64, &&op_0x65, &&op_0x66, &&op_0x67,
+    &&op_0x68, &&op_0x69, &&op_0x6A, &&op_0x6B, &&op_0x6C, &&op_0x6D, &&op_0x6E, &&op_0x6F,
+    &&op_0x70, &&op_0x71, &&op_0x72, &&op_0x73, &&op_0x74, &&op_0x75, &&op_0x76, &&op_0x77,
+    &&op_0x78, &&op_0x79, &&op_0x7A, &&op_0x7B, &&op_0x7C, &&op_0x7D, &&op_0x7E, &&op_0x7F,
+    &&op_0x80, &&op_0x81, &&op_0x82, &&op_0x83, &&op_0x84, &&op_0x85, &&op_0x86, &&op_0x87,
+    &&op_0x88, &&op_0x89, &&op_0x8A, &&op_0x8B, &&op_0x8C, &&op_0x8D, &&op_0x8E, &&op_0x8F,
+    &&op_0x90, &&op_0x91, &&op_0x92, &&op_0x93, &&op_0x94, &&op_0x95, &&op_0x96, &&op_0x97,
+    &&op_0x98, &&op_0x99, &&op_0x9A, &&op_0x9B, &&op_0x9C, &&op_0x9D, &&op_0x9E, &&op_0x9F,
+    &&op_0xA0, &&op_0xA1, &&op_0xA2, &&op_0xA3, &&op_0xA4, &&op_0xA5, &&op_0xA6, &&op_0xA7,
+    &&op_0xA8, &&op_0xA9, &&op_0xAA, &&op_0xAB, &&op_0xAC, &&op_0xAD, &&op_0xAE, &&op_0xAF,
+    &&op_0xB0, &&op_0xB1, &&op_0xB2, &&op_0xB3, &&op_0xB4, &&op_0xB5, &&op_0xB6, &&op_0xB7,
+    &&op_0xB8, &&op_0xB9, &&op_0xBA, &&op_0xBB, &&op_0xBC, &&op_0xBD, &&op_0xBE, &&op_0xBF,
+    &&op_0xC0, &&op_0xC1, &&op_0xC2, &&op_0xC3, &&op_0xC4, &&op_0xC5, &&op_0xC6, &&op_0xC7,
+    &&op_0xC8, &&op_0xC9, &&op_0xCA, &&op_0xCB, &&op_0xCC, &&op_0xCD, &&op_0xCE, &&op_0xCF,
+    &&op_0xD0, &&op_0xD1, &&op_0xD2, &&op_0xD3, &&op_0xD4, &&op_0xD5, &&op_0xD6, &&op_0xD7,
+    &&op_0xD8, &&op_0xD9, &&op_0xDA, &&op_0xDB, &&op_0xDC, &&op_0xDD, &&op_0xDE, &&op_0xDF,
+    &&op_0xE0, &&op_0xE1, &&op_0xE2, &&op_0xE3, &&op_0xE4, &&op_0xE5, &&op_0xE6, &&op_0xE7,
+    &&op_0xE8, &&op_0xE9, &&op_0xEA, &&op_0xEB, &&op_0xEC, &&op_0xED, &&op_0xEE, &&op_0xEF,
+    &&op_0xF0, &&op_0xF1, &&op_0xF2, &&op_0xF3, &&op_0xF4, &&op_0xF5, &&op_0xF6, &&op_0xF7,
+    &&op_0xF8, &&op_0xF9, &&op_0xFA, &&op_0xFB, &&op_0xFC, &&op_0xFD, &&op_0xFE, &&op_0xFF,
+  };
+
+  unsigned long long start = cpu->cyc;
+
+  DISPATCH();
+
+  OP(0x00, nop(cpu));                                      // NOP
+  OP_CYC(0x01, 10, SET_PAIR(B, C, next_word(cpu, mem64k))); // LXI B, d16
+  OP_CYC(0x02, 7, write_byte(cpu, PAIR(B, C), cpu->A, mem64k)); // STAX B
+  OP_CYC(0x03, 5, SET_PAIR(B, C, PAIR(B, C) + 1));         // INX B
+  OP_CYC(0x04, 5, cpu->B = perform_inr(cpu, cpu->B));      // INR B
+  OP_CYC(0x05, 5, cpu->B = perform_dcr(cpu, cpu->B));      // DCR B
+  OP_CYC(0x06, 7, cpu->B = next_byte(cpu, mem64k));        // MVI B, d8
+  OP(0x07, rlc(cpu));                                      // RLC
+  OP(0x08, nop(cpu));                                      // NOP (alternate)
+  OP_CYC(0x09, 10, perform_dad(cpu, PAIR(B, C)));          // DAD B
+  OP_CYC(0x0A, 7, cpu->A = read_byte(cpu, PAIR(B, C), mem64k)); // LDAX B
+  OP_CYC(0x0B, 5, SET_PAIR(B, C, PAIR(B, C) - 1));         // DCX B
+  OP_CYC(0x0C, 5, cpu->C = perform_inr(cpu, cpu->C));      // INR C
+  OP_CYC(0x0D, 5, cpu->C = perform_dcr(cpu, cpu->C));      // DCR C
+  OP_CYC(0x0E, 7, cpu->C = next_byte(cpu, mem64k));        // MVI C, d8
+  OP(0x0F, rrc(cpu));                                      // RRC
+  OP(0x10, nop(cpu));                                      // NOP (alternate)
+  OP_CYC(0x11, 10, SET_PAIR(D, E, next_word(cpu, mem64k))); // LXI D, d16
+  OP_CYC(0x12, 7, write_byte(cpu, PAIR(D, E), cpu->A, mem64k)); // STAX D
+  OP_CYC(0x13, 5, SET_PAIR(D, E, PAIR(D, E) + 1));         // INX D
+  OP_CYC(0x14, 5, cpu->D = perform_inr(cpu, cpu->D));      // INR D
+  OP_CYC(0x15, 5, cpu->D = perform_dcr(cpu, cpu->D));      // DCR D
+  OP_CYC(0x16, 7, cpu->D = next_byte(cpu, mem64k));        // MVI D, d8
+  OP(0x17, ral(cpu));                                      // RAL
+  OP(0x18, nop(cpu));                                      // NOP (alternate)
+  OP_CYC(0x19, 10, perform_dad(cpu, PAIR(D, E)));          // DAD D
+  OP_CYC(0x1A, 7, cpu->A = read_byte(cpu, PAIR(D, E), mem64k)); // LDAX D
+  OP_CYC(0x1B, 5, SET_PAIR(D, E, PAIR(D, E) - 1));         // DCX D
+  OP_CYC(0x1C, 5, cpu->E = perform_inr(cpu, cpu->E));      // INR E
+  OP_CYC(0x1D, 5, cpu->E = perform_dcr(cpu, cpu->E));      // DCR E
+  OP_CYC(0x1E, 7, cpu->E = next_byte(cpu, mem64k));        // MVI E, d8
+  OP(0x1F, rar(cpu));                                      // RAR
+  OP(0x20, nop(cpu));                                      // NOP (alternate)
+  OP_CYC(0x21, 10, SET_PAIR(H, L, next_word(cpu, mem64k))); // LXI H, d16
+  OP(0x22, shld(cpu, mem64k));                             // SHLD a16
+  OP_CYC(0x23, 5, SET_PAIR(H, L, PAIR(H, L) + 1));         // INX H
+  OP_CYC(0x24, 5, cpu->H = perform_inr(cpu, cpu->H));      // INR H
+  OP_CYC(0x25, 5, cpu->H = perform_dcr(cpu, cpu->H));      // DCR H
+  OP_CYC(0x26, 7, cpu->H = next_byte(cpu, mem64k));        // MVI H, d8
+  OP(0x27, daa(cpu));                                      // DAA
+  OP(0x28, nop(cpu));                                      // NOP (alternate)
+  OP_CYC(0x29, 10, perform_dad(cpu, PAIR(H, L)));          // DAD H
+  OP(0x2A, ldhd(cpu, mem64k));                             // LHLD a16
+  OP_CYC(0x2B, 5, SET_PAIR(H, L, PAIR(H, L) - 1));         // DCX H
+  OP_CYC(0x2C, 5, cpu->L = perform_inr(cpu, cpu->L));      // INR L
+  OP_CYC(0x2D, 5, cpu->L = perform_dcr(cpu, cpu->L));      // DCR L
+  OP_CYC(0x2E, 7, cpu->L = next_byte(cpu, mem64k));        // MVI L, d8
+  OP(0x2F, cma(cpu));                                      // CMA
+  OP(0x30, nop(cpu));                                      // NOP (alternate)
+  OP_CYC(0x31, 10, cpu->SP = next_word(cpu, mem64k));      // LXI SP, d16
+  OP(0x32, sta(cpu, mem64k));                              // STA a16
+  OP_CYC(0x33, 5, cpu->SP = (cpu->SP + 1) & 0xFFFF);       // INX SP
+  OP_CYC(0x34, 10, SET_M(perform_inr(cpu, GET_M())));      // INR M
+  OP_CYC(0x35, 10, SET_M(perform_dcr(cpu, GET_M())));      // DCR M
+  OP_CYC(0x36, 10, SET_M(next_byte(cpu, mem64k)));         // MVI M, d8
+  OP(0x37, stc(cpu));                                      // STC
+  OP(0x38, nop(cpu));                                      // NOP (alternate)
+  OP_CYC(0x39, 10, perform_dad(cpu, cpu->SP));             // DAD SP
+  OP(0x3A, lda(cpu, mem64k));                              // LDA a16
+  OP_CYC(0x3B, 5, cpu->SP = (cpu->SP - 1) & 0xFFFF);       // DCX SP
+  OP_CYC(0x3C, 5, cpu->A = perform_inr(cpu, cpu->A));      // INR A
+  OP_CYC(0x3D, 5, cpu->A = perform_dcr(cpu, cpu->A));      // DCR A
+  OP_CYC(0x3E, 7, cpu->A = next_byte(cpu, mem64k));        // MVI A, d8
+  OP(0x3F, cmc(cpu));                                      // CMC
+  OP_CYC(0x40, 5, cpu->B = cpu->B);                        // MOV B, B
+  OP_CYC(0x41, 5, cpu->B = cpu->C);                        // MOV B, C
+  OP_CYC(0x42, 5, cpu->B = cpu->D);                        // MOV B, D
+  OP_CYC(0x43, 5, cpu->B = cpu->E);                        // MOV B, E
+  OP_CYC(0x44, 5, cpu->B = cpu->H);                        // MOV B, H
+  OP_CYC(0x45, 5, cpu->B = cpu->L);                        // MOV B, L
+  OP_CYC(0x46, 7, cpu->B = GET_M());                       // MOV B, M
+  OP_CYC(0x47, 5, cpu->B = cpu->A);                        // MOV B, A
+  OP_CYC(0x48, 5, cpu->C = cpu->B);                        // MOV C, B
+  OP_CYC(0x49, 5, cpu->C = cpu->C);                        // MOV C, C
+  OP_CYC(0x4A, 5, cpu->C = cpu->D);                        // MOV C, D
+  OP_CYC(0x4B, 5, cpu->C = cpu->E);                        // MOV C, E
+  OP_CYC(0x4C, 5, cpu->C = cpu->H);                        // MOV C, H
+  OP_CYC(0x4D, 5, cpu->C = cpu->L);                        // MOV C, L
+  OP_CYC(0x4E, 7, cpu->C = GET_M());                       // MOV C, M
+  OP_CYC(0x4F, 5, cpu->C = cpu->A);                        // MOV C, A
+  OP_CYC(0x50, 5, cpu->D = cpu->B);                        // MOV D, B
+  OP_CYC(0x51, 5, cpu->D = cpu->C);                        // MOV D, C
+  OP_CYC(0x52, 5, cpu->D = cpu->D);                        // MOV D, D
+  OP_CYC(0x53, 5, cpu->D = cpu->E);                        // MOV D, E
+  OP_CYC(0x54, 5, cpu->D = cpu->H);                        // MOV D, H
+  OP_CYC(0x55, 5, cpu->D = cpu->L);                        // MOV D, L
+  OP_CYC(0x56, 7, cpu->D = GET_M());                       // MOV D, M
+  OP_CYC(0x57, 5, cpu->D = cpu->A);                        // MOV D, A
+  OP_CYC(0x58, 5, cpu->E = cpu->B);                        // MOV E, B
+  OP_CYC(0x59, 5, cpu->E = cpu->C);                        // MOV E, C
+  OP_CYC(0x5A, 5, cpu->E = cpu->D);                        // MOV E, D
+  OP_CYC(0x5B, 5, cpu->E = cpu->E);                        // MOV E, E
+  OP_CYC(0x5C, 5, cpu->E = cpu->H);                        // MOV E, H
+  OP_CYC(0x5D, 5, cpu->E = cpu->L);                        // MOV E, L
+  OP_CYC(0x5E, 7, cpu->E = GET_M());                       // MOV E, M
+  OP_CYC(0x5F, 5, cpu->E = cpu->A);                        // MOV E, A
+  OP_CYC(0x60, 5, cpu->H = cpu->B);                        // MOV H, B
+  OP_CYC(0x61, 5, cpu->H = cpu->C);                        // MOV H, C
+  OP_CYC(0x62, 5, cpu->H = cpu->D);                        // MOV H, D
+  OP_CYC(0x63, 5, cpu->H = cpu->E);                        // MOV H, E
+  OP_CYC(0x64, 5, cpu->H = cpu->H);                        // MOV H, H
+  OP_CYC(0x65, 5, cpu->H = cpu->L);                        // MOV H, L
+  OP_CYC(0x66, 7, cpu->H = GET_M());                       // MOV H, M
+  OP_CYC(0x67, 5, cpu->H = cpu->A);                        // MOV H, A
+  OP_CYC(0x68, 5, cpu->L = cpu->B);                        // MOV L, B
+  OP_CYC(0x69, 5, cpu->L = cpu->C);                        // MOV L, C
+  OP_CYC(0x6A, 5, cpu->L = cpu->D);                        // MOV L, D
+  OP_CYC(0x6B, 5, cpu->L = cpu->E);                        // MOV L, E
+  OP_CYC(0x6C, 5, cpu->L = cpu->H);                        // MOV L, H
+  OP_CYC(0x6D, 5, cpu->L = cpu->L);                        // MOV L, L
+  OP_CYC(0x6E, 7, cpu->L = GET_M());                       // MOV L, M
+  OP_CYC(0x6F, 5, cpu->L = cpu->A);                        // MOV L, A
+  OP_CYC(0x70, 7, SET_M(cpu->B));                          // MOV M, B
+  OP_CYC(0x71, 7, SET_M(cpu->C));                          // MOV M, C
+  OP_CYC(0x72, 7, SET_M(cpu->D));                          // MOV M, D
+  OP_CYC(0x73, 7, SET_M(cpu->E));                          // MOV M, E
+  OP_CYC(0x74, 7, SET_M(cpu->H));                          // MOV M, H
+  OP_CYC(0x75, 7, SET_M(cpu->L));                          // MOV M, L
+  op_0x76: hlt(cpu); goto done;                            // HLT
+  OP_CYC(0x77, 7, SET_M(cpu->A));                          // MOV M, A
+  OP_CYC(0x78, 5, cpu->A = cpu->B);                        // MOV A, B
+  OP_CYC(0x79, 5, cpu->A = cpu->C);                        // MOV A, C
+  OP_CYC(0x7A, 5, cpu->A = cpu->D);                        // MOV A, D
+  OP_CYC(0x7B, 5, cpu->A = cpu->E);                        // MOV A, E
+  OP_CYC(0x7C, 5, cpu->A = cpu->H);                        // MOV A, H
+  OP_CYC(0x7D, 5, cpu->A = cpu->L);                        // MOV A, L
+  OP_CYC(0x7E, 7, cpu->A = GET_M());                       // MOV A, M
+  OP_CYC(0x7F, 5, cpu->A = cpu->A);                        // MOV A, A
+  OP_CYC(0x80, 4, cpu->A = perform_add(cpu, cpu->A, cpu->B, 0)); // ADD B
+  OP_CYC(0x81, 4, cpu->A = perform_add(cpu, cpu->A, cpu->C, 0)); // ADD C
+  OP_CYC(0x82, 4, cpu->A = perform_add(cpu, cpu->A, cpu->D, 0)); // ADD D
+  OP_CYC(0x83, 4, cpu->A = perform_add(cpu, cpu->A, cpu->E, 0)); // ADD E
+  OP_CYC(0x84, 4, cpu->A = perform_add(cpu, cpu->A, cpu->H, 0)); // ADD H
+  OP_CYC(0x85, 4, cpu->A = perform_add(cpu, cpu->A, cpu->L, 0)); // ADD L
+  OP_CYC(0x86, 7, cpu->A = perform_add(cpu, cpu->A, GET_M(), 0)); // ADD M
+  OP_CYC(0x87, 4, cpu->A = perform_add(cpu, cpu->A, cpu->A, 0)); // ADD A
+  OP_CYC(0x88, 4, cpu->A = perform_add(cpu, cpu->A, cpu->B, CARRY())); // ADC B
+  OP_CYC(0x89, 4, cpu->A = perform_add(cpu, cpu->A, cpu->C, CARRY())); // ADC C
+  OP_CYC(0x8A, 4, cpu->A = perform_add(cpu, cpu->A, cpu->D, CARRY())); // ADC D
+  OP_CYC(0x8B, 4, cpu->A = perform_add(cpu, cpu->A, cpu->E, CARRY())); // ADC E
+  OP_CYC(0x8C, 4, cpu->A = perform_add(cpu, cpu->A, cpu->H, CARRY())); // ADC H
+  OP_CYC(0x8D, 4, cpu->A = perform_add(cpu, cpu->A, cpu->L, CARRY())); // ADC L
+  OP_CYC(0x8E, 7, cpu->A = perform_add(cpu, cpu->A, GET_M(), CARRY())); // ADC M
+  OP_CYC(0x8F, 4, cpu->A = perform_add(cpu, cpu->A, cpu->A, CARRY())); // ADC A
+  OP_CYC(0x90, 4, cpu->A = perform_sub(cpu, cpu->A, cpu->B, 0)); // SUB B
+  OP_CYC(0x91, 4, cpu->A = perform_sub(cpu, cpu->A, cpu->C, 0)); // SUB C
+  OP_CYC(0x92, 4, cpu->A = perform_sub(cpu, cpu->A, cpu->D, 0)); // SUB D
+  OP_CYC(0x93, 4, cpu->A = perform_sub(cpu, cpu->A, cpu->E, 0)); // SUB E
+  OP_CYC(0x94, 4, cpu->A = perform_sub(cpu, cpu->A, cpu->H, 0)); // SUB H
+  OP_CYC(0x95, 4, cpu->A = perform_sub(cpu, cpu->A, cpu->L, 0)); // SUB L
+  OP_CYC(0x96, 7, cpu->A = perform_sub(cpu, cpu->A, GET_M(), 0)); // SUB M
+  OP_CYC(0x97, 4, cpu->A = perform_sub(cpu, cpu->A, cpu->A, 0)); // SUB A
+  OP_CYC(0x98, 4, cpu->A = perform_sub(cpu, cpu->A, cpu->B, CARRY())); // SBB B
+  OP_CYC(0x99, 4, cpu->A = perform_sub(cpu, cpu->A, cpu->C, CARRY())); // SBB C
+  OP_CYC(0x9A, 4, cpu->A = perform_sub(cpu, cpu->A, cpu->D, CARRY())); // SBB D
+  OP_CYC(0x9B, 4, cpu->A = perform_sub(cpu, cpu->A, cpu->E, CARRY())); // SBB E
+  OP_CYC(0x9C, 4, cpu->A = perform_sub(cpu, cpu->A, cpu->H, CARRY())); // SBB H
+  OP_CYC(0x9D, 4, cpu->A = perform_sub(cpu, cpu->A, cpu->L, CARRY())); // SBB L
+  OP_CYC(0x9E, 7, cpu->A = perform_sub(cpu, cpu->A, GET_M(), CARRY())); // SBB M
+  OP_CYC(0x9F, 4, cpu->A = perform_sub(cpu, cpu->A, cpu->A, CARRY())); // SBB A
+  OP_CYC(0xA0, 4, perform_ana(cpu, cpu->B));               // ANA B
+  OP_CYC(0xA1, 4, perform_ana(cpu, cpu->C));               // ANA C
+  OP_CYC(0xA2, 4, perform_ana(cpu, cpu->D));               // ANA D
+  OP_CYC(0xA3, 4, perform_ana(cpu, cpu->E));               // ANA E
+  OP_CYC(0xA4, 4, perform_ana(cpu, cpu->H));               // ANA H
+  OP_CYC(0xA5, 4, perform_ana(cpu, cpu->L));               // ANA L
+  OP_CYC(0xA6, 7, perform_ana(cpu, GET_M()));              // ANA M
+  OP_CYC(0xA7, 4, perform_ana(cpu, cpu->A));               // ANA A
+  OP_CYC(0xA8, 4, perform_xra(cpu, cpu->B));               // XRA B
+  OP_CYC(0xA9, 4, perform_xra(cpu, cpu->C));               // XRA C
+  OP_CYC(0xAA, 4, perform_xra(cpu, cpu->D));               // XRA D
+  OP_CYC(0xAB, 4, perform_xra(cpu, cpu->E));               // XRA E
+  OP_CYC(0xAC, 4, perform_xra(cpu, cpu->H));               // XRA H
+  OP_CYC(0xAD, 4, perform_xra(cpu, cpu->L));               // XRA L
+  OP_CYC(0xAE, 7, perform_xra(cpu, GET_M()));              // XRA M
+  OP_CYC(0xAF, 4, perform_xra(cpu, cpu->A));               // XRA A
+  OP_CYC(0xB0, 4, perform_ora(cpu, cpu->B));               // ORA B
+  OP_CYC(0xB1, 4, perform_ora(cpu, cpu->C));               // ORA C
+  OP_CYC(0xB2, 4, perform_ora(cpu, cpu->D));               // ORA D
+  OP_CYC(0xB3, 4, perform_ora(cpu, cpu->E));               // ORA E
+  OP_CYC(0xB4, 4, perform_ora(cpu, cpu->H));               // ORA H
+  OP_CYC(0xB5, 4, perform_ora(cpu, cpu->L));               // ORA L
+  OP_CYC(0xB6, 7, perform_ora(cpu, GET_M()));              // ORA M
+  OP_CYC(0xB7, 4, perform_ora(cpu, cpu->A));               // ORA A
+  OP_CYC(0xB8, 4, perform_sub(cpu, cpu->A, cpu->B, 0));    // CMP B
+  OP_CYC(0xB9, 4, perform_sub(cpu, cpu->A, cpu->C, 0));    // CMP C
+  OP_CYC(0xBA, 4, perform_sub(cpu, cpu->A, cpu->D, 0));    // CMP D
+  OP_CYC(0xBB, 4, perform_sub(cpu, cpu->A, cpu->E, 0));    // CMP E
+  OP_CYC(0xBC, 4, perform_sub(cpu, cpu->A, cpu->H, 0));    // CMP H
+  OP_CYC(0xBD, 4, perform_sub(cpu, cpu->A, cpu->L, 0));    // CMP L
+  OP_CYC(0xBE, 7, perform_sub(cpu, cpu->A, GET_M(), 0));   // CMP M
+  OP_CYC(0xBF, 4, perform_sub(cpu, cpu->A, cpu->A, 0));    // CMP A
+  OP_CYC(0xC0, 5, perform_return(cpu, check_condition(cpu, 0), mem64k); TRAP()); // RNZ
+  OP_CYC(0xC1, 10, SET_PAIR(B, C, pop_word(cpu, mem64k))); // POP B
+  OP_CYC(0xC2, 10, perform_jump(cpu, check_condition(cpu, 0), mem64k); TRAP()); // JNZ a16
+  OP_CYC(0xC3, 10, perform_jump(cpu, 1, mem64k); TRAP());  // JMP a16
+  OP_CYC(0xC4, 11, perform_call(cpu, check_condition(cpu, 0), mem64k); TRAP()); // CNZ a16
+  OP_CYC(0xC5, 11, push_word(cpu, PAIR(B, C), mem64k)); // PUSH B
+  OP_CYC(0xC6, 7, cpu->A = perform_add(cpu, cpu->A, next_byte(cpu, mem64k), 0)); // ADI d8
+  OP(0xC7, rst(cpu, 0xC7, mem64k); TRAP());                // RST 0
+  OP_CYC(0xC8, 5, perform_return(cpu, check_condition(cpu, 1), mem64k); TRAP()); // RZ
+  OP_CYC(0xC9, 5, perform_return(cpu, 1, mem64k); TRAP()); // RET
+  OP_CYC(0xCA, 10, perform_jump(cpu, check_condition(cpu, 1), mem64k); TRAP()); // JZ a16
+  OP_CYC(0xCB, 10, perform_jump(cpu, 1, mem64k); TRAP());  // JMP a16 (alternate)
+  OP_CYC(0xCC, 11, perform_call(cpu, check_condition(cpu, 1), mem64k); TRAP()); // CZ a16
+  OP_CYC(0xCD, 11, perform_call(cpu, 1, mem64k); TRAP());  // CALL a16
+  OP_CYC(0xCE, 7, cpu->A = perform_add(cpu, cpu->A, next_byte(cpu, mem64k), CARRY())); // ACI d8
+  OP(0xCF, rst(cpu, 0xCF, mem64k); TRAP());                // RST 1
+  OP_CYC(0xD0, 5, perform_return(cpu, check_condition(cpu, 2), mem64k); TRAP()); // RNC
+  OP_CYC(0xD1, 10, SET_PAIR(D, E, pop_word(cpu, mem64k))); // POP D
+  OP_CYC(0xD2, 10, perform_jump(cpu, check_condition(cpu, 2), mem64k); TRAP()); // JNC a16
+  OP(0xD3, out(cpu, mem64k));                              // OUT d8
+  OP_CYC(0xD4, 11, perform_call(cpu, check_condition(cpu, 2), mem64k); TRAP()); // CNC a16
+  OP_CYC(0xD5, 11, push_word(cpu, PAIR(D, E), mem64k)); // PUSH D
+  OP_CYC(0xD6, 7, cpu->A = perform_sub(cpu, cpu->A, next_byte(cpu, mem64k), 0)); // SUI d8
+  OP(0xD7, rst(cpu, 0xD7, mem64k); TRAP());                // RST 2
+  OP_CYC(0xD8, 5, perform_return(cpu, check_condition(cpu, 3), mem64k); TRAP()); // RC
+  OP_CYC(0xD9, 5, perform_return(cpu, 1, mem64k); TRAP()); // RET (alternate)
+  OP_CYC(0xDA, 10, perform_jump(cpu, check_condition(cpu, 3), mem64k); TRAP()); // JC a16
+  OP(0xDB, if (!in(cpu, mem64k)) goto done);               // IN d8
+  OP_CYC(0xDC, 11, perform_call(cpu, check_condition(cpu, 3), mem64k); TRAP()); // CC a16
+  OP_CYC(0xDD, 11, perform_call(cpu, 1, mem64k); TRAP());  // CALL a16 (alternate)
+  OP_CYC(0xDE, 7, cpu->A = perform_sub(cpu, cpu->A, next_byte(cpu, mem64k), CARRY())); // SBI d8
+  OP(0xDF, rst(cpu, 0xDF, mem64k); TRAP());                // RST 3
+  OP_CYC(0xE0, 5, perform_return(cpu, check_condition(cpu, 4), mem64k); TRAP()); // RPO
+  OP_CYC(0xE1, 10, SET_PAIR(H, L, pop_word(cpu, mem64k))); // POP H
+  OP_CYC(0xE2, 10, perform_jump(cpu, check_condition(cpu, 4), mem64k); TRAP()); // JPO a16
+  OP(0xE3, xthl(cpu, mem64k));                             // XTHL
+  OP_CYC(0xE4, 11, perform_call(cpu, check_condition(cpu, 4), mem64k); TRAP()); // CPO a16
+  OP_CYC(0xE5, 11, push_word(cpu, PAIR(H, L), mem64k)); // PUSH H
+  OP_CYC(0xE6, 7, perform_ana(cpu, next_byte(cpu, mem64k))); // ANI d8
+  OP(0xE7, rst(cpu, 0xE7, mem64k); TRAP());                // RST 4
+  OP_CYC(0xE8, 5, perform_return(cpu, check_condition(cpu, 5), mem64k); TRAP()); // RPE
+  OP(0xE9, pchl(cpu); TRAP());                             // PCHL
+  OP_CYC(0xEA, 10, perform_jump(cpu, check_condition(cpu, 5), mem64k); TRAP()); // JPE a16
+  OP(0xEB, xchg(cpu));                                     // XCHG
+  OP_CYC(0xEC, 11, perform_call(cpu, check_condition(cpu, 5), mem64k); TRAP()); // CPE a16
+  OP_CYC(0xED, 11, perform_call(cpu, 1, mem64k); TRAP());  // CALL a16 (alternate)
+  OP_CYC(0xEE, 7, perform_xra(cpu, next_byte(cpu, mem64k))); // XRI d8
+  OP(0xEF, rst(cpu, 0xEF, mem64k); TRAP());                // RST 5
+  OP_CYC(0xF0, 5, perform_return(cpu, check_condition(cpu, 6), mem64k); TRAP()); // RP
+  OP(0xF1, pop(cpu, 0xF1, mem64k));                        // POP PSW
+  OP_CYC(0xF2, 10, perform_jump(cpu, check_condition(cpu, 6), mem64k); TRAP()); // JP a16
+  OP(0xF3, di(cpu));                                       // DI
+  OP_CYC(0xF4, 11, perform_call(cpu, check_condition(cpu, 6), mem64k); TRAP()); // CP a16
+  OP_CYC(0xF5, 11, push_word(cpu, CONCAT(cpu->A, pack_flags(cpu)), mem64k)); // PUSH PSW
+  OP_CYC(0xF6, 7, perform_ora(cpu, next_byte(cpu, mem64k))); // ORI d8
+  OP(0xF7, rst(cpu, 0xF7, mem64k); TRAP());                // RST 6
+  OP_CYC(0xF8, 5, perform_return(cpu, check_condition(cpu, 7), mem64k); TRAP()); // RM
+  OP(0xF9, sphl(cpu));                                     // SPHL
+  OP_CYC(0xFA, 10, perform_jump(cpu, check_condition(cpu, 7), mem64k); TRAP()); // JM a16
+  OP(0xFB, ei(cpu));                                       // EI
+  OP_CYC(0xFC, 11, perform_call(cpu, check_condition(cpu, 7), mem64k); TRAP()); // CM a16
+  OP_CYC(0xFD, 11, perform_call(cpu, 1, mem64k); TRAP());  // CALL a16 (alternate)
+  OP_CYC(0xFE, 7, perform_sub(cpu, cpu->A, next_byte(cpu, mem64k), 0)); // CPI d8
+  OP(0xFF, rst(cpu, 0xFF, mem64k); TRAP());                // RST 7
+
+done:
+  return cpu->cyc - start;
+}
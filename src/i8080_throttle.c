@@ -0,0 +1,123 @@
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include "i8080_throttle.h"
+
+#define NS_PER_SECOND 1000000000ull
+
+static unsigned long long now_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long long) ts.tv_sec * NS_PER_SECOND +
+         (unsigned long long) ts.tv_nsec;
+}
+
+// Sleeps until the given host time, returning how long that took. Absolute
+// deadlines keep oversleeping in one slice from adding up over many.
+static unsigned long long sleep_until(unsigned long long ns) {
+  struct timespec ts;
+  ts.tv_sec = (time_t) (ns / NS_PER_SECOND);
+  ts.tv_nsec = (long) (ns % NS_PER_SECOND);
+
+  unsigned long long before = now_ns();
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+  }
+
+  return now_ns() - before;
+}
+
+// Host time at which the CPU is due to reach the given cycle count
+static unsigned long long due_ns(struct i8080_throttle *throttle,
+                                 unsigned long long cyc) {
+  return throttle->origin_ns +
+         i8080_cycles_to_ns(throttle->cpu, cyc - throttle->origin_cyc);
+}
+
+// Pretends the CPU is exactly on time now
+static void resync(struct i8080_throttle *throttle) {
+  throttle->origin_ns = now_ns();
+  throttle->origin_cyc = throttle->cpu->cyc;
+}
+
+void i8080_throttle_init(struct i8080_throttle *throttle, struct i8080 *cpu) {
+  throttle->cpu = cpu;
+  throttle->slice_ns = I8080_THROTTLE_SLICE_NS;
+  throttle->max_lag_ns = I8080_THROTTLE_MAX_LAG_NS;
+
+  throttle->cycles = 0;
+  throttle->host_ns = 0;
+  throttle->sleep_ns = 0;
+  throttle->idle_ns = 0;
+  throttle->resyncs = 0;
+
+  resync(throttle);
+  throttle->start_ns = throttle->origin_ns;
+}
+
+unsigned long long i8080_throttle_run(struct i8080_throttle *throttle,
+                                      unsigned long long ns) {
+  struct i8080 *cpu = throttle->cpu;
+  unsigned long long start = cpu->cyc;
+  unsigned long long end = start + i8080_ns_to_cycles(cpu, ns);
+  unsigned long long slice = i8080_ns_to_cycles(cpu, throttle->slice_ns);
+
+  if (slice == 0) {
+    slice = 1;
+  }
+
+  // The cycle count was moved back, e.g. by restoring a snapshot
+  if (cpu->cyc < throttle->origin_cyc) {
+    resync(throttle);
+  }
+
+  while (cpu->cyc < end) {
+    unsigned long long until = end - cpu->cyc > slice ? cpu->cyc + slice : end;
+    unsigned long long next;
+
+    // A halted CPU has nothing to do before its next event, so skip straight
+    // there (or to the end) in one go and sleep just once
+    if (cpu->halted) {
+      until = end;
+      if (i8080_next_event(cpu, &next) && next > cpu->cyc && next < end) {
+        until = next;
+      }
+    }
+
+    unsigned long long left = until - cpu->cyc;
+    i8080_run_timed(cpu, left < ULONG_MAX ? (unsigned long) left : ULONG_MAX);
+
+    // Parked on an IN, which the host has to complete first
+    if (cpu->in_pending) {
+      break;
+    }
+
+    unsigned long long now = now_ns();
+    unsigned long long due = due_ns(throttle, cpu->cyc);
+    if (due > now) {
+      unsigned long long slept = sleep_until(due);
+      throttle->sleep_ns += slept;
+      if (cpu->halted) {
+        throttle->idle_ns += slept;
+      }
+    } else if (now - due > throttle->max_lag_ns) {
+      // Too far behind (the host was suspended, or is just too slow), so
+      // carry on from here rather than running flat out to catch up
+      resync(throttle);
+      throttle->resyncs++;
+    }
+  }
+
+  throttle->cycles += cpu->cyc - start;
+  throttle->host_ns = now_ns() - throttle->start_ns;
+
+  return cpu->cyc - start;
+}
+
+double i8080_throttle_speed(const struct i8080_throttle *throttle) {
+  if (throttle->host_ns == 0) {
+    return 0;
+  }
+
+  return (double) i8080_cycles_to_ns(throttle->cpu, throttle->cycles) /
+         (double) throttle->host_ns;
+}
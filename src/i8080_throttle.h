@@ -0,0 +1,37 @@
+#ifndef LIB8080_THROTTLE_H_
+#define LIB8080_THROTTLE_H_
+
+#include "i8080.h"
+
+// Defaults set by i8080_throttle_init
+#define I8080_THROTTLE_SLICE_NS 10000000ull
+#define I8080_THROTTLE_MAX_LAG_NS 100000000ull
+
+struct i8080_throttle {
+  struct i8080 *cpu;
+
+  // Emulated time run between checks of the host clock
+  unsigned long long slice_ns;
+  // How far behind real time the CPU may fall before giving up on catching
+  // up
+  unsigned long long max_lag_ns;
+
+  // Statistics since i8080_throttle_init
+  unsigned long long cycles;
+  unsigned long long host_ns;
+  unsigned long long sleep_ns;
+  unsigned long long idle_ns;
+  unsigned long resyncs;
+
+  // Host time at which the CPU is due to reach origin_cyc
+  unsigned long long origin_ns;
+  unsigned long long origin_cyc;
+  unsigned long long start_ns;
+};
+
+void i8080_throttle_init(struct i8080_throttle *, struct i8080 *);
+unsigned long long i8080_throttle_run(struct i8080_throttle *,
+                                      unsigned long long);
+double i8080_throttle_speed(const struct i8080_throttle *);
+
+#endif
@@ -0,0 +1,89 @@
+#include <pthread.h>
+#include "i8080_wait.h"
+
+int i8080_wait_init(struct i8080_wait *wait, struct i8080 *cpu) {
+  if (pthread_mutex_init(&wait->lock, NULL) != 0) {
+    return -1;
+  }
+  if (pthread_cond_init(&wait->cond, NULL) != 0) {
+    pthread_mutex_destroy(&wait->lock);
+    return -1;
+  }
+
+  wait->cpu = cpu;
+  wait->woken = 0;
+
+  return 0;
+}
+
+void i8080_wait_destroy(struct i8080_wait *wait) {
+  pthread_cond_destroy(&wait->cond);
+  pthread_mutex_destroy(&wait->lock);
+}
+
+int i8080_wait_post(struct i8080_wait *wait, uint opcode) {
+  // A running CPU takes it without any help. Signalling under the lock keeps
+  // it from being missed between checking the mailbox and blocking.
+  if (i8080_post_interrupt(wait->cpu, opcode) < 0) {
+    return -1;
+  }
+
+  pthread_mutex_lock(&wait->lock);
+  pthread_cond_signal(&wait->cond);
+  pthread_mutex_unlock(&wait->lock);
+
+  return 0;
+}
+
+void i8080_wait_wake(struct i8080_wait *wait) {
+  pthread_mutex_lock(&wait->lock);
+  wait->woken = 1;
+  pthread_cond_signal(&wait->cond);
+  pthread_mutex_unlock(&wait->lock);
+}
+
+// Blocks while the CPU is halted with nothing due to wake it. Returns 0 if
+// woken by i8080_wait_wake instead of an interrupt.
+static int wait_for_interrupt(struct i8080_wait *wait) {
+  struct i8080 *cpu = wait->cpu;
+  unsigned long long next;
+  int woken;
+
+  pthread_mutex_lock(&wait->lock);
+  while (cpu->halted && !i8080_interrupt_posted(cpu) && !wait->woken &&
+         !i8080_next_event(cpu, &next)) {
+    pthread_cond_wait(&wait->cond, &wait->lock);
+  }
+
+  woken = wait->woken && cpu->halted && !i8080_interrupt_posted(cpu);
+  wait->woken = 0;
+  pthread_mutex_unlock(&wait->lock);
+
+  return !woken;
+}
+
+unsigned long i8080_wait_run(struct i8080_wait *wait, unsigned long cycles) {
+  struct i8080 *cpu = wait->cpu;
+  unsigned long total = 0;
+  unsigned long long next;
+
+  while (total < cycles && wait_for_interrupt(wait)) {
+    // Takes any posted interrupt first
+    total += i8080_run(cpu, cycles - total);
+
+    // Nothing more to do until the host completes the IN
+    if (cpu->in_pending) {
+      break;
+    }
+
+    // Halted, but with an event coming up, so time passes until then
+    if (cpu->halted && total < cycles && i8080_next_event(cpu, &next) &&
+        next > cpu->cyc) {
+      unsigned long long skip = next - cpu->cyc;
+      total += i8080_run_timed(cpu, skip < cycles - total ?
+                                    (unsigned long) skip : cycles - total);
+    }
+  }
+
+  return total;
+}
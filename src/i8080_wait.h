@@ -0,0 +1,23 @@
+#ifndef LIB8080_WAIT_H_
+#define LIB8080_WAIT_H_
+
+#include <pthread.h>
+#include "i8080.h"
+
+struct i8080_wait {
+  struct i8080 *cpu;
+
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+
+  // Set by i8080_wait_wake to return from i8080_wait_run without an interrupt
+  int woken;
+};
+
+int i8080_wait_init(struct i8080_wait *, struct i8080 *);
+void i8080_wait_destroy(struct i8080_wait *);
+int i8080_wait_post(struct i8080_wait *, uint);
+void i8080_wait_wake(struct i8080_wait *);
+unsigned long i8080_wait_run(struct i8080_wait *, unsigned long);
+
+#endif
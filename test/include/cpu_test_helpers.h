@@ -1,7 +1,17 @@
 #ifndef CPU_TEST_HELPERS_H
 #define CPU_TEST_HELPERS_H
 
+#include <stddef.h>
+
 struct i8080 *setup_cpu_test_env();
 void teardown_cpu_test_env(struct i8080 *);
 
+void load_program(struct i8080 *, const unsigned char *, size_t);
+void load_wrap_program(struct i8080 *);
+void assert_same_state(struct i8080 *, struct i8080 *);
+
+void run_against_interpreter(struct i8080 *, struct i8080 *,
+                             const unsigned char *, size_t, unsigned long);
+void check_against_interpreter(struct i8080 *, struct i8080 *);
+
 #endif
\ No newline at end of file
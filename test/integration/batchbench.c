@@ -0,0 +1,104 @@
+#include "i8080.h"
+#include "i8080_batch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// Runs many copies of a CP/M binary with i8080_batch_run at increasing thread
+// counts and reports aggregate throughput. BDOS calls are swallowed, so the
+// binary's output is discarded.
+
+#define SLICE 100000
+
+static void ignore_output(struct i8080 *cpu, uint dev, uint val) {
+}
+
+static void setup_machine(struct i8080 *cpu, char *program, long size) {
+  i8080_reset(cpu);
+  cpu->PC = 0x100;
+  memcpy(cpu->memory + 0x100, program, size);
+
+  // HLT on warm boot, and OUT 0xFF; RET as the BDOS entry point
+  i8080_write_byte(cpu, 0x0000, 0x76);
+  i8080_write_byte(cpu, 0x0005, 0xD3);
+  i8080_write_byte(cpu, 0x0006, 0xFF);
+  i8080_write_byte(cpu, 0x0007, 0xC9);
+  cpu->output_handler = ignore_output;
+}
+
+// Counts the instructions executed by one run of the program
+static unsigned long count_instructions(struct i8080 *cpu, char *program,
+                                        long size) {
+  unsigned long count = 0;
+
+  setup_machine(cpu, program, size);
+  while (!cpu->halted) {
+    i8080_step(cpu);
+    count++;
+  }
+
+  return count;
+}
+
+static double now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 3) {
+    fprintf(stderr, "Usage: batchbench <filename> <machines> [max threads]\n");
+    return 1;
+  }
+
+  int count = atoi(argv[2]);
+  long online = sysconf(_SC_NPROCESSORS_ONLN);
+  int max_threads = argc > 3 ? atoi(argv[3]) : (int) online;
+  if (count <= 0 || max_threads <= 0) {
+    fprintf(stderr, "Machine and thread counts must be positive\n");
+    return 1;
+  }
+
+  struct i8080 **cpus = malloc(count * sizeof(struct i8080 *));
+  for (int i=0;i<count;i++) {
+    cpus[i] = malloc(sizeof(struct i8080));
+    cpus[i]->memsize = 65536;
+    cpus[i]->memory = calloc(cpus[i]->memsize, 1);
+  }
+
+  long size = i8080_load_memory(cpus[0], argv[1], 0x100);
+  if (size < 0) {
+    perror(argv[1]);
+    return 1;
+  }
+  char *program = malloc(size);
+  memcpy(program, cpus[0]->memory + 0x100, size);
+
+  unsigned long instructions = count_instructions(cpus[0], program, size);
+  printf("%s: %lu instructions x %d machines (%ld cores online)\n",
+         argv[1], instructions, count, online);
+  printf("threads  seconds     MIPS  speedup\n");
+
+  double base = 0;
+  for (int threads=1;threads<=max_threads;threads*=2) {
+    for (int i=0;i<count;i++) {
+      setup_machine(cpus[i], program, size);
+    }
+
+    double start = now();
+    i8080_batch_run(cpus, count, threads, SLICE, NULL, NULL);
+    double elapsed = now() - start;
+
+    double mips = (double) instructions * count / elapsed / 1e6;
+    if (threads == 1) {
+      base = mips;
+    }
+
+    printf("%7d %8.3f %8.1f %7.2fx\n", threads, elapsed, mips, mips / base);
+  }
+
+  return 0;
+}
@@ -1,6 +1,8 @@
 #include <stdlib.h>
+#include <string.h>
 #include "i8080.h"
 #include "memory.h"
+#include "attounit.h"
 
 /**
  * @brief Setup a small test environment for CPU tests
@@ -15,6 +17,9 @@
  * - All other registers (including the program counter) initialized to 0x00
  * - Zero cycles
  * - No pending interrupts
+ *
+ * When built with the JIT, it is enabled with single instruction blocks so
+ * that every instruction test also runs the translated code.
  */
 struct i8080 *setup_cpu_test_env() {
   struct i8080 *cpu = malloc(sizeof(struct i8080));
@@ -28,10 +33,255 @@ struct i8080 *setup_cpu_test_env() {
     i8080_write_byte(cpu, i, 0);
   }
 
+#ifdef I8080_JIT
+  i8080_jit_enable(cpu, 1);
+#endif
+
   return cpu;
 }
 
 void teardown_cpu_test_env(struct i8080 *cpu) {
+  i8080_jit_disable(cpu);
   free(cpu->memory);
   free(cpu);
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Load a program into memory starting at address 0x0000
+ */
+void load_program(struct i8080 *cpu, const unsigned char *program,
+                  size_t size) {
+  for (size_t i=0;i<size;i++) {
+    i8080_write_byte(cpu, i, program[i]);
+  }
+}
+
+/**
+ * @brief Load a program whose word accesses wrap around in 64K mode
+ *
+ * The program stores HL at 0xFFFF and loads it back, then pushes it and pops
+ * it into DE with the stack at 0x0001, then halts. In 64K mode the high byte
+ * of each word lands at 0x0000.
+ */
+void load_wrap_program(struct i8080 *cpu) {
+  static const unsigned char program[] = {
+    0x21, 0x34, 0x12, // 00: LXI H, 0x1234
+    0x22, 0xFF, 0xFF, // 03: SHLD 0xFFFF
+    0x21, 0x00, 0x00, // 06: LXI H, 0x0000
+    0x2A, 0xFF, 0xFF, // 09: LHLD 0xFFFF
+    0x31, 0x01, 0x00, // 0C: LXI SP, 0x0001
+    0xE5,             // 0F: PUSH H
+    0xD1,             // 10: POP D
+    0x76,             // 11: HLT
+  };
+
+  load_program(cpu, program, sizeof(program));
+}
+
+/**
+ * @brief Assert that a machine ended up in the same state as another
+ *
+ * Compares every register, the flags, the cycle count, whether the machine is
+ * halted or has interrupts enabled, and all of memory.
+ */
+void assert_same_state(struct i8080 *cpu, struct i8080 *expected) {
+  ASSERT_EQUAL(cpu->A, expected->A);
+  ASSERT_EQUAL(cpu->B, expected->B);
+  ASSERT_EQUAL(cpu->C, expected->C);
+  ASSERT_EQUAL(cpu->D, expected->D);
+  ASSERT_EQUAL(cpu->E, expected->E);
+  ASSERT_EQUAL(cpu->H, expected->H);
+  ASSERT_EQUAL(cpu->L, expected->L);
+  ASSERT_EQUAL(cpu->flags, expected->flags);
+  ASSERT_EQUAL(cpu->PC, expected->PC);
+  ASSERT_EQUAL(cpu->SP, expected->SP);
+  ASSERT_EQUAL_FMT(cpu->cyc, expected->cyc, %llu);
+  ASSERT_EQUAL(cpu->halted, expected->halted);
+  ASSERT_EQUAL(cpu->INTE, expected->INTE);
+  ASSERT_EQUAL(memcmp(cpu->memory, expected->memory, cpu->memsize), 0);
+}
+
+/**
+ * @brief Run a program on two machines and check they stay in step
+ *
+ * Loads the program into both machines, restarts them at 0x0000 and runs them
+ * for the same budget at a time until the second one halts, checking that
+ * both use the same cycles and end up in the same state after every run. The
+ * second machine is meant to be a plain interpreter the first is checked
+ * against.
+ */
+void run_against_interpreter(struct i8080 *cpu, struct i8080 *expected,
+                             const unsigned char *program, size_t size,
+                             unsigned long budget) {
+  load_program(cpu, program, size);
+  load_program(expected, program, size);
+  cpu->PC = expected->PC = 0;
+  cpu->halted = expected->halted = 0;
+
+  for (int round=0;round<10000 && !expected->halted;round++) {
+    unsigned long cyc = i8080_run(cpu, budget);
+    unsigned long expected_cyc = i8080_run(expected, budget);
+
+    ASSERT_EQUAL_FMT(cyc, expected_cyc, %lu);
+    assert_same_state(cpu, expected);
+  }
+
+  ASSERT_TRUE(cpu->halted);
+}
+
+// Loops over most kinds of instructions, including the ones the JIT hands
+// back to the interpreter (DAA, XTHL) and a call in the middle of the loop
+static const unsigned char mixed_program[] = {
+  0x31, 0x7E, 0x00, // 00: LXI SP, 0x007E
+  0x21, 0x60, 0x00, // 03: LXI H, 0x0060
+  0x06, 0x0A,       // 06: MVI B, 0x0A
+  0x78,             // 08: MOV A, B
+  0x86,             // 09: ADD M
+  0x27,             // 0A: DAA
+  0x77,             // 0B: MOV M, A
+  0x0F,             // 0C: RRC
+  0x9E,             // 0D: SBB M
+  0x2C,             // 0E: INR L
+  0xF5,             // 0F: PUSH PSW
+  0xE3,             // 10: XTHL
+  0xE3,             // 11: XTHL
+  0xF1,             // 12: POP PSW
+  0xEB,             // 13: XCHG
+  0xEB,             // 14: XCHG
+  0xCD, 0x1D, 0x00, // 15: CALL 0x001D
+  0x05,             // 18: DCR B
+  0xC2, 0x08, 0x00, // 19: JNZ 0x0008
+  0x76,             // 1C: HLT
+  0x37,             // 1D: STC
+  0xCE, 0x05,       // 1E: ACI 0x05
+  0xE6, 0x7F,       // 20: ANI 0x7F
+  0xD8,             // 22: RC
+  0x3F,             // 23: CMC
+  0xC9,             // 24: RET
+};
+
+// A block that stores over one of its own later instructions
+static const unsigned char self_modifying_program[] = {
+  0x3E, 0x3C,       // 00: MVI A, 0x3C (INR A)
+  0x32, 0x07, 0x00, // 02: STA 0x0007
+  0x06, 0x01,       // 05: MVI B, 0x01
+  0x00,             // 07: NOP, replaced by INR A
+  0x76,             // 08: HLT
+};
+
+// Spins in a one instruction block until an interrupt comes in
+static const unsigned char interrupt_program[] = {
+  0x31, 0x40, 0x00, // 00: LXI SP, 0x0040
+  0xFB,             // 03: EI
+  0xC3, 0x04, 0x00, // 04: JMP 0x0004
+  0x00,             // 07: NOP
+  0x3E, 0x42,       // 08: MVI A, 0x42
+  0x76,             // 0A: HLT
+};
+
+static void clear_memory(struct i8080 *cpu) {
+  for (size_t i=0;i<cpu->memsize;i++) {
+    i8080_write_byte(cpu, i, 0);
+  }
+}
+
+// Stores made through i8080_write_byte must drop whatever was decoded from the
+// old contents
+static void check_write_byte(struct i8080 *cpu, struct i8080 *expected) {
+  static const unsigned char program[] = {
+    0x3E, 0x01,       // 00: MVI A, 0x01
+    0x76,             // 02: HLT
+  };
+
+  run_against_interpreter(cpu, expected, program, sizeof(program), 1000);
+  ASSERT_EQUAL(cpu->A, 0x01);
+
+  for (int i=0;i<2;i++) {
+    struct i8080 *machine = i ? expected : cpu;
+    i8080_write_byte(machine, 1, 0x02);
+    machine->PC = 0;
+    machine->halted = 0;
+    i8080_run(machine, 1000);
+  }
+
+  ASSERT_EQUAL(cpu->A, 0x02);
+  assert_same_state(cpu, expected);
+}
+
+static void check_interrupt(struct i8080 *cpu, struct i8080 *expected) {
+  load_program(cpu, interrupt_program, sizeof(interrupt_program));
+  load_program(expected, interrupt_program, sizeof(interrupt_program));
+  cpu->PC = expected->PC = 0;
+  cpu->halted = expected->halted = 0;
+
+  for (int i=0;i<2;i++) {
+    struct i8080 *machine = i ? expected : cpu;
+    i8080_run(machine, 100);
+    i8080_request_interrupt(machine, I8080_RST_1);
+    i8080_run(machine, 100);
+  }
+
+  ASSERT_TRUE(cpu->halted);
+  ASSERT_EQUAL(cpu->A, 0x42);
+  ASSERT_EQUAL(i8080_read_word(cpu, 0x3E), 0x04);
+  assert_same_state(cpu, expected);
+}
+
+static void check_random_programs(struct i8080 *cpu, struct i8080 *expected) {
+  uint seed = 1;
+
+  // Random bytes exercise every opcode, including self-modifying stores and
+  // jumps off the end of memory
+  for (int program=0;program<50;program++) {
+    for (uint addr=0;addr<cpu->memsize;addr++) {
+      seed = seed * 1103515245 + 12345;
+      i8080_write_byte(cpu, addr, seed >> 16);
+      i8080_write_byte(expected, addr, seed >> 16);
+    }
+
+    cpu->PC = expected->PC = 0;
+    cpu->SP = expected->SP = 0x70;
+    cpu->halted = expected->halted = 0;
+
+    for (int round=0;round<20;round++) {
+      unsigned long cyc = i8080_run(cpu, 50);
+      unsigned long expected_cyc = i8080_run(expected, 50);
+
+      ASSERT_EQUAL_FMT(cyc, expected_cyc, %lu);
+      assert_same_state(cpu, expected);
+    }
+  }
+}
+
+/**
+ * @brief Check a block executing engine against the plain interpreter
+ *
+ * Runs a mix of programs on both machines, the first having the block cache
+ * or JIT enabled and the second neither, and checks that they behave the same:
+ * a loop over most kinds of instructions, with a whole budget and with
+ * budgets ending in the middle of blocks, self-modifying code, stores through
+ * i8080_write_byte, interrupts between blocks and random programs. Both
+ * machines need the same amount of zeroed memory to begin with.
+ */
+void check_against_interpreter(struct i8080 *cpu, struct i8080 *expected) {
+  run_against_interpreter(cpu, expected, mixed_program, sizeof(mixed_program),
+                          100000);
+
+  // Budgets that mostly end in the middle of blocks
+  for (unsigned long budget=7;budget<37;budget++) {
+    clear_memory(cpu);
+    clear_memory(expected);
+    run_against_interpreter(cpu, expected, mixed_program,
+                            sizeof(mixed_program), budget);
+  }
+
+  clear_memory(cpu);
+  clear_memory(expected);
+  run_against_interpreter(cpu, expected, self_modifying_program,
+                          sizeof(self_modifying_program), 1000);
+  ASSERT_EQUAL(cpu->A, 0x3D);
+
+  check_write_byte(cpu, expected);
+  check_interrupt(cpu, expected);
+  check_random_programs(cpu, expected);
+}
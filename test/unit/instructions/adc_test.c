@@ -25,7 +25,7 @@ TEST_CASE(adc_b) {
   ASSERT_EQUAL(cpu->A, 0xFF);
   ASSERT_TRUE(i8080_get_flag(cpu, FLAG_C));
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(adc_c) {
@@ -38,7 +38,7 @@ TEST_CASE(adc_c) {
   ASSERT_EQUAL(cpu->A, 0xFF);
   ASSERT_TRUE(i8080_get_flag(cpu, FLAG_C));
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(adc_d) {
@@ -51,7 +51,7 @@ TEST_CASE(adc_d) {
   ASSERT_EQUAL(cpu->A, 0xFF);
   ASSERT_TRUE(i8080_get_flag(cpu, FLAG_C));
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(adc_e) {
@@ -64,7 +64,7 @@ TEST_CASE(adc_e) {
   ASSERT_EQUAL(cpu->A, 0xFF);
   ASSERT_TRUE(i8080_get_flag(cpu, FLAG_C));
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(adc_h) {
@@ -77,7 +77,7 @@ TEST_CASE(adc_h) {
   ASSERT_EQUAL(cpu->A, 0xFF);
   ASSERT_TRUE(i8080_get_flag(cpu, FLAG_C));
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(adc_l) {
@@ -90,7 +90,7 @@ TEST_CASE(adc_l) {
   ASSERT_EQUAL(cpu->A, 0xFF);
   ASSERT_TRUE(i8080_get_flag(cpu, FLAG_C));
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(adc_m) {
@@ -104,7 +104,7 @@ TEST_CASE(adc_m) {
   ASSERT_EQUAL(cpu->A, 0xFF);
   ASSERT_TRUE(i8080_get_flag(cpu, FLAG_C));
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 7);
+  ASSERT_EQUAL_FMT(cpu->cyc, 7llu, %llu);
 }
 
 TEST_CASE(adc_a) {
@@ -117,7 +117,7 @@ TEST_CASE(adc_a) {
   ASSERT_EQUAL(cpu->A, 0xFF);
   ASSERT_TRUE(i8080_get_flag(cpu, FLAG_C));
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 // Bit flag tests
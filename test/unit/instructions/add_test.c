@@ -24,7 +24,7 @@ TEST_CASE(add_b) {
 
   ASSERT_EQUAL(cpu->A, 1);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(add_c) {
@@ -35,7 +35,7 @@ TEST_CASE(add_c) {
 
   ASSERT_EQUAL(cpu->A, 1);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(add_d) {
@@ -46,7 +46,7 @@ TEST_CASE(add_d) {
 
   ASSERT_EQUAL(cpu->A, 1);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(add_e) {
@@ -57,7 +57,7 @@ TEST_CASE(add_e) {
 
   ASSERT_EQUAL(cpu->A, 1);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(add_h) {
@@ -78,7 +78,7 @@ TEST_CASE(add_l) {
 
   ASSERT_EQUAL(cpu->A, 1);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(add_m) {
@@ -90,7 +90,7 @@ TEST_CASE(add_m) {
 
   ASSERT_EQUAL(cpu->A, 1);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 7);
+  ASSERT_EQUAL_FMT(cpu->cyc, 7llu, %llu);
 }
 
 TEST_CASE(add_a) {
@@ -101,7 +101,7 @@ TEST_CASE(add_a) {
 
   ASSERT_EQUAL(cpu->A, 2);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 // i8080_flag bit tests
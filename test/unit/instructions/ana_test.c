@@ -23,7 +23,7 @@ TEST_CASE(ana_b) {
 
   ASSERT_EQUAL(cpu->A, 2);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(ana_c) {
@@ -34,7 +34,7 @@ TEST_CASE(ana_c) {
 
   ASSERT_EQUAL(cpu->A, 2);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(ana_d) {
@@ -45,7 +45,7 @@ TEST_CASE(ana_d) {
 
   ASSERT_EQUAL(cpu->A, 2);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(ana_e) {
@@ -56,7 +56,7 @@ TEST_CASE(ana_e) {
 
   ASSERT_EQUAL(cpu->A, 2);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(ana_h) {
@@ -67,7 +67,7 @@ TEST_CASE(ana_h) {
 
   ASSERT_EQUAL(cpu->A, 2);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(ana_l) {
@@ -78,7 +78,7 @@ TEST_CASE(ana_l) {
 
   ASSERT_EQUAL(cpu->A, 2);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(ana_m) {
@@ -90,7 +90,7 @@ TEST_CASE(ana_m) {
 
   ASSERT_EQUAL(cpu->A, 2);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 7);
+  ASSERT_EQUAL_FMT(cpu->cyc, 7llu, %llu);
 }
 
 TEST_CASE(ana_a) {
@@ -101,7 +101,7 @@ TEST_CASE(ana_a) {
 
   ASSERT_EQUAL(cpu->A, 10);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 // i8080_flag bit tests
@@ -22,7 +22,7 @@ TEST_CASE(call) {
 
   ASSERT_EQUAL(cpu->PC, 0xABCD);
   ASSERT_EQUAL(i8080_pop_stackb(cpu), 3);
-  ASSERT_EQUAL(cpu->cyc, 17);
+  ASSERT_EQUAL_FMT(cpu->cyc, 17llu, %llu);
 }
 
 TEST_CASE(call_alternate_0xdd) {
@@ -33,7 +33,7 @@ TEST_CASE(call_alternate_0xdd) {
 
   ASSERT_EQUAL(cpu->PC, 0xABCD);
   ASSERT_EQUAL(i8080_pop_stackb(cpu), 3);
-  ASSERT_EQUAL(cpu->cyc, 17);
+  ASSERT_EQUAL_FMT(cpu->cyc, 17llu, %llu);
 }
 
 TEST_CASE(call_alternate_0xed) {
@@ -44,7 +44,7 @@ TEST_CASE(call_alternate_0xed) {
 
   ASSERT_EQUAL(cpu->PC, 0xABCD);
   ASSERT_EQUAL(i8080_pop_stackb(cpu), 3);
-  ASSERT_EQUAL(cpu->cyc, 17);
+  ASSERT_EQUAL_FMT(cpu->cyc, 17llu, %llu);
 }
 
 TEST_CASE(call_alternate_0xfd) {
@@ -55,7 +55,7 @@ TEST_CASE(call_alternate_0xfd) {
 
   ASSERT_EQUAL(cpu->PC, 0xABCD);
   ASSERT_EQUAL(i8080_pop_stackb(cpu), 3);
-  ASSERT_EQUAL(cpu->cyc, 17);
+  ASSERT_EQUAL_FMT(cpu->cyc, 17llu, %llu);
 }
 
 
@@ -68,7 +68,7 @@ TEST_CASE(cz_z_flag_set) {
 
   ASSERT_EQUAL(cpu->PC, 0xABCD);
   ASSERT_EQUAL(i8080_pop_stackb(cpu), 3);
-  ASSERT_EQUAL(cpu->cyc, 17);
+  ASSERT_EQUAL_FMT(cpu->cyc, 17llu, %llu);
 }
 
 TEST_CASE(cz_z_flag_unset) {
@@ -79,7 +79,7 @@ TEST_CASE(cz_z_flag_unset) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 3);
-  ASSERT_EQUAL(cpu->cyc, 11);
+  ASSERT_EQUAL_FMT(cpu->cyc, 11llu, %llu);
 }
 
 TEST_CASE(cnz_z_flag_set) {
@@ -90,7 +90,7 @@ TEST_CASE(cnz_z_flag_set) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 3);
-  ASSERT_EQUAL(cpu->cyc, 11);
+  ASSERT_EQUAL_FMT(cpu->cyc, 11llu, %llu);
 }
 
 TEST_CASE(cnz_z_flag_unset) {
@@ -102,7 +102,7 @@ TEST_CASE(cnz_z_flag_unset) {
 
   ASSERT_EQUAL(cpu->PC, 0xABCD);
   ASSERT_EQUAL(i8080_pop_stackb(cpu), 3);
-  ASSERT_EQUAL(cpu->cyc, 17);
+  ASSERT_EQUAL_FMT(cpu->cyc, 17llu, %llu);
 }
 
 TEST_CASE(cnc_c_flag_set) {
@@ -113,7 +113,7 @@ TEST_CASE(cnc_c_flag_set) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 3);
-  ASSERT_EQUAL(cpu->cyc, 11);
+  ASSERT_EQUAL_FMT(cpu->cyc, 11llu, %llu);
 }
 
 TEST_CASE(cnc_c_flag_unset) {
@@ -125,7 +125,7 @@ TEST_CASE(cnc_c_flag_unset) {
 
   ASSERT_EQUAL(cpu->PC, 0xABCD);
   ASSERT_EQUAL(i8080_pop_stackb(cpu), 3);
-  ASSERT_EQUAL(cpu->cyc, 17);
+  ASSERT_EQUAL_FMT(cpu->cyc, 17llu, %llu);
 }
 
 TEST_CASE(cc_c_flag_set) {
@@ -137,7 +137,7 @@ TEST_CASE(cc_c_flag_set) {
 
   ASSERT_EQUAL(cpu->PC, 0xABCD);
   ASSERT_EQUAL(i8080_pop_stackb(cpu), 3);
-  ASSERT_EQUAL(cpu->cyc, 17);
+  ASSERT_EQUAL_FMT(cpu->cyc, 17llu, %llu);
 }
 
 TEST_CASE(cc_c_flag_unset) {
@@ -148,7 +148,7 @@ TEST_CASE(cc_c_flag_unset) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 3);
-  ASSERT_EQUAL(cpu->cyc, 11);
+  ASSERT_EQUAL_FMT(cpu->cyc, 11llu, %llu);
 }
 
 TEST_CASE(cpo_p_flag_set) {
@@ -159,7 +159,7 @@ TEST_CASE(cpo_p_flag_set) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 3);
-  ASSERT_EQUAL(cpu->cyc, 11);
+  ASSERT_EQUAL_FMT(cpu->cyc, 11llu, %llu);
 }
 
 TEST_CASE(cpo_p_flag_unset) {
@@ -171,7 +171,7 @@ TEST_CASE(cpo_p_flag_unset) {
 
   ASSERT_EQUAL(cpu->PC, 0xABCD);
   ASSERT_EQUAL(i8080_pop_stackb(cpu), 3);
-  ASSERT_EQUAL(cpu->cyc, 17);
+  ASSERT_EQUAL_FMT(cpu->cyc, 17llu, %llu);
 }
 
 TEST_CASE(cpe_p_flag_set) {
@@ -183,7 +183,7 @@ TEST_CASE(cpe_p_flag_set) {
 
   ASSERT_EQUAL(cpu->PC, 0xABCD);
   ASSERT_EQUAL(i8080_pop_stackb(cpu), 3);
-  ASSERT_EQUAL(cpu->cyc, 17);
+  ASSERT_EQUAL_FMT(cpu->cyc, 17llu, %llu);
 }
 
 TEST_CASE(cpe_p_flag_unset) {
@@ -194,7 +194,7 @@ TEST_CASE(cpe_p_flag_unset) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 3);
-  ASSERT_EQUAL(cpu->cyc, 11);
+  ASSERT_EQUAL_FMT(cpu->cyc, 11llu, %llu);
 }
 
 TEST_CASE(cp_s_flag_set) {
@@ -205,7 +205,7 @@ TEST_CASE(cp_s_flag_set) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 3);
-  ASSERT_EQUAL(cpu->cyc, 11);
+  ASSERT_EQUAL_FMT(cpu->cyc, 11llu, %llu);
 }
 
 TEST_CASE(cp_s_flag_unset) {
@@ -217,7 +217,7 @@ TEST_CASE(cp_s_flag_unset) {
 
   ASSERT_EQUAL(cpu->PC, 0xABCD);
   ASSERT_EQUAL(i8080_pop_stackb(cpu), 3);
-  ASSERT_EQUAL(cpu->cyc, 17);
+  ASSERT_EQUAL_FMT(cpu->cyc, 17llu, %llu);
 }
 
 TEST_CASE(cm_s_flag_set) {
@@ -230,7 +230,7 @@ TEST_CASE(cm_s_flag_set) {
 
   ASSERT_EQUAL(cpu->PC, 0xABCD);
   ASSERT_EQUAL(i8080_pop_stackb(cpu), 3);
-  ASSERT_EQUAL(cpu->cyc, 17);
+  ASSERT_EQUAL_FMT(cpu->cyc, 17llu, %llu);
 }
 
 TEST_CASE(cm_s_flag_unset) {
@@ -241,5 +241,5 @@ TEST_CASE(cm_s_flag_unset) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 3);
-  ASSERT_EQUAL(cpu->cyc, 11);
+  ASSERT_EQUAL_FMT(cpu->cyc, 11llu, %llu);
 }
@@ -22,7 +22,7 @@ TEST_CASE(stc_carry_0) {
 
   ASSERT_TRUE(i8080_get_flag(cpu, FLAG_C));
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(stc_carry_1) {
@@ -33,7 +33,7 @@ TEST_CASE(stc_carry_1) {
 
   ASSERT_TRUE(i8080_get_flag(cpu, FLAG_C));
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(cmc_carry_1) {
@@ -44,7 +44,7 @@ TEST_CASE(cmc_carry_1) {
 
   ASSERT_FALSE(i8080_get_flag(cpu, FLAG_C));
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(cmc_carry_0) {
@@ -55,5 +55,5 @@ TEST_CASE(cmc_carry_0) {
 
   ASSERT_TRUE(i8080_get_flag(cpu, FLAG_C));
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
@@ -23,7 +23,7 @@ TEST_CASE(cmp_b) {
 
   ASSERT_TRUE(i8080_get_flag(cpu, FLAG_Z));
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(cmp_c) {
@@ -34,7 +34,7 @@ TEST_CASE(cmp_c) {
 
   ASSERT_TRUE(i8080_get_flag(cpu, FLAG_Z));
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(cmp_d) {
@@ -45,7 +45,7 @@ TEST_CASE(cmp_d) {
 
   ASSERT_TRUE(i8080_get_flag(cpu, FLAG_Z));
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(cmp_e) {
@@ -56,7 +56,7 @@ TEST_CASE(cmp_e) {
 
   ASSERT_TRUE(i8080_get_flag(cpu, FLAG_Z));
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(cmp_h) {
@@ -67,7 +67,7 @@ TEST_CASE(cmp_h) {
 
   ASSERT_TRUE(i8080_get_flag(cpu, FLAG_Z));
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(cmp_l) {
@@ -78,7 +78,7 @@ TEST_CASE(cmp_l) {
 
   ASSERT_TRUE(i8080_get_flag(cpu, FLAG_Z));
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(cmp_m) {
@@ -90,7 +90,7 @@ TEST_CASE(cmp_m) {
 
   ASSERT_TRUE(i8080_get_flag(cpu, FLAG_Z));
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 7);
+  ASSERT_EQUAL_FMT(cpu->cyc, 7llu, %llu);
 }
 
 TEST_CASE(cmp_a) {
@@ -101,7 +101,7 @@ TEST_CASE(cmp_a) {
 
   ASSERT_TRUE(i8080_get_flag(cpu, FLAG_Z));
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 // Bit flag tests
@@ -35,7 +35,7 @@ TEST_CASE(daa_cycles) {
 
   i8080_step(cpu);
 
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(daa_1_plus_1) {
@@ -19,7 +19,7 @@ TEST_CASE(mov_b_b) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_b_c) {
@@ -29,7 +29,7 @@ TEST_CASE(mov_b_c) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->B, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_b_d) {
@@ -39,7 +39,7 @@ TEST_CASE(mov_b_d) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->B, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_b_e) {
@@ -49,7 +49,7 @@ TEST_CASE(mov_b_e) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->B, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_b_h) {
@@ -59,7 +59,7 @@ TEST_CASE(mov_b_h) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->B, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_b_l) {
@@ -69,7 +69,7 @@ TEST_CASE(mov_b_l) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->B, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_b_m) {
@@ -80,7 +80,7 @@ TEST_CASE(mov_b_m) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->B, 1);
-  ASSERT_EQUAL(cpu->cyc, 7);
+  ASSERT_EQUAL_FMT(cpu->cyc, 7llu, %llu);
 }
 
 TEST_CASE(mov_b_a) {
@@ -90,7 +90,7 @@ TEST_CASE(mov_b_a) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->B, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_c_b) {
@@ -100,7 +100,7 @@ TEST_CASE(mov_c_b) {
 
   ASSERT_EQUAL(cpu->C, 1);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_c_c) {
@@ -108,7 +108,7 @@ TEST_CASE(mov_c_c) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_c_d) {
@@ -118,7 +118,7 @@ TEST_CASE(mov_c_d) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->C, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_c_e) {
@@ -128,7 +128,7 @@ TEST_CASE(mov_c_e) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->C, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_c_h) {
@@ -138,7 +138,7 @@ TEST_CASE(mov_c_h) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->C, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_c_l) {
@@ -148,7 +148,7 @@ TEST_CASE(mov_c_l) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->C, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_c_m) {
@@ -159,7 +159,7 @@ TEST_CASE(mov_c_m) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->C, 1);
-  ASSERT_EQUAL(cpu->cyc, 7);
+  ASSERT_EQUAL_FMT(cpu->cyc, 7llu, %llu);
 }
 
 TEST_CASE(mov_c_a) {
@@ -169,7 +169,7 @@ TEST_CASE(mov_c_a) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->C, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_d_b) {
@@ -179,7 +179,7 @@ TEST_CASE(mov_d_b) {
 
   ASSERT_EQUAL(cpu->D, 1);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_d_c) {
@@ -189,7 +189,7 @@ TEST_CASE(mov_d_c) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->D, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_d_d) {
@@ -197,7 +197,7 @@ TEST_CASE(mov_d_d) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_d_e) {
@@ -207,7 +207,7 @@ TEST_CASE(mov_d_e) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->D, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_d_h) {
@@ -217,7 +217,7 @@ TEST_CASE(mov_d_h) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->D, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_d_l) {
@@ -227,7 +227,7 @@ TEST_CASE(mov_d_l) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->D, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_d_m) {
@@ -238,7 +238,7 @@ TEST_CASE(mov_d_m) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->D, 1);
-  ASSERT_EQUAL(cpu->cyc, 7);
+  ASSERT_EQUAL_FMT(cpu->cyc, 7llu, %llu);
 }
 
 TEST_CASE(mov_d_a) {
@@ -248,7 +248,7 @@ TEST_CASE(mov_d_a) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->D, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_e_b) {
@@ -258,7 +258,7 @@ TEST_CASE(mov_e_b) {
 
   ASSERT_EQUAL(cpu->E, 1);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_e_c) {
@@ -268,7 +268,7 @@ TEST_CASE(mov_e_c) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->E, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_e_d) {
@@ -278,7 +278,7 @@ TEST_CASE(mov_e_d) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->E, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_e_e) {
@@ -286,7 +286,7 @@ TEST_CASE(mov_e_e) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_e_h) {
@@ -296,7 +296,7 @@ TEST_CASE(mov_e_h) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->E, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_e_l) {
@@ -306,7 +306,7 @@ TEST_CASE(mov_e_l) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->E, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_e_m) {
@@ -317,7 +317,7 @@ TEST_CASE(mov_e_m) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->E, 1);
-  ASSERT_EQUAL(cpu->cyc, 7);
+  ASSERT_EQUAL_FMT(cpu->cyc, 7llu, %llu);
 }
 
 TEST_CASE(mov_e_a) {
@@ -327,7 +327,7 @@ TEST_CASE(mov_e_a) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->E, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_h_b) {
@@ -337,7 +337,7 @@ TEST_CASE(mov_h_b) {
 
   ASSERT_EQUAL(cpu->H, 1);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_h_c) {
@@ -347,7 +347,7 @@ TEST_CASE(mov_h_c) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->H, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_h_d) {
@@ -357,7 +357,7 @@ TEST_CASE(mov_h_d) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->H, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_h_e) {
@@ -367,7 +367,7 @@ TEST_CASE(mov_h_e) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->H, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_h_h) {
@@ -375,7 +375,7 @@ TEST_CASE(mov_h_h) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_h_l) {
@@ -385,7 +385,7 @@ TEST_CASE(mov_h_l) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->H, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_h_m) {
@@ -396,7 +396,7 @@ TEST_CASE(mov_h_m) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->H, 1);
-  ASSERT_EQUAL(cpu->cyc, 7);
+  ASSERT_EQUAL_FMT(cpu->cyc, 7llu, %llu);
 }
 
 TEST_CASE(mov_h_a) {
@@ -406,7 +406,7 @@ TEST_CASE(mov_h_a) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->H, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_l_b) {
@@ -416,7 +416,7 @@ TEST_CASE(mov_l_b) {
 
   ASSERT_EQUAL(cpu->L, 1);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_l_c) {
@@ -426,7 +426,7 @@ TEST_CASE(mov_l_c) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->L, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_l_d) {
@@ -436,7 +436,7 @@ TEST_CASE(mov_l_d) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->L, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_l_e) {
@@ -446,7 +446,7 @@ TEST_CASE(mov_l_e) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->L, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_l_h) {
@@ -456,7 +456,7 @@ TEST_CASE(mov_l_h) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->L, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_l_l) {
@@ -464,7 +464,7 @@ TEST_CASE(mov_l_l) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_l_m) {
@@ -475,7 +475,7 @@ TEST_CASE(mov_l_m) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->L, 1);
-  ASSERT_EQUAL(cpu->cyc, 7);
+  ASSERT_EQUAL_FMT(cpu->cyc, 7llu, %llu);
 }
 
 TEST_CASE(mov_l_a) {
@@ -485,7 +485,7 @@ TEST_CASE(mov_l_a) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->L, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_m_b) {
@@ -495,7 +495,7 @@ TEST_CASE(mov_m_b) {
 
   ASSERT_EQUAL(i8080_read_byte(cpu, 8), 1);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 7);
+  ASSERT_EQUAL_FMT(cpu->cyc, 7llu, %llu);
 }
 
 TEST_CASE(mov_m_c) {
@@ -505,7 +505,7 @@ TEST_CASE(mov_m_c) {
 
   ASSERT_EQUAL(i8080_read_byte(cpu, 8), 1);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 7);
+  ASSERT_EQUAL_FMT(cpu->cyc, 7llu, %llu);
 }
 
 TEST_CASE(mov_m_d) {
@@ -515,7 +515,7 @@ TEST_CASE(mov_m_d) {
 
   ASSERT_EQUAL(i8080_read_byte(cpu, 8), 1);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 7);
+  ASSERT_EQUAL_FMT(cpu->cyc, 7llu, %llu);
 }
 
 TEST_CASE(mov_m_e) {
@@ -525,7 +525,7 @@ TEST_CASE(mov_m_e) {
 
   ASSERT_EQUAL(i8080_read_byte(cpu, 8), 1);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 7);
+  ASSERT_EQUAL_FMT(cpu->cyc, 7llu, %llu);
 }
 
 TEST_CASE(mov_m_h) {
@@ -538,7 +538,7 @@ TEST_CASE(mov_m_h) {
 
   ASSERT_EQUAL(i8080_read_byte(cpu, 8), 0);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 7);
+  ASSERT_EQUAL_FMT(cpu->cyc, 7llu, %llu);
 }
 
 TEST_CASE(mov_m_l) {
@@ -548,7 +548,7 @@ TEST_CASE(mov_m_l) {
 
   ASSERT_EQUAL(i8080_read_byte(cpu, 8), 8);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 7);
+  ASSERT_EQUAL_FMT(cpu->cyc, 7llu, %llu);
 }
 
 TEST_CASE(mov_m_a) {
@@ -558,7 +558,7 @@ TEST_CASE(mov_m_a) {
 
   ASSERT_EQUAL(i8080_read_byte(cpu, 8), 1);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 7);
+  ASSERT_EQUAL_FMT(cpu->cyc, 7llu, %llu);
 }
 
 TEST_CASE(mov_a_b) {
@@ -568,7 +568,7 @@ TEST_CASE(mov_a_b) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->A, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_a_c) {
@@ -578,7 +578,7 @@ TEST_CASE(mov_a_c) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->A, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_a_d) {
@@ -588,7 +588,7 @@ TEST_CASE(mov_a_d) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->A, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_a_e) {
@@ -598,7 +598,7 @@ TEST_CASE(mov_a_e) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->A, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_a_h) {
@@ -608,7 +608,7 @@ TEST_CASE(mov_a_h) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->A, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_a_l) {
@@ -618,7 +618,7 @@ TEST_CASE(mov_a_l) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->A, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(mov_a_m) {
@@ -629,7 +629,7 @@ TEST_CASE(mov_a_m) {
 
   ASSERT_EQUAL(cpu->PC, 1);
   ASSERT_EQUAL(cpu->A, 1);
-  ASSERT_EQUAL(cpu->cyc, 7);
+  ASSERT_EQUAL_FMT(cpu->cyc, 7llu, %llu);
 }
 
 TEST_CASE(mov_a_a) {
@@ -637,7 +637,7 @@ TEST_CASE(mov_a_a) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(stax_b) {
@@ -648,7 +648,7 @@ TEST_CASE(stax_b) {
 
   ASSERT_EQUAL(i8080_read_byte(cpu, 5), 0x01);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 7);
+  ASSERT_EQUAL_FMT(cpu->cyc, 7llu, %llu);
 }
 
 
@@ -660,7 +660,7 @@ TEST_CASE(stax_d) {
 
   ASSERT_EQUAL(i8080_read_byte(cpu, 5), 0x01);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 7);
+  ASSERT_EQUAL_FMT(cpu->cyc, 7llu, %llu);
 }
 
 TEST_CASE(ldax_b) {
@@ -672,7 +672,7 @@ TEST_CASE(ldax_b) {
 
   ASSERT_EQUAL(cpu->A, 0x01);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 7);
+  ASSERT_EQUAL_FMT(cpu->cyc, 7llu, %llu);
 }
 
 
@@ -685,5 +685,5 @@ TEST_CASE(ldax_d) {
 
   ASSERT_EQUAL(cpu->A, 0x01);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 7);
+  ASSERT_EQUAL_FMT(cpu->cyc, 7llu, %llu);
 }
\ No newline at end of file
@@ -22,7 +22,7 @@ TEST_CASE(dcr_b) {
   i8080_step(cpu);
   ASSERT_EQUAL(cpu->B, 0);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 
@@ -33,7 +33,7 @@ TEST_CASE(dcr_c) {
   i8080_step(cpu);
   ASSERT_EQUAL(cpu->C, 0);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(dcr_d) {
@@ -43,7 +43,7 @@ TEST_CASE(dcr_d) {
   i8080_step(cpu);
   ASSERT_EQUAL(cpu->D, 0);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 
@@ -54,7 +54,7 @@ TEST_CASE(dcr_e) {
   i8080_step(cpu);
   ASSERT_EQUAL(cpu->E, 0);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(dcr_h) {
@@ -64,7 +64,7 @@ TEST_CASE(dcr_h) {
   i8080_step(cpu);
   ASSERT_EQUAL(cpu->H, 0);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 
@@ -75,7 +75,7 @@ TEST_CASE(dcr_l) {
   i8080_step(cpu);
   ASSERT_EQUAL(cpu->L, 0);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(dcr_m) {
@@ -87,7 +87,7 @@ TEST_CASE(dcr_m) {
 
   ASSERT_EQUAL(i8080_read_byte(cpu, 0x08), 0);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 10);
+  ASSERT_EQUAL_FMT(cpu->cyc, 10llu, %llu);
 }
 
 
@@ -98,7 +98,7 @@ TEST_CASE(dcr_a) {
   i8080_step(cpu);
   ASSERT_EQUAL(cpu->A, 0);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 // Edge case tests
@@ -24,7 +24,7 @@ TEST_CASE(lda) {
 
   ASSERT_EQUAL(cpu->A, 0x01);
   ASSERT_EQUAL(cpu->PC, 3);
-  ASSERT_EQUAL(cpu->cyc, 13);
+  ASSERT_EQUAL_FMT(cpu->cyc, 13llu, %llu);
 }
 
 TEST_CASE(sta) {
@@ -36,7 +36,7 @@ TEST_CASE(sta) {
 
   ASSERT_EQUAL(i8080_read_byte(cpu, 5), 0x01);
   ASSERT_EQUAL(cpu->PC, 3);
-  ASSERT_EQUAL(cpu->cyc, 13);
+  ASSERT_EQUAL_FMT(cpu->cyc, 13llu, %llu);
 }
 
 TEST_CASE(shld) {
@@ -49,7 +49,7 @@ TEST_CASE(shld) {
   ASSERT_EQUAL(i8080_read_byte(cpu, 0x05), 0x01);
   ASSERT_EQUAL(i8080_read_byte(cpu, 0x06), 0x02);
   ASSERT_EQUAL(cpu->PC, 3);
-  ASSERT_EQUAL(cpu->cyc, 16);
+  ASSERT_EQUAL_FMT(cpu->cyc, 16llu, %llu);
 }
 
 TEST_CASE(lhld) {
@@ -63,5 +63,5 @@ TEST_CASE(lhld) {
   ASSERT_EQUAL(cpu->L, 0xCD);
   ASSERT_EQUAL(cpu->H, 0xAB);
   ASSERT_EQUAL(cpu->PC, 3);
-  ASSERT_EQUAL(cpu->cyc, 16);
+  ASSERT_EQUAL_FMT(cpu->cyc, 16llu, %llu);
 }
\ No newline at end of file
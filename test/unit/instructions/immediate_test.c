@@ -23,7 +23,7 @@ TEST_CASE(mvi_b_d8) {
 
   ASSERT_EQUAL(cpu->B, 1);
   ASSERT_EQUAL(cpu->PC, 2);
-  ASSERT_EQUAL(cpu->cyc, 7);
+  ASSERT_EQUAL_FMT(cpu->cyc, 7llu, %llu);
 }
 
 TEST_CASE(mvi_c_d8) {
@@ -35,7 +35,7 @@ TEST_CASE(mvi_c_d8) {
 
   ASSERT_EQUAL(cpu->C, 1);
   ASSERT_EQUAL(cpu->PC, 2);
-  ASSERT_EQUAL(cpu->cyc, 7);
+  ASSERT_EQUAL_FMT(cpu->cyc, 7llu, %llu);
 }
 
 TEST_CASE(mvi_d_d8) {
@@ -47,7 +47,7 @@ TEST_CASE(mvi_d_d8) {
 
   ASSERT_EQUAL(cpu->D, 1);
   ASSERT_EQUAL(cpu->PC, 2);
-  ASSERT_EQUAL(cpu->cyc, 7);
+  ASSERT_EQUAL_FMT(cpu->cyc, 7llu, %llu);
 }
 
 TEST_CASE(mvi_e_d8) {
@@ -59,7 +59,7 @@ TEST_CASE(mvi_e_d8) {
 
   ASSERT_EQUAL(cpu->E, 1);
   ASSERT_EQUAL(cpu->PC, 2);
-  ASSERT_EQUAL(cpu->cyc, 7);
+  ASSERT_EQUAL_FMT(cpu->cyc, 7llu, %llu);
 }
 
 TEST_CASE(mvi_h_d8) {
@@ -71,7 +71,7 @@ TEST_CASE(mvi_h_d8) {
 
   ASSERT_EQUAL(cpu->H, 1);
   ASSERT_EQUAL(cpu->PC, 2);
-  ASSERT_EQUAL(cpu->cyc, 7);
+  ASSERT_EQUAL_FMT(cpu->cyc, 7llu, %llu);
 }
 
 TEST_CASE(mvi_l_d8) {
@@ -83,7 +83,7 @@ TEST_CASE(mvi_l_d8) {
 
   ASSERT_EQUAL(cpu->L, 1);
   ASSERT_EQUAL(cpu->PC, 2);
-  ASSERT_EQUAL(cpu->cyc, 7);
+  ASSERT_EQUAL_FMT(cpu->cyc, 7llu, %llu);
 }
 
 TEST_CASE(mvi_m_d8) {
@@ -95,7 +95,7 @@ TEST_CASE(mvi_m_d8) {
 
   ASSERT_EQUAL(i8080_read_byte(cpu, 8), 1);
   ASSERT_EQUAL(cpu->PC, 2);
-  ASSERT_EQUAL(cpu->cyc, 10);
+  ASSERT_EQUAL_FMT(cpu->cyc, 10llu, %llu);
 }
 
 TEST_CASE(mvi_a_d8) {
@@ -107,7 +107,7 @@ TEST_CASE(mvi_a_d8) {
 
   ASSERT_EQUAL(cpu->A, 1);
   ASSERT_EQUAL(cpu->PC, 2);
-  ASSERT_EQUAL(cpu->cyc, 7);
+  ASSERT_EQUAL_FMT(cpu->cyc, 7llu, %llu);
 }
 
 TEST_CASE(lxi_b_d16) {
@@ -120,7 +120,7 @@ TEST_CASE(lxi_b_d16) {
   ASSERT_EQUAL(cpu->B, 0xAB);
   ASSERT_EQUAL(cpu->C, 0xCD);
   ASSERT_EQUAL(cpu->PC, 3);
-  ASSERT_EQUAL(cpu->cyc, 10);
+  ASSERT_EQUAL_FMT(cpu->cyc, 10llu, %llu);
 }
 
 TEST_CASE(lxi_d_d16) {
@@ -133,7 +133,7 @@ TEST_CASE(lxi_d_d16) {
   ASSERT_EQUAL(cpu->D, 0xAB);
   ASSERT_EQUAL(cpu->E, 0xCD);
   ASSERT_EQUAL(cpu->PC, 3);
-  ASSERT_EQUAL(cpu->cyc, 10);
+  ASSERT_EQUAL_FMT(cpu->cyc, 10llu, %llu);
 }
 
 TEST_CASE(lxi_h_d16) {
@@ -146,7 +146,7 @@ TEST_CASE(lxi_h_d16) {
   ASSERT_EQUAL(cpu->H, 0xAB);
   ASSERT_EQUAL(cpu->L, 0xCD);
   ASSERT_EQUAL(cpu->PC, 3);
-  ASSERT_EQUAL(cpu->cyc, 10);
+  ASSERT_EQUAL_FMT(cpu->cyc, 10llu, %llu);
 }
 
 TEST_CASE(lxi_sp_d16) {
@@ -158,7 +158,7 @@ TEST_CASE(lxi_sp_d16) {
 
   ASSERT_EQUAL(cpu->SP, 0xABCD);
   ASSERT_EQUAL(cpu->PC, 3);
-  ASSERT_EQUAL(cpu->cyc, 10);
+  ASSERT_EQUAL_FMT(cpu->cyc, 10llu, %llu);
 }
 
 TEST_CASE(adi) {
@@ -170,7 +170,7 @@ TEST_CASE(adi) {
 
   ASSERT_EQUAL(cpu->A, 1);
   ASSERT_EQUAL(cpu->PC, 2);
-  ASSERT_EQUAL(cpu->cyc, 7);
+  ASSERT_EQUAL_FMT(cpu->cyc, 7llu, %llu);
 }
 
 TEST_CASE(adi_sets_c_flag) {
@@ -233,7 +233,7 @@ TEST_CASE(aci) {
   ASSERT_EQUAL(cpu->A, 0xFF);
   ASSERT_TRUE(i8080_get_flag(cpu, FLAG_C));
   ASSERT_EQUAL(cpu->PC, 2);
-  ASSERT_EQUAL(cpu->cyc, 7);
+  ASSERT_EQUAL_FMT(cpu->cyc, 7llu, %llu);
 }
 
 TEST_CASE(aci_unsets_c_flag) {
@@ -300,7 +300,7 @@ TEST_CASE(sui) {
 
   ASSERT_EQUAL(cpu->A, 0);
   ASSERT_EQUAL(cpu->PC, 2);
-  ASSERT_EQUAL(cpu->cyc, 7);
+  ASSERT_EQUAL_FMT(cpu->cyc, 7llu, %llu);
 }
 
 TEST_CASE(sui_sets_c_flag) {
@@ -374,7 +374,7 @@ TEST_CASE(sbi) {
 
   ASSERT_EQUAL(cpu->A, 0xE0);
   ASSERT_FALSE(i8080_get_flag(cpu, FLAG_C));
-  ASSERT_EQUAL(cpu->cyc, 7);
+  ASSERT_EQUAL_FMT(cpu->cyc, 7llu, %llu);
 }
 
 TEST_CASE(sbi_sets_z_flag) {
@@ -441,7 +441,7 @@ TEST_CASE(ani) {
 
   ASSERT_EQUAL(cpu->A, 2);
   ASSERT_EQUAL(cpu->PC, 2);
-  ASSERT_EQUAL(cpu->cyc, 7);
+  ASSERT_EQUAL_FMT(cpu->cyc, 7llu, %llu);
 }
 
 TEST_CASE(ani_resets_c_flag) {
@@ -516,7 +516,7 @@ TEST_CASE(ori) {
 
   ASSERT_EQUAL(cpu->A, 14);
   ASSERT_EQUAL(cpu->PC, 2);
-  ASSERT_EQUAL(cpu->cyc, 7);
+  ASSERT_EQUAL_FMT(cpu->cyc, 7llu, %llu);
 }
 
 TEST_CASE(ori_resets_c_flag) {
@@ -570,7 +570,7 @@ TEST_CASE(xri) {
 
   ASSERT_EQUAL(cpu->A, 0x0F);
   ASSERT_EQUAL(cpu->PC, 2);
-  ASSERT_EQUAL(cpu->cyc, 7);
+  ASSERT_EQUAL_FMT(cpu->cyc, 7llu, %llu);
 }
 
 TEST_CASE(xri_resets_flag_c) {
@@ -624,7 +624,7 @@ TEST_CASE(cpi) {
 
   ASSERT_TRUE(i8080_get_flag(cpu, FLAG_Z));
   ASSERT_EQUAL(cpu->PC, 2);
-  ASSERT_EQUAL(cpu->cyc, 7);
+  ASSERT_EQUAL_FMT(cpu->cyc, 7llu, %llu);
 }
 
 TEST_CASE(cpi_less) {
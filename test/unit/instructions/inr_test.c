@@ -22,7 +22,7 @@ TEST_CASE(inr_b) {
   i8080_step(cpu);
   ASSERT_EQUAL(cpu->B, 1);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 
@@ -33,7 +33,7 @@ TEST_CASE(inr_c) {
   i8080_step(cpu);
   ASSERT_EQUAL(cpu->C, 1);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(inr_d) {
@@ -43,7 +43,7 @@ TEST_CASE(inr_d) {
   i8080_step(cpu);
   ASSERT_EQUAL(cpu->D, 1);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 
@@ -54,7 +54,7 @@ TEST_CASE(inr_e) {
   i8080_step(cpu);
   ASSERT_EQUAL(cpu->E, 1);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(inr_h) {
@@ -64,7 +64,7 @@ TEST_CASE(inr_h) {
   i8080_step(cpu);
   ASSERT_EQUAL(cpu->H, 1);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 
@@ -75,7 +75,7 @@ TEST_CASE(inr_l) {
   i8080_step(cpu);
   ASSERT_EQUAL(cpu->L, 1);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(inr_m) {
@@ -86,7 +86,7 @@ TEST_CASE(inr_m) {
   i8080_step(cpu);
   ASSERT_EQUAL(i8080_read_byte(cpu, 0x08), 1);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 10);
+  ASSERT_EQUAL_FMT(cpu->cyc, 10llu, %llu);
 }
 
 
@@ -97,7 +97,7 @@ TEST_CASE(inr_a) {
   i8080_step(cpu);
   ASSERT_EQUAL(cpu->A, 1);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 // i8080_flag bit tests
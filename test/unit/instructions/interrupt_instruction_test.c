@@ -20,7 +20,7 @@ TEST_CASE(ei) {
   i8080_step(cpu);
 
   ASSERT_TRUE(cpu->INTE);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(di) {
@@ -30,7 +30,7 @@ TEST_CASE(di) {
   i8080_step(cpu);
 
   ASSERT_FALSE(cpu->INTE);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(rst_0) {
@@ -41,7 +41,7 @@ TEST_CASE(rst_0) {
 
   ASSERT_EQUAL(i8080_pop_stackb(cpu), 61);
   ASSERT_EQUAL(cpu->PC, 0);
-  ASSERT_EQUAL(cpu->cyc, 11);
+  ASSERT_EQUAL_FMT(cpu->cyc, 11llu, %llu);
 }
 
 TEST_CASE(rst_1) {
@@ -52,7 +52,7 @@ TEST_CASE(rst_1) {
 
   ASSERT_EQUAL(i8080_pop_stackb(cpu), 61);
   ASSERT_EQUAL(cpu->PC, 8);
-  ASSERT_EQUAL(cpu->cyc, 11);
+  ASSERT_EQUAL_FMT(cpu->cyc, 11llu, %llu);
 }
 
 TEST_CASE(rst_2) {
@@ -63,7 +63,7 @@ TEST_CASE(rst_2) {
 
   ASSERT_EQUAL(i8080_pop_stackb(cpu), 61);
   ASSERT_EQUAL(cpu->PC, 16);
-  ASSERT_EQUAL(cpu->cyc, 11);
+  ASSERT_EQUAL_FMT(cpu->cyc, 11llu, %llu);
 }
 
 TEST_CASE(rst_3) {
@@ -74,7 +74,7 @@ TEST_CASE(rst_3) {
 
   ASSERT_EQUAL(i8080_pop_stackb(cpu), 61);
   ASSERT_EQUAL(cpu->PC, 24);
-  ASSERT_EQUAL(cpu->cyc, 11);
+  ASSERT_EQUAL_FMT(cpu->cyc, 11llu, %llu);
 }
 
 TEST_CASE(rst_4) {
@@ -85,7 +85,7 @@ TEST_CASE(rst_4) {
 
   ASSERT_EQUAL(i8080_pop_stackb(cpu), 61);
   ASSERT_EQUAL(cpu->PC, 32);
-  ASSERT_EQUAL(cpu->cyc, 11);
+  ASSERT_EQUAL_FMT(cpu->cyc, 11llu, %llu);
 }
 
 TEST_CASE(rst_5) {
@@ -96,7 +96,7 @@ TEST_CASE(rst_5) {
 
   ASSERT_EQUAL(i8080_pop_stackb(cpu), 61);
   ASSERT_EQUAL(cpu->PC, 40);
-  ASSERT_EQUAL(cpu->cyc, 11);
+  ASSERT_EQUAL_FMT(cpu->cyc, 11llu, %llu);
 }
 
 TEST_CASE(rst_6) {
@@ -107,7 +107,7 @@ TEST_CASE(rst_6) {
 
   ASSERT_EQUAL(i8080_pop_stackb(cpu), 61);
   ASSERT_EQUAL(cpu->PC, 48);
-  ASSERT_EQUAL(cpu->cyc, 11);
+  ASSERT_EQUAL_FMT(cpu->cyc, 11llu, %llu);
 }
 
 TEST_CASE(rst_7) {
@@ -118,7 +118,7 @@ TEST_CASE(rst_7) {
 
   ASSERT_EQUAL(i8080_pop_stackb(cpu), 61);
   ASSERT_EQUAL(cpu->PC, 56);
-  ASSERT_EQUAL(cpu->cyc, 11);
+  ASSERT_EQUAL_FMT(cpu->cyc, 11llu, %llu);
 }
 
 TEST_CASE(hlt) {
@@ -146,5 +146,5 @@ TEST_CASE(hlt_cycles) {
   i8080_write_byte(cpu, 0, 0x76); // HLT
   i8080_step(cpu);
 
-  ASSERT_EQUAL(cpu->cyc, 7);
+  ASSERT_EQUAL_FMT(cpu->cyc, 7llu, %llu);
 }
\ No newline at end of file
@@ -19,7 +19,7 @@ TEST_CASE(in_no_handler) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 2);
-  ASSERT_EQUAL(cpu->cyc, 10);
+  ASSERT_EQUAL_FMT(cpu->cyc, 10llu, %llu);
 }
 
 TEST_CASE(out_no_handler) {
@@ -29,5 +29,5 @@ TEST_CASE(out_no_handler) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 2);
-  ASSERT_EQUAL(cpu->cyc, 10);
+  ASSERT_EQUAL_FMT(cpu->cyc, 10llu, %llu);
 }
\ No newline at end of file
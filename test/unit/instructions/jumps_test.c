@@ -21,7 +21,7 @@ TEST_CASE(jmp) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 0xABCD);
-  ASSERT_EQUAL(cpu->cyc, 10);
+  ASSERT_EQUAL_FMT(cpu->cyc, 10llu, %llu);
 }
 
 TEST_CASE(jmp_alternate_0xcb) {
@@ -31,7 +31,7 @@ TEST_CASE(jmp_alternate_0xcb) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 0xABCD);
-  ASSERT_EQUAL(cpu->cyc, 10);
+  ASSERT_EQUAL_FMT(cpu->cyc, 10llu, %llu);
 }
 
 
@@ -43,7 +43,7 @@ TEST_CASE(jnz_z_flag_set) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 3);
-  ASSERT_EQUAL(cpu->cyc, 10);
+  ASSERT_EQUAL_FMT(cpu->cyc, 10llu, %llu);
 }
 
 TEST_CASE(jnz_z_flag_unset) {
@@ -53,7 +53,7 @@ TEST_CASE(jnz_z_flag_unset) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 0xABCD);
-  ASSERT_EQUAL(cpu->cyc, 10);
+  ASSERT_EQUAL_FMT(cpu->cyc, 10llu, %llu);
 }
 
 TEST_CASE(jz_z_flag_set) {
@@ -64,7 +64,7 @@ TEST_CASE(jz_z_flag_set) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 0xABCD);
-  ASSERT_EQUAL(cpu->cyc, 10);
+  ASSERT_EQUAL_FMT(cpu->cyc, 10llu, %llu);
 }
 
 
@@ -75,7 +75,7 @@ TEST_CASE(jz_z_flag_unset) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 3);
-  ASSERT_EQUAL(cpu->cyc, 10);
+  ASSERT_EQUAL_FMT(cpu->cyc, 10llu, %llu);
 }
 
 TEST_CASE(jnc_c_flag_set) {
@@ -86,7 +86,7 @@ TEST_CASE(jnc_c_flag_set) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 3);
-  ASSERT_EQUAL(cpu->cyc, 10);
+  ASSERT_EQUAL_FMT(cpu->cyc, 10llu, %llu);
 }
 
 TEST_CASE(jnc_c_flag_unset) {
@@ -96,7 +96,7 @@ TEST_CASE(jnc_c_flag_unset) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 0xABCD);
-  ASSERT_EQUAL(cpu->cyc, 10);
+  ASSERT_EQUAL_FMT(cpu->cyc, 10llu, %llu);
 }
 
 TEST_CASE(jc_c_flag_set) {
@@ -107,7 +107,7 @@ TEST_CASE(jc_c_flag_set) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 0xABCD);
-  ASSERT_EQUAL(cpu->cyc, 10);
+  ASSERT_EQUAL_FMT(cpu->cyc, 10llu, %llu);
 }
 
 
@@ -118,7 +118,7 @@ TEST_CASE(jc_c_flag_unset) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 3);
-  ASSERT_EQUAL(cpu->cyc, 10);
+  ASSERT_EQUAL_FMT(cpu->cyc, 10llu, %llu);
 }
 
 TEST_CASE(jpo_p_flag_set) {
@@ -129,7 +129,7 @@ TEST_CASE(jpo_p_flag_set) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 3);
-  ASSERT_EQUAL(cpu->cyc, 10);
+  ASSERT_EQUAL_FMT(cpu->cyc, 10llu, %llu);
 }
 
 TEST_CASE(jpo_p_flag_unset) {
@@ -139,7 +139,7 @@ TEST_CASE(jpo_p_flag_unset) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 0xABCD);
-  ASSERT_EQUAL(cpu->cyc, 10);
+  ASSERT_EQUAL_FMT(cpu->cyc, 10llu, %llu);
 }
 
 TEST_CASE(jpe_p_flag_set) {
@@ -150,7 +150,7 @@ TEST_CASE(jpe_p_flag_set) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 0xABCD);
-  ASSERT_EQUAL(cpu->cyc, 10);
+  ASSERT_EQUAL_FMT(cpu->cyc, 10llu, %llu);
 }
 
 TEST_CASE(jpe_p_flag_unset) {
@@ -160,7 +160,7 @@ TEST_CASE(jpe_p_flag_unset) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 3);
-  ASSERT_EQUAL(cpu->cyc, 10);
+  ASSERT_EQUAL_FMT(cpu->cyc, 10llu, %llu);
 }
 
 TEST_CASE(jp_s_flag_set) {
@@ -171,7 +171,7 @@ TEST_CASE(jp_s_flag_set) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 3);
-  ASSERT_EQUAL(cpu->cyc, 10);
+  ASSERT_EQUAL_FMT(cpu->cyc, 10llu, %llu);
 }
 
 TEST_CASE(jp_s_flag_unset) {
@@ -181,7 +181,7 @@ TEST_CASE(jp_s_flag_unset) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 0xABCD);
-  ASSERT_EQUAL(cpu->cyc, 10);
+  ASSERT_EQUAL_FMT(cpu->cyc, 10llu, %llu);
 }
 
 TEST_CASE(jm_s_flag_set) {
@@ -192,7 +192,7 @@ TEST_CASE(jm_s_flag_set) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 0xABCD);
-  ASSERT_EQUAL(cpu->cyc, 10);
+  ASSERT_EQUAL_FMT(cpu->cyc, 10llu, %llu);
 }
 
 TEST_CASE(jm_s_flag_unset) {
@@ -202,7 +202,7 @@ TEST_CASE(jm_s_flag_unset) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 3);
-  ASSERT_EQUAL(cpu->cyc, 10);
+  ASSERT_EQUAL_FMT(cpu->cyc, 10llu, %llu);
 }
 
 TEST_CASE(pchl) {
@@ -212,5 +212,5 @@ TEST_CASE(pchl) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 0xABCD);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
@@ -19,7 +19,7 @@ TEST_CASE(nop_0x00) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(nop_0x08) {
@@ -27,7 +27,7 @@ TEST_CASE(nop_0x08) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(nop_0x10) {
@@ -35,7 +35,7 @@ TEST_CASE(nop_0x10) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(nop_0x18) {
@@ -43,7 +43,7 @@ TEST_CASE(nop_0x18) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(nop_0x20) {
@@ -51,7 +51,7 @@ TEST_CASE(nop_0x20) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(nop_0x28) {
@@ -59,7 +59,7 @@ TEST_CASE(nop_0x28) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(nop_0x30) {
@@ -67,7 +67,7 @@ TEST_CASE(nop_0x30) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(nop_0x38) {
@@ -75,5 +75,5 @@ TEST_CASE(nop_0x38) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
\ No newline at end of file
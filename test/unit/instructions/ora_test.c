@@ -23,7 +23,7 @@ TEST_CASE(ora_b) {
 
   ASSERT_EQUAL(cpu->A, 14);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(ora_c) {
@@ -34,7 +34,7 @@ TEST_CASE(ora_c) {
 
   ASSERT_EQUAL(cpu->A, 14);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(ora_d) {
@@ -45,7 +45,7 @@ TEST_CASE(ora_d) {
 
   ASSERT_EQUAL(cpu->A, 14);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(ora_e) {
@@ -56,7 +56,7 @@ TEST_CASE(ora_e) {
 
   ASSERT_EQUAL(cpu->A, 14);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(ora_h) {
@@ -67,7 +67,7 @@ TEST_CASE(ora_h) {
 
   ASSERT_EQUAL(cpu->A, 14);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(ora_l) {
@@ -78,7 +78,7 @@ TEST_CASE(ora_l) {
 
   ASSERT_EQUAL(cpu->A, 14);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(ora_m) {
@@ -90,7 +90,7 @@ TEST_CASE(ora_m) {
 
   ASSERT_EQUAL(cpu->A, 14);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 7);
+  ASSERT_EQUAL_FMT(cpu->cyc, 7llu, %llu);
 }
 
 TEST_CASE(ora_a) {
@@ -101,7 +101,7 @@ TEST_CASE(ora_a) {
 
   ASSERT_EQUAL(cpu->A, 10);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 // i8080_flag bit tests
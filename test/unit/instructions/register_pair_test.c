@@ -22,7 +22,7 @@ TEST_CASE(push_b) {
 
   ASSERT_EQUAL(i8080_pop_stackw(cpu), 0xABCD);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 11);
+  ASSERT_EQUAL_FMT(cpu->cyc, 11llu, %llu);
 }
 
 TEST_CASE(push_d) {
@@ -33,7 +33,7 @@ TEST_CASE(push_d) {
 
   ASSERT_EQUAL(i8080_pop_stackw(cpu), 0xABCD);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 11);
+  ASSERT_EQUAL_FMT(cpu->cyc, 11llu, %llu);
 }
 
 TEST_CASE(push_h) {
@@ -44,7 +44,7 @@ TEST_CASE(push_h) {
 
   ASSERT_EQUAL(i8080_pop_stackw(cpu), 0xABCD);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 11);
+  ASSERT_EQUAL_FMT(cpu->cyc, 11llu, %llu);
 }
 
 TEST_CASE(push_psw) {
@@ -60,7 +60,7 @@ TEST_CASE(push_psw) {
 
   ASSERT_EQUAL(i8080_pop_stackw(cpu), 0xABD7);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 11);
+  ASSERT_EQUAL_FMT(cpu->cyc, 11llu, %llu);
 }
 
 
@@ -74,7 +74,7 @@ TEST_CASE(pop_b) {
   ASSERT_EQUAL(cpu->B, 0xAB);
   ASSERT_EQUAL(cpu->C, 0xCD);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 10);
+  ASSERT_EQUAL_FMT(cpu->cyc, 10llu, %llu);
 }
 
 TEST_CASE(pop_d) {
@@ -87,7 +87,7 @@ TEST_CASE(pop_d) {
   ASSERT_EQUAL(cpu->D, 0xAB);
   ASSERT_EQUAL(cpu->E, 0xCD);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 10);
+  ASSERT_EQUAL_FMT(cpu->cyc, 10llu, %llu);
 }
 
 TEST_CASE(pop_h) {
@@ -100,7 +100,7 @@ TEST_CASE(pop_h) {
   ASSERT_EQUAL(cpu->H, 0xAB);
   ASSERT_EQUAL(cpu->L, 0xCD);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 10);
+  ASSERT_EQUAL_FMT(cpu->cyc, 10llu, %llu);
 }
 
 TEST_CASE(pop_psw) {
@@ -117,7 +117,7 @@ TEST_CASE(pop_psw) {
   ASSERT_TRUE(i8080_get_flag(cpu, FLAG_Z));
   ASSERT_TRUE(i8080_get_flag(cpu, FLAG_S));
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 10);
+  ASSERT_EQUAL_FMT(cpu->cyc, 10llu, %llu);
 }
 
 TEST_CASE(push_pop_psw) {
@@ -145,7 +145,7 @@ TEST_CASE(dad_b) {
   ASSERT_EQUAL(cpu->H, 0x00);
   ASSERT_EQUAL(cpu->L, 0x02);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 10);
+  ASSERT_EQUAL_FMT(cpu->cyc, 10llu, %llu);
 }
 
 TEST_CASE(dad_d) {
@@ -158,7 +158,7 @@ TEST_CASE(dad_d) {
   ASSERT_EQUAL(cpu->H, 0x00);
   ASSERT_EQUAL(cpu->L, 0x02);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 10);
+  ASSERT_EQUAL_FMT(cpu->cyc, 10llu, %llu);
 }
 
 TEST_CASE(dad_h) {
@@ -170,7 +170,7 @@ TEST_CASE(dad_h) {
   ASSERT_EQUAL(cpu->H, 0xFF);
   ASSERT_EQUAL(cpu->L, 0xFA);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 10);
+  ASSERT_EQUAL_FMT(cpu->cyc, 10llu, %llu);
 }
 
 TEST_CASE(dad_sp) {
@@ -183,7 +183,7 @@ TEST_CASE(dad_sp) {
   ASSERT_EQUAL(cpu->H, 0x00);
   ASSERT_EQUAL(cpu->L, 0x02);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 10);
+  ASSERT_EQUAL_FMT(cpu->cyc, 10llu, %llu);
 }
 
 // Bit flag tests
@@ -220,7 +220,7 @@ TEST_CASE(inx_b) {
   ASSERT_EQUAL(cpu->B, 0x01);
   ASSERT_EQUAL(cpu->C, 0x00);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(inx_d) {
@@ -232,7 +232,7 @@ TEST_CASE(inx_d) {
   ASSERT_EQUAL(cpu->D, 0x01);
   ASSERT_EQUAL(cpu->E, 0x00);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(inx_h) {
@@ -244,7 +244,7 @@ TEST_CASE(inx_h) {
   ASSERT_EQUAL(cpu->H, 0x01);
   ASSERT_EQUAL(cpu->L, 0x00);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(inx_sp) {
@@ -255,7 +255,7 @@ TEST_CASE(inx_sp) {
 
   ASSERT_EQUAL(cpu->SP, 0x01);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 
@@ -268,7 +268,7 @@ TEST_CASE(dcx_b) {
   ASSERT_EQUAL(cpu->B, 0x00);
   ASSERT_EQUAL(cpu->C, 0xFF);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(dcx_d) {
@@ -280,7 +280,7 @@ TEST_CASE(dcx_d) {
   ASSERT_EQUAL(cpu->D, 0x00);
   ASSERT_EQUAL(cpu->E, 0xFF);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(dcx_h) {
@@ -292,7 +292,7 @@ TEST_CASE(dcx_h) {
   ASSERT_EQUAL(cpu->H, 0x00);
   ASSERT_EQUAL(cpu->L, 0xFF);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(dcx_sp) {
@@ -303,7 +303,7 @@ TEST_CASE(dcx_sp) {
 
   ASSERT_EQUAL(cpu->SP, 0);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(xchg) {
@@ -318,7 +318,7 @@ TEST_CASE(xchg) {
   ASSERT_EQUAL(cpu->H, 3);
   ASSERT_EQUAL(cpu->L, 4);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(xthl) {
@@ -336,7 +336,7 @@ TEST_CASE(xthl) {
   ASSERT_EQUAL(i8080_read_byte(cpu, 10), 0x02);
   ASSERT_EQUAL(i8080_read_byte(cpu, 11), 0x01);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 18);
+  ASSERT_EQUAL_FMT(cpu->cyc, 18llu, %llu);
 }
 
 TEST_CASE(sphl) {
@@ -348,5 +348,5 @@ TEST_CASE(sphl) {
 
   ASSERT_EQUAL(cpu->SP, 0xABCD);
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
@@ -21,7 +21,7 @@ TEST_CASE(ret) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 0xABCD);
-  ASSERT_EQUAL(cpu->cyc, 11);
+  ASSERT_EQUAL_FMT(cpu->cyc, 11llu, %llu);
 }
 
 TEST_CASE(ret_alternate_0xd9) {
@@ -30,7 +30,7 @@ TEST_CASE(ret_alternate_0xd9) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 0xABCD);
-  ASSERT_EQUAL(cpu->cyc, 11);
+  ASSERT_EQUAL_FMT(cpu->cyc, 11llu, %llu);
 }
 
 TEST_CASE(rnz_z_flag_set) {
@@ -40,7 +40,7 @@ TEST_CASE(rnz_z_flag_set) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(rnz_z_flag_unset) {
@@ -49,7 +49,7 @@ TEST_CASE(rnz_z_flag_unset) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 0xABCD);
-  ASSERT_EQUAL(cpu->cyc, 11);
+  ASSERT_EQUAL_FMT(cpu->cyc, 11llu, %llu);
 }
 
 TEST_CASE(rz_z_flag_set) {
@@ -59,7 +59,7 @@ TEST_CASE(rz_z_flag_set) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 0xABCD);
-  ASSERT_EQUAL(cpu->cyc, 11);
+  ASSERT_EQUAL_FMT(cpu->cyc, 11llu, %llu);
 }
 
 TEST_CASE(rz_z_flag_unset) {
@@ -68,7 +68,7 @@ TEST_CASE(rz_z_flag_unset) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(rnc_c_flag_set) {
@@ -78,7 +78,7 @@ TEST_CASE(rnc_c_flag_set) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(rnc_c_flag_unset) {
@@ -87,7 +87,7 @@ TEST_CASE(rnc_c_flag_unset) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 0xABCD);
-  ASSERT_EQUAL(cpu->cyc, 11);
+  ASSERT_EQUAL_FMT(cpu->cyc, 11llu, %llu);
 }
 
 TEST_CASE(rc_c_flag_set) {
@@ -97,7 +97,7 @@ TEST_CASE(rc_c_flag_set) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 0xABCD);
-  ASSERT_EQUAL(cpu->cyc, 11);
+  ASSERT_EQUAL_FMT(cpu->cyc, 11llu, %llu);
 }
 
 TEST_CASE(rc_c_flag_unset) {
@@ -106,7 +106,7 @@ TEST_CASE(rc_c_flag_unset) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(rpo_p_flag_set) {
@@ -116,7 +116,7 @@ TEST_CASE(rpo_p_flag_set) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(rpo_p_flag_unset) {
@@ -125,7 +125,7 @@ TEST_CASE(rpo_p_flag_unset) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 0xABCD);
-  ASSERT_EQUAL(cpu->cyc, 11);
+  ASSERT_EQUAL_FMT(cpu->cyc, 11llu, %llu);
 }
 
 TEST_CASE(rpe_p_flag_set) {
@@ -135,7 +135,7 @@ TEST_CASE(rpe_p_flag_set) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 0xABCD);
-  ASSERT_EQUAL(cpu->cyc, 11);
+  ASSERT_EQUAL_FMT(cpu->cyc, 11llu, %llu);
 }
 
 
@@ -145,7 +145,7 @@ TEST_CASE(rpe_p_flag_unset) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(rp_s_flag_set) {
@@ -155,7 +155,7 @@ TEST_CASE(rp_s_flag_set) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
 
 TEST_CASE(rp_s_flag_unset) {
@@ -164,7 +164,7 @@ TEST_CASE(rp_s_flag_unset) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 0xABCD);
-  ASSERT_EQUAL(cpu->cyc, 11);
+  ASSERT_EQUAL_FMT(cpu->cyc, 11llu, %llu);
 }
 
 TEST_CASE(rm_s_flag_set) {
@@ -174,7 +174,7 @@ TEST_CASE(rm_s_flag_set) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 0xABCD);
-  ASSERT_EQUAL(cpu->cyc, 11);
+  ASSERT_EQUAL_FMT(cpu->cyc, 11llu, %llu);
 }
 
 TEST_CASE(rm_s_flag_unset) {
@@ -183,5 +183,5 @@ TEST_CASE(rm_s_flag_unset) {
   i8080_step(cpu);
 
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 5);
+  ASSERT_EQUAL_FMT(cpu->cyc, 5llu, %llu);
 }
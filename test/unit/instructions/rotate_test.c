@@ -24,7 +24,7 @@ TEST_CASE(rrc_low_bit_one) {
   ASSERT_EQUAL(cpu->A, 0xFF);
   ASSERT_TRUE(i8080_get_flag(cpu, FLAG_C));
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(rrc_low_bit_zero) {
@@ -37,7 +37,7 @@ TEST_CASE(rrc_low_bit_zero) {
   ASSERT_EQUAL(cpu->A, 0x7F);
   ASSERT_FALSE(i8080_get_flag(cpu, FLAG_P));
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 
@@ -51,7 +51,7 @@ TEST_CASE(rar_low_bit_one_carry_zero) {
   ASSERT_EQUAL(cpu->A, 0x7F);
   ASSERT_TRUE(i8080_get_flag(cpu, FLAG_C));
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(rar_low_bit_zero_carry_zero) {
@@ -64,7 +64,7 @@ TEST_CASE(rar_low_bit_zero_carry_zero) {
   ASSERT_EQUAL(cpu->A, 0x7F);
   ASSERT_FALSE(i8080_get_flag(cpu, FLAG_P));
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(rar_low_bit_one_carry_one) {
@@ -77,7 +77,7 @@ TEST_CASE(rar_low_bit_one_carry_one) {
   ASSERT_EQUAL(cpu->A, 0xFF);
   ASSERT_TRUE(i8080_get_flag(cpu, FLAG_C));
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 
@@ -91,7 +91,7 @@ TEST_CASE(rlc_high_bit_one) {
   ASSERT_EQUAL(cpu->A, 0xFF);
   ASSERT_TRUE(i8080_get_flag(cpu, FLAG_C));
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(rlc_high_bit_zero) {
@@ -104,7 +104,7 @@ TEST_CASE(rlc_high_bit_zero) {
   ASSERT_EQUAL(cpu->A, 0xFE);
   ASSERT_FALSE(i8080_get_flag(cpu, FLAG_C));
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 
@@ -118,7 +118,7 @@ TEST_CASE(ral_high_bit_one_carry_zero) {
   ASSERT_EQUAL(cpu->A, 0xFE);
   ASSERT_TRUE(i8080_get_flag(cpu, FLAG_C));
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(ral_high_bit_zero_carry_zero) {
@@ -131,7 +131,7 @@ TEST_CASE(ral_high_bit_zero_carry_zero) {
   ASSERT_EQUAL(cpu->A, 0xFE);
   ASSERT_FALSE(i8080_get_flag(cpu, FLAG_P));
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(ral_high_bit_one_carry_one) {
@@ -144,5 +144,5 @@ TEST_CASE(ral_high_bit_one_carry_one) {
   ASSERT_EQUAL(cpu->A, 0xFF);
   ASSERT_TRUE(i8080_get_flag(cpu, FLAG_C));
   ASSERT_EQUAL(cpu->PC, 1);
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
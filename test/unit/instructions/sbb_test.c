@@ -24,7 +24,7 @@ TEST_CASE(sbb_b) {
 
   ASSERT_EQUAL(cpu->A, 0xE0);
   ASSERT_FALSE(i8080_get_flag(cpu, FLAG_C));
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(sbb_c) {
@@ -36,7 +36,7 @@ TEST_CASE(sbb_c) {
 
   ASSERT_EQUAL(cpu->A, 0xE0);
   ASSERT_FALSE(i8080_get_flag(cpu, FLAG_C));
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(sbb_d) {
@@ -48,7 +48,7 @@ TEST_CASE(sbb_d) {
 
   ASSERT_EQUAL(cpu->A, 0xE0);
   ASSERT_FALSE(i8080_get_flag(cpu, FLAG_C));
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(sbb_e) {
@@ -60,7 +60,7 @@ TEST_CASE(sbb_e) {
 
   ASSERT_EQUAL(cpu->A, 0xE0);
   ASSERT_FALSE(i8080_get_flag(cpu, FLAG_C));
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(sbb_h) {
@@ -72,7 +72,7 @@ TEST_CASE(sbb_h) {
 
   ASSERT_EQUAL(cpu->A, 0xE0);
   ASSERT_FALSE(i8080_get_flag(cpu, FLAG_C));
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(sbb_l) {
@@ -84,7 +84,7 @@ TEST_CASE(sbb_l) {
 
   ASSERT_EQUAL(cpu->A, 0xE0);
   ASSERT_FALSE(i8080_get_flag(cpu, FLAG_C));
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 TEST_CASE(sbb_m) {
@@ -97,7 +97,7 @@ TEST_CASE(sbb_m) {
 
   ASSERT_EQUAL(cpu->A, 0xE0);
   ASSERT_FALSE(i8080_get_flag(cpu, FLAG_C));
-  ASSERT_EQUAL(cpu->cyc, 7);
+  ASSERT_EQUAL_FMT(cpu->cyc, 7llu, %llu);
 }
 
 TEST_CASE(sbb_a) {
@@ -109,7 +109,7 @@ TEST_CASE(sbb_a) {
 
   ASSERT_EQUAL(cpu->A, 0xFF);
   ASSERT_TRUE(i8080_get_flag(cpu, FLAG_C));
-  ASSERT_EQUAL(cpu->cyc, 4);
+  ASSERT_EQUAL_FMT(cpu->cyc, 4llu, %llu);
 }
 
 // Bit flag tests
@@ -0,0 +1,78 @@
+#include <stdlib.h>
+#include "attounit.h"
+#include "i8080.h"
+#include "i8080_batch.h"
+#include "cpu_test_helpers.h"
+
+TEST_SUITE(batch)
+
+#define NUM_MACHINES 16
+
+struct i8080 *machines[NUM_MACHINES];
+int completed[NUM_MACHINES];
+
+BEFORE_EACH() {
+  for (int i=0;i<NUM_MACHINES;i++) {
+    struct i8080 *cpu = setup_cpu_test_env();
+
+    // Count B down from a different value on every machine, then halt
+    i8080_write_byte(cpu, 0, 0x06); // MVI B, d8
+    i8080_write_byte(cpu, 1, (i + 1) * 10);
+    i8080_write_byte(cpu, 2, 0x3C); // INR A
+    i8080_write_byte(cpu, 3, 0x05); // DCR B
+    i8080_write_byte(cpu, 4, 0xC2); // JNZ 0x0002
+    i8080_write_word(cpu, 5, 0x0002);
+    i8080_write_byte(cpu, 7, 0x76); // HLT
+
+    machines[i] = cpu;
+    completed[i] = 0;
+  }
+}
+AFTER_EACH() {
+  for (int i=0;i<NUM_MACHINES;i++) {
+    teardown_cpu_test_env(machines[i]);
+  }
+}
+
+void on_done(struct i8080 *cpu, void *ctx) {
+  int *completed = ctx;
+
+  for (int i=0;i<NUM_MACHINES;i++) {
+    if (machines[i] == cpu) {
+      completed[i]++;
+    }
+  }
+}
+
+TEST_CASE(batch_runs_every_machine_to_completion) {
+  ASSERT_EQUAL(i8080_batch_run(machines, NUM_MACHINES, 1, 50, on_done, completed), 0);
+
+  for (int i=0;i<NUM_MACHINES;i++) {
+    ASSERT_EQUAL(completed[i], 1);
+    ASSERT_TRUE(machines[i]->halted);
+    ASSERT_EQUAL(machines[i]->A, (i + 1) * 10);
+    ASSERT_EQUAL(machines[i]->PC, 8);
+  }
+}
+
+TEST_CASE(batch_runs_across_threads) {
+  ASSERT_EQUAL(i8080_batch_run(machines, NUM_MACHINES, 4, 50, on_done, completed), 0);
+
+  for (int i=0;i<NUM_MACHINES;i++) {
+    ASSERT_EQUAL(completed[i], 1);
+    ASSERT_EQUAL(machines[i]->A, (i + 1) * 10);
+    ASSERT_EQUAL_FMT(machines[i]->cyc, 7 + (i + 1) * 10 * 20 + 7llu, %llu);
+  }
+}
+
+TEST_CASE(batch_without_callback) {
+  ASSERT_EQUAL(i8080_batch_run(machines, NUM_MACHINES, 0, 1000, NULL, NULL), 0);
+
+  for (int i=0;i<NUM_MACHINES;i++) {
+    ASSERT_TRUE(machines[i]->halted);
+  }
+}
+
+TEST_CASE(batch_empty) {
+  ASSERT_EQUAL(i8080_batch_run(machines, 0, 4, 1000, on_done, completed), 0);
+}
@@ -0,0 +1,34 @@
+#include "attounit.h"
+#include "i8080.h"
+#include "cpu_test_helpers.h"
+
+TEST_SUITE(block_cache)
+
+static struct i8080 *cached_cpu;
+static struct i8080 *interp_cpu;
+
+BEFORE_EACH() {
+  cached_cpu = setup_cpu_test_env();
+  interp_cpu = setup_cpu_test_env();
+
+  // Only the block cache for one, plain interpreter for the other
+  i8080_jit_disable(cached_cpu);
+  i8080_jit_disable(interp_cpu);
+  i8080_block_cache_enable(cached_cpu, 0);
+}
+AFTER_EACH() {
+  i8080_block_cache_disable(cached_cpu);
+  teardown_cpu_test_env(cached_cpu);
+  teardown_cpu_test_env(interp_cpu);
+}
+
+TEST_CASE(block_cache_enable) {
+  ASSERT_TRUE(cached_cpu->block_cache != NULL);
+
+  i8080_block_cache_disable(cached_cpu);
+  ASSERT_TRUE(cached_cpu->block_cache == NULL);
+}
+
+TEST_CASE(block_cache_matches_interpreter) {
+  check_against_interpreter(cached_cpu, interp_cpu);
+}
@@ -0,0 +1,108 @@
+#include <stdlib.h>
+#include "i8080.h"
+#include "attounit.h"
+#include "cpu_test_helpers.h"
+
+TEST_SUITE(memory_bus)
+
+struct i8080 *cpu;
+struct i8080_page pages[I8080_NUM_PAGES];
+char ram[0x200];
+char rom[0x100];
+
+int device_ctx;
+void *read_handler_ctx;
+uint read_handler_addr;
+void *write_handler_ctx;
+uint write_handler_addr;
+uint write_handler_data;
+
+BEFORE_EACH() {
+  cpu = setup_cpu_test_env();
+  i8080_bus_init(cpu, pages);
+
+  for (int i=0;i<0x200;i++) {
+    ram[i] = 0;
+  }
+  for (int i=0;i<0x100;i++) {
+    rom[i] = (char) i;
+  }
+
+  read_handler_ctx = NULL;
+  read_handler_addr = 0xFFFFFF;
+  write_handler_ctx = NULL;
+  write_handler_addr = 0xFFFFFF;
+  write_handler_data = 0xFFFFFF;
+}
+AFTER_EACH() {
+  teardown_cpu_test_env(cpu);
+}
+
+uint device_read(struct i8080 *cpu, void *ctx, uint addr) {
+  read_handler_ctx = ctx;
+  read_handler_addr = addr;
+  return 0xAB;
+}
+
+void device_write(struct i8080 *cpu, void *ctx, uint addr, uint data) {
+  write_handler_ctx = ctx;
+  write_handler_addr = addr;
+  write_handler_data = data;
+}
+
+TEST_CASE(bus_ram) {
+  i8080_map_ram(cpu, 0x0000, sizeof(ram), ram);
+
+  i8080_write_byte(cpu, 0x1FF, 0xCD);
+  i8080_write_word(cpu, 0x0FF, 0x1234);
+
+  ASSERT_EQUAL(ram[0x1FF] & 0xFF, 0xCD);
+  ASSERT_EQUAL(i8080_read_byte(cpu, 0x1FF), 0xCD);
+  ASSERT_EQUAL(i8080_read_word(cpu, 0x0FF), 0x1234);
+}
+
+TEST_CASE(bus_rom_drops_writes) {
+  i8080_map_rom(cpu, 0xF000, sizeof(rom), rom);
+
+  i8080_write_byte(cpu, 0xF010, 0xFF);
+
+  ASSERT_EQUAL(i8080_read_byte(cpu, 0xF010), 0x10);
+  ASSERT_EQUAL(rom[0x10], 0x10);
+}
+
+TEST_CASE(bus_unmapped) {
+  i8080_write_byte(cpu, 0x4000, 0xFF);
+
+  ASSERT_EQUAL(i8080_read_byte(cpu, 0x4000), 0);
+}
+
+TEST_CASE(bus_io_handlers) {
+  i8080_map_io(cpu, 0x8000, 0x100, device_read, device_write, &device_ctx);
+
+  ASSERT_EQUAL(i8080_read_byte(cpu, 0x8012), 0xAB);
+  ASSERT_TRUE(read_handler_ctx == &device_ctx);
+  ASSERT_EQUAL(read_handler_addr, 0x8012);
+
+  i8080_write_byte(cpu, 0x80FF, 0x34);
+  ASSERT_TRUE(write_handler_ctx == &device_ctx);
+  ASSERT_EQUAL(write_handler_addr, 0x80FF);
+  ASSERT_EQUAL(write_handler_data, 0x34);
+}
+
+TEST_CASE(bus_execute_from_rom) {
+  rom[0] = 0x3A; // LDA a16
+  rom[1] = 0x00;
+  rom[2] = 0x80;
+  rom[3] = 0x32; // STA a16
+  rom[4] = 0x10;
+  rom[5] = 0x01;
+  i8080_map_rom(cpu, 0x0000, sizeof(rom), rom);
+  i8080_map_ram(cpu, 0x0100, 0x100, ram);
+  i8080_map_io(cpu, 0x8000, 0x100, device_read, device_write, NULL);
+
+  i8080_run(cpu, 26);
+
+  ASSERT_EQUAL(cpu->A, 0xAB);
+  ASSERT_EQUAL(ram[0x10] & 0xFF, 0xAB);
+  ASSERT_EQUAL(cpu->PC, 6);
+}
@@ -0,0 +1,507 @@
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "attounit.h"
+#include "i8080.h"
+#include "i8080_cpm.h"
+#include "cpu_test_helpers.h"
+
+TEST_SUITE(cpm)
+
+static struct i8080 *cpu;
+static struct i8080_cpm cpm;
+static FILE *out;
+static char dir[] = "/tmp/cpm_testXXXXXX";
+static char dir_path[sizeof(dir)];
+
+#define PATH_SIZE (sizeof(dir) + 256)
+
+#define FCB 0x005C
+#define DMA 0x0080
+
+static void host_path(char *path, const char *name) {
+  snprintf(path, PATH_SIZE, "%s/%s", dir_path, name);
+}
+
+static void write_host_file(const char *name, const uint8_t *data, size_t len) {
+  char path[PATH_SIZE];
+  host_path(path, name);
+  FILE *file = fopen(path, "wb");
+  fwrite(data, 1, len, file);
+  fclose(file);
+}
+
+static long host_file_size(const char *name) {
+  char path[PATH_SIZE];
+  struct stat st;
+  host_path(path, name);
+  return stat(path, &st) == 0 ? (long) st.st_size : -1;
+}
+
+// The start of what's been written to the console so far, without flushing
+static const char *written() {
+  static char buf[256];
+  ssize_t len = pread(fileno(out), buf, sizeof(buf) - 1, 0);
+  buf[len > 0 ? len : 0] = '\0';
+  return buf;
+}
+
+static const char *output() {
+  i8080_cpm_flush(&cpm);
+  return written();
+}
+
+// Calls the BDOS from a CALL 5 followed by a HLT, returning A
+static uint bdos(uint function, uint de) {
+  i8080_write_byte(cpu, 0x0100, 0xCD); // CALL 0x0005
+  i8080_write_word(cpu, 0x0101, 0x0005);
+  i8080_write_byte(cpu, 0x0103, 0x76); // HLT
+
+  cpu->C = function;
+  cpu->D = de >> 8;
+  cpu->E = de & 0xFF;
+  cpu->PC = 0x0100;
+  cpu->SP = 0xF000;
+  cpu->halted = 0;
+  while (!cpu->halted) {
+    i8080_run(cpu, 1000);
+  }
+
+  return cpu->A;
+}
+
+// Sets up an FCB for a file, at the start of the file
+static void set_fcb(uint fcb, const char *name) {
+  for (int i=0;i<36;i++) {
+    i8080_write_byte(cpu, fcb + i, 0);
+  }
+  for (int i=0;i<11;i++) {
+    i8080_write_byte(cpu, fcb + 1 + i, name[i]);
+  }
+}
+
+static void fill_dma(uint val) {
+  for (int i=0;i<128;i++) {
+    i8080_write_byte(cpu, DMA + i, (val + i) & 0xFF);
+  }
+}
+
+static int dma_holds(uint val) {
+  for (int i=0;i<128;i++) {
+    if (i8080_read_byte(cpu, DMA + i) != ((val + i) & 0xFF)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static void set_random(uint fcb, uint record) {
+  i8080_write_byte(cpu, fcb + 33, record & 0xFF);
+  i8080_write_byte(cpu, fcb + 34, record >> 8);
+  i8080_write_byte(cpu, fcb + 35, 0);
+}
+
+BEFORE_EACH() {
+  cpu = setup_cpu_test_env();
+  i8080_jit_disable(cpu);
+  free(cpu->memory);
+  ASSERT_EQUAL(i8080_memory_64k_enable(cpu), 0);
+#ifdef I8080_JIT
+  i8080_jit_enable(cpu, 1);
+#endif
+
+  strcpy(dir_path, dir);
+  ASSERT_TRUE(mkdtemp(dir_path) != NULL);
+  ASSERT_EQUAL(i8080_cpm_init(&cpm, cpu, dir_path), 0);
+  out = tmpfile();
+  cpm.out = fileno(out);
+}
+AFTER_EACH() {
+  i8080_cpm_destroy(&cpm);
+  fclose(out);
+
+  DIR *d = opendir(dir_path);
+  struct dirent *entry;
+  while ((entry = readdir(d)) != NULL) {
+    if (entry->d_name[0] != '.') {
+      char path[PATH_SIZE];
+      host_path(path, entry->d_name);
+      unlink(path);
+    }
+  }
+  closedir(d);
+  rmdir(dir_path);
+
+  i8080_jit_disable(cpu);
+  i8080_memory_64k_disable(cpu);
+  free(cpu);
+}
+
+TEST_CASE(cpm_needs_64k) {
+  struct i8080 small;
+  i8080_reset(&small);
+  small.memsize = 128;
+
+  ASSERT_EQUAL(i8080_cpm_init(&cpm, &small, dir_path), -1);
+  // Leaves the one from BEFORE_EACH for AFTER_EACH
+  ASSERT_TRUE(cpm.cpu == cpu);
+}
+
+TEST_CASE(cpm_console_output) {
+  const char *str = "ello\0 world$";
+  for (int i=0;i<12;i++) {
+    i8080_write_byte(cpu, 0x0200 + i, str[i]);
+  }
+
+  bdos(2, 'H');
+  bdos(9, 0x0200);
+
+  // NULs are dropped
+  ASSERT_EQUAL(strcmp(output(), "Hello world"), 0);
+}
+
+TEST_CASE(cpm_output_waits_for_input) {
+  FILE *in = tmpfile();
+  fputs("y\n", in);
+  rewind(in);
+  cpm.in = in;
+
+  bdos(2, '?');
+  ASSERT_EQUAL(strcmp(written(), ""), 0);
+
+  // Goes out before reading, with the echo buffered again
+  ASSERT_EQUAL(bdos(1, 0), 'y');
+  ASSERT_EQUAL(strcmp(written(), "?"), 0);
+  ASSERT_EQUAL(bdos(1, 0), '\r');
+  ASSERT_EQUAL(strcmp(output(), "?y\r"), 0);
+
+  fclose(in);
+}
+
+TEST_CASE(cpm_long_string_output) {
+  // Strings longer than what's left of the buffer (below the stack used by
+  // bdos), and one wrapping around the top of memory
+  const uint len = 0xD000;
+  for (uint i=0;i<len;i++) {
+    i8080_write_byte(cpu, 0x1000 + i, 'a' + i % 26);
+  }
+  i8080_write_byte(cpu, 0x1000 + len, '$');
+  i8080_write_byte(cpu, 0xFFFE, 'x');
+  i8080_write_byte(cpu, 0xFFFF, 0);
+  i8080_write_byte(cpu, 0x0000, 'y');
+  i8080_write_byte(cpu, 0x0001, '$');
+
+  bdos(9, 0x1000);
+  bdos(9, 0x1000);
+  bdos(9, 0xFFFE);
+  i8080_cpm_flush(&cpm);
+
+  char *buf = malloc(2 * len + 3);
+  ASSERT_EQUAL_FMT(pread(fileno(out), buf, 2 * len + 3, 0), (ssize_t) (2 * len + 2), %zd);
+  uint mismatches = 0;
+  for (uint i=0;i<2 * len;i++) {
+    mismatches += buf[i] != 'a' + i % len % 26;
+  }
+  ASSERT_EQUAL(mismatches, 0);
+  ASSERT_EQUAL(buf[2 * len], 'x');
+  ASSERT_EQUAL(buf[2 * len + 1], 'y');
+  free(buf);
+}
+
+TEST_CASE(cpm_version) {
+  bdos(12, 0);
+  ASSERT_EQUAL(cpu->L, 0x22);
+  ASSERT_EQUAL(cpu->H, 0x00);
+  ASSERT_EQUAL(cpu->B, 0x00);
+}
+
+TEST_CASE(cpm_file_round_trip) {
+  set_fcb(FCB, "TEST    TXT");
+  ASSERT_EQUAL(bdos(22, FCB), 0);
+  for (uint i=0;i<3;i++) {
+    fill_dma(i * 0x10);
+    ASSERT_EQUAL(bdos(21, FCB), 0);
+  }
+  ASSERT_EQUAL(i8080_read_byte(cpu, FCB + 32), 3);
+  ASSERT_EQUAL(bdos(16, FCB), 0);
+  ASSERT_EQUAL_FMT(host_file_size("TEST.TXT"), (long) 384, %ld);
+
+  set_fcb(FCB, "TEST    TXT");
+  ASSERT_EQUAL(bdos(15, FCB), 0);
+  ASSERT_EQUAL(i8080_read_byte(cpu, FCB + 15), 3);
+  for (uint i=0;i<3;i++) {
+    ASSERT_EQUAL(bdos(20, FCB), 0);
+    ASSERT_TRUE(dma_holds(i * 0x10));
+  }
+  ASSERT_EQUAL(bdos(20, FCB), 1);
+}
+
+TEST_CASE(cpm_open_matches_any_case) {
+  uint8_t data[130];
+  memset(data, 'x', sizeof(data));
+  write_host_file("lower.txt", data, sizeof(data));
+
+  set_fcb(FCB, "LOWER   TXT");
+  ASSERT_EQUAL(bdos(15, FCB), 0);
+  ASSERT_EQUAL(i8080_read_byte(cpu, FCB + 15), 2);
+  ASSERT_EQUAL(bdos(20, FCB), 0);
+  ASSERT_EQUAL(i8080_read_byte(cpu, DMA + 127), 'x');
+
+  // The partial last record is padded with ^Z
+  ASSERT_EQUAL(bdos(20, FCB), 0);
+  ASSERT_EQUAL(i8080_read_byte(cpu, DMA + 1), 'x');
+  ASSERT_EQUAL(i8080_read_byte(cpu, DMA + 2), 0x1A);
+  ASSERT_EQUAL(i8080_read_byte(cpu, DMA + 127), 0x1A);
+  ASSERT_EQUAL(bdos(20, FCB), 1);
+}
+
+TEST_CASE(cpm_open_missing_file) {
+  set_fcb(FCB, "MISSING TXT");
+  ASSERT_EQUAL(bdos(15, FCB), 0xFF);
+  ASSERT_EQUAL(bdos(20, FCB), 1);
+}
+
+TEST_CASE(cpm_random_access) {
+  uint8_t data[10 * 128];
+  for (size_t i=0;i<sizeof(data);i++) {
+    data[i] = (uint8_t) (i / 128 * 0x10 + i % 128);
+  }
+  write_host_file("RAND.DAT", data, sizeof(data));
+
+  set_fcb(FCB, "RAND    DAT");
+  ASSERT_EQUAL(bdos(15, FCB), 0);
+  set_random(FCB, 5);
+  ASSERT_EQUAL(bdos(33, FCB), 0);
+  ASSERT_TRUE(dma_holds(0x50));
+
+  // Sequential access carries on from the same record
+  ASSERT_EQUAL(i8080_read_byte(cpu, FCB + 32), 5);
+  ASSERT_EQUAL(bdos(20, FCB), 0);
+  ASSERT_TRUE(dma_holds(0x50));
+  bdos(36, FCB);
+  ASSERT_EQUAL(i8080_read_byte(cpu, FCB + 33), 6);
+
+  set_random(FCB, 10);
+  ASSERT_EQUAL(bdos(33, FCB), 1);
+
+  fill_dma(0x77);
+  set_random(FCB, 20);
+  ASSERT_EQUAL(bdos(34, FCB), 0);
+  set_random(FCB, 0);
+  ASSERT_EQUAL(bdos(35, FCB), 0);
+  ASSERT_EQUAL(i8080_read_byte(cpu, FCB + 33), 21);
+  ASSERT_EQUAL(i8080_read_byte(cpu, FCB + 34), 0);
+
+  fill_dma(0);
+  set_random(FCB, 20);
+  ASSERT_EQUAL(bdos(33, FCB), 0);
+  ASSERT_TRUE(dma_holds(0x77));
+
+  ASSERT_EQUAL(bdos(16, FCB), 0);
+  ASSERT_EQUAL_FMT(host_file_size("RAND.DAT"), (long) 21 * 128, %ld);
+
+  // Only 16 bit record numbers
+  i8080_write_byte(cpu, FCB + 35, 1);
+  ASSERT_EQUAL(bdos(33, FCB), 6);
+}
+
+TEST_CASE(cpm_search) {
+  uint8_t data[200] = {0};
+  write_host_file("A.COM", data, sizeof(data));
+  write_host_file("B.COM", data, 10);
+  write_host_file("C.TXT", data, 10);
+  write_host_file("too_long_name.COM", data, 10);
+
+  int found_a = 0, found_b = 0;
+  set_fcb(FCB, "????????COM");
+  for (uint result=bdos(17, FCB);result != 0xFF;result=bdos(18, FCB)) {
+    ASSERT_EQUAL(result, 0);
+    ASSERT_EQUAL(i8080_read_byte(cpu, DMA + 9), 'C');
+    if (i8080_read_byte(cpu, DMA + 1) == 'A') {
+      ASSERT_EQUAL(i8080_read_byte(cpu, DMA + 15), 2);
+      found_a++;
+    } else {
+      ASSERT_EQUAL(i8080_read_byte(cpu, DMA + 1), 'B');
+      ASSERT_EQUAL(i8080_read_byte(cpu, DMA + 2), ' ');
+      ASSERT_EQUAL(i8080_read_byte(cpu, DMA + 15), 1);
+      found_b++;
+    }
+  }
+
+  ASSERT_EQUAL(found_a, 1);
+  ASSERT_EQUAL(found_b, 1);
+}
+
+TEST_CASE(cpm_delete_and_rename) {
+  uint8_t data[10] = {0};
+  write_host_file("OLD.TXT", data, sizeof(data));
+
+  set_fcb(FCB, "OLD     TXT");
+  for (int i=0;i<11;i++) {
+    i8080_write_byte(cpu, FCB + 17 + i, "NEW     TXT"[i]);
+  }
+  ASSERT_EQUAL(bdos(23, FCB), 0);
+  ASSERT_EQUAL_FMT(host_file_size("OLD.TXT"), (long) -1, %ld);
+  ASSERT_EQUAL_FMT(host_file_size("NEW.TXT"), (long) 10, %ld);
+  ASSERT_EQUAL(bdos(23, FCB), 0xFF);
+
+  set_fcb(FCB, "NEW     ???");
+  ASSERT_EQUAL(bdos(19, FCB), 0);
+  ASSERT_EQUAL_FMT(host_file_size("NEW.TXT"), (long) -1, %ld);
+  ASSERT_EQUAL(bdos(19, FCB), 0xFF);
+}
+
+TEST_CASE(cpm_rename_keeps_existing_file) {
+  uint8_t old_data[10] = {0}, new_data[20] = {0};
+  write_host_file("OLD.TXT", old_data, sizeof(old_data));
+  write_host_file("new.txt", new_data, sizeof(new_data));
+
+  set_fcb(FCB, "OLD     TXT");
+  for (int i=0;i<11;i++) {
+    i8080_write_byte(cpu, FCB + 17 + i, "NEW     TXT"[i]);
+  }
+  ASSERT_EQUAL(bdos(23, FCB), 0xFF);
+  ASSERT_EQUAL_FMT(host_file_size("OLD.TXT"), (long) 10, %ld);
+  ASSERT_EQUAL_FMT(host_file_size("new.txt"), (long) 20, %ld);
+}
+
+// Names that would reach outside the directory on the host are turned down
+TEST_CASE(cpm_rejects_host_paths) {
+  uint8_t data[10] = {0};
+  char escaped[PATH_SIZE];
+  struct stat st;
+  write_host_file("HI.TXT", data, sizeof(data));
+  host_path(escaped, "../ESC.TXT");
+
+  set_fcb(FCB, "../ESC  TXT");
+  ASSERT_EQUAL(bdos(22, FCB), 0xFF);
+  ASSERT_EQUAL(stat(escaped, &st), -1);
+  set_fcb(FCB, "/TMP/X  TXT");
+  ASSERT_EQUAL(bdos(22, FCB), 0xFF);
+
+  set_fcb(FCB, "./HI    TXT");
+  ASSERT_EQUAL(bdos(15, FCB), 0xFF);
+  set_fcb(FCB, "/HI     TXT");
+  ASSERT_EQUAL(bdos(15, FCB), 0xFF);
+
+  set_fcb(FCB, "HI      TXT");
+  for (int i=0;i<11;i++) {
+    i8080_write_byte(cpu, FCB + 17 + i, "../ESC  TXT"[i]);
+  }
+  ASSERT_EQUAL(bdos(23, FCB), 0xFF);
+  ASSERT_EQUAL(stat(escaped, &st), -1);
+  ASSERT_EQUAL_FMT(host_file_size("HI.TXT"), (long) 10, %ld);
+
+  set_fcb(FCB, "../HI   TXT");
+  for (int i=0;i<11;i++) {
+    i8080_write_byte(cpu, FCB + 17 + i, "ESC     TXT"[i]);
+  }
+  ASSERT_EQUAL(bdos(23, FCB), 0xFF);
+
+  set_fcb(FCB, "./HI    ???");
+  ASSERT_EQUAL(bdos(19, FCB), 0xFF);
+  set_fcb(FCB, "/HI     TXT");
+  ASSERT_EQUAL(bdos(19, FCB), 0xFF);
+  ASSERT_EQUAL_FMT(host_file_size("HI.TXT"), (long) 10, %ld);
+}
+
+// Writes across several extents and more than one buffer's worth of records
+TEST_CASE(cpm_large_file) {
+  const uint records = I8080_CPM_BUFFER_SIZE / 128 + 88;
+  const uint last_extent = records / 128, in_last_extent = records & 0x7F;
+
+  set_fcb(FCB, "BIG     DAT");
+  ASSERT_EQUAL(bdos(22, FCB), 0);
+  for (uint i=0;i<records;i++) {
+    fill_dma(i);
+    ASSERT_EQUAL(bdos(21, FCB), 0);
+  }
+  ASSERT_EQUAL(i8080_read_byte(cpu, FCB + 12), last_extent);
+  ASSERT_EQUAL(i8080_read_byte(cpu, FCB + 32), in_last_extent);
+  ASSERT_EQUAL(i8080_read_byte(cpu, FCB + 15), in_last_extent);
+  ASSERT_EQUAL(bdos(16, FCB), 0);
+  ASSERT_EQUAL_FMT(host_file_size("BIG.DAT"), (long) records * 128, %ld);
+
+  set_fcb(FCB, "BIG     DAT");
+  ASSERT_EQUAL(bdos(15, FCB), 0);
+  ASSERT_EQUAL(i8080_read_byte(cpu, FCB + 15), 128);
+  for (uint i=0;i<records;i++) {
+    ASSERT_EQUAL(bdos(20, FCB), 0);
+    ASSERT_TRUE(dma_holds(i));
+  }
+  ASSERT_EQUAL(bdos(20, FCB), 1);
+}
+
+TEST_CASE(cpm_runs_program) {
+  const uint8_t program[] = {
+    0x11, 0x09, 0x01, // 0100: LXI D, 0x0109
+    0x0E, 0x09,       // 0103: MVI C, 9
+    0xCD, 0x05, 0x00, // 0105: CALL 0x0005
+    0xC9,             // 0108: RET
+    'h', 'i', '$',    // 0109
+  };
+  char path[PATH_SIZE];
+  write_host_file("HI.COM", program, sizeof(program));
+  host_path(path, "HI.COM");
+
+  ASSERT_EQUAL(i8080_cpm_load(&cpm, path, "foo.txt b:*.c"), 0);
+  ASSERT_EQUAL(i8080_cpm_run(&cpm), 0);
+  ASSERT_TRUE(cpm.exited);
+  ASSERT_EQUAL(strcmp(output(), "hi"), 0);
+
+  // Command tail
+  ASSERT_EQUAL(i8080_read_byte(cpu, 0x0080), 14);
+  char tail[15];
+  for (int i=0;i<14;i++) {
+    tail[i] = (char) i8080_read_byte(cpu, 0x0081 + i);
+  }
+  tail[14] = '\0';
+  ASSERT_EQUAL(strcmp(tail, " FOO.TXT B:*.C"), 0);
+
+  // Default FCBs
+  char fcbs[2][12];
+  for (int i=0;i<11;i++) {
+    fcbs[0][i] = (char) i8080_read_byte(cpu, 0x005D + i);
+    fcbs[1][i] = (char) i8080_read_byte(cpu, 0x006D + i);
+  }
+  fcbs[0][11] = fcbs[1][11] = '\0';
+  ASSERT_EQUAL(i8080_read_byte(cpu, 0x005C), 0);
+  ASSERT_EQUAL(strcmp(fcbs[0], "FOO     TXT"), 0);
+  ASSERT_EQUAL(i8080_read_byte(cpu, 0x006C), 2);
+  ASSERT_EQUAL(strcmp(fcbs[1], "????????C  "), 0);
+}
+
+// A program too big for the TPA is turned down before it can overwrite the
+// BDOS and BIOS
+TEST_CASE(cpm_load_too_big) {
+  static uint8_t program[I8080_CPM_BDOS - 0x0100 + 1];
+  static uint8_t top[0x10000 - I8080_CPM_BDOS];
+  char path[PATH_SIZE];
+  memset(program, 0x76, sizeof(program));
+  write_host_file("BIG.COM", program, sizeof(program));
+  host_path(path, "BIG.COM");
+  memcpy(top, cpu->memory + I8080_CPM_BDOS, sizeof(top));
+
+  errno = 0;
+  ASSERT_EQUAL(i8080_cpm_load(&cpm, path, NULL), -1);
+  ASSERT_EQUAL(errno, EFBIG);
+  ASSERT_EQUAL(i8080_read_byte(cpu, 0x0100), 0);
+  ASSERT_EQUAL(memcmp(cpu->memory + I8080_CPM_BDOS, top, sizeof(top)), 0);
+}
+
+TEST_CASE(cpm_run_reports_halt) {
+  const uint8_t program[] = {0x76};
+  char path[PATH_SIZE];
+  write_host_file("HALT.COM", program, sizeof(program));
+  host_path(path, "HALT.COM");
+
+  ASSERT_EQUAL(i8080_cpm_load(&cpm, path, NULL), 0);
+  ASSERT_EQUAL(i8080_read_byte(cpu, 0x0080), 0);
+  ASSERT_EQUAL(i8080_cpm_run(&cpm), -1);
+  ASSERT_FALSE(cpm.exited);
+}
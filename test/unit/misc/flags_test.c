@@ -14,6 +14,8 @@ AFTER_EACH() {
 }
 
 TEST_CASE(set_flag_c) {
+  // Resetting would forget the JIT the test environment may have enabled
+  i8080_jit_disable(cpu);
   i8080_reset(cpu);
   i8080_set_flag(cpu, FLAG_C, 1);
 
@@ -22,6 +24,7 @@ TEST_CASE(set_flag_c) {
 }
 
 TEST_CASE(set_flag_p) {
+  i8080_jit_disable(cpu);
   i8080_reset(cpu);
   i8080_set_flag(cpu, FLAG_P, 1);
 
@@ -30,6 +33,7 @@ TEST_CASE(set_flag_p) {
 }
 
 TEST_CASE(set_flag_a) {
+  i8080_jit_disable(cpu);
   i8080_reset(cpu);
   i8080_set_flag(cpu, FLAG_A, 1);
 
@@ -38,6 +42,7 @@ TEST_CASE(set_flag_a) {
 }
 
 TEST_CASE(set_flag_z) {
+  i8080_jit_disable(cpu);
   i8080_reset(cpu);
   i8080_set_flag(cpu, FLAG_Z, 1);
 
@@ -46,9 +51,41 @@ TEST_CASE(set_flag_z) {
 }
 
 TEST_CASE(set_flag_s) {
+  i8080_jit_disable(cpu);
   i8080_reset(cpu);
   i8080_set_flag(cpu, FLAG_S, 1);
 
   ASSERT_TRUE(i8080_get_flag(cpu, FLAG_S));
   ASSERT_EQUAL(cpu->flags, 0x82);
-}
\ No newline at end of file
+}
+uint flags_seen_by_handler;
+
+void record_flags(struct i8080 *cpu, uint dev, uint val) {
+  flags_seen_by_handler = cpu->flags;
+}
+
+uint set_carry(struct i8080 *cpu, uint dev) {
+  cpu->flags |= 0x01;
+  return 0;
+}
+
+TEST_CASE(flags_visible_to_io_handlers) {
+  i8080_write_byte(cpu, 0, 0xAF); // XRA A
+  i8080_write_byte(cpu, 1, 0xD3); // OUT
+  cpu->output_handler = record_flags;
+
+  i8080_run(cpu, 8);
+
+  ASSERT_EQUAL(flags_seen_by_handler, 0x46);
+}
+
+TEST_CASE(flags_changed_by_io_handlers) {
+  i8080_write_byte(cpu, 0, 0xDB); // IN
+  i8080_write_byte(cpu, 2, 0x17); // RAL
+  cpu->input_handler = set_carry;
+
+  i8080_run(cpu, 11);
+
+  ASSERT_EQUAL(cpu->A, 0x01);
+  ASSERT_FALSE(i8080_get_flag(cpu, FLAG_C));
+}
@@ -1,3 +1,6 @@
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
 #include "attounit.h"
 #include "i8080.h"
 #include "memory.h"
@@ -123,4 +126,106 @@ TEST_CASE(interrupt_request_rst_7) {
   ASSERT_FALSE(cpu->INTE);
   ASSERT_EQUAL(cpu->PC, 56);
   ASSERT_EQUAL(i8080_pop_stackb(cpu), 60);
-}
\ No newline at end of file
+}
+
+TEST_CASE(interrupt_post_taken_at_step) {
+  cpu->PC = 60;
+  cpu->INTE = 1;
+  ASSERT_EQUAL(i8080_post_interrupt(cpu, I8080_RST_2), 0);
+  ASSERT_TRUE(i8080_interrupt_posted(cpu));
+
+  i8080_step(cpu);
+
+  ASSERT_FALSE(i8080_interrupt_posted(cpu));
+  ASSERT_FALSE(cpu->INTE);
+  ASSERT_EQUAL(cpu->PC, 16);
+  ASSERT_EQUAL(i8080_pop_stackb(cpu), 60);
+}
+
+TEST_CASE(interrupt_post_held_until_taken) {
+  cpu->PC = 60;
+  cpu->INTE = 1;
+  i8080_post_interrupt(cpu, I8080_RST_2);
+
+  errno = 0;
+  ASSERT_EQUAL(i8080_post_interrupt(cpu, I8080_RST_3), -1);
+  ASSERT_EQUAL(errno, EBUSY);
+
+  i8080_step(cpu);
+  ASSERT_EQUAL(cpu->PC, 16);
+
+  // Free again once taken
+  ASSERT_EQUAL(i8080_post_interrupt(cpu, I8080_RST_3), 0);
+}
+
+TEST_CASE(interrupt_post_wakes_halted) {
+  cpu->PC = 60;
+  cpu->INTE = 1;
+  cpu->halted = 1;
+  i8080_post_interrupt(cpu, I8080_RST_2);
+
+  i8080_run(cpu, 1);
+
+  ASSERT_FALSE(cpu->halted);
+  ASSERT_EQUAL(cpu->PC, 16);
+}
+
+// Set before posting, and read back by the interrupt handler with IN
+static uint device_data;
+static struct i8080 *posting_cpu;
+
+static uint read_device(struct i8080 *cpu, uint port) {
+  return device_data;
+}
+
+static void *post_from_thread(void *arg) {
+  // Most likely arrives while the CPU is running
+  struct timespec ts = {0, 1000000};
+  nanosleep(&ts, NULL);
+
+  device_data = 0x42;
+  i8080_post_interrupt(posting_cpu, I8080_RST_1);
+  return NULL;
+}
+
+static void assert_takes_from_thread(struct i8080 *cpu) {
+  const unsigned char program[] = {
+    0x31, 0x70, 0x00, // 00: LXI SP, 0x0070
+    0xC3, 0x03, 0x00, // 03: JMP 0x0003
+    0x00,             // 06: NOP
+    0x00,             // 07: NOP
+    0xDB, 0x00,       // 08: IN 0
+    0x76,             // 0A: HLT
+  };
+  for (size_t i=0;i<sizeof(program);i++) {
+    i8080_write_byte(cpu, i, program[i]);
+  }
+  cpu->INTE = 1;
+  cpu->input_handler = read_device;
+  device_data = 0;
+  posting_cpu = cpu;
+
+  pthread_t thread;
+  pthread_create(&thread, NULL, post_from_thread, NULL);
+
+  // Spins until the interrupt arrives, in a single budget that takes seconds
+  // to run out, so it has to be taken mid-run
+  i8080_run(cpu, 1000000000);
+  pthread_join(thread, NULL);
+
+  ASSERT_TRUE(cpu->halted);
+  ASSERT_EQUAL(cpu->A, 0x42);
+}
+
+TEST_CASE(interrupt_post_from_thread) {
+  assert_takes_from_thread(cpu);
+}
+
+TEST_CASE(interrupt_post_from_thread_between_blocks) {
+  i8080_jit_disable(cpu);
+  i8080_block_cache_enable(cpu, 0);
+
+  assert_takes_from_thread(cpu);
+
+  i8080_block_cache_disable(cpu);
+}
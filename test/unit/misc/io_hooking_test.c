@@ -1,3 +1,4 @@
+#include <errno.h>
 #include "cpu_test_helpers.h"
 #include "i8080.h"
 #include "attounit.h"
@@ -65,3 +66,235 @@ TEST_CASE(hook_output) {
   ASSERT_EQUAL(out_handler_dev_arg, 0xAB);
   ASSERT_EQUAL(out_handler_data_arg, 0xCD);
 }
+
+uint pending_in_handler(struct i8080 *cpu, uint dev) {
+  in_handler_called++;
+  in_handler_dev_arg = dev;
+
+  return I8080_IN_PENDING;
+}
+
+TEST_CASE(hook_input_pending) {
+  i8080_write_byte(cpu, 0, 0xDB); // IN
+  i8080_write_byte(cpu, 1, 0xAB); // d8
+  i8080_write_byte(cpu, 2, 0x47); // MOV B, A
+  i8080_write_byte(cpu, 3, 0x76); // HLT
+  cpu->A = 0x12;
+  cpu->input_handler = pending_in_handler;
+
+  // Parks right after the IN, without a value
+  ASSERT_EQUAL_FMT(i8080_run(cpu, 1000), 10lu, %lu);
+  ASSERT_TRUE(cpu->in_pending);
+  ASSERT_EQUAL(cpu->in_port, 0xAB);
+  ASSERT_EQUAL(cpu->PC, 2);
+  ASSERT_EQUAL(cpu->A, 0x12);
+
+  // And stays there
+  ASSERT_EQUAL_FMT(i8080_run(cpu, 1000), 0lu, %lu);
+  i8080_step(cpu);
+  ASSERT_EQUAL(cpu->PC, 2);
+  ASSERT_EQUAL(in_handler_called, 1);
+
+  ASSERT_EQUAL(i8080_complete_in(cpu, 0xCD), 0);
+  ASSERT_FALSE(cpu->in_pending);
+  ASSERT_EQUAL(cpu->A, 0xCD);
+
+  i8080_run(cpu, 1000);
+  ASSERT_EQUAL(cpu->B, 0xCD);
+  ASSERT_TRUE(cpu->halted);
+  ASSERT_EQUAL(in_handler_called, 1);
+}
+
+TEST_CASE(hook_input_complete_without_pending) {
+  errno = 0;
+  ASSERT_EQUAL(i8080_complete_in(cpu, 0xCD), -1);
+  ASSERT_EQUAL(errno, EINVAL);
+}
+
+TEST_CASE(hook_input_pending_holds_interrupts) {
+  i8080_write_byte(cpu, 0, 0xDB); // IN
+  i8080_write_byte(cpu, 1, 0xAB); // d8
+  cpu->INTE = 1;
+  cpu->input_handler = pending_in_handler;
+
+  i8080_run(cpu, 1000);
+  i8080_request_interrupt(cpu, I8080_RST_1);
+  ASSERT_EQUAL_FMT(i8080_run(cpu, 1000), 0lu, %lu);
+
+  // Taken once the IN has finished
+  i8080_complete_in(cpu, 0xCD);
+  i8080_step(cpu);
+  ASSERT_EQUAL(cpu->PC, 8);
+  ASSERT_EQUAL(i8080_pop_stackw(cpu), 2);
+}
+
+TEST_CASE(hook_input_pending_in_block) {
+  i8080_write_byte(cpu, 0, 0x06); // MVI B, 0x01
+  i8080_write_byte(cpu, 1, 0x01);
+  i8080_write_byte(cpu, 2, 0xDB); // IN
+  i8080_write_byte(cpu, 3, 0xAB); // d8
+  i8080_write_byte(cpu, 4, 0x4F); // MOV C, A
+  i8080_write_byte(cpu, 5, 0x76); // HLT
+  i8080_jit_disable(cpu);
+  i8080_block_cache_enable(cpu, 0);
+  cpu->input_handler = pending_in_handler;
+
+  ASSERT_EQUAL_FMT(i8080_run(cpu, 1000), 17lu, %lu);
+  ASSERT_TRUE(cpu->in_pending);
+  ASSERT_EQUAL(cpu->C, 0x00);
+
+  i8080_complete_in(cpu, 0xCD);
+  i8080_run(cpu, 1000);
+  ASSERT_EQUAL(cpu->C, 0xCD);
+  ASSERT_TRUE(cpu->halted);
+
+  i8080_block_cache_disable(cpu);
+}
+
+// One host thread serving several CPUs that read from slow devices
+TEST_CASE(hook_input_pending_multiplexed) {
+  struct i8080 *cpus[4];
+
+  for (int i=0;i<4;i++) {
+    cpus[i] = setup_cpu_test_env();
+    i8080_write_byte(cpus[i], 0, 0xDB); // IN 0x01
+    i8080_write_byte(cpus[i], 1, 0x01);
+    i8080_write_byte(cpus[i], 2, 0x80); // ADD B
+    i8080_write_byte(cpus[i], 3, 0x47); // MOV B, A
+    i8080_write_byte(cpus[i], 4, 0xC3); // JMP 0x0000
+    i8080_write_byte(cpus[i], 5, 0x00);
+    i8080_write_byte(cpus[i], 6, 0x00);
+    cpus[i]->input_handler = pending_in_handler;
+  }
+
+  for (int round=1;round<=10;round++) {
+    for (int i=0;i<4;i++) {
+      i8080_run(cpus[i], 1000);
+      ASSERT_TRUE(cpus[i]->in_pending);
+    }
+
+    // The reads finish in any order
+    for (int i=3;i>=0;i--) {
+      i8080_complete_in(cpus[i], i + 1);
+    }
+  }
+
+  for (int i=0;i<4;i++) {
+    i8080_run(cpus[i], 1000);
+    ASSERT_EQUAL(cpus[i]->B, 10 * (i + 1));
+    ASSERT_TRUE(cpus[i]->in_pending);
+    teardown_cpu_test_env(cpus[i]);
+  }
+}
+
+struct port_device {
+  int reads;
+  int writes;
+  uint port;
+  uint val;
+};
+
+uint port_in_handler(struct i8080 *cpu, void *ctx, uint port) {
+  struct port_device *device = ctx;
+  device->reads++;
+  device->port = port;
+
+  return 0x5A;
+}
+
+void port_out_handler(struct i8080 *cpu, void *ctx, uint port, uint val) {
+  struct port_device *device = ctx;
+  device->writes++;
+  device->port = port;
+  device->val = val;
+}
+
+TEST_CASE(hook_port_table) {
+  struct i8080_port ports[I8080_NUM_PORTS];
+  struct port_device device = {0};
+  i8080_ports_init(cpu, ports);
+  i8080_map_port(cpu, 0x10, port_in_handler, port_out_handler, &device);
+  cpu->input_handler = in_handler;
+  cpu->output_handler = out_handler;
+
+  i8080_write_byte(cpu, 0, 0xDB); // IN 0x10
+  i8080_write_byte(cpu, 1, 0x10);
+  i8080_write_byte(cpu, 2, 0xD3); // OUT 0x10
+  i8080_write_byte(cpu, 3, 0x10);
+  i8080_write_byte(cpu, 4, 0xDB); // IN 0x11
+  i8080_write_byte(cpu, 5, 0x11);
+  i8080_write_byte(cpu, 6, 0xD3); // OUT 0x11
+  i8080_write_byte(cpu, 7, 0x11);
+  in_handler_retval = 0xCD;
+
+  i8080_step(cpu);
+  ASSERT_EQUAL(cpu->A, 0x5A);
+  ASSERT_EQUAL(device.reads, 1);
+  ASSERT_EQUAL(device.port, 0x10);
+
+  i8080_step(cpu);
+  ASSERT_EQUAL(device.writes, 1);
+  ASSERT_EQUAL(device.val, 0x5A);
+
+  // Unmapped ports still go to the global handlers
+  ASSERT_FALSE(in_handler_called);
+  ASSERT_FALSE(out_handler_called);
+  i8080_step(cpu);
+  i8080_step(cpu);
+  ASSERT_EQUAL(cpu->A, 0xCD);
+  ASSERT_EQUAL(in_handler_dev_arg, 0x11);
+  ASSERT_EQUAL(out_handler_dev_arg, 0x11);
+  ASSERT_EQUAL(device.reads, 1);
+  ASSERT_EQUAL(device.writes, 1);
+}
+
+TEST_CASE(hook_port_latch) {
+  struct i8080_port ports[I8080_NUM_PORTS];
+  i8080_ports_init(cpu, ports);
+  i8080_latch_port(cpu, 0x20, 0x12);
+  cpu->input_handler = in_handler;
+  cpu->output_handler = out_handler;
+
+  i8080_write_byte(cpu, 0, 0xDB); // IN 0x20
+  i8080_write_byte(cpu, 1, 0x20);
+  i8080_write_byte(cpu, 2, 0x3C); // INR A
+  i8080_write_byte(cpu, 3, 0xD3); // OUT 0x20
+  i8080_write_byte(cpu, 4, 0x20);
+  i8080_write_byte(cpu, 5, 0xDB); // IN 0x20
+  i8080_write_byte(cpu, 6, 0x20);
+
+  i8080_run(cpu, 10);
+  ASSERT_EQUAL(cpu->A, 0x12);
+
+  i8080_run(cpu, 15);
+  ASSERT_EQUAL(ports[0x20].latch, 0x13);
+
+  // The host can change it too
+  ports[0x20].latch = 0x77;
+  i8080_run(cpu, 10);
+  ASSERT_EQUAL(cpu->A, 0x77);
+
+  ASSERT_FALSE(in_handler_called);
+  ASSERT_FALSE(out_handler_called);
+}
+
+TEST_CASE(hook_port_output_only) {
+  struct i8080_port ports[I8080_NUM_PORTS];
+  struct port_device device = {0};
+  i8080_ports_init(cpu, ports);
+  i8080_map_port(cpu, 0x30, NULL, port_out_handler, &device);
+  ports[0x30].latch = 0x44;
+
+  i8080_write_byte(cpu, 0, 0xDB); // IN 0x30
+  i8080_write_byte(cpu, 1, 0x30);
+  i8080_write_byte(cpu, 2, 0xD3); // OUT 0x30
+  i8080_write_byte(cpu, 3, 0x30);
+
+  i8080_run(cpu, 20);
+
+  // Reads the latch, which the handler is left to update
+  ASSERT_EQUAL(cpu->A, 0x44);
+  ASSERT_EQUAL(device.writes, 1);
+  ASSERT_EQUAL(device.val, 0x44);
+  ASSERT_EQUAL(ports[0x30].latch, 0x44);
+}
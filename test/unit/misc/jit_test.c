@@ -0,0 +1,68 @@
+#include <errno.h>
+#include <stdlib.h>
+#include "attounit.h"
+#include "i8080.h"
+#include "cpu_test_helpers.h"
+
+TEST_SUITE(jit)
+
+static struct i8080 *jit_cpu;
+static struct i8080 *interp_cpu;
+
+BEFORE_EACH() {
+  jit_cpu = setup_cpu_test_env();
+  interp_cpu = setup_cpu_test_env();
+
+  // Whole blocks for one, plain interpreter for the other
+  i8080_jit_enable(jit_cpu, 0);
+  i8080_jit_disable(interp_cpu);
+}
+AFTER_EACH() {
+  teardown_cpu_test_env(jit_cpu);
+  teardown_cpu_test_env(interp_cpu);
+}
+
+TEST_CASE(jit_enable) {
+  i8080_jit_disable(jit_cpu);
+  ASSERT_TRUE(jit_cpu->jit == NULL);
+
+#ifdef I8080_JIT
+  ASSERT_EQUAL(i8080_jit_enable(jit_cpu, 8), 0);
+  ASSERT_TRUE(jit_cpu->jit != NULL);
+#else
+  ASSERT_EQUAL(i8080_jit_enable(jit_cpu, 8), -1);
+  ASSERT_EQUAL(errno, ENOSYS);
+  ASSERT_TRUE(jit_cpu->jit == NULL);
+#endif
+}
+
+TEST_CASE(jit_matches_interpreter) {
+  check_against_interpreter(jit_cpu, interp_cpu);
+}
+
+TEST_CASE(jit_64k_matches_interpreter) {
+  for (int i=0;i<2;i++) {
+    struct i8080 *cpu = i ? interp_cpu : jit_cpu;
+    i8080_jit_disable(cpu);
+    free(cpu->memory);
+    ASSERT_EQUAL(i8080_memory_64k_enable(cpu), 0);
+    load_wrap_program(cpu);
+  }
+  i8080_jit_enable(jit_cpu, 0);
+
+  i8080_run(jit_cpu, 1000);
+  i8080_run(interp_cpu, 1000);
+
+  ASSERT_EQUAL(interp_cpu->H, 0x12);
+  ASSERT_EQUAL(interp_cpu->D, 0x12);
+  ASSERT_EQUAL(i8080_read_byte(interp_cpu, 0x0000), 0x12);
+  assert_same_state(jit_cpu, interp_cpu);
+}
+
+TEST_CASE(jit_budget_stops_between_instructions) {
+  // Three NOPs fit in the first 10 cycles, as with the interpreter
+  i8080_write_byte(jit_cpu, 5, 0x76);
+
+  ASSERT_EQUAL_FMT(i8080_run(jit_cpu, 10), 12lu, %lu);
+  ASSERT_EQUAL(jit_cpu->PC, 3);
+}
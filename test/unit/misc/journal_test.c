@@ -0,0 +1,215 @@
+#include <errno.h>
+#include <string.h>
+#include "attounit.h"
+#include "i8080.h"
+#include "cpu_test_helpers.h"
+
+TEST_SUITE(journal)
+
+#define JOURNAL_TEST_STEPS 400
+
+struct saved_state {
+  struct i8080 regs;
+  char memory[128];
+};
+
+static struct i8080 *cpu;
+static struct saved_state states[JOURNAL_TEST_STEPS + 1];
+
+// Stores, calls, pushes and pops in a loop
+static const unsigned char store_program[] = {
+  0x31, 0x70, 0x00, // 00: LXI SP, 0x0070
+  0x21, 0x40, 0x00, // 03: LXI H, 0x0040
+  0x06, 0x00,       // 06: MVI B, 0x00
+  0x04,             // 08: INR B
+  0x70,             // 09: MOV M, B
+  0x23,             // 0A: INX H
+  0x7D,             // 0B: MOV A, L
+  0xE6, 0x4F,       // 0C: ANI 0x4F
+  0x6F,             // 0E: MOV L, A
+  0xCD, 0x18, 0x00, // 0F: CALL 0x0018
+  0xC5,             // 12: PUSH B
+  0xD1,             // 13: POP D
+  0xC3, 0x08, 0x00, // 14: JMP 0x0008
+  0x00,             // 17: NOP
+  0x22, 0x60, 0x00, // 18: SHLD 0x0060
+  0x80,             // 1B: ADD B
+  0x1F,             // 1C: RAR
+  0xC9,             // 1D: RET
+};
+
+static void save_state(struct saved_state *state) {
+  state->regs = *cpu;
+  memcpy(state->memory, cpu->memory, sizeof(state->memory));
+}
+
+static void assert_state(struct saved_state *state) {
+  ASSERT_EQUAL(cpu->A, state->regs.A);
+  ASSERT_EQUAL(cpu->B, state->regs.B);
+  ASSERT_EQUAL(cpu->C, state->regs.C);
+  ASSERT_EQUAL(cpu->D, state->regs.D);
+  ASSERT_EQUAL(cpu->E, state->regs.E);
+  ASSERT_EQUAL(cpu->H, state->regs.H);
+  ASSERT_EQUAL(cpu->L, state->regs.L);
+  ASSERT_EQUAL(cpu->flags, state->regs.flags);
+  ASSERT_EQUAL(cpu->SP, state->regs.SP);
+  ASSERT_EQUAL(cpu->PC, state->regs.PC);
+  ASSERT_EQUAL(cpu->INTE, state->regs.INTE);
+  ASSERT_EQUAL(cpu->halted, state->regs.halted);
+  ASSERT_EQUAL_FMT(cpu->cyc, state->regs.cyc, %llu);
+  ASSERT_EQUAL(memcmp(cpu->memory, state->memory, sizeof(state->memory)), 0);
+}
+
+// Steps through the program, saving the state before every instruction
+static void run_steps(uint steps) {
+  for (uint i=0;i<steps;i++) {
+    save_state(&states[i]);
+    i8080_step(cpu);
+  }
+  save_state(&states[steps]);
+}
+
+BEFORE_EACH() {
+  cpu = setup_cpu_test_env();
+  load_program(cpu, store_program, sizeof(store_program));
+}
+AFTER_EACH() {
+  i8080_journal_disable(cpu);
+  teardown_cpu_test_env(cpu);
+}
+
+TEST_CASE(journal_rewinds_single_steps) {
+  ASSERT_EQUAL(i8080_journal_enable(cpu, 1 << 20, 0), 0);
+  run_steps(JOURNAL_TEST_STEPS);
+  ASSERT_EQUAL_FMT(i8080_journal_depth(cpu), (unsigned long) JOURNAL_TEST_STEPS,
+                   %lu);
+
+  for (int i=JOURNAL_TEST_STEPS-1;i>=0;i--) {
+    ASSERT_EQUAL_FMT(i8080_rewind(cpu, 1), 1lu, %lu);
+    assert_state(&states[i]);
+  }
+
+  ASSERT_EQUAL_FMT(i8080_journal_depth(cpu), 0lu, %lu);
+  ASSERT_EQUAL_FMT(i8080_rewind(cpu, 1), 0lu, %lu);
+}
+
+TEST_CASE(journal_rewinds_through_checkpoints) {
+  i8080_journal_enable(cpu, 1 << 20, 16);
+  run_steps(JOURNAL_TEST_STEPS);
+
+  ASSERT_EQUAL_FMT(i8080_rewind(cpu, 150), 150lu, %lu);
+  assert_state(&states[JOURNAL_TEST_STEPS - 150]);
+
+  ASSERT_EQUAL_FMT(i8080_rewind(cpu, 7), 7lu, %lu);
+  assert_state(&states[JOURNAL_TEST_STEPS - 157]);
+
+  ASSERT_EQUAL_FMT(i8080_rewind(cpu, 200), 200lu, %lu);
+  assert_state(&states[JOURNAL_TEST_STEPS - 357]);
+}
+
+TEST_CASE(journal_runs_forward_again) {
+  i8080_journal_enable(cpu, 1 << 20, 32);
+  run_steps(JOURNAL_TEST_STEPS);
+
+  i8080_rewind(cpu, 300);
+  for (uint i=JOURNAL_TEST_STEPS-300;i<JOURNAL_TEST_STEPS;i++) {
+    i8080_step(cpu);
+  }
+  assert_state(&states[JOURNAL_TEST_STEPS]);
+
+  // The new history is journaled in place of the old one
+  i8080_rewind(cpu, 250);
+  assert_state(&states[JOURNAL_TEST_STEPS - 250]);
+}
+
+TEST_CASE(journal_works_with_i8080_run) {
+  i8080_journal_enable(cpu, 1 << 20, 10);
+  save_state(&states[0]);
+
+  i8080_run(cpu, 5000);
+  unsigned long depth = i8080_journal_depth(cpu);
+  ASSERT_TRUE(depth > 100);
+
+  ASSERT_EQUAL_FMT(i8080_rewind(cpu, depth), depth, %lu);
+  assert_state(&states[0]);
+}
+
+TEST_CASE(journal_drops_oldest_entries) {
+  // Room for about 20 instructions
+  i8080_journal_enable(cpu, 20 * 32, 4);
+  run_steps(JOURNAL_TEST_STEPS);
+
+  unsigned long depth = i8080_journal_depth(cpu);
+  ASSERT_TRUE(depth > 0 && depth <= 20);
+
+  ASSERT_EQUAL_FMT(i8080_rewind(cpu, 1000), depth, %lu);
+  assert_state(&states[JOURNAL_TEST_STEPS - depth]);
+}
+
+TEST_CASE(journal_undoes_host_writes) {
+  i8080_journal_enable(cpu, 1 << 20, 0);
+  run_steps(10);
+
+  i8080_write_byte(cpu, 0x50, 0xAA);
+  i8080_write_word(cpu, 0x52, 0xBBCC);
+  i8080_rewind(cpu, 1);
+
+  assert_state(&states[9]);
+}
+
+TEST_CASE(journal_rewinds_interrupts_and_halts) {
+  const unsigned char program[] = {
+    0x31, 0x70, 0x00, // 00: LXI SP, 0x0070
+    0xFB,             // 03: EI
+    0x76,             // 04: HLT
+    0x76,             // 05: HLT
+    0x00,             // 06: NOP
+    0x00,             // 07: NOP
+    0x3E, 0x42,       // 08: MVI A, 0x42
+    0xC9,             // 0A: RET
+  };
+  load_program(cpu, program, sizeof(program));
+  i8080_journal_enable(cpu, 1 << 20, 0);
+
+  run_steps(3);
+  ASSERT_TRUE(cpu->halted);
+  i8080_request_interrupt(cpu, I8080_RST_1);
+  i8080_run(cpu, 100);
+  ASSERT_TRUE(cpu->halted);
+  ASSERT_EQUAL(cpu->A, 0x42);
+
+  // RST 1, MVI and RET, then the HLT
+  ASSERT_EQUAL_FMT(i8080_rewind(cpu, 4), 4lu, %lu);
+  ASSERT_FALSE(cpu->halted);
+  ASSERT_TRUE(cpu->pending_interrupt);
+
+  i8080_rewind(cpu, 1);
+  assert_state(&states[2]);
+}
+
+TEST_CASE(journal_cleared_by_restore) {
+  struct i8080_snapshot snapshot = {0};
+
+  i8080_journal_enable(cpu, 1 << 20, 0);
+  run_steps(10);
+  i8080_snapshot(cpu, &snapshot);
+  i8080_restore(cpu, &snapshot);
+
+  ASSERT_EQUAL_FMT(i8080_journal_depth(cpu), 0lu, %lu);
+  i8080_free_snapshot(&snapshot);
+}
+
+TEST_CASE(journal_rejects_bad_arguments) {
+  errno = 0;
+  ASSERT_EQUAL(i8080_journal_enable(cpu, 8, 0), -1);
+  ASSERT_EQUAL(errno, EINVAL);
+
+  struct i8080_page pages[I8080_NUM_PAGES];
+  i8080_bus_init(cpu, pages);
+  errno = 0;
+  ASSERT_EQUAL(i8080_journal_enable(cpu, 1 << 20, 0), -1);
+  ASSERT_EQUAL(errno, EINVAL);
+  ASSERT_TRUE(cpu->journal == NULL);
+
+  cpu->pages = NULL;
+}
@@ -0,0 +1,87 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "i8080.h"
+#include "attounit.h"
+#include "cpu_test_helpers.h"
+
+TEST_SUITE(loader)
+
+struct i8080 *cpu;
+char image_path[] = "/tmp/lib8080testXXXXXX";
+
+BEFORE_EACH() {
+  cpu = setup_cpu_test_env();
+
+  strcpy(image_path, "/tmp/lib8080testXXXXXX");
+  int fd = mkstemp(image_path);
+  FILE *file = fdopen(fd, "wb");
+  for (int i=0;i<300;i++) {
+    fputc(i & 0xFF, file);
+  }
+  fclose(file);
+}
+AFTER_EACH() {
+  unlink(image_path);
+  teardown_cpu_test_env(cpu);
+}
+
+TEST_CASE(load_memory_reports_bytes_loaded) {
+  ASSERT_EQUAL_FMT(i8080_load_memory(cpu, image_path, 0x10), 112L, %ld);
+
+  ASSERT_EQUAL(i8080_read_byte(cpu, 0x0F), 0x00);
+  ASSERT_EQUAL(i8080_read_byte(cpu, 0x10), 0x00);
+  ASSERT_EQUAL(i8080_read_byte(cpu, 0x7F), 0x6F);
+}
+
+TEST_CASE(load_memory_missing_file) {
+  ASSERT_EQUAL_FMT(i8080_load_memory(cpu, "/nonexistent/FILE.COM", 0), -1L, %ld);
+}
+
+TEST_CASE(load_memory_offset_beyond_end) {
+  ASSERT_EQUAL_FMT(i8080_load_memory(cpu, image_path, 0x100), -1L, %ld);
+}
+
+TEST_CASE(image_mapped_as_rom) {
+  struct i8080_page pages[I8080_NUM_PAGES];
+  struct i8080_image image;
+
+  ASSERT_EQUAL(i8080_open_image(&image, image_path), 0);
+  ASSERT_EQUAL_FMT(image.size, (size_t) 300, %zu);
+
+  i8080_bus_init(cpu, pages);
+  ASSERT_EQUAL(i8080_map_image(cpu, 0x100, &image), 0);
+
+  ASSERT_EQUAL(i8080_read_byte(cpu, 0x0FF), 0x00);
+  ASSERT_EQUAL(i8080_read_byte(cpu, 0x101), 0x01);
+  ASSERT_EQUAL(i8080_read_byte(cpu, 0x22B), 0x2B);
+  ASSERT_EQUAL(i8080_read_byte(cpu, 0x22C), 0x00);
+  ASSERT_EQUAL(i8080_read_byte(cpu, 0x2FF), 0x00);
+
+  i8080_write_byte(cpu, 0x101, 0xFF);
+  ASSERT_EQUAL(i8080_read_byte(cpu, 0x101), 0x01);
+
+  cpu->pages = NULL;
+  i8080_close_image(&image);
+}
+
+TEST_CASE(image_requires_page_alignment) {
+  struct i8080_page pages[I8080_NUM_PAGES];
+  struct i8080_image image;
+
+  ASSERT_EQUAL(i8080_open_image(&image, image_path), 0);
+
+  ASSERT_EQUAL(i8080_map_image(cpu, 0x100, &image), -1);
+
+  i8080_bus_init(cpu, pages);
+  ASSERT_EQUAL(i8080_map_image(cpu, 0x180, &image), -1);
+
+  cpu->pages = NULL;
+  i8080_close_image(&image);
+}
+
+TEST_CASE(open_image_missing_file) {
+  struct i8080_image image;
+
+  ASSERT_EQUAL(i8080_open_image(&image, "/nonexistent/FILE.COM"), -1);
+}
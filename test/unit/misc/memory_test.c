@@ -7,6 +7,7 @@ struct i8080 *cpu;
 TEST_SUITE(memory)
 BEFORE_EACH() {
   cpu = malloc(sizeof(struct i8080));
+  i8080_reset(cpu);
   cpu->memsize = 128;
   cpu->memory = malloc(sizeof(char) * 128);
 
@@ -15,12 +16,87 @@ BEFORE_EACH() {
   }
 }
 AFTER_EACH() {
-  free(cpu->memory);
+  if (cpu->memory_64k) {
+    i8080_memory_64k_disable(cpu);
+  } else {
+    free(cpu->memory);
+  }
   free(cpu);
 }
 
+// Swaps the test memory for a library owned 64K buffer
+static void use_memory_64k() {
+  free(cpu->memory);
+  ASSERT_EQUAL(i8080_memory_64k_enable(cpu), 0);
+}
+
 TEST_CASE(read_beyond_end_return_0) {
   i8080_write_byte(cpu, 128, 0xFF);
 
   ASSERT_EQUAL(i8080_read_byte(cpu, 128), 0);
 }
+
+TEST_CASE(word_beyond_end) {
+  i8080_write_byte(cpu, 127, 0x12);
+  i8080_write_word(cpu, 127, 0xABCD);
+
+  ASSERT_EQUAL(i8080_read_byte(cpu, 127), 0xCD);
+  ASSERT_EQUAL(i8080_read_word(cpu, 127), 0xCD);
+}
+
+TEST_CASE(memory_64k_masks_addresses) {
+  use_memory_64k();
+  ASSERT_EQUAL_FMT(cpu->memsize, (size_t) 0x10000, %zu);
+  ASSERT_EQUAL(i8080_read_byte(cpu, 0x1234), 0);
+
+  i8080_write_byte(cpu, 0x10005, 0x42);
+
+  ASSERT_EQUAL(i8080_read_byte(cpu, 5), 0x42);
+  ASSERT_EQUAL(i8080_read_byte(cpu, 0x20005), 0x42);
+}
+
+TEST_CASE(memory_64k_words_wrap) {
+  use_memory_64k();
+
+  i8080_write_word(cpu, 0xFFFF, 0x1234);
+
+  ASSERT_EQUAL(i8080_read_byte(cpu, 0xFFFF), 0x34);
+  ASSERT_EQUAL(i8080_read_byte(cpu, 0x0000), 0x12);
+  ASSERT_EQUAL(i8080_read_word(cpu, 0xFFFF), 0x1234);
+}
+
+TEST_CASE(memory_64k_stack_wraps) {
+  use_memory_64k();
+  cpu->SP = 0x0001;
+
+  i8080_push_stackw(cpu, 0xABCD);
+
+  ASSERT_EQUAL(cpu->SP, 0xFFFF);
+  ASSERT_EQUAL(i8080_read_byte(cpu, 0x0000), 0xAB);
+  ASSERT_EQUAL(i8080_read_byte(cpu, 0xFFFF), 0xCD);
+  ASSERT_EQUAL(i8080_pop_stackw(cpu), 0xABCD);
+  ASSERT_EQUAL(cpu->SP, 0x0001);
+}
+
+TEST_CASE(memory_64k_operand_wraps) {
+  use_memory_64k();
+  i8080_write_byte(cpu, 0xFFFE, 0x01); // LXI B, 0x1234
+  i8080_write_word(cpu, 0xFFFF, 0x1234);
+  cpu->PC = 0xFFFE;
+
+  i8080_step(cpu);
+
+  ASSERT_EQUAL(cpu->B, 0x12);
+  ASSERT_EQUAL(cpu->C, 0x34);
+  ASSERT_EQUAL(cpu->PC, 0x0001);
+}
+
+TEST_CASE(memory_64k_disable) {
+  use_memory_64k();
+
+  i8080_memory_64k_disable(cpu);
+
+  ASSERT_TRUE(cpu->memory == NULL);
+  ASSERT_EQUAL_FMT(cpu->memsize, (size_t) 0, %zu);
+  ASSERT_FALSE(cpu->memory_64k);
+}
@@ -0,0 +1,349 @@
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include "attounit.h"
+#include "i8080.h"
+#include "cpu_test_helpers.h"
+
+TEST_SUITE(replay)
+
+static struct i8080 *cpu;
+static FILE *log_file;
+
+static uint inputs;
+static uint outputs;
+static uint output_sum;
+static int interrupt_every;
+
+// Adds up input from port 1 and echoes it to port 2, while RST 1 counts
+// interrupts in C
+static const unsigned char io_program[] = {
+  0xC3, 0x10, 0x00, // 00: JMP 0x0010
+  0x00, 0x00, 0x00, 0x00, 0x00,
+  0x0C,             // 08: INR C
+  0xFB,             // 09: EI
+  0xC9,             // 0A: RET
+  0x00, 0x00, 0x00, 0x00, 0x00,
+  0x31, 0x70, 0x00, // 10: LXI SP, 0x0070
+  0xFB,             // 13: EI
+  0x04,             // 14: INR B
+  0xDB, 0x01,       // 15: IN 0x01
+  0x80,             // 17: ADD B
+  0xD3, 0x02,       // 18: OUT 0x02
+  0xC3, 0x14, 0x00, // 1A: JMP 0x0014
+};
+
+static uint input_handler(struct i8080 *cpu, uint port) {
+  inputs++;
+  if (interrupt_every > 0 && inputs % interrupt_every == 0) {
+    i8080_request_interrupt(cpu, I8080_RST_1);
+  }
+
+  return (inputs * 37 + 11) & 0xFF;
+}
+
+static void output_handler(struct i8080 *cpu, uint port, uint val) {
+  outputs++;
+  output_sum = output_sum * 31 + val;
+}
+
+static struct i8080 *new_machine() {
+  struct i8080 *machine = setup_cpu_test_env();
+  load_program(machine, io_program, sizeof(io_program));
+  machine->input_handler = input_handler;
+  machine->output_handler = output_handler;
+
+  return machine;
+}
+
+// Stops any replay still going before freeing the machine
+static void free_machine(struct i8080 *machine) {
+  i8080_recording_stop(machine);
+  teardown_cpu_test_env(machine);
+}
+
+// Records a run in slices of the given budget, requesting RST 1 between
+// slices
+static void record_run(struct i8080 *machine, uint slices,
+                       unsigned long budget) {
+  ASSERT_EQUAL(i8080_record_start(machine, log_file), 0);
+  for (uint i=0;i<slices;i++) {
+    if (i > 0) {
+      i8080_request_interrupt(machine, I8080_RST_1);
+    }
+    i8080_run(machine, budget);
+  }
+  ASSERT_EQUAL(i8080_recording_stop(machine), 0);
+  rewind(log_file);
+}
+
+// Replays up to the given cycle count in slices of the given budget
+static void replay_run(struct i8080 *machine, unsigned long long cyc,
+                       unsigned long budget) {
+  if (machine->recording == NULL) {
+    ASSERT_EQUAL(i8080_replay_start(machine, log_file), 0);
+  }
+  while (machine->cyc < cyc) {
+    unsigned long left = cyc - machine->cyc;
+    i8080_run(machine, left < budget ? left : budget);
+  }
+}
+
+BEFORE_EACH() {
+  cpu = new_machine();
+  log_file = tmpfile();
+
+  inputs = 0;
+  outputs = 0;
+  output_sum = 0;
+  interrupt_every = 0;
+}
+AFTER_EACH() {
+  i8080_recording_stop(cpu);
+  teardown_cpu_test_env(cpu);
+  fclose(log_file);
+}
+
+TEST_CASE(replay_io_without_handlers) {
+  record_run(cpu, 20, 100);
+  uint recorded_inputs = inputs;
+  ASSERT_TRUE(recorded_inputs > 0);
+
+  struct i8080 *replayed = new_machine();
+  replayed->input_handler = NULL;
+  replayed->output_handler = NULL;
+  replay_run(replayed, cpu->cyc, 1000);
+
+  assert_same_state(replayed, cpu);
+  ASSERT_EQUAL(inputs, recorded_inputs);
+
+  // The last event has been replayed
+  ASSERT_FALSE(i8080_replay_active(replayed));
+  ASSERT_EQUAL(i8080_recording_stop(replayed), 0);
+
+  teardown_cpu_test_env(replayed);
+}
+
+static uint pending_input_handler(struct i8080 *cpu, uint port) {
+  inputs++;
+  return I8080_IN_PENDING;
+}
+
+TEST_CASE(replay_pending_input) {
+  cpu->input_handler = pending_input_handler;
+
+  // Interrupts are requested while the IN is pending, and taken after it
+  ASSERT_EQUAL(i8080_record_start(cpu, log_file), 0);
+  for (uint i=0;i<30;i++) {
+    i8080_run(cpu, 1000);
+    ASSERT_TRUE(cpu->in_pending);
+    if (i % 4 == 0) {
+      i8080_request_interrupt(cpu, I8080_RST_1);
+    }
+    i8080_complete_in(cpu, (i * 37 + 11) & 0xFF);
+  }
+  ASSERT_EQUAL(i8080_recording_stop(cpu), 0);
+  rewind(log_file);
+  ASSERT_EQUAL(cpu->C, 8);
+
+  struct i8080 *replayed = new_machine();
+  replayed->input_handler = NULL;
+  replay_run(replayed, cpu->cyc, 1000);
+
+  assert_same_state(replayed, cpu);
+  ASSERT_EQUAL(i8080_recording_stop(replayed), 0);
+
+  teardown_cpu_test_env(replayed);
+}
+
+TEST_CASE(replay_interrupts_at_same_cycle) {
+  // Interrupts land wherever the odd budget happens to end while recording,
+  // and have to land in the same place with a different one
+  record_run(cpu, 50, 37);
+  ASSERT_TRUE(cpu->C > 0);
+
+  struct i8080 *replayed = new_machine();
+  i8080_block_cache_enable(replayed, 0);
+  replay_run(replayed, cpu->cyc, 500);
+
+  assert_same_state(replayed, cpu);
+  i8080_block_cache_disable(replayed);
+  free_machine(replayed);
+}
+
+TEST_CASE(replay_interrupts_from_handlers) {
+  interrupt_every = 3;
+  record_run(cpu, 10, 200);
+  uint recorded_outputs = outputs;
+
+  struct i8080 *replayed = new_machine();
+  replay_run(replayed, cpu->cyc, 1);
+
+  assert_same_state(replayed, cpu);
+  ASSERT_EQUAL(outputs, recorded_outputs);
+  free_machine(replayed);
+}
+
+TEST_CASE(replay_wakes_halted_cpu) {
+  const unsigned char program[] = {
+    0x31, 0x70, 0x00, // 00: LXI SP, 0x0070
+    0xFB,             // 03: EI
+    0x76,             // 04: HLT
+    0x00,             // 05: NOP
+    0x76,             // 06: HLT
+    0x00,             // 07: NOP
+    0x3E, 0x42,       // 08: MVI A, 0x42
+    0xC9,             // 0A: RET
+  };
+  load_program(cpu, program, sizeof(program));
+
+  i8080_record_start(cpu, log_file);
+  i8080_run(cpu, 100);
+  ASSERT_TRUE(cpu->halted);
+  i8080_request_interrupt(cpu, I8080_RST_1);
+  i8080_run(cpu, 100);
+  i8080_recording_stop(cpu);
+  rewind(log_file);
+
+  struct i8080 *replayed = setup_cpu_test_env();
+  load_program(replayed, program, sizeof(program));
+  i8080_replay_start(replayed, log_file);
+  i8080_run(replayed, 100);
+  i8080_run(replayed, 100);
+
+  ASSERT_TRUE(replayed->halted);
+  ASSERT_EQUAL(replayed->A, 0x42);
+  ASSERT_EQUAL(replayed->PC, cpu->PC);
+  ASSERT_EQUAL_FMT(replayed->cyc, cpu->cyc, %llu);
+  free_machine(replayed);
+}
+
+TEST_CASE(replay_ignores_live_interrupts) {
+  record_run(cpu, 5, 100);
+
+  struct i8080 *replayed = new_machine();
+  i8080_replay_start(replayed, log_file);
+  i8080_run(replayed, 50);
+  i8080_request_interrupt(replayed, I8080_RST_7);
+  replay_run(replayed, cpu->cyc, 1000);
+
+  assert_same_state(replayed, cpu);
+  free_machine(replayed);
+}
+
+TEST_CASE(replay_hands_back_to_handlers) {
+  record_run(cpu, 2, 100);
+  uint recorded_inputs = inputs;
+
+  struct i8080 *replayed = new_machine();
+  i8080_replay_start(replayed, log_file);
+
+  // Once the log runs out, IO goes to the handlers again
+  i8080_run(replayed, 1000);
+  ASSERT_FALSE(i8080_replay_active(replayed));
+  ASSERT_TRUE(inputs > recorded_inputs);
+  ASSERT_EQUAL(i8080_recording_stop(replayed), 0);
+
+  teardown_cpu_test_env(replayed);
+}
+
+TEST_CASE(replay_detects_divergence) {
+  record_run(cpu, 5, 100);
+  uint recorded_inputs = inputs;
+
+  // Reading from port 3 instead of 1 doesn't match the log
+  struct i8080 *replayed = new_machine();
+  i8080_write_byte(replayed, 0x16, 0x03);
+  i8080_replay_start(replayed, log_file);
+  i8080_run(replayed, 100);
+
+  // From then on the handlers are used again
+  ASSERT_FALSE(i8080_replay_active(replayed));
+  ASSERT_TRUE(inputs > recorded_inputs);
+
+  errno = 0;
+  ASSERT_EQUAL(i8080_recording_stop(replayed), -1);
+  ASSERT_EQUAL(errno, EILSEQ);
+  teardown_cpu_test_env(replayed);
+}
+
+TEST_CASE(replay_rejects_bad_logs) {
+  fputs("not a log", log_file);
+  rewind(log_file);
+
+  errno = 0;
+  ASSERT_EQUAL(i8080_replay_start(cpu, log_file), -1);
+  ASSERT_EQUAL(errno, EILSEQ);
+
+  // Recorded from a different cycle count
+  rewind(log_file);
+  i8080_record_start(cpu, log_file);
+  i8080_recording_stop(cpu);
+  rewind(log_file);
+  cpu->cyc = 1234;
+
+  errno = 0;
+  ASSERT_EQUAL(i8080_replay_start(cpu, log_file), -1);
+  ASSERT_EQUAL(errno, EINVAL);
+  ASSERT_TRUE(cpu->recording == NULL);
+}
+
+TEST_CASE(replay_log_is_compact) {
+  record_run(cpu, 20, 100);
+  fseek(log_file, 0, SEEK_END);
+
+  // Every IN and OUT takes 4 bytes with cycle deltas under 128, and every
+  // interrupt 3
+  long expected = 6 + (long) (inputs + outputs) * 4 + 19 * 3;
+  ASSERT_EQUAL_FMT(ftell(log_file), expected, %ld);
+}
+
+TEST_CASE(replay_past_32_bits) {
+  cpu->cyc = 0xFFFFFF00llu;
+  record_run(cpu, 20, 100);
+
+  struct i8080 *replayed = new_machine();
+  replayed->cyc = 0xFFFFFF00llu;
+  replay_run(replayed, cpu->cyc, 1000);
+
+  assert_same_state(replayed, cpu);
+  free_machine(replayed);
+}
+
+static void timer_handler(struct i8080 *cpu, void *data) {
+  i8080_request_interrupt(cpu, I8080_RST_1);
+  i8080_schedule_event(cpu, cpu->cyc + 777, timer_handler, data);
+}
+
+TEST_CASE(replay_skips_halted_time) {
+  const unsigned char program[] = {
+    0xC3, 0x10, 0x00, // 00: JMP 0x0010
+    0x00, 0x00, 0x00, 0x00, 0x00,
+    0xFB,             // 08: EI
+    0xC9,             // 09: RET
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x31, 0x70, 0x00, // 10: LXI SP, 0x0070
+    0xFB,             // 13: EI
+    0x76,             // 14: HLT
+    0x04,             // 15: INR B
+    0xC3, 0x14, 0x00, // 16: JMP 0x0014
+  };
+  load_program(cpu, program, sizeof(program));
+
+  i8080_record_start(cpu, log_file);
+  i8080_schedule_event(cpu, 777, timer_handler, NULL);
+  i8080_run_timed(cpu, 10000);
+  i8080_recording_stop(cpu);
+  i8080_cancel_all_events(cpu);
+  rewind(log_file);
+  ASSERT_EQUAL(cpu->B, 12);
+
+  // Without the timer, the logged interrupts wake the CPU at the same cycles
+  struct i8080 *replayed = new_machine();
+  load_program(replayed, program, sizeof(program));
+  i8080_replay_start(replayed, log_file);
+  i8080_run_timed(replayed, 10000);
+
+  assert_same_state(replayed, cpu);
+  free_machine(replayed);
+}
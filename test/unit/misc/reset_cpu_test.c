@@ -1,3 +1,4 @@
+#include <stddef.h>
 #include <stdlib.h>
 #include "i8080.h"
 #include "attounit.h"
@@ -30,4 +31,29 @@ TEST_CASE(i8080_reset) {
   ASSERT_EQUAL(cpu->pending_interrupt, 0);
 
   free(cpu);
-}
\ No newline at end of file
+}
+TEST_CASE(i8080_register_file) {
+  cpu = malloc(sizeof(struct i8080));
+  i8080_reset(cpu);
+
+  // Registers are indexed by their encoding in opcodes, flags sitting where
+  // M would be
+  for (int i=0;i<8;i++) {
+    cpu->regs[i] = i + 1;
+  }
+  ASSERT_EQUAL(cpu->B, 1);
+  ASSERT_EQUAL(cpu->C, 2);
+  ASSERT_EQUAL(cpu->D, 3);
+  ASSERT_EQUAL(cpu->E, 4);
+  ASSERT_EQUAL(cpu->H, 5);
+  ASSERT_EQUAL(cpu->L, 6);
+  ASSERT_EQUAL(cpu->flags, 7);
+  ASSERT_EQUAL(cpu->A, 8);
+
+  // Everything touched per instruction fits in the first 32 bytes
+  ASSERT_TRUE(offsetof(struct i8080, flag_res) < 32);
+  ASSERT_TRUE(offsetof(struct i8080, in_pending) < 32);
+  ASSERT_TRUE(offsetof(struct i8080, cyc) < 32);
+
+  free(cpu);
+}
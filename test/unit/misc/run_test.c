@@ -0,0 +1,122 @@
+#include "attounit.h"
+#include "i8080.h"
+#include "cpu_test_helpers.h"
+
+TEST_SUITE(run)
+
+struct i8080 *cpu;
+
+BEFORE_EACH() {
+  cpu = setup_cpu_test_env();
+}
+AFTER_EACH() {
+  teardown_cpu_test_env(cpu);
+}
+
+TEST_CASE(run_stops_when_budget_spent) {
+  // Memory is all NOPs (4 cycles each)
+  unsigned long cyc = i8080_run(cpu, 40);
+
+  ASSERT_EQUAL_FMT(cyc, 40UL, %lu);
+  ASSERT_EQUAL_FMT(cpu->cyc, 40llu, %llu);
+  ASSERT_EQUAL(cpu->PC, 10);
+}
+
+TEST_CASE(run_finishes_last_instruction) {
+  i8080_write_byte(cpu, 1, 0x01); // LXI B, d16 (10 cycles)
+
+  unsigned long cyc = i8080_run(cpu, 5);
+
+  ASSERT_EQUAL_FMT(cyc, 14UL, %lu);
+  ASSERT_EQUAL(cpu->PC, 4);
+}
+
+TEST_CASE(run_stops_on_hlt) {
+  i8080_write_byte(cpu, 2, 0x76); // HLT
+
+  unsigned long cyc = i8080_run(cpu, 1000);
+
+  ASSERT_EQUAL_FMT(cyc, 15UL, %lu);
+  ASSERT_EQUAL(cpu->PC, 3);
+  ASSERT_TRUE(cpu->halted);
+}
+
+TEST_CASE(run_while_halted) {
+  cpu->halted = 1;
+
+  ASSERT_EQUAL_FMT(i8080_run(cpu, 1000), 0UL, %lu);
+  ASSERT_EQUAL(cpu->PC, 0);
+}
+
+TEST_CASE(run_accepts_interrupt_once) {
+  cpu->PC = 60;
+  cpu->INTE = 1;
+  i8080_request_interrupt(cpu, I8080_RST_1);
+
+  // RST 1 (11 cycles) followed by a NOP at 0x08
+  i8080_run(cpu, 12);
+
+  ASSERT_EQUAL(cpu->PC, 9);
+  ASSERT_EQUAL(cpu->SP, 14);
+  ASSERT_FALSE(cpu->pending_interrupt);
+}
+
+TEST_CASE(run_counts_past_32_bits) {
+  cpu->cyc = 0xFFFFFFF0llu;
+
+  ASSERT_EQUAL_FMT(i8080_run(cpu, 40), 40UL, %lu);
+  ASSERT_EQUAL_FMT(cpu->cyc, 0x100000018llu, %llu);
+}
+
+TEST_CASE(run_until_target) {
+  ASSERT_EQUAL_FMT(i8080_run_until(cpu, 100), 100llu, %llu);
+  ASSERT_EQUAL_FMT(cpu->cyc, 100llu, %llu);
+
+  // Already there
+  ASSERT_EQUAL_FMT(i8080_run_until(cpu, 50), 0llu, %llu);
+
+  // Stops short when the CPU halts
+  i8080_write_byte(cpu, 30, 0x76); // HLT
+  ASSERT_EQUAL_FMT(i8080_run_until(cpu, 1000), 27llu, %llu);
+  ASSERT_TRUE(cpu->halted);
+}
+
+TEST_CASE(run_converts_cycles_to_time) {
+  // 500ns per cycle at the default 2 MHz
+  ASSERT_EQUAL_FMT(i8080_cycles_to_ns(cpu, 3), 1500llu, %llu);
+  ASSERT_EQUAL_FMT(i8080_ns_to_cycles(cpu, 1999), 3llu, %llu);
+
+  // A century of emulated time
+  unsigned long long century = 100 * 365 * 86400llu * I8080_CLOCK_HZ;
+  ASSERT_EQUAL_FMT(i8080_cycles_to_ns(cpu, century),
+                   100 * 365 * 86400llu * 1000000000llu, %llu);
+  ASSERT_EQUAL_FMT(i8080_ns_to_cycles(cpu, i8080_cycles_to_ns(cpu, century)),
+                   century, %llu);
+
+  cpu->clock_hz = 3000000;
+  i8080_run(cpu, 3000);
+  ASSERT_EQUAL_FMT(i8080_elapsed_ns(cpu), 1000000llu, %llu);
+  ASSERT_EQUAL_FMT(i8080_cycles_to_ns(cpu, 1), 333llu, %llu);
+}
+
+TEST_CASE(run_timed_skips_to_budget_end) {
+  i8080_write_byte(cpu, 2, 0x76); // HLT
+
+  ASSERT_EQUAL_FMT(i8080_run_timed(cpu, 1000), 1000lu, %lu);
+  ASSERT_EQUAL_FMT(cpu->cyc, 1000llu, %llu);
+  ASSERT_EQUAL(cpu->PC, 3);
+  ASSERT_TRUE(cpu->halted);
+
+  // Still halted, so the whole budget passes at once
+  ASSERT_EQUAL_FMT(i8080_run_timed(cpu, 5000), 5000lu, %lu);
+  ASSERT_EQUAL_FMT(cpu->cyc, 6000llu, %llu);
+}
+
+TEST_CASE(run_wraps_pc) {
+  // Reads past the end of memory are NOPs, so this runs off the top
+  cpu->PC = 0xFFFE;
+
+  i8080_run(cpu, 12);
+
+  ASSERT_EQUAL(cpu->PC, 1);
+}
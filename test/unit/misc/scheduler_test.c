@@ -0,0 +1,288 @@
+#include <string.h>
+#include "attounit.h"
+#include "i8080.h"
+#include "cpu_test_helpers.h"
+
+TEST_SUITE(scheduler)
+
+#define MAX_FIRED 64
+
+static struct i8080 *cpu;
+
+// Cycle count and data of every handler call, in order
+static unsigned long long fired_cyc[MAX_FIRED];
+static void *fired_data[MAX_FIRED];
+static uint num_fired;
+
+struct timer {
+  unsigned long long next;
+  uint period;
+};
+
+// Counts interrupts in C, with the main loop counting in B
+static const unsigned char timer_program[] = {
+  0xC3, 0x10, 0x00, // 00: JMP 0x0010
+  0x00, 0x00, 0x00, 0x00, 0x00,
+  0x0C,             // 08: INR C
+  0xFB,             // 09: EI
+  0xC9,             // 0A: RET
+  0x00, 0x00, 0x00, 0x00, 0x00,
+  0x31, 0x70, 0x00, // 10: LXI SP, 0x0070
+  0xFB,             // 13: EI
+  0x04,             // 14: INR B
+  0xC3, 0x14, 0x00, // 15: JMP 0x0014
+};
+
+static void record_handler(struct i8080 *cpu, void *data) {
+  if (num_fired < MAX_FIRED) {
+    fired_cyc[num_fired] = cpu->cyc;
+    fired_data[num_fired] = data;
+  }
+  num_fired++;
+}
+
+static void timer_handler(struct i8080 *cpu, void *data) {
+  struct timer *timer = data;
+
+  i8080_request_interrupt(cpu, I8080_RST_1);
+  timer->next += timer->period;
+  i8080_schedule_event(cpu, timer->next, timer_handler, timer);
+}
+
+static void chain_handler(struct i8080 *cpu, void *data) {
+  record_handler(cpu, data);
+  if (num_fired < 3) {
+    // Already due, so it runs before i8080_run carries on
+    i8080_schedule_event(cpu, cpu->cyc - 1, chain_handler, data);
+  }
+}
+
+static void cancel_all_handler(struct i8080 *cpu, void *data) {
+  record_handler(cpu, data);
+  i8080_cancel_all_events(cpu);
+}
+
+BEFORE_EACH() {
+  cpu = setup_cpu_test_env();
+  num_fired = 0;
+}
+AFTER_EACH() {
+  i8080_cancel_all_events(cpu);
+  teardown_cpu_test_env(cpu);
+}
+
+TEST_CASE(scheduler_fires_at_instruction_boundary) {
+  // Memory is all NOPs, 4 cycles each
+  i8080_schedule_event(cpu, 10, record_handler, NULL);
+  i8080_schedule_event(cpu, 40, record_handler, NULL);
+
+  // The budget isn't cut short by the events
+  ASSERT_EQUAL_FMT(i8080_run(cpu, 100), 100lu, %lu);
+
+  ASSERT_EQUAL(num_fired, 2);
+  ASSERT_EQUAL_FMT(fired_cyc[0], 12llu, %llu);
+  ASSERT_EQUAL_FMT(fired_cyc[1], 40llu, %llu);
+}
+
+TEST_CASE(scheduler_fires_in_order) {
+  int a, b, c;
+
+  i8080_schedule_event(cpu, 30, record_handler, &c);
+  i8080_schedule_event(cpu, 10, record_handler, &a);
+  i8080_schedule_event(cpu, 20, record_handler, &b);
+  i8080_schedule_event(cpu, 20, record_handler, &c);
+  i8080_schedule_event(cpu, 10, record_handler, &b);
+
+  i8080_run(cpu, 100);
+
+  void *expected[] = {&a, &b, &b, &c, &c};
+  ASSERT_EQUAL(num_fired, 5);
+  for (uint i=0;i<5;i++) {
+    ASSERT_TRUE(fired_data[i] == expected[i]);
+  }
+}
+
+TEST_CASE(scheduler_handles_many_events) {
+  uint deadlines[2*MAX_FIRED];
+  uint seed = 7;
+
+  for (uint i=0;i<2*MAX_FIRED;i++) {
+    seed = seed * 1103515245 + 12345;
+    deadlines[i] = (seed >> 16) % 1000;
+    i8080_schedule_event(cpu, deadlines[i], record_handler, &deadlines[i]);
+  }
+
+  // Leaves holes all over the heap
+  for (uint i=0;i<2*MAX_FIRED;i+=2) {
+    ASSERT_EQUAL(i8080_cancel_event(cpu, record_handler, &deadlines[i]), 1);
+  }
+  i8080_run(cpu, 1000);
+
+  // Every NOP takes 4 cycles, so each has to fire within 4 cycles
+  ASSERT_EQUAL(num_fired, MAX_FIRED);
+  for (uint i=0;i<MAX_FIRED;i++) {
+    uint deadline = *(uint *) fired_data[i];
+    ASSERT_TRUE(fired_cyc[i] >= deadline && fired_cyc[i] < deadline + 4);
+  }
+}
+
+TEST_CASE(scheduler_fires_between_steps) {
+  i8080_schedule_event(cpu, 8, record_handler, NULL);
+
+  i8080_step(cpu);
+  ASSERT_EQUAL(num_fired, 0);
+  i8080_step(cpu);
+  ASSERT_EQUAL(num_fired, 1);
+  ASSERT_EQUAL_FMT(fired_cyc[0], 8llu, %llu);
+}
+
+TEST_CASE(scheduler_fires_past_events_first) {
+  i8080_run(cpu, 100);
+  i8080_schedule_event(cpu, 50, record_handler, NULL);
+  i8080_schedule_event(cpu, cpu->cyc, record_handler, NULL);
+
+  i8080_run(cpu, 4);
+
+  ASSERT_EQUAL(num_fired, 2);
+  ASSERT_EQUAL_FMT(fired_cyc[0], 100llu, %llu);
+  ASSERT_EQUAL_FMT(fired_cyc[1], 100llu, %llu);
+}
+
+TEST_CASE(scheduler_handler_schedules_due_event) {
+  i8080_schedule_event(cpu, 20, chain_handler, NULL);
+
+  i8080_run(cpu, 40);
+
+  ASSERT_EQUAL(num_fired, 3);
+  ASSERT_EQUAL_FMT(fired_cyc[2], 20llu, %llu);
+}
+
+TEST_CASE(scheduler_cancels_events) {
+  int a, b;
+
+  i8080_schedule_event(cpu, 10, record_handler, &a);
+  i8080_schedule_event(cpu, 20, record_handler, &b);
+  i8080_schedule_event(cpu, 30, record_handler, &a);
+  i8080_schedule_event(cpu, 40, record_handler, &b);
+  i8080_schedule_event(cpu, 50, record_handler, &a);
+
+  ASSERT_EQUAL(i8080_cancel_event(cpu, record_handler, &a), 3);
+  ASSERT_EQUAL(i8080_cancel_event(cpu, record_handler, &a), 0);
+  i8080_run(cpu, 100);
+
+  ASSERT_EQUAL(num_fired, 2);
+  ASSERT_EQUAL_FMT(fired_cyc[0], 20llu, %llu);
+  ASSERT_EQUAL_FMT(fired_cyc[1], 40llu, %llu);
+}
+
+TEST_CASE(scheduler_handler_cancels_all) {
+  i8080_schedule_event(cpu, 10, cancel_all_handler, NULL);
+  i8080_schedule_event(cpu, 20, record_handler, NULL);
+
+  i8080_run(cpu, 100);
+
+  ASSERT_EQUAL(num_fired, 1);
+  ASSERT_TRUE(cpu->scheduler == NULL);
+}
+
+TEST_CASE(scheduler_timer_interrupts) {
+  struct timer timer = {1000, 1000};
+  load_program(cpu, timer_program, sizeof(timer_program));
+  i8080_schedule_event(cpu, timer.next, timer_handler, &timer);
+
+  // Drifts neither with the budget nor with instruction lengths
+  for (int i=0;i<100;i++) {
+    i8080_run(cpu, 77);
+  }
+  i8080_run(cpu, 10500 - cpu->cyc);
+
+  ASSERT_EQUAL(cpu->C, 10);
+  ASSERT_TRUE(cpu->B > 0);
+}
+
+TEST_CASE(scheduler_same_cycles_with_cache_and_jit) {
+  struct timer timer = {333, 333};
+  struct timer cached_timer = {333, 333};
+  struct timer jit_timer = {333, 333};
+  struct i8080 *cached = setup_cpu_test_env();
+  struct i8080 *jit = setup_cpu_test_env();
+
+  load_program(cpu, timer_program, sizeof(timer_program));
+  load_program(cached, timer_program, sizeof(timer_program));
+  load_program(jit, timer_program, sizeof(timer_program));
+  i8080_block_cache_enable(cached, 0);
+  i8080_jit_enable(jit, 0);
+
+  i8080_schedule_event(cpu, timer.next, timer_handler, &timer);
+  i8080_schedule_event(cached, cached_timer.next, timer_handler, &cached_timer);
+  i8080_schedule_event(jit, jit_timer.next, timer_handler, &jit_timer);
+  i8080_run(cpu, 20000);
+  i8080_run(cached, 20000);
+  i8080_run(jit, 20000);
+
+  ASSERT_EQUAL(cached->B, cpu->B);
+  ASSERT_EQUAL(cached->C, cpu->C);
+  ASSERT_EQUAL_FMT(cached->cyc, cpu->cyc, %llu);
+  ASSERT_EQUAL(jit->B, cpu->B);
+  ASSERT_EQUAL(jit->C, cpu->C);
+  ASSERT_EQUAL_FMT(jit->cyc, cpu->cyc, %llu);
+
+  i8080_cancel_all_events(cached);
+  i8080_cancel_all_events(jit);
+  i8080_block_cache_disable(cached);
+  i8080_jit_disable(jit);
+  teardown_cpu_test_env(cached);
+  teardown_cpu_test_env(jit);
+}
+
+TEST_CASE(scheduler_fires_past_32_bits) {
+  cpu->cyc = 0xFFFFFFF0llu;
+  i8080_schedule_event(cpu, 0x100000008llu, record_handler, NULL);
+  i8080_schedule_event(cpu, 0xFFFFFFF8llu, record_handler, NULL);
+
+  i8080_run(cpu, 100);
+
+  ASSERT_EQUAL(num_fired, 2);
+  ASSERT_TRUE(cpu->cyc - 100 == 0xFFFFFFF0llu);
+}
+
+TEST_CASE(scheduler_skips_halted_time) {
+  const unsigned char program[] = {
+    0xC3, 0x10, 0x00, // 00: JMP 0x0010
+    0x00, 0x00, 0x00, 0x00, 0x00,
+    0x0C,             // 08: INR C
+    0xFB,             // 09: EI
+    0xC9,             // 0A: RET
+    0x00, 0x00, 0x00, 0x00, 0x00,
+    0x31, 0x70, 0x00, // 10: LXI SP, 0x0070
+    0xFB,             // 13: EI
+    0x76,             // 14: HLT
+    0x04,             // 15: INR B
+    0xC3, 0x14, 0x00, // 16: JMP 0x0014
+  };
+  struct timer timer = {1000, 1000};
+  load_program(cpu, program, sizeof(program));
+  i8080_schedule_event(cpu, timer.next, timer_handler, &timer);
+
+  // Each interrupt is taken right at its cycle count
+  ASSERT_EQUAL_FMT(i8080_run_timed(cpu, 10500), 10500lu, %lu);
+  ASSERT_EQUAL(cpu->C, 10);
+  ASSERT_EQUAL(cpu->B, 10);
+  ASSERT_TRUE(cpu->halted);
+  ASSERT_EQUAL_FMT(cpu->cyc, 10500llu, %llu);
+
+  // The next one is due right at the end of the budget
+  i8080_run_timed(cpu, 500);
+  ASSERT_EQUAL_FMT(cpu->cyc, 11000llu, %llu);
+  ASSERT_TRUE(cpu->pending_interrupt);
+}
+
+TEST_CASE(scheduler_next_event) {
+  unsigned long long next = 0;
+
+  ASSERT_FALSE(i8080_next_event(cpu, &next));
+  i8080_schedule_event(cpu, 300, record_handler, NULL);
+  i8080_schedule_event(cpu, 200, record_handler, NULL);
+  ASSERT_TRUE(i8080_next_event(cpu, &next));
+  ASSERT_EQUAL_FMT(next, 200llu, %llu);
+}
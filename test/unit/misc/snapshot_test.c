@@ -0,0 +1,257 @@
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "attounit.h"
+#include "i8080.h"
+#include "cpu_test_helpers.h"
+
+TEST_SUITE(snapshot)
+
+#define SNAPSHOT_TEST_MEMSIZE 0x1000
+
+static struct i8080 *cpu;
+static struct i8080_snapshot first;
+static struct i8080_snapshot second;
+
+// Fills 0x0800 - 0x0FFF with its own address bits, forever
+static const unsigned char fill_program[] = {
+  0x31, 0x00, 0x01, // 00: LXI SP, 0x0100
+  0x21, 0x00, 0x08, // 03: LXI H, 0x0800
+  0x75,             // 06: MOV M, L
+  0x23,             // 07: INX H
+  0x7C,             // 08: MOV A, H
+  0xE6, 0x07,       // 09: ANI 0x07
+  0xF6, 0x08,       // 0B: ORI 0x08
+  0x67,             // 0D: MOV H, A
+  0xE5,             // 0E: PUSH H
+  0xE1,             // 0F: POP H
+  0xC3, 0x06, 0x00, // 10: JMP 0x0006
+};
+
+BEFORE_EACH() {
+  cpu = setup_cpu_test_env();
+
+  free(cpu->memory);
+  cpu->memsize = SNAPSHOT_TEST_MEMSIZE;
+  cpu->memory = calloc(SNAPSHOT_TEST_MEMSIZE, 1);
+
+  memset(&first, 0, sizeof(first));
+  memset(&second, 0, sizeof(second));
+}
+AFTER_EACH() {
+  i8080_free_snapshot(&first);
+  i8080_free_snapshot(&second);
+  i8080_snapshot_disable(cpu);
+  teardown_cpu_test_env(cpu);
+}
+
+TEST_CASE(snapshot_restores_state) {
+  i8080_snapshot_enable(cpu);
+  load_program(cpu, fill_program, sizeof(fill_program));
+  i8080_run(cpu, 5000);
+
+  char expected[SNAPSHOT_TEST_MEMSIZE];
+  memcpy(expected, cpu->memory, SNAPSHOT_TEST_MEMSIZE);
+  i8080_set_flag(cpu, FLAG_C, 1);
+  cpu->INTE = 1;
+  ASSERT_EQUAL(i8080_snapshot(cpu, &first), 0);
+
+  struct i8080 saved = *cpu;
+  i8080_run(cpu, 5000);
+  i8080_set_flag(cpu, FLAG_C, 0);
+  cpu->INTE = 0;
+  ASSERT_EQUAL(i8080_restore(cpu, &first), 0);
+
+  ASSERT_EQUAL(cpu->A, saved.A);
+  ASSERT_EQUAL(cpu->H, saved.H);
+  ASSERT_EQUAL(cpu->L, saved.L);
+  ASSERT_EQUAL(cpu->PC, saved.PC);
+  ASSERT_EQUAL(cpu->SP, saved.SP);
+  ASSERT_EQUAL_FMT(cpu->cyc, saved.cyc, %llu);
+  ASSERT_EQUAL(cpu->INTE, 1);
+  ASSERT_EQUAL(i8080_get_flag(cpu, FLAG_C), 1);
+  ASSERT_EQUAL(memcmp(cpu->memory, expected, SNAPSHOT_TEST_MEMSIZE), 0);
+}
+
+TEST_CASE(snapshot_restore_is_repeatable) {
+  i8080_snapshot_enable(cpu);
+  load_program(cpu, fill_program, sizeof(fill_program));
+  i8080_run(cpu, 2000);
+  i8080_snapshot(cpu, &first);
+
+  i8080_run(cpu, 3000);
+  char expected[SNAPSHOT_TEST_MEMSIZE];
+  memcpy(expected, cpu->memory, SNAPSHOT_TEST_MEMSIZE);
+  uint expected_pc = cpu->PC;
+
+  // Running on from the same snapshot has to end up in the same place, no
+  // matter which pages were written in between
+  for (int round=0;round<5;round++) {
+    i8080_restore(cpu, &first);
+    i8080_run(cpu, 3000);
+
+    ASSERT_EQUAL(cpu->PC, expected_pc);
+    ASSERT_EQUAL(memcmp(cpu->memory, expected, SNAPSHOT_TEST_MEMSIZE), 0);
+  }
+}
+
+TEST_CASE(snapshot_shares_clean_pages) {
+  i8080_snapshot_enable(cpu);
+  i8080_snapshot(cpu, &first);
+
+  i8080_write_byte(cpu, 0x345, 0xAA);
+  i8080_write_word(cpu, 0x7FF, 0xBBCC);
+  i8080_snapshot(cpu, &second);
+
+  ASSERT_EQUAL_FMT(second.num_pages,
+                   (size_t) (SNAPSHOT_TEST_MEMSIZE / I8080_PAGE_SIZE), %zu);
+  for (size_t i=0;i<second.num_pages;i++) {
+    int written = i == 3 || i == 7 || i == 8;
+    ASSERT_EQUAL(first.pages[i] == second.pages[i], !written);
+  }
+}
+
+TEST_CASE(snapshot_restore_copies_back_written_pages) {
+  i8080_snapshot_enable(cpu);
+  i8080_write_byte(cpu, 0x123, 0x11);
+  i8080_snapshot(cpu, &first);
+
+  i8080_write_byte(cpu, 0x123, 0x22);
+  i8080_push_stackw(cpu, 0x3344);
+  i8080_restore(cpu, &first);
+
+  ASSERT_EQUAL(i8080_read_byte(cpu, 0x123), 0x11);
+  ASSERT_EQUAL(i8080_read_word(cpu, 0x0E), 0);
+  ASSERT_EQUAL(cpu->SP, 0x10);
+}
+
+TEST_CASE(snapshot_after_load_memory) {
+  char path[] = "/tmp/lib8080testXXXXXX";
+  FILE *file = fdopen(mkstemp(path), "wb");
+  for (int i=0;i<0x300;i++) {
+    fputc(0x3E, file);
+  }
+  fclose(file);
+
+  i8080_snapshot_enable(cpu);
+  i8080_snapshot(cpu, &first);
+  ASSERT_EQUAL_FMT(i8080_load_memory(cpu, path, 0x80), 0x300L, %ld);
+  i8080_snapshot(cpu, &second);
+  unlink(path);
+
+  // Every page loaded into is the snapshot's own
+  for (size_t i=0;i<second.num_pages;i++) {
+    int loaded = i * I8080_PAGE_SIZE < 0x380 &&
+                 (i + 1) * I8080_PAGE_SIZE > 0x80;
+    ASSERT_EQUAL(first.pages[i] == second.pages[i], !loaded);
+  }
+
+  i8080_write_byte(cpu, 0x80, 0x00);
+  i8080_write_byte(cpu, 0x37F, 0x00);
+  i8080_restore(cpu, &second);
+
+  ASSERT_EQUAL(i8080_read_byte(cpu, 0x80), 0x3E);
+  ASSERT_EQUAL(i8080_read_byte(cpu, 0x37F), 0x3E);
+}
+
+TEST_CASE(snapshot_switches_between_snapshots) {
+  i8080_snapshot_enable(cpu);
+  i8080_write_byte(cpu, 0x500, 0x01);
+  i8080_snapshot(cpu, &first);
+  i8080_write_byte(cpu, 0x500, 0x02);
+  i8080_write_byte(cpu, 0x900, 0x03);
+  i8080_snapshot(cpu, &second);
+
+  // Pages that are clean but differ between the two still have to be copied
+  i8080_restore(cpu, &first);
+  ASSERT_EQUAL(i8080_read_byte(cpu, 0x500), 0x01);
+  ASSERT_EQUAL(i8080_read_byte(cpu, 0x900), 0x00);
+
+  i8080_restore(cpu, &second);
+  ASSERT_EQUAL(i8080_read_byte(cpu, 0x500), 0x02);
+  ASSERT_EQUAL(i8080_read_byte(cpu, 0x900), 0x03);
+}
+
+TEST_CASE(snapshot_outlives_freed_snapshots) {
+  i8080_snapshot_enable(cpu);
+  i8080_write_byte(cpu, 0x200, 0x42);
+  i8080_snapshot(cpu, &first);
+  i8080_snapshot(cpu, &second);
+  i8080_free_snapshot(&first);
+
+  i8080_write_byte(cpu, 0x200, 0x00);
+  i8080_restore(cpu, &second);
+
+  ASSERT_EQUAL(i8080_read_byte(cpu, 0x200), 0x42);
+}
+
+TEST_CASE(snapshot_without_tracking) {
+  i8080_write_byte(cpu, 0x10, 0x55);
+  ASSERT_EQUAL(i8080_snapshot(cpu, &first), 0);
+
+  // Every page is copied, but the result is the same
+  cpu->memory[0x10] = 0x00;
+  cpu->memory[0xFFF] = 0x01;
+  ASSERT_EQUAL(i8080_restore(cpu, &first), 0);
+
+  ASSERT_EQUAL(i8080_read_byte(cpu, 0x10), 0x55);
+  ASSERT_EQUAL(i8080_read_byte(cpu, 0xFFF), 0x00);
+}
+
+TEST_CASE(snapshot_restore_into_other_cpu) {
+  struct i8080 *other = setup_cpu_test_env();
+  free(other->memory);
+  other->memsize = SNAPSHOT_TEST_MEMSIZE;
+  other->memory = calloc(SNAPSHOT_TEST_MEMSIZE, 1);
+  i8080_snapshot_enable(other);
+
+  load_program(cpu, fill_program, sizeof(fill_program));
+  i8080_run(cpu, 1000);
+  i8080_snapshot(cpu, &first);
+  i8080_run(cpu, 1000);
+
+  ASSERT_EQUAL(i8080_restore(other, &first), 0);
+  i8080_run(other, 1000);
+
+  ASSERT_EQUAL(other->PC, cpu->PC);
+  ASSERT_EQUAL_FMT(other->cyc, cpu->cyc, %llu);
+  ASSERT_EQUAL(memcmp(other->memory, cpu->memory, SNAPSHOT_TEST_MEMSIZE), 0);
+
+  i8080_snapshot_disable(other);
+  teardown_cpu_test_env(other);
+}
+
+TEST_CASE(snapshot_restore_discards_cached_code) {
+  const unsigned char program[] = {
+    0x3E, 0x01,       // 00: MVI A, 0x01
+    0x76,             // 02: HLT
+  };
+
+  i8080_snapshot_enable(cpu);
+  i8080_block_cache_enable(cpu, 0);
+  load_program(cpu, program, sizeof(program));
+  i8080_snapshot(cpu, &first);
+
+  i8080_write_byte(cpu, 1, 0x02);
+  i8080_run(cpu, 100);
+  ASSERT_EQUAL(cpu->A, 0x02);
+
+  i8080_restore(cpu, &first);
+  i8080_run(cpu, 100);
+  ASSERT_EQUAL(cpu->A, 0x01);
+
+  i8080_block_cache_disable(cpu);
+}
+
+TEST_CASE(snapshot_rejects_page_table) {
+  struct i8080_page pages[I8080_NUM_PAGES];
+  i8080_bus_init(cpu, pages);
+
+  errno = 0;
+  ASSERT_EQUAL(i8080_snapshot(cpu, &first), -1);
+  ASSERT_EQUAL(errno, EINVAL);
+  ASSERT_EQUAL(i8080_restore(cpu, &first), -1);
+
+  cpu->pages = NULL;
+}
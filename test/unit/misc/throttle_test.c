@@ -0,0 +1,88 @@
+#include "attounit.h"
+#include "i8080.h"
+#include "i8080_throttle.h"
+#include "cpu_test_helpers.h"
+
+TEST_SUITE(throttle)
+
+static struct i8080 *cpu;
+static struct i8080_throttle throttle;
+
+BEFORE_EACH() {
+  cpu = setup_cpu_test_env();
+  i8080_throttle_init(&throttle, cpu);
+}
+AFTER_EACH() {
+  teardown_cpu_test_env(cpu);
+}
+
+TEST_CASE(throttle_paces_to_clock) {
+  // Memory is all NOPs, 20 ms at 2 MHz
+  unsigned long long cyc = i8080_throttle_run(&throttle, 20000000);
+
+  ASSERT_TRUE(cyc >= 40000 && cyc < 40004);
+  ASSERT_EQUAL_FMT(throttle.cycles, cyc, %llu);
+
+  // Never ahead of real time, and NOPs can't be behind by much
+  ASSERT_TRUE(throttle.host_ns >= 20000000);
+  ASSERT_TRUE(throttle.sleep_ns > 0);
+  ASSERT_TRUE(i8080_throttle_speed(&throttle) <= 1.0);
+  ASSERT_TRUE(i8080_throttle_speed(&throttle) > 0.5);
+}
+
+TEST_CASE(throttle_uses_clock_rate) {
+  cpu->clock_hz = 3125000;
+
+  unsigned long long cyc = i8080_throttle_run(&throttle, 10000000);
+
+  ASSERT_TRUE(cyc >= 31250 && cyc < 31254);
+  ASSERT_TRUE(throttle.host_ns >= 10000000);
+}
+
+TEST_CASE(throttle_sleeps_while_halted) {
+  i8080_write_byte(cpu, 0, 0x76); // HLT
+
+  // Time passes while halted, in a single sleep
+  ASSERT_EQUAL_FMT(i8080_throttle_run(&throttle, 20000000), 40000llu, %llu);
+  ASSERT_TRUE(throttle.host_ns >= 20000000);
+  ASSERT_TRUE(throttle.idle_ns > 0);
+  ASSERT_EQUAL_FMT(throttle.idle_ns, throttle.sleep_ns, %llu);
+}
+
+static void wake_handler(struct i8080 *cpu, void *data) {
+  i8080_request_interrupt(cpu, I8080_RST_1);
+}
+
+TEST_CASE(throttle_wakes_for_events) {
+  const unsigned char program[] = {
+    0x31, 0x70, 0x00, // 00: LXI SP, 0x0070
+    0xFB,             // 03: EI
+    0x76,             // 04: HLT
+    0x00,             // 05: NOP
+    0x00,             // 06: NOP
+    0x00,             // 07: NOP
+    0x3E, 0x42,       // 08: MVI A, 0x42
+    0x76,             // 0A: HLT
+  };
+  for (size_t i=0;i<sizeof(program);i++) {
+    i8080_write_byte(cpu, i, program[i]);
+  }
+
+  // 5 ms in, halfway through a slice
+  i8080_schedule_event(cpu, 10000, wake_handler, NULL);
+  i8080_throttle_run(&throttle, 20000000);
+
+  ASSERT_EQUAL(cpu->A, 0x42);
+  ASSERT_TRUE(throttle.host_ns >= 20000000);
+  i8080_cancel_all_events(cpu);
+}
+
+TEST_CASE(throttle_resyncs_when_behind) {
+  // As if the host had been suspended for a second
+  throttle.origin_ns -= 1000000000;
+
+  unsigned long long cyc = i8080_throttle_run(&throttle, 5000000);
+
+  ASSERT_TRUE(cyc >= 10000);
+  ASSERT_EQUAL_FMT(throttle.resyncs, 1lu, %lu);
+}
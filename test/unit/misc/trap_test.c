@@ -0,0 +1,191 @@
+#include "attounit.h"
+#include "i8080.h"
+#include "cpu_test_helpers.h"
+
+TEST_SUITE(trap)
+
+static struct i8080 *cpu;
+static uint8_t traps[I8080_TRAP_BYTES];
+
+static uint trapped[16];
+static int num_trapped;
+
+static void record_trap(struct i8080 *cpu, void *ctx, uint addr) {
+  if (num_trapped < 16) {
+    trapped[num_trapped] = addr;
+  }
+  num_trapped++;
+}
+
+// Stops the run at the trap
+static void halt_trap(struct i8080 *cpu, void *ctx, uint addr) {
+  record_trap(cpu, ctx, addr);
+  cpu->halted = 1;
+}
+
+// Does the work of a subroutine on the host and returns from it
+static void return_trap(struct i8080 *cpu, void *ctx, uint addr) {
+  record_trap(cpu, ctx, addr);
+  cpu->A = 0x42;
+  cpu->PC = i8080_pop_stackw(cpu);
+}
+
+// Sees the carry set before the jump, and clears it for the code after
+static int saw_carry;
+static void carry_trap(struct i8080 *cpu, void *ctx, uint addr) {
+  record_trap(cpu, ctx, addr);
+  saw_carry = cpu->flags & 0x01;
+  cpu->flags &= ~0x01;
+}
+
+BEFORE_EACH() {
+  cpu = setup_cpu_test_env();
+  num_trapped = 0;
+}
+AFTER_EACH() {
+  teardown_cpu_test_env(cpu);
+}
+
+// Calls, returns, jumps through HL and then jumps to a HLT, with a trap at
+// each destination
+static void run_transfers() {
+  const unsigned char program[] = {
+    0x31, 0x70, 0x00, // 00: LXI SP, 0x0070
+    0xCD, 0x20, 0x00, // 03: CALL 0x0020
+    0x21, 0x30, 0x00, // 06: LXI H, 0x0030
+    0xE9,             // 09: PCHL
+  };
+  load_program(cpu, program, sizeof(program));
+  i8080_write_byte(cpu, 0x20, 0xC9);   // 20: RET
+  i8080_write_byte(cpu, 0x30, 0xC3);   // 30: JMP 0x0040
+  i8080_write_word(cpu, 0x31, 0x0040);
+  i8080_write_byte(cpu, 0x40, 0x76);   // 40: HLT
+
+  i8080_traps_init(cpu, traps, record_trap, NULL);
+  i8080_set_trap(cpu, 0x20);
+  i8080_set_trap(cpu, 0x06);
+  i8080_set_trap(cpu, 0x30);
+  i8080_set_trap(cpu, 0x40);
+
+  i8080_run(cpu, 1000);
+}
+
+TEST_CASE(trap_on_control_transfers) {
+  run_transfers();
+
+  ASSERT_TRUE(cpu->halted);
+  ASSERT_EQUAL(num_trapped, 4);
+  ASSERT_EQUAL(trapped[0], 0x20);
+  ASSERT_EQUAL(trapped[1], 0x06);
+  ASSERT_EQUAL(trapped[2], 0x30);
+  ASSERT_EQUAL(trapped[3], 0x40);
+}
+
+TEST_CASE(trap_in_cached_blocks) {
+  i8080_jit_disable(cpu);
+  i8080_block_cache_enable(cpu, 0);
+
+  run_transfers();
+
+  ASSERT_TRUE(cpu->halted);
+  ASSERT_EQUAL(num_trapped, 4);
+  ASSERT_EQUAL(trapped[0], 0x20);
+  ASSERT_EQUAL(trapped[1], 0x06);
+  ASSERT_EQUAL(trapped[2], 0x30);
+  ASSERT_EQUAL(trapped[3], 0x40);
+
+  i8080_block_cache_disable(cpu);
+}
+
+TEST_CASE(trap_on_interrupt) {
+  i8080_write_byte(cpu, 0x40, 0x76); // HLT
+  cpu->PC = 0x40;
+  cpu->SP = 0x70;
+  cpu->INTE = 1;
+
+  i8080_traps_init(cpu, traps, record_trap, NULL);
+  i8080_set_trap(cpu, 0x08);
+  i8080_request_interrupt(cpu, I8080_RST_1);
+  i8080_run(cpu, 11);
+
+  ASSERT_EQUAL(num_trapped, 1);
+  ASSERT_EQUAL(trapped[0], 0x08);
+}
+
+TEST_CASE(trap_sees_flags) {
+  const unsigned char program[] = {
+    0x37,             // 00: STC
+    0xC3, 0x20, 0x00, // 01: JMP 0x0020
+  };
+  load_program(cpu, program, sizeof(program));
+  i8080_write_byte(cpu, 0x20, 0xDA);   // 20: JC 0x0030
+  i8080_write_word(cpu, 0x21, 0x0030);
+  i8080_write_byte(cpu, 0x23, 0x3E);   // 23: MVI A, 1
+  i8080_write_byte(cpu, 0x24, 0x01);
+  i8080_write_byte(cpu, 0x25, 0x76);   // 25: HLT
+  i8080_write_byte(cpu, 0x30, 0x3E);   // 30: MVI A, 2
+  i8080_write_byte(cpu, 0x31, 0x02);
+  i8080_write_byte(cpu, 0x32, 0x76);   // 32: HLT
+
+  saw_carry = 0;
+  i8080_traps_init(cpu, traps, carry_trap, NULL);
+  i8080_set_trap(cpu, 0x20);
+  i8080_run(cpu, 1000);
+
+  ASSERT_EQUAL(num_trapped, 1);
+  ASSERT_TRUE(saw_carry);
+  ASSERT_EQUAL(cpu->A, 1);
+  ASSERT_FALSE(cpu->flags & 0x01);
+}
+
+TEST_CASE(trap_halts_run) {
+  const unsigned char program[] = {
+    0xC3, 0x20, 0x00, // 00: JMP 0x0020
+  };
+  load_program(cpu, program, sizeof(program));
+
+  i8080_traps_init(cpu, traps, halt_trap, NULL);
+  i8080_set_trap(cpu, 0x20);
+
+  // Stops right at the trap, without running on through the NOPs
+  ASSERT_EQUAL_FMT(i8080_run(cpu, 1000), 10lu, %lu);
+  ASSERT_EQUAL(cpu->PC, 0x20);
+  ASSERT_EQUAL(num_trapped, 1);
+}
+
+TEST_CASE(trap_replaces_subroutine) {
+  const unsigned char program[] = {
+    0x31, 0x70, 0x00, // 00: LXI SP, 0x0070
+    0xCD, 0x05, 0x00, // 03: CALL 0x0005
+    0x47,             // 06: MOV B, A
+    0x76,             // 07: HLT
+  };
+  load_program(cpu, program, sizeof(program));
+
+  i8080_traps_init(cpu, traps, return_trap, NULL);
+  i8080_set_trap(cpu, 0x05);
+  i8080_run(cpu, 1000);
+
+  // The MOV at 0x05 never ran, the handler having returned from the call
+  ASSERT_EQUAL(cpu->B, 0x42);
+  ASSERT_EQUAL(cpu->SP, 0x70);
+  ASSERT_EQUAL(cpu->PC, 0x08);
+  ASSERT_EQUAL(num_trapped, 1);
+}
+
+TEST_CASE(trap_cleared) {
+  const unsigned char program[] = {
+    0xC3, 0x20, 0x00, // 00: JMP 0x0020
+  };
+  load_program(cpu, program, sizeof(program));
+  i8080_write_byte(cpu, 0x20, 0x76); // HLT
+
+  i8080_traps_init(cpu, traps, record_trap, NULL);
+  i8080_set_trap(cpu, 0x20);
+  i8080_set_trap(cpu, 0x21);
+  i8080_clear_trap(cpu, 0x20);
+  i8080_run(cpu, 1000);
+
+  ASSERT_TRUE(cpu->halted);
+  ASSERT_EQUAL(num_trapped, 0);
+}
@@ -0,0 +1,105 @@
+#include <pthread.h>
+#include <time.h>
+#include "attounit.h"
+#include "i8080.h"
+#include "i8080_wait.h"
+#include "cpu_test_helpers.h"
+
+TEST_SUITE(wait)
+
+static struct i8080 *cpu;
+static struct i8080_wait wait;
+
+// Halts until RST 1 sets A, then spins until the budget runs out
+static const unsigned char halt_program[] = {
+  0x31, 0x70, 0x00, // 00: LXI SP, 0x0070
+  0xFB,             // 03: EI
+  0x76,             // 04: HLT
+  0x00,             // 05: NOP
+  0x00,             // 06: NOP
+  0x00,             // 07: NOP
+  0x3E, 0x42,       // 08: MVI A, 0x42
+  0xC3, 0x0A, 0x00, // 0A: JMP 0x000A
+};
+
+static void sleep_ms(long ms) {
+  struct timespec ts = {0, ms * 1000000};
+  nanosleep(&ts, NULL);
+}
+
+static void *post_later(void *arg) {
+  sleep_ms(10);
+  i8080_wait_post(&wait, I8080_RST_1);
+  return NULL;
+}
+
+static void *wake_later(void *arg) {
+  sleep_ms(10);
+  i8080_wait_wake(&wait);
+  return NULL;
+}
+
+static void wake_handler(struct i8080 *cpu, void *data) {
+  i8080_request_interrupt(cpu, I8080_RST_1);
+}
+
+BEFORE_EACH() {
+  cpu = setup_cpu_test_env();
+  for (size_t i=0;i<sizeof(halt_program);i++) {
+    i8080_write_byte(cpu, i, halt_program[i]);
+  }
+  i8080_wait_init(&wait, cpu);
+}
+AFTER_EACH() {
+  i8080_wait_destroy(&wait);
+  i8080_cancel_all_events(cpu);
+  teardown_cpu_test_env(cpu);
+}
+
+TEST_CASE(wait_blocks_until_posted) {
+  pthread_t thread;
+  pthread_create(&thread, NULL, post_later, NULL);
+
+  // Halted time doesn't count towards the budget, so this returns only after
+  // the interrupt has been handled
+  unsigned long cyc = i8080_wait_run(&wait, 1000);
+  pthread_join(thread, NULL);
+
+  ASSERT_EQUAL(cpu->A, 0x42);
+  ASSERT_FALSE(cpu->halted);
+  ASSERT_TRUE(cyc >= 1000 && cyc < 1010);
+  ASSERT_FALSE(i8080_interrupt_posted(cpu));
+}
+
+TEST_CASE(wait_delivers_before_running) {
+  i8080_run(cpu, 100);
+  ASSERT_TRUE(cpu->halted);
+
+  ASSERT_EQUAL(i8080_wait_post(&wait, I8080_RST_1), 0);
+  i8080_wait_run(&wait, 1000);
+
+  ASSERT_EQUAL(cpu->A, 0x42);
+}
+
+TEST_CASE(wait_returns_when_woken) {
+  pthread_t thread;
+  pthread_create(&thread, NULL, wake_later, NULL);
+
+  i8080_wait_run(&wait, 1000);
+  pthread_join(thread, NULL);
+
+  ASSERT_TRUE(cpu->halted);
+  ASSERT_EQUAL(cpu->A, 0x00);
+  ASSERT_EQUAL(cpu->PC, 0x05);
+}
+
+TEST_CASE(wait_skips_to_events) {
+  // Doesn't block, as the event will wake the CPU anyway
+  i8080_schedule_event(cpu, 500, wake_handler, NULL);
+
+  unsigned long cyc = i8080_wait_run(&wait, 1000);
+
+  ASSERT_TRUE(cyc >= 1000 && cyc < 1010);
+  ASSERT_EQUAL(cpu->A, 0x42);
+  ASSERT_EQUAL_FMT(cpu->cyc, (unsigned long long) cyc, %llu);
+}